@@ -0,0 +1,679 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_Crypto_Bench.c
+ * @brief Host check and cost model of the mbedtls AES and SHA-256 modules
+ *        on the L2C engine (SDK mbedtls library/ec61x).
+ *
+ * The modules are built against the reference engine of Mock/HT_Mock_L2c.c.
+ * Known answers (FIPS-197, FIPS 180-2, GCM test case 3, RFC 3610 packet 1)
+ * are checked with the engine off and on, then both paths are compared on
+ * random keys, lengths and update splits, with interleaved and cloned SHA
+ * contexts, with the engine held by another user and with an engine call
+ * failing part way.
+ *
+ * The workloads are the symmetric side of a TLS 1.2 session: AES-GCM and
+ * AES-CCM-8 records built on mbedtls_aes_crypt_ecb as gcm.c and ccm.c do,
+ * a CCM variant that runs its CBC-MAC through mbedtls_aes_crypt_cbc, and the
+ * handshake hashing (transcript with its clones, PRF HMACs, certificate
+ * hashes). Host time says nothing about the target, so each workload is
+ * reported as Cortex-M3 time modeled from the block and call counts; the
+ * per-block and per-call cycles are assumptions to calibrate with the
+ * on-target HT_CRYPTO_BENCH (Src/HT_CryptoBench.c). GHASH and the public
+ * key operations run in software on both paths and are left out.
+ *
+ * Usage: crypto_bench [-r record_bytes] [-n records] [-x seed] [-f cpu_mhz]
+ *                     [-A aes_sw_cycles] [-a aes_hw_cycles] [-c call_cycles]
+ *                     [-S sha_sw_cycles] [-s sha_hw_cycles]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
+#include "l2c_alt.h"
+#include "l2ctls_qcx212.h"
+
+#define BENCH_RECORD_MAX    16384   /**< TLS maximum plaintext record. */
+#define BENCH_RANDOM_RUNS   200     /**< Cases per random cross-check. */
+
+/**
+ * @brief Cortex-M3 cost model, cycles.
+ */
+typedef struct {
+    double mhz;
+    double aesSw;       /**< Software AES block. */
+    double aesHw;       /**< Engine AES block. */
+    double call;        /**< Engine call or SHA session: setup, bounce copies, zeroize. */
+    double shaSw;       /**< Software SHA-256 compression. */
+    double shaHw;       /**< Engine SHA-256 compression. */
+} BenchModel;
+
+static int failures;
+static uint32_t seed = 1;
+
+static uint32_t BenchRand(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void BenchFill(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (uint8_t)BenchRand();
+}
+
+static size_t BenchHex(const char *hex, uint8_t *out)
+{
+    size_t n = 0;
+    unsigned int byte;
+
+    while (hex[0] && hex[1] && sscanf(hex, "%2x", &byte) == 1)
+    {
+        out[n++] = (uint8_t)byte;
+        hex += 2;
+    }
+
+    return n;
+}
+
+static void BenchCheck(const char *what, int hw, int ok)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s (engine %s)\n", what, hw ? "on" : "off");
+        failures++;
+    }
+}
+
+static int BenchEqualHex(const uint8_t *data, const char *hex)
+{
+    uint8_t ref[64];
+    size_t len = BenchHex(hex, ref);
+
+    return memcmp(data, ref, len) == 0;
+}
+
+/* Modes built on the block cipher as mbedtls gcm.c and ccm.c ------------- */
+
+static void BenchGfMul(uint8_t x[16], const uint8_t h[16])
+{
+    uint8_t z[16] = { 0 }, v[16];
+    int carry;
+
+    memcpy(v, h, 16);
+    for (int i = 0; i < 128; i++)
+    {
+        if (x[i / 8] & (0x80 >> (i % 8)))
+            for (int j = 0; j < 16; j++)
+                z[j] ^= v[j];
+
+        carry = v[15] & 1;
+        for (int j = 15; j > 0; j--)
+            v[j] = (uint8_t)((v[j] >> 1) | (v[j - 1] << 7));
+        v[0] >>= 1;
+        if (carry)
+            v[0] ^= 0xE1;
+    }
+
+    memcpy(x, z, 16);
+}
+
+static void BenchGhash(uint8_t y[16], const uint8_t h[16], const uint8_t *data, size_t len)
+{
+    for (size_t off = 0; off < len; off += 16)
+    {
+        for (size_t i = 0; i < 16 && off + i < len; i++)
+            y[i] ^= data[off + i];
+        BenchGfMul(y, h);
+    }
+}
+
+/* AES-GCM encryption, 12-byte IV */
+static void BenchGcm(mbedtls_aes_context *aes, const uint8_t iv[12], const uint8_t *aad, size_t aadLen,
+                     const uint8_t *in, uint8_t *out, size_t len, uint8_t tag[16])
+{
+    uint8_t h[16] = { 0 }, j0[16], ctr[16], ks[16], y[16] = { 0 }, lens[16] = { 0 };
+    uint32_t c;
+
+    mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, h, h);
+    memcpy(j0, iv, 12);
+    j0[12] = j0[13] = j0[14] = 0;
+    j0[15] = 1;
+    memcpy(ctr, j0, 16);
+
+    for (size_t off = 0; off < len; off += 16)
+    {
+        for (int i = 15; i >= 12 && ++ctr[i] == 0; i--)
+            ;
+        mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, ctr, ks);
+        for (size_t i = 0; i < 16 && off + i < len; i++)
+            out[off + i] = in[off + i] ^ ks[i];
+    }
+
+    BenchGhash(y, h, aad, aadLen);
+    BenchGhash(y, h, out, len);
+    c = (uint32_t)aadLen * 8;
+    lens[4] = (uint8_t)(c >> 24); lens[5] = (uint8_t)(c >> 16); lens[6] = (uint8_t)(c >> 8); lens[7] = (uint8_t)c;
+    c = (uint32_t)len * 8;
+    lens[12] = (uint8_t)(c >> 24); lens[13] = (uint8_t)(c >> 16); lens[14] = (uint8_t)(c >> 8); lens[15] = (uint8_t)c;
+    BenchGhash(y, h, lens, 16);
+
+    mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, j0, ks);
+    for (int i = 0; i < 16; i++)
+        tag[i] = y[i] ^ ks[i];
+}
+
+/*
+ * AES-CCM encryption, aadLen < 0xFF00. With batched set the CBC-MAC runs
+ * as one mbedtls_aes_crypt_cbc call over the formatted input instead of
+ * one block call per 16 bytes.
+ */
+static void BenchCcm(mbedtls_aes_context *aes, int batched, const uint8_t *nonce, size_t nonceLen,
+                     const uint8_t *aad, size_t aadLen, const uint8_t *in, uint8_t *out, size_t len,
+                     uint8_t *tag, size_t tagLen)
+{
+    static uint8_t fmt[16 + 16 + 32 + BENCH_RECORD_MAX];
+    uint8_t mac[16] = { 0 }, ctr[16], ks[16];
+    size_t q = 15 - nonceLen, n = 0, pad;
+
+    // B0, the AAD with its length, the payload, each zero padded to a block
+    fmt[0] = (uint8_t)((aadLen ? 0x40 : 0) | ((tagLen - 2) / 2) << 3 | (q - 1));
+    memcpy(fmt + 1, nonce, nonceLen);
+    for (size_t i = 0; i < q; i++)
+        fmt[15 - i] = (uint8_t)(len >> (8 * i));
+    n = 16;
+    if (aadLen)
+    {
+        fmt[n++] = (uint8_t)(aadLen >> 8);
+        fmt[n++] = (uint8_t)aadLen;
+        memcpy(fmt + n, aad, aadLen);
+        n += aadLen;
+        pad = (16 - n % 16) % 16;
+        memset(fmt + n, 0, pad);
+        n += pad;
+    }
+    memcpy(fmt + n, in, len);
+    n += len;
+    pad = (16 - n % 16) % 16;
+    memset(fmt + n, 0, pad);
+    n += pad;
+
+    if (batched)
+    {
+        mbedtls_aes_crypt_cbc(aes, MBEDTLS_AES_ENCRYPT, n, mac, fmt, fmt);
+        memcpy(mac, fmt + n - 16, 16);
+    }
+    else
+    {
+        for (size_t off = 0; off < n; off += 16)
+        {
+            for (int i = 0; i < 16; i++)
+                mac[i] ^= fmt[off + i];
+            mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, mac, mac);
+        }
+    }
+
+    memset(ctr, 0, 16);
+    ctr[0] = (uint8_t)(q - 1);
+    memcpy(ctr + 1, nonce, nonceLen);
+    mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, ctr, ks);
+    for (size_t i = 0; i < tagLen; i++)
+        tag[i] = mac[i] ^ ks[i];
+
+    for (size_t off = 0; off < len; off += 16)
+    {
+        for (int i = 15; i > 15 - (int)q && ++ctr[i] == 0; i--)
+            ;
+        mbedtls_aes_crypt_ecb(aes, MBEDTLS_AES_ENCRYPT, ctr, ks);
+        for (size_t i = 0; i < 16 && off + i < len; i++)
+            out[off + i] = in[off + i] ^ ks[i];
+    }
+}
+
+/* Hashing as the TLS 1.2 PRF and handshake do ---------------------------- */
+
+static void BenchHmac(const uint8_t *key, size_t keyLen, const uint8_t *msg, size_t len, uint8_t out[32])
+{
+    mbedtls_sha256_context sha;
+    uint8_t pad[64];
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        memset(pad, pass ? 0x5C : 0x36, 64);
+        for (size_t i = 0; i < keyLen; i++)
+            pad[i] ^= key[i];
+
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts_ret(&sha, 0);
+        mbedtls_sha256_update_ret(&sha, pad, 64);
+        mbedtls_sha256_update_ret(&sha, pass ? out : msg, pass ? 32 : len);
+        mbedtls_sha256_finish_ret(&sha, out);
+        mbedtls_sha256_free(&sha);
+    }
+}
+
+/* P_SHA256 as in RFC 5246 section 5 */
+static void BenchPrf(const uint8_t *secret, size_t secretLen, const uint8_t *seed, size_t seedLen,
+                     uint8_t *out, size_t len)
+{
+    uint8_t a[32 + 96], block[32];
+
+    BenchHmac(secret, secretLen, seed, seedLen, a);
+    for (size_t off = 0; off < len; off += 32)
+    {
+        memcpy(a + 32, seed, seedLen);
+        BenchHmac(secret, secretLen, a, 32 + seedLen, block);
+        memcpy(out + off, block, (len - off < 32) ? len - off : 32);
+        BenchHmac(secret, secretLen, a, 32, a);
+    }
+}
+
+/*
+ * Symmetric work of one ECDHE-ECDSA-AES128-CCM-8 full handshake with a
+ * two certificate chain; the transcript is forked twice for Finished.
+ */
+static void BenchHandshake(uint8_t out[32])
+{
+    static const uint16_t messages[] = { 180, 90, 1480, 150, 400, 4, 70, 1, 16, 1, 16 };
+    mbedtls_sha256_context transcript, fork;
+    uint8_t msg[1500], secret[48], seed[77], keys[40], verify[32];
+
+    mbedtls_sha256_init(&transcript);
+    mbedtls_sha256_starts_ret(&transcript, 0);
+    BenchFill(seed, sizeof(seed));
+
+    for (size_t m = 0; m < sizeof(messages) / sizeof(messages[0]); m++)
+    {
+        BenchFill(msg, messages[m]);
+        mbedtls_sha256_update_ret(&transcript, msg, messages[m]);
+
+        // Certificate: both TBS hashed for the chain signatures
+        if (messages[m] == 1480)
+        {
+            mbedtls_sha256_context tbs;
+            for (int cert = 0; cert < 2; cert++)
+            {
+                mbedtls_sha256_init(&tbs);
+                mbedtls_sha256_starts_ret(&tbs, 0);
+                mbedtls_sha256_update_ret(&tbs, msg + 10 + cert * 720, 600);
+                mbedtls_sha256_finish_ret(&tbs, verify);
+                mbedtls_sha256_free(&tbs);
+            }
+        }
+
+        // ClientKeyExchange: master secret and key block
+        if (messages[m] == 70)
+        {
+            BenchPrf(msg, 32, seed, sizeof(seed), secret, sizeof(secret));
+            BenchPrf(secret, sizeof(secret), seed, sizeof(seed), keys, sizeof(keys));
+        }
+
+        // Client and server Finished
+        if (messages[m] == 1)
+        {
+            mbedtls_sha256_clone(&fork, &transcript);
+            mbedtls_sha256_finish_ret(&fork, verify);
+            memcpy(seed + 15, verify, 32);
+            BenchPrf(secret, sizeof(secret), seed, 15 + 32, verify, 12);
+        }
+    }
+
+    mbedtls_sha256_finish_ret(&transcript, out);
+    for (int i = 0; i < 12; i++)
+        out[i] ^= verify[i];
+}
+
+/* Known answers ----------------------------------------------------------- */
+
+static void BenchKnownAnswers(int hw)
+{
+    mbedtls_aes_context aes;
+    mbedtls_sha256_context sha;
+    uint8_t key[32], pt[64], ct[64], buf[64], tag[16];
+    static const char *fips197[3] = { "69c4e0d86a7b0430d8cdb78070b4c55a",
+                                      "dda97ca4864cdfe06eaf70a0ec0d7191",
+                                      "8ea2b7ca516745bfeafc49904b496089" };
+
+    mbedtls_l2c_set_hw(hw);
+    mbedtls_aes_init(&aes);
+
+    for (int k = 0; k < 3; k++)
+    {
+        for (int i = 0; i < 32; i++)
+            key[i] = (uint8_t)i;
+        for (int i = 0; i < 16; i++)
+            pt[i] = (uint8_t)(i * 0x11);
+
+        mbedtls_aes_setkey_enc(&aes, key, 128 + 64 * k);
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, pt, ct);
+        BenchCheck("FIPS-197 C encrypt", hw, BenchEqualHex(ct, fips197[k]));
+        mbedtls_aes_setkey_dec(&aes, key, 128 + 64 * k);
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_DECRYPT, ct, buf);
+        BenchCheck("FIPS-197 C decrypt", hw, memcmp(buf, pt, 16) == 0);
+    }
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t *)"abc", 3);
+    mbedtls_sha256_finish_ret(&sha, buf);
+    BenchCheck("SHA-256 abc", hw, BenchEqualHex(buf, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t *)"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56);
+    mbedtls_sha256_finish_ret(&sha, buf);
+    BenchCheck("SHA-256 two blocks", hw, BenchEqualHex(buf, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+    mbedtls_sha256_starts_ret(&sha, 1);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t *)"abc", 3);
+    mbedtls_sha256_finish_ret(&sha, buf);
+    BenchCheck("SHA-224 abc", hw, BenchEqualHex(buf, "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7"));
+    mbedtls_sha256_free(&sha);
+
+    // GCM test case 3
+    BenchHex("feffe9928665731c6d6a8f9467308308", key);
+    BenchHex("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+             "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255", pt);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    BenchGcm(&aes, (const uint8_t *)"\xca\xfe\xba\xbe\xfa\xce\xdb\xad\xde\xca\xf8\x88", NULL, 0, pt, ct, 64, tag);
+    BenchCheck("GCM test case 3", hw, BenchEqualHex(ct, "42831ec2217774244b7221b784d0d49c") &&
+                                      BenchEqualHex(tag, "4d5c2af327cd64a62cf35abd2ba6fab4"));
+
+    // RFC 3610 packet vector 1, both CBC-MAC forms
+    BenchHex("c0c1c2c3c4c5c6c7c8c9cacbcccdcecf", key);
+    BenchHex("00000003020100a0a1a2a3a4a5", buf);
+    for (int i = 0; i < 31; i++)
+        pt[i] = (uint8_t)i;
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    for (int batched = 0; batched < 2; batched++)
+    {
+        BenchCcm(&aes, batched, buf, 13, pt, 8, pt + 8, ct, 23, tag, 8);
+        BenchCheck("RFC 3610 packet 1", hw, BenchEqualHex(ct, "588c979a61c663d2f066d0c2c0f989806d5f6b61dac384") &&
+                                            BenchEqualHex(tag, "17e8d12cfdf926e0"));
+    }
+
+    mbedtls_aes_free(&aes);
+}
+
+/* Engine against software ------------------------------------------------- */
+
+static void BenchSha(int hw, const uint8_t *msg, size_t len, uint32_t splitSeed, int is224, uint8_t out[32])
+{
+    mbedtls_sha256_context sha;
+    size_t off = 0, n;
+    uint32_t s = splitSeed;
+
+    mbedtls_l2c_set_hw(hw);
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, is224);
+    while (off < len)
+    {
+        s = s * 1103515245 + 12345;
+        n = (s >> 8) % 100;
+        n = (n > len - off) ? len - off : n;
+        mbedtls_sha256_update_ret(&sha, msg + off, n);
+        off += n;
+    }
+    memset(out, 0, 32);
+    mbedtls_sha256_finish_ret(&sha, out);
+    mbedtls_sha256_free(&sha);
+}
+
+static void BenchCbc(int hw, const uint8_t *key, unsigned int bits, int mode, const uint8_t iv[16],
+                     const uint8_t *in, uint8_t *out, size_t len, uint8_t ivOut[16])
+{
+    mbedtls_aes_context aes;
+
+    mbedtls_l2c_set_hw(hw);
+    mbedtls_aes_init(&aes);
+    if (mode == MBEDTLS_AES_ENCRYPT)
+        mbedtls_aes_setkey_enc(&aes, key, bits);
+    else
+        mbedtls_aes_setkey_dec(&aes, key, bits);
+    memcpy(ivOut, iv, 16);
+    mbedtls_aes_crypt_cbc(&aes, mode, len, ivOut, in, out);
+    mbedtls_aes_free(&aes);
+}
+
+static void BenchCrossChecks(void)
+{
+    static uint8_t msg[2048], a[2048], b[2048], c[2048];
+    uint8_t key[32], iv[16], ivA[16], ivB[16], ivC[16];
+    uint8_t da[32], db[32], dc[32], dh[32], fc[32], fh[32];
+    mbedtls_aes_context aes;
+    mbedtls_sha256_context x, y, fork;
+    size_t len, off;
+    unsigned int bits;
+    const HT_MockL2cCounters *mock = HT_MockL2c_Counters();
+    mbedtls_l2c_stats *stats = mbedtls_l2c_get_stats();
+    uint32_t calls;
+
+    for (int run = 0; run < BENCH_RANDOM_RUNS; run++)
+    {
+        BenchFill(key, 32);
+        BenchFill(iv, 16);
+        bits = 128 + 64 * (BenchRand() % 3);
+        len = 16 * (1 + BenchRand() % 100);
+        BenchFill(msg, len);
+
+        BenchCbc(0, key, bits, MBEDTLS_AES_ENCRYPT, iv, msg, a, len, ivA);
+        BenchCbc(1, key, bits, MBEDTLS_AES_ENCRYPT, iv, msg, b, len, ivB);
+        BenchCheck("CBC encrypt, engine against software", 1, memcmp(a, b, len) == 0 && memcmp(ivA, ivB, 16) == 0);
+        BenchCbc(1, key, bits, MBEDTLS_AES_DECRYPT, iv, b, c, len, ivC);
+        BenchCheck("CBC decrypt round trip", 1, memcmp(c, msg, len) == 0 && memcmp(ivC, ivA, 16) == 0);
+
+        // Byte-oriented modes, ragged lengths
+        len = 1 + BenchRand() % 600;
+        for (int hw = 0; hw < 2; hw++)
+        {
+            uint8_t *out = hw ? b : a;
+            uint8_t nonce[16], stream[16];
+            size_t ivOff = 0;
+
+            mbedtls_l2c_set_hw(hw);
+            mbedtls_aes_init(&aes);
+            mbedtls_aes_setkey_enc(&aes, key, bits);
+            memcpy(nonce, iv, 16);
+            mbedtls_aes_crypt_cfb128(&aes, MBEDTLS_AES_ENCRYPT, len, &ivOff, nonce, msg, out);
+            ivOff = 0;
+            memcpy(nonce, iv, 16);
+            mbedtls_aes_crypt_ctr(&aes, len, &ivOff, nonce, stream, out + len, out + len);
+            mbedtls_aes_free(&aes);
+        }
+        BenchCheck("CFB128 and CTR, engine against software", 1, memcmp(a, b, 2 * len) == 0);
+
+        len = BenchRand() % 700;
+        BenchFill(msg, len);
+        BenchSha(0, msg, len, (uint32_t)run, run & 1, da);
+        BenchSha(1, msg, len, (uint32_t)run, run & 1, db);
+        BenchCheck("SHA-256 random splits, engine against software", 1, memcmp(da, db, 32) == 0);
+    }
+
+    // Two interleaved contexts and a fork of one, staged and demoted
+    BenchFill(msg, sizeof(msg));
+    for (len = 32; len <= 512; len *= 2)
+    {
+        BenchSha(0, msg, len, 0, 0, da);
+        BenchSha(0, msg, len / 2 + 16, 0, 0, dh);
+        BenchSha(0, msg + 1000, len + 7, 0, 0, dc);
+
+        mbedtls_l2c_set_hw(1);
+        mbedtls_sha256_init(&x);
+        mbedtls_sha256_init(&y);
+        mbedtls_sha256_starts_ret(&x, 0);
+        mbedtls_sha256_starts_ret(&y, 0);
+        for (off = 0; off < len; off += 16)
+        {
+            mbedtls_sha256_update_ret(&x, msg + off, 16);
+            mbedtls_sha256_update_ret(&y, msg + 1000 + off, 16);
+            if (off == len / 2)
+            {
+                mbedtls_sha256_clone(&fork, &x);
+                mbedtls_sha256_finish_ret(&fork, fh);
+            }
+        }
+        mbedtls_sha256_update_ret(&y, msg + 1000 + len, 7);
+        mbedtls_sha256_finish_ret(&x, db);
+        mbedtls_sha256_finish_ret(&y, fc);
+        BenchCheck("interleaved and cloned SHA-256 contexts", 1,
+                   memcmp(da, db, 32) == 0 && memcmp(dh, fh, 32) == 0 && memcmp(dc, fc, 32) == 0);
+    }
+
+    // Engine held by another user: software, same answers
+    BenchSha(0, msg, 100, 5, 0, da);
+    BenchCbc(0, key, 128, MBEDTLS_AES_ENCRYPT, iv, msg, a, 512, ivA);
+    mbedtls_l2c_set_hw(1);
+    BenchCheck("engine acquire", 1, mbedtls_l2c_acquire());
+    calls = mock->aesCalls + mock->shaCalls;
+    mbedtls_l2c_reset_stats();
+    BenchSha(1, msg, 100, 5, 0, db);
+    BenchCbc(1, key, 128, MBEDTLS_AES_ENCRYPT, iv, msg, b, 512, ivB);
+    mbedtls_l2c_release();
+    BenchCheck("engine taken: software fallback", 1, memcmp(da, db, 32) == 0 && memcmp(a, b, 512) == 0 &&
+               mock->aesCalls + mock->shaCalls == calls && stats->busy == 2);
+
+    // Engine call failing on the second chunk: software goes on from there
+    mbedtls_l2c_reset_stats();
+    HT_MockL2c_FailAfter(1);
+    BenchCbc(1, key, 128, MBEDTLS_AES_ENCRYPT, iv, msg, b, 512, ivB);
+    BenchCheck("engine error part way", 1, memcmp(a, b, 512) == 0 && memcmp(ivA, ivB, 16) == 0 &&
+               stats->errors == 1 && stats->aes_hw_bytes == MBEDTLS_L2C_CHUNK);
+    HT_MockL2c_FailAfter(0);
+    BenchSha(1, msg, 100, 5, 0, db);
+    BenchCheck("engine error in SHA session", 1, memcmp(da, db, 32) == 0 && stats->errors == 2);
+}
+
+/* Workloads --------------------------------------------------------------- */
+
+typedef struct {
+    mbedtls_l2c_stats stats;
+    HT_MockL2cCounters mock;
+} BenchCost;
+
+static double BenchModelMs(const BenchModel *m, const BenchCost *c)
+{
+    double cycles = c->stats.aes_sw_blocks * m->aesSw + c->stats.sha_sw_blocks * m->shaSw +
+                    (c->mock.aesCalls + c->stats.sha_hw) * m->call +
+                    c->mock.aesBlocks * m->aesHw + c->mock.shaBlocks * m->shaHw;
+
+    return cycles / (m->mhz * 1000.0);
+}
+
+static void BenchWorkload(const BenchModel *m, const char *name, int what, size_t record, uint32_t records)
+{
+    static uint8_t in[BENCH_RECORD_MAX], out[2][BENCH_RECORD_MAX];
+    uint8_t key[16], nonce[12], aad[13], tag[2][16], digest[2][32];
+    mbedtls_aes_context aes;
+    BenchCost cost[2];
+    double ms[2];
+
+    BenchFill(key, sizeof(key));
+    BenchFill(in, record);
+
+    for (int hw = 0; hw < 2; hw++)
+    {
+        mbedtls_l2c_set_hw(hw);
+        mbedtls_l2c_reset_stats();
+        HT_MockL2c_Reset();
+        seed = 7;
+
+        mbedtls_aes_init(&aes);
+        mbedtls_aes_setkey_enc(&aes, key, 128);
+        for (uint32_t r = 0; r < records; r++)
+        {
+            memset(nonce, 0, sizeof(nonce));
+            nonce[11] = (uint8_t)r;
+            memset(aad, 0x17, sizeof(aad));
+            if (what == 0)
+                BenchGcm(&aes, nonce, aad, sizeof(aad), in, out[hw], record, tag[hw]);
+            else if (what == 1 || what == 2)
+                BenchCcm(&aes, what == 2, nonce, sizeof(nonce), aad, sizeof(aad), in, out[hw], record, tag[hw], 8);
+            else
+                BenchHandshake(digest[hw]);
+        }
+        mbedtls_aes_free(&aes);
+
+        cost[hw].stats = *mbedtls_l2c_get_stats();
+        cost[hw].mock = *HT_MockL2c_Counters();
+        ms[hw] = BenchModelMs(m, &cost[hw]) / records;
+    }
+
+    if (what < 3)
+        BenchCheck(name, 1, memcmp(out[0], out[1], record) == 0 && memcmp(tag[0], tag[1], 8) == 0);
+    else
+        BenchCheck(name, 1, memcmp(digest[0], digest[1], 32) == 0);
+
+    printf("%-16s %9.3f %9.3f %6.2fx %8.1f %7.1f",
+           name, ms[0], ms[1], ms[0] / ms[1],
+           (double)cost[1].mock.aesCalls / records, (double)cost[1].mock.shaCalls / records);
+    if (what < 3)
+        printf(" %8.1f kB/s\n", record / ms[1] * 1000.0 / 1024.0);
+    else
+        printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    BenchModel model = { 204.8, 3000, 40, 500, 2600, 60 };
+    size_t record = 1024;
+    uint32_t records = 32;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:x:f:A:a:c:S:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': record = (size_t)atoi(optarg); break;
+            case 'n': records = (uint32_t)atoi(optarg); break;
+            case 'x': seed = (uint32_t)atoi(optarg); break;
+            case 'f': model.mhz = atof(optarg); break;
+            case 'A': model.aesSw = atof(optarg); break;
+            case 'a': model.aesHw = atof(optarg); break;
+            case 'c': model.call = atof(optarg); break;
+            case 'S': model.shaSw = atof(optarg); break;
+            case 's': model.shaHw = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r record_bytes] [-n records] [-x seed] [-f cpu_mhz]\n"
+                                "       [-A aes_sw_cycles] [-a aes_hw_cycles] [-c call_cycles]\n"
+                                "       [-S sha_sw_cycles] [-s sha_hw_cycles]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (record == 0 || record > BENCH_RECORD_MAX || records == 0)
+    {
+        fprintf(stderr, "record must be 1..%u bytes, records at least 1\n", BENCH_RECORD_MAX);
+        return 2;
+    }
+
+    for (int hw = 0; hw < 2; hw++)
+        BenchKnownAnswers(hw);
+    BenchCrossChecks();
+
+    printf("model            %.1f MHz, AES block %.0f/%.0f, SHA block %.0f/%.0f, engine call %.0f cycles (sw/hw)\n",
+           model.mhz, model.aesSw, model.aesHw, model.shaSw, model.shaHw, model.call);
+    printf("%-16s %9s %9s %7s %8s %7s\n", "per record", "sw ms", "hw ms", "gain", "aes/rec", "sha/rec");
+    BenchWorkload(&model, "gcm", 0, record, records);
+    BenchWorkload(&model, "ccm-8", 1, record, records);
+    BenchWorkload(&model, "ccm-8 cbc-mac", 2, record, records);
+    BenchWorkload(&model, "handshake", 3, record, 4);
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file HT_Crypto_Config.h
+ * @brief mbedtls configuration of the host crypto bench: the L2C AES and
+ *        SHA-256 modules with every cipher mode they implement.
+ */
+
+#ifndef __HT_CRYPTO_CONFIG_H__
+#define __HT_CRYPTO_CONFIG_H__
+
+#define MBEDTLS_AES_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_CIPHER_MODE_CFB
+#define MBEDTLS_CIPHER_MODE_CTR
+#define MBEDTLS_CIPHER_MODE_OFB
+
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_SHA256_ALT
+
+#endif /* __HT_CRYPTO_CONFIG_H__ */
@@ -0,0 +1,244 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_DHT22_Bench.c
+ * @brief Host benchmark for the DHT22 decoder.
+ *
+ * Runs the unmodified Src/HT_DHT22.c against the virtual-time GPIO mock and
+ * sweeps timing jitter for each fault scenario. For every point it reports
+ * how many reads decoded correctly, how many were rejected (per error code),
+ * how many were accepted with wrong values, the host CPU time spent inside
+ * DHT22_Read and the virtual bus time of a read.
+ *
+ * Usage: dht22_bench [-n reads] [-j max_jitter_us] [-s step_us] [-r read_cost_ns]
+ *                    [-m nominal|stretched|missing|checksum|all] [-f capture.txt] [-S seed] [-c]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "HT_DHT22.h"
+#include "HT_DHT22_Sim.h"
+#include "HT_Mock_Gpio.h"
+
+#define BENCH_ERR_SLOTS  6   // DHT22_OK .. DHT22_ERROR_CHECKSUM
+
+typedef struct {
+    const char *name;
+    void (*apply)(HT_DhtSimProfile *profile);
+} BenchScenario;
+
+typedef struct {
+    uint32_t ok;
+    uint32_t wrong;
+    uint32_t err[BENCH_ERR_SLOTS];
+    uint64_t cpuNs;
+    uint64_t busNs;
+} BenchResult;
+
+static void BenchNominal(HT_DhtSimProfile *p)   { (void)p; }
+static void BenchStretched(HT_DhtSimProfile *p) { p->response_low_us = 120; }
+static void BenchMissing(HT_DhtSimProfile *p)   { p->missing_pulses = 1; }
+static void BenchChecksum(HT_DhtSimProfile *p)  { p->bad_checksum = 1; }
+
+static const BenchScenario scenarios[] = {
+    { "nominal",   BenchNominal   },
+    { "stretched", BenchStretched },
+    { "missing",   BenchMissing   },
+    { "checksum",  BenchChecksum  },
+};
+
+static uint64_t BenchCpuNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Plays one train into DHT22_Read and classifies the outcome.
+ * @param expected Frame the train encodes, or NULL when the values are unknown (captures).
+ */
+static void BenchRunOne(const HT_SimTrain *train, const uint8_t *expected,
+                        uint32_t readCostNs, BenchResult *res)
+{
+    float temp = 0.0f, humi = 0.0f;
+    uint64_t t0;
+    int ret;
+
+    HT_MockGpio_Reset(readCostNs);
+    HT_MockGpio_Arm(train);
+
+    t0 = BenchCpuNs();
+    ret = DHT22_Read(&temp, &humi);
+    res->cpuNs += BenchCpuNs() - t0;
+    res->busNs += HT_MockGpio_NowNs();
+
+    if (!HT_MockGpio_SchedulerBalanced())
+    {
+        fprintf(stderr, "DHT22_Read left the scheduler suspended\n");
+        exit(2);
+    }
+
+    if (ret != DHT22_OK)
+    {
+        if (-ret < BENCH_ERR_SLOTS)
+            res->err[-ret]++;
+        return;
+    }
+
+    if (expected != NULL)
+    {
+        int16_t h = (int16_t)(humi * 10.0f + (humi >= 0 ? 0.5f : -0.5f));
+        int16_t t = (int16_t)(temp * 10.0f + (temp >= 0 ? 0.5f : -0.5f));
+        uint16_t rawT = ((uint16_t)(expected[2] & 0x7F) << 8) | expected[3];
+        int16_t expT = (expected[2] & 0x80) ? -(int16_t)rawT : (int16_t)rawT;
+        int16_t expH = (int16_t)(((uint16_t)expected[0] << 8) | expected[1]);
+
+        if (h != expH || t != expT)
+        {
+            res->wrong++;
+            return;
+        }
+    }
+
+    res->ok++;
+}
+
+static void BenchPrintHeader(int csv)
+{
+    if (csv)
+        printf("scenario,jitter_us,reads,ok_pct,rejected_pct,wrong_pct,e_start,e_low,e_high,e_data,e_checksum,cpu_ns_per_read,bus_us_per_read\n");
+    else
+        printf("%-10s %6s %6s %7s %7s %7s %6s %6s %6s %6s %6s %10s %9s\n",
+               "scenario", "jit_us", "reads", "ok%", "rej%", "wrong%",
+               "start", "low", "high", "data", "csum", "cpu_ns/rd", "bus_us/rd");
+}
+
+static void BenchPrintRow(int csv, const char *name, double jitterUs, uint32_t n, const BenchResult *r)
+{
+    uint32_t rejected = 0;
+
+    for (int i = 1; i < BENCH_ERR_SLOTS; i++)
+        rejected += r->err[i];
+
+    printf(csv ? "%s,%.1f,%u,%.2f,%.2f,%.2f,%u,%u,%u,%u,%u,%.0f,%.1f\n"
+               : "%-10s %6.1f %6u %7.2f %7.2f %7.2f %6u %6u %6u %6u %6u %10.0f %9.1f\n",
+           name, jitterUs, n,
+           100.0 * r->ok / n, 100.0 * rejected / n, 100.0 * r->wrong / n,
+           r->err[1], r->err[2], r->err[3], r->err[4], r->err[5],
+           (double)r->cpuNs / n, (double)r->busNs / n / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t reads = 1000, maxJitterUs = 20, stepUs = 2, readCostNs = 250, seed = 1;
+    const char *mode = "all", *capture = NULL;
+    int csv = 0, opt;
+    static HT_SimTrain train;
+
+    while ((opt = getopt(argc, argv, "n:j:s:r:m:f:S:c")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': reads = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'j': maxJitterUs = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': stepUs = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': readCostNs = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'm': mode = optarg; break;
+            case 'f': capture = optarg; break;
+            case 'S': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': csv = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n reads] [-j max_jitter_us] [-s step_us] [-r read_cost_ns]\n"
+                                "       [-m nominal|stretched|missing|checksum|all] [-f capture.txt] [-S seed] [-c]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (reads == 0 || stepUs == 0)
+        return 1;
+
+    // Boot calibration of the poll loop against the virtual clock.
+    HT_MockGpio_Reset(readCostNs);
+    DHT22_Calibrate();
+
+    if (!csv)
+        printf("DHT22 decoder bench: timeouts start=%d pulse=%d data=%d us, read cost %u ns, loop %lu.%02lu/us\n\n",
+               DHT22_TIMEOUT_RESPONSE_START, DHT22_TIMEOUT_RESPONSE_PULSE, DHT22_TIMEOUT_DATA_PULSE, readCostNs,
+               (unsigned long)(DHT22_LoopsPerUsQ8() >> 8), (unsigned long)(((DHT22_LoopsPerUsQ8() & 0xFF) * 100) >> 8));
+    BenchPrintHeader(csv);
+
+    if (capture != NULL)
+    {
+        HT_SimTrain recorded;
+
+        if (HT_DhtSim_Load(&recorded, capture) <= 0)
+        {
+            fprintf(stderr, "cannot load capture %s\n", capture);
+            return 1;
+        }
+
+        for (uint32_t j = 0; j <= maxJitterUs; j += stepUs)
+        {
+            BenchResult res;
+
+            memset(&res, 0, sizeof(res));
+            for (uint32_t i = 0; i < reads; i++)
+            {
+                train = recorded;
+                HT_DhtSim_AddJitter(&train, j * 1000u, &seed);
+                BenchRunOne(&train, NULL, readCostNs, &res);
+            }
+            BenchPrintRow(csv, "capture", j, reads, &res);
+        }
+        return 0;
+    }
+
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++)
+    {
+        if (strcmp(mode, "all") != 0 && strcmp(mode, scenarios[s].name) != 0)
+            continue;
+
+        for (uint32_t j = 0; j <= maxJitterUs; j += stepUs)
+        {
+            BenchResult res;
+            HT_DhtSimProfile profile;
+
+            HT_DhtSim_DefaultProfile(&profile);
+            scenarios[s].apply(&profile);
+            profile.jitter_ns = j * 1000u;
+
+            memset(&res, 0, sizeof(res));
+            for (uint32_t i = 0; i < reads; i++)
+            {
+                uint8_t frame[5];
+                uint16_t humi = (uint16_t)(HT_DhtSim_Rand(&seed) % 1001u);
+                int16_t temp = (int16_t)(HT_DhtSim_Rand(&seed) % 1201u) - 400;
+
+                HT_DhtSim_Encode(frame, humi, temp);
+                HT_DhtSim_Synthesize(&train, frame, &profile, &seed);
+                BenchRunOne(&train, frame, readCostNs, &res);
+            }
+            BenchPrintRow(csv, scenarios[s].name, j, reads, &res);
+        }
+    }
+
+    return 0;
+}
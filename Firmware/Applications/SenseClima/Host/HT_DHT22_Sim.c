@@ -0,0 +1,181 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HT_DHT22_Sim.h"
+
+// Sensor releases the line after the last bit with a short low trailer.
+#define DHT_SIM_TRAILER_LOW_US  50
+
+uint32_t HT_DhtSim_Rand(uint32_t *seed)
+{
+    uint32_t x = *seed ? *seed : 0x2545F491u;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+
+    return x;
+}
+
+void HT_DhtSim_DefaultProfile(HT_DhtSimProfile *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+    profile->response_delay_us = 30;
+    profile->response_low_us = 80;
+    profile->response_high_us = 80;
+    profile->bit_low_us = 50;
+    profile->bit0_high_us = 26;
+    profile->bit1_high_us = 70;
+}
+
+void HT_DhtSim_Encode(uint8_t frame[5], uint16_t humi_x10, int16_t temp_x10)
+{
+    uint16_t t = (temp_x10 < 0) ? (uint16_t)(-temp_x10) | 0x8000u : (uint16_t)temp_x10;
+
+    frame[0] = (uint8_t)(humi_x10 >> 8);
+    frame[1] = (uint8_t)humi_x10;
+    frame[2] = (uint8_t)(t >> 8);
+    frame[3] = (uint8_t)t;
+    frame[4] = (uint8_t)(frame[0] + frame[1] + frame[2] + frame[3]);
+}
+
+static void HT_DhtSim_Push(HT_SimTrain *train, uint8_t level, uint32_t us)
+{
+    if (train->count >= HT_SIM_MAX_SEGMENTS)
+        return;
+
+    train->seg[train->count].level = level;
+    train->seg[train->count].duration_ns = us * 1000u;
+    train->count++;
+}
+
+void HT_DhtSim_AddJitter(HT_SimTrain *train, uint32_t jitter_ns, uint32_t *seed)
+{
+    if (jitter_ns == 0)
+        return;
+
+    for (uint16_t i = 0; i < train->count; i++)
+    {
+        int64_t d = (int64_t)(HT_DhtSim_Rand(seed) % (2u * jitter_ns + 1u)) - (int64_t)jitter_ns;
+        int64_t v = (int64_t)train->seg[i].duration_ns + d;
+
+        train->seg[i].duration_ns = (v < 1000) ? 1000u : (uint32_t)v;
+    }
+}
+
+/**
+ * @brief Removes one bit low pulse, merging it with the surrounding highs.
+ *
+ * Segment layout: [0] release high, [1] response low, [2] response high,
+ * then (low, high) per bit starting at index 3.
+ */
+static void HT_DhtSim_DropPulse(HT_SimTrain *train, uint32_t *seed)
+{
+    // Pick a bit low that has a high on both sides (bits 1..39).
+    uint16_t bit = 1 + (uint16_t)(HT_DhtSim_Rand(seed) % 39u);
+    uint16_t low = 3 + 2 * bit;
+
+    if (low + 1 >= train->count || train->seg[low].level != 0)
+        return;
+
+    train->seg[low - 1].duration_ns += train->seg[low].duration_ns + train->seg[low + 1].duration_ns;
+    memmove(&train->seg[low], &train->seg[low + 2], (train->count - low - 2) * sizeof(HT_SimSegment));
+    train->count -= 2;
+}
+
+void HT_DhtSim_Synthesize(HT_SimTrain *train, const uint8_t frame[5],
+                          const HT_DhtSimProfile *profile, uint32_t *seed)
+{
+    uint8_t data[5];
+
+    memcpy(data, frame, sizeof(data));
+    if (profile->bad_checksum)
+        data[4] ^= (uint8_t)(1u << (HT_DhtSim_Rand(seed) % 8u));
+
+    train->count = 0;
+    HT_DhtSim_Push(train, 1, profile->response_delay_us);
+    HT_DhtSim_Push(train, 0, profile->response_low_us);
+    HT_DhtSim_Push(train, 1, profile->response_high_us);
+
+    for (int i = 0; i < 40; i++)
+    {
+        uint8_t bit = (data[i / 8] >> (7 - (i % 8))) & 1u;
+
+        HT_DhtSim_Push(train, 0, profile->bit_low_us);
+        HT_DhtSim_Push(train, 1, bit ? profile->bit1_high_us : profile->bit0_high_us);
+    }
+
+    HT_DhtSim_Push(train, 0, DHT_SIM_TRAILER_LOW_US);
+
+    for (uint8_t i = 0; i < profile->missing_pulses; i++)
+        HT_DhtSim_DropPulse(train, seed);
+
+    HT_DhtSim_AddJitter(train, profile->jitter_ns, seed);
+}
+
+int HT_DhtSim_Load(HT_SimTrain *train, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[128];
+
+    if (f == NULL)
+        return -1;
+
+    train->count = 0;
+    while (fgets(line, sizeof(line), f) != NULL && train->count < HT_SIM_MAX_SEGMENTS)
+    {
+        char lvl;
+        double us;
+
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (sscanf(line, " %c %lf", &lvl, &us) != 2 || us <= 0.0)
+        {
+            fclose(f);
+            return -1;
+        }
+
+        train->seg[train->count].level = (lvl == '1' || lvl == 'H' || lvl == 'h') ? 1 : 0;
+        train->seg[train->count].duration_ns = (uint32_t)(us * 1000.0 + 0.5);
+        train->count++;
+    }
+
+    fclose(f);
+    return train->count;
+}
+
+void HT_DhtSim_ReplayEdges(const HT_SimTrain *train,
+                           void (*onEdge)(uint8_t level, uint64_t t_ns, void *ctx), void *ctx)
+{
+    uint64_t t = 0;
+    uint8_t level = 1;
+
+    for (uint16_t i = 0; i < train->count; i++)
+    {
+        if (train->seg[i].level != level)
+        {
+            level = train->seg[i].level;
+            onEdge(level, t, ctx);
+        }
+        t += train->seg[i].duration_ns;
+    }
+
+    if (level != 1)
+        onEdge(1, t, ctx);
+}
@@ -0,0 +1,101 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_DHT22_Sim.h
+ * @brief DHT22 waveform generator for the host decoder benchmark.
+ *
+ * Builds the sensor answer (response pulse, 40 data bits, trailer) as a
+ * HT_SimTrain, optionally degraded with timing jitter, a stretched response
+ * low, missing pulses or a corrupted checksum. Recorded captures can be
+ * loaded from text files instead.
+ */
+
+#ifndef __HT_DHT22_SIM_H__
+#define __HT_DHT22_SIM_H__
+
+#include <stdint.h>
+#include "HT_Mock_Gpio.h"
+
+/**
+ * @brief Timing and fault profile of a synthesized answer (datasheet nominals by default).
+ */
+typedef struct {
+    uint32_t response_delay_us;  /**< Release edge to sensor pulling low (20..40 us). */
+    uint32_t response_low_us;    /**< Response low pulse, nominal 80 us. */
+    uint32_t response_high_us;   /**< Response high pulse, nominal 80 us. */
+    uint32_t bit_low_us;         /**< Low preamble of every bit, nominal 50 us. */
+    uint32_t bit0_high_us;       /**< High time of a '0' bit, nominal 26 us. */
+    uint32_t bit1_high_us;       /**< High time of a '1' bit, nominal 70 us. */
+    uint32_t jitter_ns;          /**< Uniform +/- jitter added to every segment. */
+    uint8_t  missing_pulses;     /**< Bit low pulses dropped (two edges each). */
+    uint8_t  bad_checksum;       /**< Non-zero corrupts the checksum byte. */
+} HT_DhtSimProfile;
+
+/**
+ * @brief Fills a profile with the datasheet nominal timings and no faults.
+ */
+void HT_DhtSim_DefaultProfile(HT_DhtSimProfile *profile);
+
+/**
+ * @brief Encodes humidity and temperature (both x10) into a 5-byte DHT22 frame.
+ */
+void HT_DhtSim_Encode(uint8_t frame[5], uint16_t humi_x10, int16_t temp_x10);
+
+/**
+ * @brief Synthesizes the pulse train answering with @p frame.
+ * @param train Output train.
+ * @param frame 5-byte frame (checksum included).
+ * @param profile Timing/fault profile.
+ * @param seed PRNG state, advanced on every call.
+ */
+void HT_DhtSim_Synthesize(HT_SimTrain *train, const uint8_t frame[5],
+                          const HT_DhtSimProfile *profile, uint32_t *seed);
+
+/**
+ * @brief Adds uniform +/- jitter to every segment of an existing train.
+ */
+void HT_DhtSim_AddJitter(HT_SimTrain *train, uint32_t jitter_ns, uint32_t *seed);
+
+/**
+ * @brief Loads a recorded train from a text file.
+ *
+ * One segment per line: "<level> <duration_us>", level 0/1 or L/H, duration
+ * may be fractional. Lines starting with '#' are ignored. Time zero is the
+ * host release edge.
+ *
+ * @return Number of segments loaded, or -1 on error.
+ */
+int HT_DhtSim_Load(HT_SimTrain *train, const char *path);
+
+/**
+ * @brief Replays a train as edge events, as a pad interrupt would see them.
+ *
+ * Intended for edge-timestamp (interrupt-driven) decoders, which consume
+ * the same waveform without the polling mock.
+ *
+ * @param train Train to replay.
+ * @param onEdge Called per edge with the new level and its time in ns since release.
+ * @param ctx User context passed to @p onEdge.
+ */
+void HT_DhtSim_ReplayEdges(const HT_SimTrain *train,
+                           void (*onEdge)(uint8_t level, uint64_t t_ns, void *ctx), void *ctx);
+
+/**
+ * @brief xorshift32 step used by the generator; exposed so the bench shares the stream.
+ */
+uint32_t HT_DhtSim_Rand(uint32_t *seed);
+
+#endif /* __HT_DHT22_SIM_H__ */
@@ -0,0 +1,155 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_LogStore_Bench.c
+ * @brief Host check of the post-mortem log ring across boots and crashes.
+ *
+ * Every boot runs in a forked process over a shared flash image, logs a
+ * burst of frames (one warning in ten) and either flushes before "sleep" or,
+ * every crash-th boot, dies in the middle of a page program. A last boot
+ * then reads the upload and checks that it is made of whole frames, in
+ * order, ending with the newest frame of the last clean boot. Flash traffic
+ * per logged frame is reported.
+ *
+ * Usage: logstore_bench [-b boots] [-n frames_per_boot] [-c crash_every]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "HT_Log.h"
+#include "HT_LogStore.h"
+#include "cmsis_os2.h"
+#include "flash_qcx212_rt.h"
+
+#define BENCH_ID        1       /**< Any ID: the bench checks structure, not text. */
+
+static void BenchBoot(uint32_t boot, uint32_t frames, uint8_t crash)
+{
+    uint8_t level;
+
+    HT_MockOs_SetTick(0);
+    HT_Log_Init();
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        HT_MockOs_SetTick(i * 10);
+        level = (i % 10 == 9) ? HT_LOG_LEVEL_WARNING : HT_LOG_LEVEL_INFO;
+
+        // Reset half way through the page program of this warning
+        if (crash && i == 19)
+            HT_MockFlash_TearNextWrite(5);
+
+        HT_Log_Write(level, BENCH_ID, NULL, 0, 2, boot, i);
+    }
+
+    HT_LogStore_Flush();
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t upload[HT_LOGSTORE_UPLOAD_MAX];
+    uint32_t boots = 40, frames = 30, crashEvery = 7;
+    uint32_t lastBoot = 0, lastFrame = 0, uploadFrames = 0, versions = 0;
+    uint32_t prevKey = 0, boot, frame, logged = 0, crashes = 0;
+    size_t len, off = 0, flen;
+    int opt, ok = 1, status;
+    pid_t pid;
+
+    while ((opt = getopt(argc, argv, "b:n:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': boots = (uint32_t)atoi(optarg); break;
+            case 'n': frames = (uint32_t)atoi(optarg); break;
+            case 'c': crashEvery = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-b boots] [-n frames_per_boot] [-c crash_every]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    HT_MockFlash_Init();
+
+    for (boot = 1; boot <= boots; boot++)
+    {
+        uint8_t crash = crashEvery && boot % crashEvery == 0 && boot != boots && frames >= 20;
+
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0)
+        {
+            BenchBoot(boot, frames, crash);
+            _exit(0);
+        }
+        waitpid(pid, &status, 0);
+
+        crashes += crash;
+        logged += frames + 1;
+        if (!crash)
+        {
+            lastBoot = boot;
+            lastFrame = frames - 1;
+        }
+    }
+
+    // The boot that serves the upload request
+    HT_Log_Init();
+    len = HT_LogStore_Read(upload, sizeof(upload));
+
+    while (off < len)
+    {
+        flen = HT_Log_FrameLength(upload + off, len - off);
+        if (flen == 0)
+        {
+            printf("FAIL: bad frame at %zu of %zu\n", off, len);
+            return 1;
+        }
+
+        uploadFrames++;
+        if ((upload[off + 1] | upload[off + 2] << 8) == HT_LOG_ID_VERSION)
+        {
+            versions++;
+        }
+        else
+        {
+            memcpy(&boot, upload + off + 8, 4);
+            memcpy(&frame, upload + off + 12, 4);
+            if ((boot << 16 | frame) <= prevKey)
+                ok = 0;
+            prevKey = boot << 16 | frame;
+        }
+        off += flen;
+    }
+
+    if (prevKey != (lastBoot << 16 | lastFrame))
+        ok = 0;
+
+    printf("boots        %8u (%u crashed mid-program)\n", boots, crashes);
+    printf("frames       %8u logged, %u bytes each\n", logged, 8 + 4 * 2 + 1);
+    printf("programs     %8u (%.2f per frame, %u bytes)\n", HT_MockFlash_Counters()->writes,
+           (double)HT_MockFlash_Counters()->writes / logged, HT_MockFlash_Counters()->writeBytes);
+    printf("erases       %8u\n", HT_MockFlash_Counters()->erases);
+    printf("upload       %8zu bytes, %u frames (%u boot markers), newest %u/%u\n",
+           len, uploadFrames, versions, (unsigned)(prevKey >> 16), (unsigned)(prevKey & 0xFFFF));
+    printf("%s\n", ok ? "OK" : "FAIL: upload out of order or missing the newest frame");
+
+    return ok ? 0 : 1;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,235 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_Sampler_Bench.c
+ * @brief Host comparison of the adaptive sampler against fixed intervals.
+ *
+ * Replays a one-day temperature/humidity trace (synthesized, or loaded from
+ * a "t_s,temp_x10,humi_x10" CSV) through HT_Sampler_Step. For the adaptive
+ * controller and a set of fixed periods it reports wakes per day, energy per
+ * day for a given energy per wake, and the reconstruction error obtained by
+ * linearly interpolating the samples against the full-rate trace.
+ *
+ * The controller settings default to HT_Config_Defaults and can be overridden
+ * to tune them: -m/-x min/max period (s), -t/-u temperature/humidity
+ * tolerance (0.1 units), -w EW shift.
+ *
+ * Usage: sampler_bench [-f trace.csv] [-e mJ_per_wake] [-m s] [-x s] [-t tol] [-u tol] [-w shift] [-S seed] [-c]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "HT_Sampler.h"
+#include "HT_Retained.h"
+
+#define BENCH_DAY_S     86400
+
+static int16_t traceTemp[BENCH_DAY_S];
+static uint16_t traceHumi[BENCH_DAY_S];
+static uint32_t traceLen;
+
+static double BenchNoise(uint32_t *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return ((double)((*seed >> 8) & 0xFFFF) / 65535.0) - 0.5;
+}
+
+/**
+ * @brief Quiet night, HVAC cycling during office hours, slow diurnal drift.
+ *
+ * HVAC transients are first-order responses with a cycle that is not a
+ * multiple of the fixed periods, so no fixed period lines up with them.
+ */
+static void BenchSynthesize(uint32_t seed)
+{
+    for (uint32_t t = 0; t < BENCH_DAY_S; t++)
+    {
+        double hour = t / 3600.0;
+        double temp = 22.0 + 1.5 * sin((hour - 9.0) * M_PI / 12.0);
+        double humi = 55.0 - 4.0 * sin((hour - 9.0) * M_PI / 12.0);
+
+        if (t >= 8 * 3600 && t < 8 * 3600 + 16 * 2220)
+        {
+            // 16 cycles of 37 min from 08:00: first-order pull-down by up to 2 C, then first-order recovery.
+            double phase = fmod(t - 8.0 * 3600.0, 2220.0);
+            double drop = (phase < 720.0) ? 2.0 * (1.0 - exp(-phase / 240.0))
+                                          : 2.0 * (1.0 - exp(-3.0)) * exp(-(phase - 720.0) / 400.0);
+
+            temp -= drop;
+            humi -= 3.0 * drop;
+        }
+
+        temp += 0.04 * BenchNoise(&seed);
+        humi += 0.3 * BenchNoise(&seed);
+        traceTemp[t] = (int16_t)lround(temp * 10.0);
+        traceHumi[t] = (uint16_t)lround(humi * 10.0);
+    }
+    traceLen = BENCH_DAY_S;
+}
+
+static int BenchLoad(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[96];
+    long lastT = -1;
+    int lastTemp = 0, lastHumi = 0;
+
+    if (f == NULL)
+        return -1;
+
+    traceLen = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        long ts;
+        int temp, humi;
+
+        if (sscanf(line, "%ld,%d,%d", &ts, &temp, &humi) != 3 || ts < 0 || ts >= BENCH_DAY_S)
+            continue;
+
+        // Sample-and-hold up to the new point, so sparse logs are accepted.
+        for (long t = lastT + 1; t < ts; t++)
+        {
+            traceTemp[t] = (int16_t)lastTemp;
+            traceHumi[t] = (uint16_t)lastHumi;
+        }
+        traceTemp[ts] = (int16_t)temp;
+        traceHumi[ts] = (uint16_t)humi;
+        lastT = ts;
+        lastTemp = temp;
+        lastHumi = humi;
+        traceLen = (uint32_t)ts + 1;
+    }
+
+    fclose(f);
+    return traceLen > 1 ? 0 : -1;
+}
+
+typedef struct {
+    uint32_t wakes;
+    double tempRms;
+    double tempMax;
+    double humiRms;
+} BenchResult;
+
+static void BenchRun(const HT_ConfigData *cfg, BenchResult *res)
+{
+    HT_SamplerState st;
+    uint32_t t = 0, prevT = 0;
+    double tErr2 = 0.0, hErr2 = 0.0, tMax = 0.0;
+    int first = 1;
+
+    HT_Sampler_Reset(&st, cfg);
+    memset(res, 0, sizeof(*res));
+
+    while (t < traceLen)
+    {
+        uint32_t period = HT_Sampler_Step(&st, cfg, t, traceTemp[t], traceHumi[t]);
+
+        res->wakes++;
+        if (!first)
+        {
+            // Linear interpolation between the two samples vs the real trace.
+            for (uint32_t u = prevT; u < t; u++)
+            {
+                double a = (double)(u - prevT) / (double)(t - prevT);
+                double te = traceTemp[prevT] + a * (traceTemp[t] - traceTemp[prevT]) - traceTemp[u];
+                double he = traceHumi[prevT] + a * (traceHumi[t] - traceHumi[prevT]) - traceHumi[u];
+
+                tErr2 += te * te;
+                hErr2 += he * he;
+                if (fabs(te) > tMax)
+                    tMax = fabs(te);
+            }
+        }
+        first = 0;
+        prevT = t;
+        t += period;
+    }
+
+    res->tempRms = sqrt(tErr2 / prevT) / 10.0;
+    res->humiRms = sqrt(hErr2 / prevT) / 10.0;
+    res->tempMax = tMax / 10.0;
+}
+
+static void BenchPrint(int csv, const char *name, const BenchResult *r, double mJPerWake)
+{
+    double perDay = r->wakes * (86400.0 / traceLen);
+
+    printf(csv ? "%s,%.0f,%.1f,%.3f,%.3f,%.3f\n" : "%-12s %10.0f %12.1f %10.3f %10.3f %10.3f\n",
+           name, perDay, perDay * mJPerWake / 1000.0, r->tempRms, r->tempMax, r->humiRms);
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t fixedPeriods[] = { 60, 300, 900 };
+    double mJPerWake = 400.0;
+    const char *trace = NULL;
+    uint32_t seed = 1;
+    int csv = 0, opt;
+    HT_ConfigData cfg;
+    BenchResult res;
+    char name[24];
+
+    HT_Config_Defaults(&cfg);
+
+    while ((opt = getopt(argc, argv, "f:e:m:x:t:u:w:S:c")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f': trace = optarg; break;
+            case 'e': mJPerWake = atof(optarg); break;
+            case 'm': cfg.min_interval_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'x': cfg.max_interval_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 't': cfg.temp_tol_x10 = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'u': cfg.humi_tol_x10 = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'w': cfg.ew_shift = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'S': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': csv = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-f trace.csv] [-e mJ_per_wake] [-m s] [-x s] [-t tol] [-u tol] [-w shift] [-S seed] [-c]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (trace != NULL ? BenchLoad(trace) != 0 : (BenchSynthesize(seed), 0))
+    {
+        fprintf(stderr, "cannot load trace %s\n", trace);
+        return 1;
+    }
+
+    if (csv)
+        printf("mode,wakes_per_day,energy_j_per_day,temp_rms_c,temp_max_c,humi_rms_pct\n");
+    else
+        printf("%-12s %10s %12s %10s %10s %10s\n", "mode", "wakes/day", "J/day", "T rms C", "T max C", "H rms %");
+
+    cfg.adaptive = 1;
+    BenchRun(&cfg, &res);
+    BenchPrint(csv, "adaptive", &res, mJPerWake);
+
+    cfg.adaptive = 0;
+    for (size_t i = 0; i < sizeof(fixedPeriods) / sizeof(fixedPeriods[0]); i++)
+    {
+        cfg.interval_s = fixedPeriods[i];
+        snprintf(name, sizeof(name), "fixed_%lu", (unsigned long)fixedPeriods[i]);
+        BenchRun(&cfg, &res);
+        BenchPrint(csv, name, &res, mJPerWake);
+    }
+
+    return 0;
+}
@@ -0,0 +1,697 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_TimeSeries_Bench.c
+ * @brief Host benchmark and check of the time-series store on a RAM littlefs
+ *        partition (HT_Mock_Lfs.h), one JSON object per line on stdout.
+ *
+ * Every mode runs in a forked process over a freshly formatted partition:
+ *  - append: n readings, ten minutes apart, beyond HT_TS_MAX_SEGMENTS
+ *    segments; time and block device traffic per append, segments evicted.
+ *  - fill: the same with another file taking fill blocks of the partition,
+ *    so that eviction keeps HT_TS_RESERVE_BLOCKS free before the segment
+ *    limit is reached.
+ *  - query: q ranges of w seconds at random places of the stored history,
+ *    then a paged walk of all of it; every record returned is checked.
+ *  - recover: b boots of k readings, each in its own process; every
+ *    crash-th boot dies after committing half of them. The device clock
+ *    restarts half way through, as after a loss of the retained state.
+ *    Then the history is checked for order and loss, the index deleted
+ *    and rebuilt, and every segment CRC verified.
+ *  - drain: b boots of k readings drained through the uplink queue to a
+ *    broker stand-in that leaves one publish in eight unacknowledged and
+ *    closes the session with it, as the MQTT client does on a missing
+ *    PUBACK, is down every third boot, and kills every crash-th boot between its
+ *    acknowledgment of a batch and the rewrite of the queue position. A
+ *    last boot drains the backlog; every reading must have arrived under
+ *    one sequence number, duplicates only from the batches of the crashes.
+ *
+ * Times are host times (_us): compare runs of the same host with
+ * Debug/Scripts/bench_compare.py. Block device traffic does not depend on
+ * the host.
+ *
+ * Usage: timeseries_bench [-n appends] [-q queries] [-w width_s] [-b boots] [-k per_boot] [-c crash_every] [-f fill_blocks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "HT_TimeSeries.h"
+#include "HT_Uplink.h"
+#include "HT_Mock_Lfs.h"
+
+#define BENCH_PERIOD_S      600     /**< Readings ten minutes apart. */
+#define BENCH_FILL_PATH     "nv_fill"
+#define BENCH_DRAIN_MAX     4096    /**< Readings of the drain mode at most. */
+#define BENCH_NACK_ONE_IN   8       /**< Publishes left unacknowledged by the broker stand-in. */
+#define BENCH_DOWN_EVERY    3       /**< Boots without a link. */
+
+/**
+ * @brief Broker stand-in of the drain mode, shared with the boots.
+ */
+typedef struct {
+    uint32_t received[BENCH_DRAIN_MAX];     // Arrivals per reading
+    uint32_t seqOf[BENCH_DRAIN_MAX];        // Sequence number plus one per reading
+    uint32_t batches;
+    uint32_t bytes;
+    uint32_t records;
+    uint32_t nacks;
+    uint32_t crashRecords;                  // Records of the batches acknowledged by a dying boot
+    uint32_t closed;                        // Publishes refused on a closed session
+    uint8_t down;
+    uint8_t connected;                      // Session of this boot, lost with a missing acknowledgment
+    uint8_t crashNext;
+    long error;
+} BenchBroker;
+
+typedef struct {
+    uint32_t appends;
+    uint32_t queries;
+    uint32_t width;
+    uint32_t boots;
+    uint32_t perBoot;
+    uint32_t crashEvery;
+    uint32_t fill;
+} BenchOptions;
+
+static double BenchNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Reading number i, recoverable from the record whatever its time.
+ */
+static void BenchRecord(HT_TsRecord *rec, uint32_t i, uint32_t clock_s)
+{
+    rec->t_s = clock_s;
+    rec->temp = (int16_t)(200 + i % 50);
+    rec->humi = (uint16_t)(i >> 16);
+    rec->vbat_mv = (uint16_t)i;
+    rec->flags = 0;
+}
+
+static uint32_t BenchIndex(const HT_TsRecord *rec)
+{
+    return (uint32_t)rec->humi << 16 | rec->vbat_mv;
+}
+
+static void BenchError(const char *mode, const char *error, long value)
+{
+    printf("{\"bench\":\"timeseries\",\"fs\":\"%s\",\"mode\":\"%s\",\"error\":\"%s\",\"ret\":%ld}\n",
+           HT_MockLfs_Name(), mode, error, value);
+}
+
+static int BenchMount(const char *mode)
+{
+    int err = LFS_Init();
+
+    if (err == 0)
+        err = HT_TimeSeries_Init();
+    if (err < 0)
+        BenchError(mode, "init", err);
+
+    return err;
+}
+
+/**
+ * @brief Takes blocks of the partition with another file, as the SDK settings do.
+ */
+static int BenchFill(uint32_t blocks)
+{
+    static uint8_t block[HT_MOCK_LFS_BLOCK_SIZE];
+    lfs_file_t file;
+    int err;
+
+    err = LFS_FileOpen(&file, BENCH_FILL_PATH, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    for (uint32_t i = 0; i < blocks && err == 0; i++)
+        if (LFS_FileWrite(&file, block, sizeof(block)) != (lfs_ssize_t)sizeof(block))
+            err = LFS_ERR_NOSPC;
+    if (LFS_FileClose(&file) < 0 && err == 0)
+        err = LFS_ERR_IO;
+
+    return err;
+}
+
+static int BenchAppend(const char *mode, const BenchOptions *opt, uint32_t fill)
+{
+    const HT_TimeSeriesStats *stats = HT_TimeSeries_Stats();
+    HT_MockLfsCounters before;
+    lfs_status_t status;
+    HT_TsRecord rec;
+    uint32_t minFree = HT_MOCK_LFS_BLOCKS;
+    double start, elapsed = 0;
+    int err;
+
+    if (BenchMount(mode) < 0)
+        return 1;
+    if (fill && (err = BenchFill(fill)) < 0)
+    {
+        BenchError(mode, "fill", err);
+        return 1;
+    }
+
+    before = *HT_MockLfs_Counters();
+    for (uint32_t i = 0; i < opt->appends; i++)
+    {
+        BenchRecord(&rec, i, i * BENCH_PERIOD_S);
+        start = BenchNow();
+        err = HT_TimeSeries_Append(&rec);
+        elapsed += BenchNow() - start;
+        if (err < 0)
+        {
+            BenchError(mode, "append", err);
+            return 1;
+        }
+        if (LFS_Statfs(&status) == 0 && status.total_block - status.block_used < minFree)
+            minFree = status.total_block - status.block_used;
+    }
+    HT_TimeSeries_Sync();
+
+    printf("{\"bench\":\"timeseries\",\"fs\":\"%s\",\"mode\":\"%s\",\"records\":%u,\"fill\":%u,"
+           "\"append_us\":%.3f,\"prog_bytes_per_record\":%.1f,\"erases_per_1000\":%.1f,\"syncs\":%u,"
+           "\"segments\":%u,\"stored\":%u,\"evicted\":%u,\"min_free_blocks\":%u}\n",
+           HT_MockLfs_Name(), mode, opt->appends, fill, elapsed / opt->appends,
+           (double)(HT_MockLfs_Counters()->progBytes - before.progBytes) / opt->appends,
+           (HT_MockLfs_Counters()->erases - before.erases) * 1000.0 / opt->appends, stats->syncs,
+           stats->segments, stats->records, stats->evicted, minFree);
+
+    if (stats->newest_s != (opt->appends - 1) * BENCH_PERIOD_S || stats->errors)
+    {
+        BenchError(mode, "newest", (long)stats->errors);
+        return 1;
+    }
+    // Beyond the segment limit or the reserve, never both short
+    if (stats->segments > HT_TS_MAX_SEGMENTS + 1 || (stats->evicted && minFree < HT_TS_RESERVE_BLOCKS &&
+        stats->segments <= HT_TS_MAX_SEGMENTS))
+    {
+        BenchError(mode, "evict", (long)minFree);
+        return 1;
+    }
+    if (HT_TimeSeries_Verify() != 0)
+    {
+        BenchError(mode, "crc", 0);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks a query result against the readings stored by BenchAppend.
+ */
+static int BenchCheck(const HT_TsRecord *out, size_t n, uint32_t from_s, uint32_t to_s, uint32_t oldest_s, uint32_t newest_s)
+{
+    uint32_t first = from_s < oldest_s ? oldest_s : from_s;
+    uint32_t last = to_s > newest_s ? newest_s : to_s;
+    size_t expected;
+
+    first = (first + BENCH_PERIOD_S - 1) / BENCH_PERIOD_S;
+    last /= BENCH_PERIOD_S;
+    expected = last >= first ? last - first + 1 : 0;
+    if (n != expected)
+        return 0;
+
+    for (size_t i = 0; i < n; i++)
+        if (BenchIndex(&out[i]) != first + i || out[i].t_s != (first + i) * BENCH_PERIOD_S)
+            return 0;
+
+    return 1;
+}
+
+static int BenchQuery(const BenchOptions *opt)
+{
+    static HT_TsRecord out[HT_TS_SEGMENT_RECORDS * 4];
+    const HT_TimeSeriesStats *stats = HT_TimeSeries_Stats();
+    uint32_t from, span, oldest, newest, reads;
+    size_t n, total = 0, max = sizeof(out) / sizeof(out[0]);
+    double start, elapsed = 0;
+
+    if (BenchMount("query") < 0)
+        return 1;
+
+    for (uint32_t i = 0; i < opt->appends; i++)
+    {
+        HT_TsRecord rec;
+
+        BenchRecord(&rec, i, i * BENCH_PERIOD_S);
+        if (HT_TimeSeries_Append(&rec) < 0)
+        {
+            BenchError("query", "append", 0);
+            return 1;
+        }
+    }
+    HT_TimeSeries_Sync();
+
+    oldest = stats->oldest_s;
+    newest = stats->newest_s;
+    span = newest - oldest;
+    srand(1);
+
+    reads = HT_MockLfs_Counters()->readBytes;
+    for (uint32_t q = 0; q < opt->queries; q++)
+    {
+        from = oldest + (uint32_t)(((uint64_t)rand() * span) / RAND_MAX);
+        start = BenchNow();
+        n = HT_TimeSeries_Query(from, from + opt->width, out, max);
+        elapsed += BenchNow() - start;
+        total += n;
+
+        if (!BenchCheck(out, n, from, from + opt->width, oldest, newest) && n < max)
+        {
+            BenchError("query", "range", (long)from);
+            return 1;
+        }
+    }
+    reads = HT_MockLfs_Counters()->readBytes - reads;
+
+    printf("{\"bench\":\"timeseries\",\"fs\":\"%s\",\"mode\":\"query\",\"queries\":%u,\"width_s\":%u,"
+           "\"query_us\":%.2f,\"records_per_query\":%.1f,\"read_bytes_per_query\":%.0f,",
+           HT_MockLfs_Name(), opt->queries, opt->width, elapsed / opt->queries, (double)total / opt->queries,
+           (double)reads / opt->queries);
+
+    // Paged walk of the whole history
+    total = 0;
+    from = oldest;
+    reads = HT_MockLfs_Counters()->readBytes;
+    start = BenchNow();
+    while ((n = HT_TimeSeries_Query(from, UINT32_MAX, out, max)) > 0)
+    {
+        if (BenchIndex(&out[0]) != oldest / BENCH_PERIOD_S + total)
+            break;
+        total += n;
+        from = out[n - 1].t_s + 1;
+    }
+    elapsed = BenchNow() - start;
+    reads = HT_MockLfs_Counters()->readBytes - reads;
+
+    printf("\"walk_us\":%.0f,\"walk_records\":%zu,\"walk_read_bytes_per_record\":%.1f}\n",
+           elapsed, total, total ? (double)reads / total : 0.0);
+
+    if (total != stats->records)
+    {
+        BenchError("query", "walk", (long)total);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void BenchBoot(const BenchOptions *opt, uint32_t boot, uint32_t clock_s, uint8_t crash)
+{
+    HT_TsRecord rec;
+
+    if (BenchMount("recover") < 0)
+        _exit(1);
+
+    for (uint32_t j = 0; j < opt->perBoot; j++)
+    {
+        BenchRecord(&rec, boot << 12 | j, clock_s + j * BENCH_PERIOD_S);
+        if (HT_TimeSeries_Append(&rec) < 0)
+            _exit(1);
+        if (crash && j == opt->perBoot / 2)
+            HT_TimeSeries_Sync();
+    }
+
+    // Power lost before the sleep that commits the rest
+    if (!crash)
+        HT_TimeSeries_Sync();
+    _exit(0);
+}
+
+static int BenchRecover(const BenchOptions *opt)
+{
+    static HT_TsRecord out[HT_TS_SEGMENT_RECORDS];
+    const HT_TimeSeriesStats *stats = HT_TimeSeries_Stats();
+    uint32_t clock_s = 0, lost = 0, crashes = 0, records, boot, from = 0, prev = 0;
+    uint32_t stored[opt->boots + 1];
+    uint8_t crashed[opt->boots + 1];
+    size_t n;
+    int status;
+    pid_t pid;
+
+    for (boot = 1; boot <= opt->boots; boot++)
+    {
+        // Retained state lost half way: the device clock starts over
+        if (boot == opt->boots / 2 + 1)
+            clock_s = 0;
+
+        crashed[boot] = opt->crashEvery && boot % opt->crashEvery == 0 && boot != opt->boots;
+        stored[boot] = 0;
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0)
+            BenchBoot(opt, boot, clock_s, crashed[boot]);
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            BenchError("recover", "boot", (long)boot);
+            return 1;
+        }
+
+        crashes += crashed[boot];
+        clock_s += opt->perBoot * BENCH_PERIOD_S + 3600;
+    }
+
+    if (BenchMount("recover") < 0)
+        return 1;
+    records = stats->records;
+
+    // Each boot a prefix of its readings, boots in order, times never decreasing
+    while ((n = HT_TimeSeries_Query(from, UINT32_MAX, out, sizeof(out) / sizeof(out[0]))) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            boot = BenchIndex(&out[i]) >> 12;
+            if (boot == 0 || boot > opt->boots || (BenchIndex(&out[i]) & 0xFFF) != stored[boot] || out[i].t_s < prev ||
+                (boot > 1 && stored[boot - 1] == 0))
+            {
+                BenchError("recover", "order", (long)BenchIndex(&out[i]));
+                return 1;
+            }
+            stored[boot]++;
+            prev = out[i].t_s;
+        }
+        from = out[n - 1].t_s + 1;
+    }
+
+    // Clean boots complete, crashed ones at least up to their commit
+    for (boot = 1; boot <= opt->boots; boot++)
+    {
+        if (stored[boot] < (crashed[boot] ? opt->perBoot / 2 + 1 : opt->perBoot))
+        {
+            BenchError("recover", "missing", (long)boot);
+            return 1;
+        }
+        lost += opt->perBoot - stored[boot];
+        records -= stored[boot];
+    }
+    if (records != 0)
+    {
+        BenchError("recover", "count", (long)records);
+        return 1;
+    }
+    records = stats->records;
+
+    // Index lost: rebuilt from the segment files
+    if (LFS_Remove(HT_TS_INDEX_PATH) < 0 || HT_TimeSeries_Init() < 0 || stats->records != records)
+    {
+        BenchError("recover", "rebuild", (long)stats->records);
+        return 1;
+    }
+    if (HT_TimeSeries_Verify() != 0)
+    {
+        BenchError("recover", "crc", 0);
+        return 1;
+    }
+
+    printf("{\"bench\":\"timeseries\",\"fs\":\"%s\",\"mode\":\"recover\",\"boots\":%u,\"crashes\":%u,"
+           "\"stored\":%u,\"lost_uncommitted\":%u,\"segments\":%u}\n",
+           HT_MockLfs_Name(), opt->boots, crashes, records, lost, stats->segments);
+
+    return 0;
+}
+
+/**
+ * @brief Publish callback of the drain mode: parses the batch, checks the
+ *        sequence numbers of the readings, acknowledges or not.
+ */
+static int BenchPublish(const uint8_t *payload, size_t len, void *ctx)
+{
+    BenchBroker *broker = ctx;
+    char text[HT_UPLINK_BATCH_MAX + 1];
+    unsigned long seq, now, t, dt;
+    unsigned humi, vbat, flags;
+    uint32_t i, n = 0;
+    int temp, used;
+    const char *p;
+
+    if (!broker->connected)
+    {
+        broker->closed++;
+        return -1;
+    }
+    if (broker->down || rand() % BENCH_NACK_ONE_IN == 0)
+    {
+        broker->nacks++;
+        broker->connected = 0;
+        return -1;
+    }
+
+    memcpy(text, payload, len);
+    text[len] = '\0';
+    if (len >= sizeof(text) || sscanf(text, "{\"seq\":%lu,\"now\":%lu,\"t\":%lu,\"r\":[%n", &seq, &now, &t, &used) != 3)
+    {
+        broker->error = 1;
+        return -1;
+    }
+
+    // Consecutive sequence numbers, times rebuilt from the deltas
+    for (p = text + used;; p += used + 1)
+    {
+        if (sscanf(p, "[%lu,%d,%u,%u,%u]%n", &dt, &temp, &humi, &vbat, &flags, &used) != 5)
+            break;
+        i = humi << 16 | vbat;
+        t += dt;
+        if (i >= BENCH_DRAIN_MAX || t != i * BENCH_PERIOD_S || (broker->seqOf[i] && broker->seqOf[i] != seq + n + 1))
+        {
+            broker->error = 2;
+            return -1;
+        }
+        broker->seqOf[i] = seq + n + 1;
+        broker->received[i]++;
+        n++;
+        if (p[used] != ',')
+            break;
+    }
+    if (n == 0 || strcmp(p + used, "]}") != 0)
+    {
+        broker->error = 3;
+        return -1;
+    }
+
+    broker->batches++;
+    broker->bytes += len;
+    broker->records += n;
+
+    // Acknowledged, then the power goes before the position is rewritten
+    if (broker->crashNext)
+    {
+        broker->crashRecords += n;
+        _exit(3);
+    }
+
+    return 0;
+}
+
+static int BenchDrainMount(void)
+{
+    int err = BenchMount("drain");
+
+    if (err == 0 && (err = HT_Uplink_Init()) < 0)
+        BenchError("drain", "uplink", err);
+
+    return err;
+}
+
+static void BenchDrainBoot(const BenchOptions *opt, BenchBroker *broker, uint32_t boot)
+{
+    HT_TsRecord rec;
+    uint32_t i;
+
+    if (BenchDrainMount() < 0)
+        _exit(1);
+
+    for (uint32_t j = 0; j < opt->perBoot; j++)
+    {
+        i = (boot - 1) * opt->perBoot + j;
+        BenchRecord(&rec, i, i * BENCH_PERIOD_S);
+        if (HT_TimeSeries_Append(&rec) < 0)
+            _exit(1);
+    }
+
+    srand(boot);
+    HT_Uplink_Prepare();
+    HT_Uplink_Drain(BenchPublish, broker, HT_UPLINK_DRAIN_BATCHES);
+    _exit(0);
+}
+
+static int BenchDrain(const BenchOptions *opt)
+{
+    const HT_UplinkStats *stats = HT_Uplink_Stats();
+    uint32_t readings = opt->boots * opt->perBoot, crashes = 0, backlog, progs, dup = 0;
+    BenchBroker *broker;
+    uint8_t crash;
+    double start, elapsed;
+    char diag[128];
+    int status;
+    pid_t pid;
+
+    if (readings > BENCH_DRAIN_MAX)
+    {
+        BenchError("drain", "readings", (long)readings);
+        return 1;
+    }
+    broker = mmap(NULL, sizeof(*broker), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (broker == MAP_FAILED)
+    {
+        BenchError("drain", "mmap", 0);
+        return 1;
+    }
+    memset(broker, 0, sizeof(*broker));
+
+    for (uint32_t boot = 1; boot <= opt->boots; boot++)
+    {
+        broker->down = boot % BENCH_DOWN_EVERY == 0;
+        broker->connected = 1;
+        crash = opt->crashEvery && boot % opt->crashEvery == 0 && !broker->down;
+        broker->crashNext = crash;
+
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0)
+            BenchDrainBoot(opt, broker, boot);
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0 && !(crash && WEXITSTATUS(status) == 3)) || broker->error)
+        {
+            BenchError("drain", "boot", broker->error ? broker->error : (long)boot);
+            return 1;
+        }
+        crashes += WEXITSTATUS(status) == 3;
+    }
+
+    // Link back: the backlog goes out
+    broker->down = 0;
+    broker->crashNext = 0;
+    srand(0);
+    if (BenchDrainMount() < 0)
+        return 1;
+    backlog = HT_Uplink_Depth();
+
+    progs = HT_MockLfs_Counters()->progBytes;
+    start = BenchNow();
+    // One upload wake, with its own session, per pass
+    for (uint32_t pass = 0; pass < 32 && HT_Uplink_Depth(); pass++)
+    {
+        broker->connected = 1;
+        HT_Uplink_Drain(BenchPublish, broker, HT_UPLINK_DRAIN_BATCHES);
+    }
+    elapsed = BenchNow() - start;
+    progs = HT_MockLfs_Counters()->progBytes - progs;
+
+    for (uint32_t i = 0; i < readings; i++)
+    {
+        if (broker->received[i] == 0)
+        {
+            BenchError("drain", "lost", (long)i);
+            return 1;
+        }
+        dup += broker->received[i] - 1;
+    }
+    if (broker->error || HT_Uplink_Depth() != 0 || dup > broker->crashRecords || stats->dropped || broker->closed)
+    {
+        BenchError("drain", "dup", broker->error ? broker->error : (long)dup);
+        return 1;
+    }
+    HT_Uplink_DiagFormat(diag, sizeof(diag));
+
+    printf("{\"bench\":\"timeseries\",\"fs\":\"%s\",\"mode\":\"drain\",\"boots\":%u,\"crashes\":%u,\"readings\":%u,"
+           "\"backlog\":%u,\"batches\":%u,\"records_per_batch\":%.1f,\"bytes_per_record\":%.1f,\"nacks\":%u,\"dup\":%u,"
+           "\"drain_us_per_record\":%.2f,\"prog_bytes_per_batch\":%.0f}\n",
+           HT_MockLfs_Name(), opt->boots, crashes, readings, backlog, broker->batches,
+           (double)broker->records / broker->batches, (double)broker->bytes / broker->records, broker->nacks, dup,
+           backlog ? elapsed / backlog : 0.0, stats->batches ? (double)progs / stats->batches : 0.0);
+
+    return 0;
+}
+
+/**
+ * @brief Runs one mode in its own process over a blank partition.
+ */
+static int BenchRun(const char *mode, const BenchOptions *opt)
+{
+    int status, ret = 1;
+    pid_t pid;
+
+    HT_MockLfs_Init();
+    fflush(stdout);
+
+    pid = fork();
+    if (pid == 0)
+    {
+        if (strcmp(mode, "append") == 0)
+            ret = BenchAppend(mode, opt, 0);
+        else if (strcmp(mode, "fill") == 0)
+            ret = BenchAppend(mode, opt, opt->fill);
+        else if (strcmp(mode, "query") == 0)
+            ret = BenchQuery(opt);
+        else if (strcmp(mode, "recover") == 0)
+            ret = BenchRecover(opt);
+        else
+            ret = BenchDrain(opt);
+        fflush(stdout);
+        _exit(ret);
+    }
+    waitpid(pid, &status, 0);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt = { 20000, 2000, 6 * 3600, 24, 40, 5, 40 };
+    static const char *modes[] = { "append", "fill", "query", "recover", "drain" };
+    int o, failures = 0;
+
+    while ((o = getopt(argc, argv, "n:q:w:b:k:c:f:")) != -1)
+    {
+        switch (o)
+        {
+            case 'n': opt.appends = (uint32_t)atoi(optarg); break;
+            case 'q': opt.queries = (uint32_t)atoi(optarg); break;
+            case 'w': opt.width = (uint32_t)atoi(optarg); break;
+            case 'b': opt.boots = (uint32_t)atoi(optarg); break;
+            case 'k': opt.perBoot = (uint32_t)atoi(optarg); break;
+            case 'c': opt.crashEvery = (uint32_t)atoi(optarg); break;
+            case 'f': opt.fill = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n appends] [-q queries] [-w width_s] [-b boots] [-k per_boot] "
+                        "[-c crash_every] [-f fill_blocks]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (opt.appends == 0 || opt.queries == 0 || opt.boots < 2 || opt.perBoot < 2 || opt.perBoot > 0xFFF ||
+        opt.fill >= HT_MOCK_LFS_BLOCKS)
+    {
+        fprintf(stderr, "appends and queries at least 1, boots and per_boot 2..4095, fill below %u blocks\n",
+                HT_MOCK_LFS_BLOCKS);
+        return 2;
+    }
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+        failures += BenchRun(modes[m], &opt) != 0;
+
+    return failures ? 1 : 0;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
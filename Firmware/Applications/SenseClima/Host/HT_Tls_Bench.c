@@ -0,0 +1,825 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_Tls_Bench.c
+ * @brief Host benchmark of TLS 1.2 handshakes and records with the SenseClima
+ *        mbedtls configuration (HT_Tls_Config.h), against a local server.
+ *
+ * The client is set up as HT_MQTT_TLSConnect does it: TLS 1.2 only, the
+ * same cipher suites, maximum fragment length and verification, the
+ * session kept in an HT_TLS_SESSION_MAX buffer between connections, and
+ * every allocation from a static arena of HT_MQTT_TLS_ARENA_SIZE bytes
+ * through memory_buffer_alloc, so that the heap peak is the one the
+ * target sees (same sizes on a 32-bit target, pointers aside).
+ *
+ * The server stand-in runs in a forked child on a loopback TCP port, on
+ * its own heap: the mbedtls ECDSA P-256 test certificates (MBEDTLS_CERTS_C),
+ * the development PSK of Src/HT_Psk.c and a session cache. It echoes
+ * application data.
+ *
+ * Modes, one JSON object per line on stdout:
+ *  - psk, psk-resume: PSK-AES-128-CCM-8, full and abbreviated handshakes.
+ *  - cert, cert-resume: mutual TLS with ECDHE-ECDSA, as with a device
+ *    certificate; the CA and device certificates are parsed at every
+ *    connection, as on the target ("setup_us").
+ *  - record: records of 64, 256 and the largest payload the fragment
+ *    length allows, encrypted (client write) and decrypted (client read of
+ *    the echo), on a psk and a cert connection.
+ * The certificate modes need MBEDTLS_X509_CRT_PARSE_C: not in the PSK-only
+ * build (tls_bench_psk).
+ *
+ * Client time is wall time spent in the client calls minus the time blocked
+ * in recv, so the server does not count; host cycles are TSC ticks over the
+ * same intervals (x86 only). Neither says how long the Cortex-M3 takes:
+ * compare runs of the same host, e.g. before and after a change, with
+ * Debug/Scripts/bench_compare.py. Sizes, round trips and heap figures come
+ * from a deterministic DRBG and do not depend on the host.
+ *
+ * AES and SHA-256 run in software: the L2C engine cost is modelled by
+ * crypto_bench.
+ *
+ * Usage: tls_bench [-n handshakes] [-k records] [-m mode,...] [-x seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TSC() __rdtsc()
+#endif
+#include "mbedtls/ssl.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/memory_buffer_alloc.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl_cache.h"
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/certs.h"
+#endif
+#include "HT_TlsSession.h"
+
+#if !defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || !defined(MBEDTLS_MEMORY_DEBUG)
+#error "tls_bench measures the arena: build with CONFIG_MBEDTLS_ARENA (HT_TLS_ARENA = y)"
+#endif
+
+/* As HT_MQTT_Tls.h */
+#if !defined(HT_MQTT_TLS_MFL)
+#define HT_MQTT_TLS_MFL MBEDTLS_SSL_MAX_FRAG_LEN_1024
+#endif
+#if !defined(HT_MQTT_TLS_MFL_PSK)
+#if defined(CONFIG_MBEDTLS_LOW_RAM)
+#define HT_MQTT_TLS_MFL_PSK MBEDTLS_SSL_MAX_FRAG_LEN_512
+#else
+#define HT_MQTT_TLS_MFL_PSK HT_MQTT_TLS_MFL
+#endif
+#endif
+
+#define BENCH_RUNS_MAX      1000
+#define BENCH_HOSTNAME      "localhost"     /**< CN of the mbedtls test server certificate. */
+#define BENCH_PSK_IDENTITY  "SIP_HTNB32L-XXX"
+#define BENCH_PSK_KEY       "SenseClima-dev01"
+#define BENCH_IO_MAX        16384
+
+/**
+ * @brief Handshake modes.
+ */
+typedef enum {
+    BENCH_PSK,
+    BENCH_PSK_RESUME,
+    BENCH_CERT,
+    BENCH_CERT_RESUME,
+    BENCH_RECORD,
+    BENCH_MODES
+} BenchMode;
+
+static const char *const benchModeNames[BENCH_MODES] = {
+    "psk", "psk-resume", "cert", "cert-resume", "record"
+};
+
+/**
+ * @brief Socket of one connection with the client time accounting.
+ */
+typedef struct {
+    int fd;
+    uint64_t blockedNs;     /**< Time blocked in recv. */
+    uint64_t blockedTsc;
+    size_t bytesOut;
+    size_t bytesIn;
+    uint32_t roundTrips;    /**< Receptions that followed a send. */
+    uint8_t sent;
+} BenchLink;
+
+/**
+ * @brief Client connection, in the arena.
+ */
+typedef struct {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt ca;
+    mbedtls_x509_crt crt;
+    mbedtls_pk_context key;
+#endif
+} BenchClient;
+
+/**
+ * @brief Client interval: wall time and TSC, blocked time excluded.
+ */
+typedef struct {
+    uint64_t ns;
+    uint64_t tsc;
+    uint64_t ns0, tsc0, blockedNs0, blockedTsc0;
+} BenchClock;
+
+static const int benchPskSuites[] = {
+    MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+    0
+};
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/* HT_MQTT_TlsCiphersuites, offered by the target with the L2C engine (HT_TLS_HW_CRYPTO = y) */
+static const int benchCertSuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+    MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_RSA_WITH_AES_256_CBC_SHA256,
+    0
+};
+#endif
+
+static unsigned char benchArena[HT_MQTT_TLS_ARENA_SIZE] __attribute__((aligned(8)));
+static mbedtls_ctr_drbg_context benchDrbg;
+static uint8_t benchSession[HT_TLS_SESSION_MAX];
+static size_t benchSessionLen;
+static unsigned char benchIo[2][BENCH_IO_MAX];
+static int failures;
+static uint32_t seed = 1;
+
+/* Time ------------------------------------------------------------------- */
+
+static uint64_t BenchNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t BenchTsc(void)
+{
+#if defined(BENCH_TSC)
+    return BENCH_TSC();
+#else
+    return 0;
+#endif
+}
+
+static void BenchClockStart(BenchClock *clock, const BenchLink *link)
+{
+    clock->blockedNs0 = link->blockedNs;
+    clock->blockedTsc0 = link->blockedTsc;
+    clock->tsc0 = BenchTsc();
+    clock->ns0 = BenchNs();
+}
+
+static void BenchClockStop(BenchClock *clock, const BenchLink *link)
+{
+    uint64_t ns = BenchNs();
+    uint64_t tsc = BenchTsc();
+
+    clock->ns += ns - clock->ns0 - (link->blockedNs - clock->blockedNs0);
+    clock->tsc += tsc - clock->tsc0 - (link->blockedTsc - clock->blockedTsc0);
+}
+
+static int BenchCompare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double BenchMedian(double *v, uint32_t n)
+{
+    qsort(v, n, sizeof(*v), BenchCompare);
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+/* Transport -------------------------------------------------------------- */
+
+static int BenchSend(void *ctx, const unsigned char *buf, size_t len)
+{
+    BenchLink *link = ctx;
+    ssize_t n = send(link->fd, buf, len, MSG_NOSIGNAL);
+
+    if (n < 0)
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+
+    link->bytesOut += (size_t)n;
+    link->sent = 1;
+    return (int)n;
+}
+
+static int BenchRecv(void *ctx, unsigned char *buf, size_t len)
+{
+    BenchLink *link = ctx;
+    uint64_t ns = BenchNs(), tsc = BenchTsc();
+    ssize_t n = recv(link->fd, buf, len, 0);
+
+    link->blockedTsc += BenchTsc() - tsc;
+    link->blockedNs += BenchNs() - ns;
+    if (n < 0)
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+
+    if (n > 0 && link->sent)
+    {
+        link->roundTrips++;
+        link->sent = 0;
+    }
+    link->bytesIn += (size_t)n;
+    return (int)n;
+}
+
+static int BenchConnect(uint16_t port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0)
+        return -1;
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Deterministic DRBG: heap and size figures repeat from run to run */
+static int BenchEntropy(void *ctx, unsigned char *out, size_t len)
+{
+    uint32_t *state = ctx;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        *state = *state * 1103515245 + 12345;
+        out[i] = (uint8_t)(*state >> 16);
+    }
+
+    return 0;
+}
+
+static int BenchDrbgSeed(mbedtls_ctr_drbg_context *drbg, uint32_t *state, const char *who)
+{
+    mbedtls_ctr_drbg_init(drbg);
+    return mbedtls_ctr_drbg_seed(drbg, BenchEntropy, state, (const unsigned char *)who, strlen(who));
+}
+
+/* Server stand-in, forked ------------------------------------------------ */
+
+static void BenchServe(int listenFd)
+{
+    static mbedtls_ctr_drbg_context drbg;
+    static mbedtls_ssl_config conf;
+    static mbedtls_ssl_context ssl;
+    static mbedtls_ssl_cache_context cache;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    static mbedtls_x509_crt ca, crt;
+    static mbedtls_pk_context key;
+#endif
+    uint32_t state = seed ^ 0x5e4e5e4e;
+    BenchLink link;
+    int ret;
+
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_cache_init(&cache);
+    if (BenchDrbgSeed(&drbg, &state, "tls_bench server") != 0 ||
+        mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+        _exit(1);
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_session_cache(&conf, &cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+    if (mbedtls_ssl_conf_psk(&conf, (const unsigned char *)BENCH_PSK_KEY, strlen(BENCH_PSK_KEY),
+                             (const unsigned char *)BENCH_PSK_IDENTITY, strlen(BENCH_PSK_IDENTITY)) != 0)
+        _exit(1);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_x509_crt_init(&crt);
+    mbedtls_pk_init(&key);
+    if (mbedtls_x509_crt_parse(&ca, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len) != 0 ||
+        mbedtls_x509_crt_parse(&crt, (const unsigned char *)mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len) != 0 ||
+        mbedtls_pk_parse_key(&key, (const unsigned char *)mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0) != 0 ||
+        mbedtls_ssl_conf_own_cert(&conf, &crt, &key) != 0)
+        _exit(1);
+    mbedtls_ssl_conf_ca_chain(&conf, &ca, NULL);
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#endif
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0)
+        _exit(1);
+
+    for (;;)
+    {
+        memset(&link, 0, sizeof(link));
+        link.fd = accept(listenFd, NULL, NULL);
+        if (link.fd < 0)
+            _exit(1);
+
+        mbedtls_ssl_set_bio(&ssl, &link, BenchSend, BenchRecv, NULL);
+        if (mbedtls_ssl_handshake(&ssl) == 0)
+        {
+            // Echo until the client closes
+            while ((ret = mbedtls_ssl_read(&ssl, benchIo[1], sizeof(benchIo[1]))) > 0)
+                if (mbedtls_ssl_write(&ssl, benchIo[1], (size_t)ret) != ret)
+                    break;
+        }
+        close(link.fd);
+        mbedtls_ssl_session_reset(&ssl);
+    }
+}
+
+static pid_t BenchServerStart(uint16_t *port)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    socklen_t len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    pid_t pid;
+
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0)
+        return -1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    *port = ntohs(addr.sin_port);
+
+    pid = fork();
+    if (pid == 0)
+    {
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        BenchServe(fd);
+    }
+    close(fd);
+
+    return pid;
+}
+
+/* Client, as HT_MQTT_TLSConnect ------------------------------------------ */
+
+static void BenchClientFree(BenchClient *client)
+{
+    if (client == NULL)
+        return;
+
+    mbedtls_ssl_free(&client->ssl);
+    mbedtls_ssl_config_free(&client->conf);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_free(&client->ca);
+    mbedtls_x509_crt_free(&client->crt);
+    mbedtls_pk_free(&client->key);
+#endif
+    mbedtls_free(client);
+}
+
+static BenchClient *BenchClientOpen(int psk, BenchLink *link)
+{
+    BenchClient *client = mbedtls_calloc(1, sizeof(*client));
+    mbedtls_ssl_session session;
+    int ok;
+
+    if (client == NULL)
+        return NULL;
+
+    mbedtls_ssl_init(&client->ssl);
+    mbedtls_ssl_config_init(&client->conf);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_init(&client->ca);
+    mbedtls_x509_crt_init(&client->crt);
+    mbedtls_pk_init(&client->key);
+    if (!psk &&
+        (mbedtls_x509_crt_parse(&client->ca, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len) != 0 ||
+         mbedtls_x509_crt_parse(&client->crt, (const unsigned char *)mbedtls_test_cli_crt_ec, mbedtls_test_cli_crt_ec_len) != 0 ||
+         mbedtls_pk_parse_key(&client->key, (const unsigned char *)mbedtls_test_cli_key_ec, mbedtls_test_cli_key_ec_len, NULL, 0) != 0))
+    {
+        BenchClientFree(client);
+        return NULL;
+    }
+#endif
+
+    ok = mbedtls_ssl_config_defaults(&client->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                     MBEDTLS_SSL_PRESET_DEFAULT) == 0;
+    mbedtls_ssl_conf_max_version(&client->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_min_version(&client->conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    if (psk)
+    {
+        mbedtls_ssl_conf_ciphersuites(&client->conf, benchPskSuites);
+        ok = ok && mbedtls_ssl_conf_psk(&client->conf, (const unsigned char *)BENCH_PSK_KEY, strlen(BENCH_PSK_KEY),
+                                        (const unsigned char *)BENCH_PSK_IDENTITY, strlen(BENCH_PSK_IDENTITY)) == 0;
+    }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    else
+    {
+        mbedtls_ssl_conf_ciphersuites(&client->conf, benchCertSuites);
+        mbedtls_ssl_conf_authmode(&client->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&client->conf, &client->ca, NULL);
+        ok = ok && mbedtls_ssl_conf_own_cert(&client->conf, &client->crt, &client->key) == 0;
+    }
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    ok = ok && mbedtls_ssl_conf_max_frag_len(&client->conf, psk ? HT_MQTT_TLS_MFL_PSK : HT_MQTT_TLS_MFL) == 0;
+#endif
+    mbedtls_ssl_conf_rng(&client->conf, mbedtls_ctr_drbg_random, &benchDrbg);
+    ok = ok && mbedtls_ssl_setup(&client->ssl, &client->conf) == 0;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    ok = ok && mbedtls_ssl_set_hostname(&client->ssl, BENCH_HOSTNAME) == 0;
+#endif
+    if (!ok)
+    {
+        BenchClientFree(client);
+        return NULL;
+    }
+    mbedtls_ssl_set_bio(&client->ssl, link, BenchSend, BenchRecv, NULL);
+
+    // The session of the last connection, as HT_MQTT_TLSOfferSession
+    if (benchSessionLen != 0)
+    {
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_session_load(&session, benchSession, benchSessionLen) == 0)
+            mbedtls_ssl_set_session(&client->ssl, &session);
+        mbedtls_ssl_session_free(&session);
+    }
+
+    return client;
+}
+
+// Stepwise, as the target: only a full handshake goes through ClientKeyExchange
+static int BenchHandshake(BenchClient *client, int *full)
+{
+    int ret = 0;
+
+    *full = 0;
+    while (client->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+    {
+        if (client->ssl.state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE)
+            *full = 1;
+
+        ret = mbedtls_ssl_handshake_step(&client->ssl);
+        if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+            return ret;
+    }
+
+    return (int)mbedtls_ssl_get_verify_result(&client->ssl) == 0 ? 0 : -1;
+}
+
+static void BenchSaveSession(BenchClient *client)
+{
+    mbedtls_ssl_session session;
+
+    benchSessionLen = 0;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&client->ssl, &session) == 0 &&
+        mbedtls_ssl_session_save(&session, benchSession, sizeof(benchSession), &benchSessionLen) != 0)
+        benchSessionLen = 0;
+    mbedtls_ssl_session_free(&session);
+}
+
+static void BenchClose(BenchClient *client, BenchLink *link)
+{
+    size_t used, blocks;
+
+    if (client != NULL)
+    {
+        mbedtls_ssl_close_notify(&client->ssl);
+        BenchClientFree(client);
+    }
+    close(link->fd);
+
+    mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+    if (used != 0 || blocks != 0)
+    {
+        fprintf(stderr, "tls_bench: %zu bytes in %zu blocks left in the arena\n", used, blocks);
+        failures++;
+    }
+}
+
+static void BenchError(BenchMode mode, const char *step, int ret)
+{
+    printf("{\"bench\":\"tls\",\"config\":\"%s\",\"mode\":\"%s\",\"error\":\"%s\",\"ret\":%d}\n",
+           TLS_BENCH_NAME, benchModeNames[mode], step, ret);
+    failures++;
+}
+
+/* Measurements ----------------------------------------------------------- */
+
+static void BenchHandshakes(BenchMode mode, uint16_t port, uint32_t runs)
+{
+    static double setupUs[BENCH_RUNS_MAX], handshakeUs[BENCH_RUNS_MAX], handshakeCycles[BENCH_RUNS_MAX];
+    int psk = mode == BENCH_PSK || mode == BENCH_PSK_RESUME;
+    int resume = mode == BENCH_PSK_RESUME || mode == BENCH_CERT_RESUME;
+    size_t peak = 0, peakBlocks = 0, connected = 0, used, blocks;
+    char suite[64] = "";
+    BenchClient *client;
+    BenchClock setup, handshake;
+    BenchLink link;
+    uint32_t resumed = 0;
+    int ret, full;
+
+    // Run 0 warms up and, for the resume modes, makes the session
+    benchSessionLen = 0;
+    for (uint32_t run = 0; run <= runs; run++)
+    {
+        if (!resume)
+            benchSessionLen = 0;
+
+        memset(&link, 0, sizeof(link));
+        memset(&setup, 0, sizeof(setup));
+        memset(&handshake, 0, sizeof(handshake));
+        link.fd = BenchConnect(port);
+        if (link.fd < 0)
+        {
+            BenchError(mode, "connect", -1);
+            return;
+        }
+        mbedtls_memory_buffer_alloc_max_reset();
+
+        BenchClockStart(&setup, &link);
+        client = BenchClientOpen(psk, &link);
+        BenchClockStop(&setup, &link);
+        if (client == NULL)
+        {
+            BenchClose(NULL, &link);
+            BenchError(mode, "setup", -1);
+            return;
+        }
+
+        BenchClockStart(&handshake, &link);
+        ret = BenchHandshake(client, &full);
+        BenchClockStop(&handshake, &link);
+        if (ret != 0)
+        {
+            BenchClose(client, &link);
+            BenchError(mode, "handshake", ret);
+            return;
+        }
+
+        BenchSaveSession(client);
+        if (run != 0)
+        {
+            setupUs[run - 1] = setup.ns / 1000.0;
+            handshakeUs[run - 1] = handshake.ns / 1000.0;
+            handshakeCycles[run - 1] = (double)handshake.tsc;
+            resumed += !full;
+            snprintf(suite, sizeof(suite), "%s", mbedtls_ssl_get_ciphersuite(&client->ssl));
+            mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+            connected = used > connected ? used : connected;
+            mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+            peak = used > peak ? used : peak;
+            peakBlocks = blocks > peakBlocks ? blocks : peakBlocks;
+        }
+
+        if (run == runs)
+        {
+            double median = BenchMedian(handshakeUs, runs);
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+            unsigned int recordIn = (unsigned int)client->ssl.in_buf_len, recordOut = (unsigned int)client->ssl.out_buf_len;
+#else
+            unsigned int recordIn = MBEDTLS_SSL_IN_BUFFER_LEN, recordOut = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+
+            printf("{\"bench\":\"tls\",\"config\":\"%s\",\"mode\":\"%s\",\"suite\":\"%s\",\"runs\":%u,"
+                   "\"resumed\":%u,\"round_trips\":%u,\"bytes_out\":%zu,\"bytes_in\":%zu,"
+                   "\"setup_us\":%.1f,\"handshake_us\":%.1f,\"handshake_us_min\":%.1f,\"handshake_us_max\":%.1f,",
+                   TLS_BENCH_NAME, benchModeNames[mode], suite, runs, resumed, link.roundTrips,
+                   link.bytesOut, link.bytesIn, BenchMedian(setupUs, runs), median,
+                   handshakeUs[0], handshakeUs[runs - 1]);
+#if defined(BENCH_TSC)
+            printf("\"handshake_cycles\":%.0f,", BenchMedian(handshakeCycles, runs));
+#endif
+            printf("\"heap_peak\":%zu,\"heap_peak_blocks\":%zu,\"heap_connected\":%zu,\"arena\":%u,"
+                   "\"record_in\":%u,\"record_out\":%u,\"session_len\":%zu}\n",
+                   peak, peakBlocks, connected, (unsigned int)sizeof(benchArena), recordIn, recordOut,
+                   benchSessionLen);
+        }
+        BenchClose(client, &link);
+    }
+
+    if (resume && resumed != runs)
+        BenchError(mode, "not resumed", (int)resumed);
+}
+
+static void BenchRecords(int psk, uint16_t port, uint32_t records)
+{
+    size_t sizes[3] = { 64, 256, 0 };
+    BenchClient *client;
+    BenchClock enc, dec;
+    BenchLink link;
+    size_t used, blocks, got;
+    int ret, full;
+
+    memset(&link, 0, sizeof(link));
+    benchSessionLen = 0;
+    link.fd = BenchConnect(port);
+    if (link.fd < 0)
+    {
+        BenchError(BENCH_RECORD, "connect", -1);
+        return;
+    }
+    mbedtls_memory_buffer_alloc_max_reset();
+    client = BenchClientOpen(psk, &link);
+    if (client == NULL || (ret = BenchHandshake(client, &full)) != 0)
+    {
+        BenchClose(client, &link);
+        BenchError(BENCH_RECORD, "handshake", client == NULL ? -1 : ret);
+        return;
+    }
+
+    sizes[2] = (size_t)mbedtls_ssl_get_max_out_record_payload(&client->ssl);
+    for (int s = 0; s < 3; s++)
+    {
+        size_t wireOut = link.bytesOut;
+
+        if (sizes[s] > sizeof(benchIo[0]))
+            sizes[s] = sizeof(benchIo[0]);
+        memset(&enc, 0, sizeof(enc));
+        memset(&dec, 0, sizeof(dec));
+        for (uint32_t r = 0; r < records; r++)
+        {
+            memset(benchIo[0], (int)r, sizes[s]);
+            BenchClockStart(&enc, &link);
+            ret = mbedtls_ssl_write(&client->ssl, benchIo[0], sizes[s]);
+            BenchClockStop(&enc, &link);
+            if (ret != (int)sizes[s])
+            {
+                BenchClose(client, &link);
+                BenchError(BENCH_RECORD, "write", ret);
+                return;
+            }
+
+            for (got = 0; got < sizes[s]; got += (size_t)ret)
+            {
+                BenchClockStart(&dec, &link);
+                ret = mbedtls_ssl_read(&client->ssl, benchIo[1] + got, sizes[s] - got);
+                BenchClockStop(&dec, &link);
+                if (ret <= 0)
+                {
+                    BenchClose(client, &link);
+                    BenchError(BENCH_RECORD, "read", ret);
+                    return;
+                }
+            }
+            if (memcmp(benchIo[0], benchIo[1], sizes[s]) != 0)
+            {
+                BenchClose(client, &link);
+                BenchError(BENCH_RECORD, "echo", 0);
+                return;
+            }
+        }
+
+        mbedtls_memory_buffer_alloc_max_get(&used, &blocks);
+        printf("{\"bench\":\"tls\",\"config\":\"%s\",\"mode\":\"record\",\"suite\":\"%s\",\"record\":%zu,"
+               "\"records\":%u,\"wire_overhead\":%zu,\"encrypt_MBps\":%.2f,\"decrypt_MBps\":%.2f,",
+               TLS_BENCH_NAME, mbedtls_ssl_get_ciphersuite(&client->ssl), sizes[s], records,
+               (link.bytesOut - wireOut) / records - sizes[s],
+               (double)sizes[s] * records * 1000.0 / (enc.ns ? enc.ns : 1),
+               (double)sizes[s] * records * 1000.0 / (dec.ns ? dec.ns : 1));
+#if defined(BENCH_TSC)
+        printf("\"encrypt_cycles_per_byte\":%.2f,\"decrypt_cycles_per_byte\":%.2f,",
+               (double)enc.tsc / ((double)sizes[s] * records), (double)dec.tsc / ((double)sizes[s] * records));
+#endif
+        printf("\"heap_peak\":%zu}\n", used);
+    }
+
+    BenchClose(client, &link);
+}
+
+static int BenchAvailable(BenchMode mode)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    return 1;
+#else
+    return mode != BENCH_CERT && mode != BENCH_CERT_RESUME;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t runs = 20, records = 200;
+    uint8_t modes[BENCH_MODES] = { 0 };
+    uint8_t any = 0;
+    uint32_t state;
+    uint16_t port;
+    pid_t server;
+    char *list, *name;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:k:m:x:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': runs = (uint32_t)atoi(optarg); break;
+            case 'k': records = (uint32_t)atoi(optarg); break;
+            case 'x': seed = (uint32_t)atoi(optarg); break;
+            case 'm':
+                for (list = optarg; (name = strtok(list, ",")) != NULL; list = NULL)
+                {
+                    int m;
+
+                    for (m = 0; m < BENCH_MODES && strcmp(name, benchModeNames[m]) != 0; m++)
+                        ;
+                    if (m == BENCH_MODES || !BenchAvailable((BenchMode)m))
+                    {
+                        fprintf(stderr, "tls_bench: no mode %s in this build\n", name);
+                        return 2;
+                    }
+                    modes[m] = any = 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n handshakes] [-k records] [-m mode,...] [-x seed]\n"
+                                "       modes: psk psk-resume cert cert-resume record\n", argv[0]);
+                return 2;
+        }
+    }
+    if (runs == 0 || runs > BENCH_RUNS_MAX || records == 0)
+    {
+        fprintf(stderr, "handshakes must be 1..%u, records at least 1\n", BENCH_RUNS_MAX);
+        return 2;
+    }
+    for (int m = 0; m < BENCH_MODES && !any; m++)
+        modes[m] = (uint8_t)BenchAvailable((BenchMode)m);
+
+    // The server forks before the arena is set up: it keeps the libc heap
+    server = BenchServerStart(&port);
+    if (server < 0)
+    {
+        fprintf(stderr, "tls_bench: cannot start the server\n");
+        return 1;
+    }
+    mbedtls_memory_buffer_alloc_init(benchArena, sizeof(benchArena));
+    state = seed;
+    if (BenchDrbgSeed(&benchDrbg, &state, "tls_bench client") != 0)
+    {
+        fprintf(stderr, "tls_bench: DRBG seed failed\n");
+        kill(server, SIGTERM);
+        return 1;
+    }
+
+    for (int m = 0; m < BENCH_RECORD; m++)
+        if (modes[m])
+            BenchHandshakes((BenchMode)m, port, runs);
+    if (modes[BENCH_RECORD])
+    {
+        BenchRecords(1, port, records);
+        if (BenchAvailable(BENCH_CERT))
+            BenchRecords(0, port, records);
+    }
+
+    mbedtls_ctr_drbg_free(&benchDrbg);
+    mbedtls_memory_buffer_alloc_free();
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file HT_Tls_Config.h
+ * @brief mbedtls configuration of the host TLS bench: the target configuration
+ *        named by TLS_BENCH_CONFIG (config_ec_ssl_libcoap.h or
+ *        config_ec_ssl_psk.h, with the application Makefile flags) minus the
+ *        FreeRTOS, lwIP, timer and TRNG glue, plus the server side of the
+ *        stand-in.
+ */
+
+#ifndef __HT_TLS_CONFIG_H__
+#define __HT_TLS_CONFIG_H__
+
+#include TLS_BENCH_CONFIG
+
+/* Target glue: FreeRTOS mutexes, lwIP sockets, the EC616 timer and TRNG. The bench
+   brings its own socket callbacks and a seeded DRBG */
+#undef MBEDTLS_OS_FREERTOS
+#undef MBEDTLS_TCPIP_LWIP
+#undef MBEDTLS_NET_C
+#undef MBEDTLS_THREADING_C
+#undef MBEDTLS_TIMING_C
+#undef MBEDTLS_TIMING_ALT
+#undef MBEDTLS_USE_RAND_API_ENTROPY
+#undef MBEDTLS_ENTROPY_TRNG
+
+/* Server stand-in: the SSL server with a session cache for resumption */
+#define MBEDTLS_SSL_SRV_C
+#define MBEDTLS_SSL_CACHE_C
+
+#endif /* __HT_TLS_CONFIG_H__ */
@@ -0,0 +1,19 @@
+/**
+ * @file HT_GPIO_Api.h
+ * @brief Host stand-in for Inc/HT_GPIO_Api.h.
+ *
+ * Same prototypes as the target header, without the RTOS/board includes, so
+ * the real Src/HT_GPIO_Api.c can be compiled against the mock GPIO driver.
+ */
+
+#ifndef __HT_GPIO_API_H__
+#define __HT_GPIO_API_H__
+
+#include <stdint.h>
+#include "pad_qcx212.h"
+#include "gpio_qcx212.h"
+
+void HT_GPIO_WritePin(uint16_t pin, uint32_t instance, uint16_t value);
+uint32_t HT_GPIO_ReadPin(uint16_t pin, uint32_t instance);
+
+#endif /* __HT_GPIO_API_H__ */
@@ -0,0 +1,58 @@
+/**
+ * @file HT_GPIO_Fast.h
+ * @brief Host stand-in for Inc/HT_GPIO_Fast.h.
+ *
+ * Maps the register-level helpers onto the mock GPIO driver, and the cycle
+ * counter onto the virtual nanosecond clock, so the RAM loop and its boot
+ * calibration run unchanged against the simulated sensor.
+ */
+
+#ifndef __HT_GPIO_FAST_H__
+#define __HT_GPIO_FAST_H__
+
+#include <stdint.h>
+#include "gpio_qcx212.h"
+#include "HT_Mock_Gpio.h"
+
+#define PLAT_CODE_IN_RAM
+
+static inline uint32_t HT_GPIO_FastRead(uint32_t instance, uint16_t pin)
+{
+    return GPIO_PinRead(instance, pin);
+}
+
+static inline void HT_GPIO_FastWrite(uint32_t instance, uint16_t pin, uint32_t value)
+{
+    GPIO_PinWrite(instance, (uint16_t)(1U << pin), value ? (uint16_t)(1U << pin) : 0);
+}
+
+static inline void HT_GPIO_FastSetOutput(uint32_t instance, uint16_t pin)
+{
+    gpio_pin_config_t config = { .pinDirection = GPIO_DirectionOutput };
+
+    GPIO_PinConfig(instance, pin, &config);
+}
+
+static inline void HT_GPIO_FastSetInput(uint32_t instance, uint16_t pin)
+{
+    gpio_pin_config_t config = { .pinDirection = GPIO_DirectionInput };
+
+    GPIO_PinConfig(instance, pin, &config);
+}
+
+static inline uint8_t HT_CycleCounter_Enable(void)
+{
+    return 1;
+}
+
+static inline uint32_t HT_CycleCounter_Read(void)
+{
+    return (uint32_t)HT_MockGpio_NowNs();
+}
+
+static inline uint32_t HT_CycleCounter_Hz(void)
+{
+    return 1000000000UL;
+}
+
+#endif /* __HT_GPIO_FAST_H__ */
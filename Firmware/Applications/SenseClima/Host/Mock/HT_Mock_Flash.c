@@ -0,0 +1,94 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "flash_qcx212_rt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define HT_MOCK_FLASH_SECTOR    0x1000
+
+typedef struct {
+    HT_MockFlashCounters counters;
+    uint8_t image[HT_MOCK_FLASH_SIZE];
+} HT_MockFlash;
+
+static HT_MockFlash privateFlash;
+static HT_MockFlash *flash = &privateFlash;
+static uint32_t tearLen = UINT32_MAX;
+
+static void HT_MockFlash_Blank(void)
+{
+    memset(flash, 0, sizeof(flash->counters));
+    memset(flash->image, 0xFF, sizeof(flash->image));
+}
+
+void HT_MockFlash_Init(void)
+{
+    void *shared = mmap(NULL, sizeof(HT_MockFlash), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (shared != MAP_FAILED)
+        flash = shared;
+    HT_MockFlash_Blank();
+}
+
+void HT_MockFlash_TearNextWrite(uint32_t len)
+{
+    tearLen = len;
+}
+
+const HT_MockFlashCounters *HT_MockFlash_Counters(void)
+{
+    return &flash->counters;
+}
+
+uint8_t BSP_QSPI_Erase_Safe(uint32_t SectorAddress, uint32_t Size)
+{
+    if ((SectorAddress % HT_MOCK_FLASH_SECTOR) || (Size % HT_MOCK_FLASH_SECTOR) || SectorAddress + Size > HT_MOCK_FLASH_SIZE)
+        return QSPI_ERROR;
+
+    memset(flash->image + SectorAddress, 0xFF, Size);
+    flash->counters.erases += Size / HT_MOCK_FLASH_SECTOR;
+
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Write_Safe(uint8_t* pData, uint32_t WriteAddr, uint32_t Size)
+{
+    if (WriteAddr + Size > HT_MOCK_FLASH_SIZE)
+        return QSPI_ERROR;
+
+    // NOR programming only clears bits
+    for (uint32_t i = 0; i < Size && i < tearLen; i++)
+        flash->image[WriteAddr + i] &= pData[i];
+    flash->counters.writes++;
+    flash->counters.writeBytes += Size;
+
+    if (tearLen != UINT32_MAX)
+        _Exit(1);
+
+    return QSPI_OK;
+}
+
+uint8_t BSP_QSPI_Read_Safe(uint8_t* pData, uint32_t WriteAddr, uint32_t Size)
+{
+    if (WriteAddr + Size > HT_MOCK_FLASH_SIZE)
+        return QSPI_ERROR;
+
+    memcpy(pData, flash->image + WriteAddr, Size);
+    flash->counters.reads++;
+
+    return QSPI_OK;
+}
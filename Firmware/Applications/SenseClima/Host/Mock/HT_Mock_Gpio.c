@@ -0,0 +1,179 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <stddef.h>
+#include "HT_Mock_Gpio.h"
+#include "bsp.h"
+#include "task.h"
+
+// Minimum host low time the DHT22 accepts as a start signal.
+#define MOCK_START_LOW_MIN_NS   1000000ULL
+
+static uint64_t nowNs;
+static uint32_t readCost;
+static uint32_t readCount;
+static int32_t schedNesting;
+
+static gpio_pin_direction_t direction = GPIO_DirectionInput;
+static uint8_t outLevel = 1;
+static uint64_t lowStartNs;
+
+static const HT_SimTrain *armed;
+static uint8_t triggered;
+static uint64_t triggerNs;
+
+// Playback cursor: time only moves forward, so the segment lookup is amortised O(1).
+static uint16_t cursor;
+static uint64_t cursorStartNs;
+
+void HT_MockGpio_Reset(uint32_t readCostNs)
+{
+    nowNs = 0;
+    readCost = readCostNs;
+    readCount = 0;
+    schedNesting = 0;
+    direction = GPIO_DirectionInput;
+    outLevel = 1;
+    lowStartNs = 0;
+    armed = NULL;
+    triggered = 0;
+}
+
+void HT_MockGpio_Arm(const HT_SimTrain *train)
+{
+    armed = train;
+    triggered = 0;
+}
+
+uint64_t HT_MockGpio_NowNs(void)
+{
+    return nowNs;
+}
+
+uint32_t HT_MockGpio_ReadCount(void)
+{
+    return readCount;
+}
+
+int HT_MockGpio_SchedulerBalanced(void)
+{
+    return schedNesting == 0;
+}
+
+static uint8_t HT_MockGpio_SensorLevel(void)
+{
+    if (!triggered || armed == NULL)
+        return 1; // External pull-up.
+
+    uint64_t t = nowNs - triggerNs;
+
+    while (cursor < armed->count && t >= cursorStartNs + armed->seg[cursor].duration_ns)
+    {
+        cursorStartNs += armed->seg[cursor].duration_ns;
+        cursor++;
+    }
+
+    return (cursor < armed->count) ? armed->seg[cursor].level : 1;
+}
+
+/* Board stand-ins ------------------------------------------------------------*/
+
+void delay_us(uint32_t us)
+{
+    nowNs += (uint64_t)us * 1000ULL;
+}
+
+void PAD_GetDefaultConfig(pad_config_t *config)
+{
+    config->pullSelect = 0;
+    config->pullUpEnable = 0;
+    config->pullDownEnable = 0;
+    config->mux = PAD_MuxAlt0;
+    config->inputForceDisable = 0;
+    config->swOutputEnable = 0;
+    config->swOutputValue = 0;
+}
+
+void PAD_SetPinConfig(uint32_t pin, const pad_config_t *config)
+{
+    (void)pin;
+    (void)config;
+}
+
+void PAD_SetPinPullConfig(uint32_t pin, pad_pull_config_t config)
+{
+    (void)pin;
+    (void)config;
+}
+
+void GPIO_PinConfig(uint32_t port, uint16_t pin, const gpio_pin_config_t *config)
+{
+    (void)port;
+    (void)pin;
+    direction = config->pinDirection;
+}
+
+void GPIO_PinWrite(uint32_t port, uint16_t pinMask, uint16_t output)
+{
+    uint8_t level = (output & pinMask) ? 1 : 0;
+
+    (void)port;
+
+    if (direction != GPIO_DirectionOutput)
+        return;
+
+    if (outLevel && !level)
+    {
+        lowStartNs = nowNs;
+        triggered = 0;
+    }
+    else if (!outLevel && level && (nowNs - lowStartNs) >= MOCK_START_LOW_MIN_NS)
+    {
+        // Rising edge after a long enough start pulse: the sensor starts answering.
+        triggered = 1;
+        triggerNs = nowNs;
+        cursor = 0;
+        cursorStartNs = 0;
+    }
+
+    outLevel = level;
+}
+
+uint32_t GPIO_PinRead(uint32_t port, uint16_t pin)
+{
+    (void)port;
+    (void)pin;
+
+    nowNs += readCost;
+    readCount++;
+
+    if (direction == GPIO_DirectionOutput)
+        return outLevel;
+
+    return HT_MockGpio_SensorLevel();
+}
+
+/* Scheduler stand-ins --------------------------------------------------------*/
+
+void vTaskSuspendAll(void)
+{
+    schedNesting++;
+}
+
+int32_t xTaskResumeAll(void)
+{
+    schedNesting--;
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file HT_Mock_Gpio.h
+ * @brief Virtual-time GPIO/timer mock used to run sensor drivers on a Linux host.
+ *
+ * The mock keeps a nanosecond clock that only advances through delay_us() and
+ * a configurable per-access cost, so results are deterministic and do not
+ * depend on host load. A single data line is modelled: while the driver owns
+ * it as an output the written level is read back; once it is released, the
+ * armed pulse train (see HT_DHT22_Sim.h) is played relative to the release edge.
+ */
+
+#ifndef __HT_MOCK_GPIO_H__
+#define __HT_MOCK_GPIO_H__
+
+#include <stdint.h>
+
+#define HT_SIM_MAX_SEGMENTS   96      /**< Response + 40 bits + trailer fits with margin. */
+
+/**
+ * @brief One constant-level stretch of the data line.
+ */
+typedef struct {
+    uint8_t  level;         /**< Line level (0 or 1). */
+    uint32_t duration_ns;   /**< Time the line holds this level. */
+} HT_SimSegment;
+
+/**
+ * @brief Pulse train played by the sensor after the host releases the line.
+ *
+ * Time zero is the rising edge that ends the host start pulse. After the last
+ * segment the line returns to the pull-up level (1).
+ */
+typedef struct {
+    HT_SimSegment seg[HT_SIM_MAX_SEGMENTS];
+    uint16_t count;
+} HT_SimTrain;
+
+/**
+ * @brief Resets the virtual clock and line state.
+ * @param readCostNs Virtual time consumed by each GPIO read, modelling loop overhead.
+ */
+void HT_MockGpio_Reset(uint32_t readCostNs);
+
+/**
+ * @brief Arms the pulse train answered on the next valid start pulse.
+ * @param train Train to play; must stay valid until the read completes. NULL disarms.
+ */
+void HT_MockGpio_Arm(const HT_SimTrain *train);
+
+/**
+ * @brief Returns the current virtual time in nanoseconds.
+ */
+uint64_t HT_MockGpio_NowNs(void);
+
+/**
+ * @brief Returns the number of GPIO reads since the last reset.
+ */
+uint32_t HT_MockGpio_ReadCount(void);
+
+/**
+ * @brief Returns 1 if every vTaskSuspendAll was matched by xTaskResumeAll.
+ */
+int HT_MockGpio_SchedulerBalanced(void);
+
+#endif /* __HT_MOCK_GPIO_H__ */
@@ -0,0 +1,352 @@
+/**
+ * @file HT_Mock_L2c.c
+ * @brief Reference L2C crypto engine for host builds.
+ *
+ * The cipher and hash are written independently of the software paths of
+ * aes_alt.c and sha256_alt.c (S-box and round constants are derived, not
+ * tabled), so comparing the two paths checks both. The engine takes 32-bit
+ * addresses: host builds link with -no-pie so that the static bounce buffer
+ * of l2c_alt.c is below 4 GB.
+ */
+
+#include "l2ctls_qcx212.h"
+#include <math.h>
+#include <string.h>
+
+#define MOCK_SHA_MAX    (64 * 1024)
+
+static HT_MockL2cCounters counters;
+static uint32_t failAfter;
+static uint8_t failArmed;
+static uint8_t sbox[256], rsbox[256];
+static uint8_t clocked;
+
+static uint8_t shaMsg[MOCK_SHA_MAX];
+static uint32_t shaLen;
+static int shaType = -1;
+
+static void *MockL2c_Ptr(uint32_t addr)
+{
+    return (void *)(uintptr_t)addr;
+}
+
+static int MockL2c_Fail(void)
+{
+    if (!clocked)
+    {
+        counters.errors++;
+        return 1;
+    }
+
+    if (failArmed && failAfter-- == 0)
+    {
+        failArmed = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* AES reference ----------------------------------------------------------- */
+
+static uint8_t MockL2c_Mul(uint8_t a, uint8_t b)
+{
+    uint8_t r = 0;
+
+    while (b)
+    {
+        if (b & 1)
+            r ^= a;
+        a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+        b >>= 1;
+    }
+
+    return r;
+}
+
+static void MockL2c_Sbox(void)
+{
+    uint8_t inv, x;
+
+    if (sbox[0] == 0x63)
+        return;
+
+    for (int a = 0; a < 256; a++)
+    {
+        // a^254 is the multiplicative inverse, 0 for 0
+        inv = 1;
+        for (int i = 0; i < 254; i++)
+            inv = MockL2c_Mul(inv, (uint8_t)a);
+        inv = a ? inv : 0;
+
+        x = inv;
+        for (int i = 1; i < 5; i++)
+            x ^= (uint8_t)((inv << i) | (inv >> (8 - i)));
+        sbox[a] = x ^ 0x63;
+        rsbox[sbox[a]] = (uint8_t)a;
+    }
+}
+
+static void MockL2c_Expand(const uint8_t *key, int nk, uint8_t w[240])
+{
+    int nr = nk + 6;
+    uint8_t t[4], u, rcon = 1;
+
+    memcpy(w, key, 4 * nk);
+    for (int i = nk; i < 4 * (nr + 1); i++)
+    {
+        memcpy(t, w + 4 * (i - 1), 4);
+        if (i % nk == 0)
+        {
+            u = t[0];
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[u];
+            rcon = MockL2c_Mul(rcon, 2);
+        }
+        for (int j = 0; j < 4; j++)
+            w[4 * i + j] = w[4 * (i - nk) + j] ^ t[j];
+    }
+}
+
+static void MockL2c_Block(const uint8_t *w, int nr, int decrypt, const uint8_t in[16], uint8_t out[16])
+{
+    static const uint8_t mix[2][4] = { { 2, 3, 1, 1 }, { 14, 11, 13, 9 } };
+    uint8_t s[16], t[16];
+    int round, c, r, k;
+
+    for (int i = 0; i < 16; i++)
+        s[i] = in[i] ^ w[16 * (decrypt ? nr : 0) + i];
+
+    for (round = 1; round <= nr; round++)
+    {
+        // (Inv)ShiftRows and (Inv)SubBytes
+        for (c = 0; c < 4; c++)
+            for (r = 0; r < 4; r++)
+            {
+                if (decrypt)
+                    t[4 * ((c + r) % 4) + r] = rsbox[s[4 * c + r]];
+                else
+                    t[4 * c + r] = sbox[s[4 * ((c + r) % 4) + r]];
+            }
+
+        // Encryption mixes before the round key, decryption after
+        k = decrypt ? nr - round : round;
+        if (decrypt)
+            for (int i = 0; i < 16; i++)
+                t[i] ^= w[16 * k + i];
+
+        // (Inv)MixColumns as a circulant matrix product, not in the last round
+        for (c = 0; c < 4; c++)
+            for (r = 0; r < 4; r++)
+            {
+                s[4 * c + r] = (round == nr) ? t[4 * c + r] : 0;
+                for (int j = 0; j < 4 && round < nr; j++)
+                    s[4 * c + r] ^= MockL2c_Mul(mix[decrypt][(j - r + 4) % 4], t[4 * c + j]);
+            }
+
+        if (!decrypt)
+            for (int i = 0; i < 16; i++)
+                s[i] ^= w[16 * k + i];
+    }
+
+    memcpy(out, s, 16);
+}
+
+int32_t L2CTlsAesProcess(L2CTlsAesStruct *info)
+{
+    const uint8_t *in = MockL2c_Ptr(info->InputData);
+    uint8_t *out = MockL2c_Ptr(info->OutputData);
+    uint8_t w[240], iv[16], block[16];
+    int decrypt = info->Ctrl.Encrypt;   // 0 encrypts
+    int nk;
+
+    if (MockL2c_Fail())
+        return L2CTLSDRV_BusyErr;
+
+    if (info->Ctrl.KeyType != 1 || info->Ctrl.KeySize > 1 || info->Ctrl.ChainMode > 1 ||
+        info->Ctrl.PaddingMode != 0 || info->DataLen == 0 || info->DataLen % 16 ||
+        (info->InputData | info->OutputData | info->KeyAddress) % 4)
+    {
+        counters.errors++;
+        return L2CTLSDRV_ParameterErr;
+    }
+
+    MockL2c_Sbox();
+    nk = info->Ctrl.KeySize ? 6 : 4;
+    MockL2c_Expand(MockL2c_Ptr(info->KeyAddress), nk, w);
+    if (info->Ctrl.ChainMode)
+        memcpy(iv, MockL2c_Ptr(info->IVAddress), 16);
+
+    for (uint32_t off = 0; off < info->DataLen; off += 16)
+    {
+        memcpy(block, in + off, 16);
+        if (info->Ctrl.ChainMode && !decrypt)
+            for (int i = 0; i < 16; i++)
+                block[i] ^= iv[i];
+
+        MockL2c_Block(w, nk + 6, decrypt, block, block);
+
+        if (info->Ctrl.ChainMode && decrypt)
+        {
+            for (int i = 0; i < 16; i++)
+                block[i] ^= iv[i];
+            memcpy(iv, in + off, 16);
+        }
+        else if (info->Ctrl.ChainMode)
+        {
+            memcpy(iv, block, 16);
+        }
+        memcpy(out + off, block, 16);
+    }
+
+    counters.aesCalls++;
+    counters.aesBlocks += info->DataLen / 16;
+
+    return L2CTLSDRV_OK;
+}
+
+/* SHA-2 reference --------------------------------------------------------- */
+
+/* First 32 bits of the fractional part of x */
+static uint32_t MockL2c_Frac(double x)
+{
+    return (uint32_t)((x - floor(x)) * 4294967296.0);
+}
+
+static void MockL2c_Sha(const uint8_t *msg, uint32_t len, int is224, uint8_t out[32])
+{
+    static const uint32_t iv224[8] = { 0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939,
+                                       0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4 };
+    uint32_t k[64], h[8], w[64], v[8], t1, t2;
+    uint8_t block[64];
+    uint64_t bits = (uint64_t)len * 8;
+    uint32_t blocks = (len + 9 + 63) / 64;
+    int n = 0;
+
+    // Round constants and SHA-256 IV from the cube and square roots of the primes
+    for (int p = 2; n < 64; p++)
+    {
+        int prime = 1;
+        for (int d = 2; d * d <= p; d++)
+            prime &= (p % d) != 0;
+        if (!prime)
+            continue;
+        if (n < 8)
+            h[n] = MockL2c_Frac(sqrt((double)p));
+        k[n++] = MockL2c_Frac(cbrt((double)p));
+    }
+    if (is224)
+        memcpy(h, iv224, sizeof(h));
+
+    for (uint32_t b = 0; b < blocks; b++)
+    {
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            uint64_t pos = (uint64_t)b * 64 + i;
+            if (pos < len)
+                block[i] = msg[pos];
+            else if (pos == len)
+                block[i] = 0x80;
+            else if (b == blocks - 1 && i >= 56)
+                block[i] = (uint8_t)(bits >> (8 * (63 - i)));
+            else
+                block[i] = 0;
+        }
+
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+                   (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+#define ROR(x, s) (((x) >> (s)) | ((x) << (32 - (s))))
+        for (int i = 16; i < 64; i++)
+            w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+                   w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+
+        memcpy(v, h, sizeof(v));
+        for (int i = 0; i < 64; i++)
+        {
+            t1 = v[7] + (ROR(v[4], 6) ^ ROR(v[4], 11) ^ ROR(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) + k[i] + w[i];
+            t2 = (ROR(v[0], 2) ^ ROR(v[0], 13) ^ ROR(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+            memmove(v + 1, v, 7 * sizeof(uint32_t));
+            v[4] += t1;
+            v[0] = t1 + t2;
+        }
+#undef ROR
+        for (int i = 0; i < 8; i++)
+            h[i] += v[i];
+    }
+
+    for (int i = 0; i < (is224 ? 7 : 8); i++)
+        for (int j = 0; j < 4; j++)
+            out[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+
+    counters.shaBlocks += blocks;
+}
+
+void L2CShaComInit(L2CSHAType ShaType)
+{
+    shaType = ShaType;
+    shaLen = 0;
+}
+
+int32_t L2CShaUpdate(uint32_t SrcAddr, uint32_t DstAddr, uint32_t Lenth, uint32_t LastFlag)
+{
+    if (MockL2c_Fail())
+        return L2CTLSDRV_BusyErr;
+
+    // Only whole blocks before the last part, no SHA-1
+    if ((shaType != L2C_SHA_TYPE_224 && shaType != L2C_SHA_TYPE_256) ||
+        (!LastFlag && Lenth % 64) || shaLen + Lenth > MOCK_SHA_MAX || (SrcAddr | DstAddr) % 4)
+    {
+        counters.errors++;
+        return L2CTLSDRV_ParameterErr;
+    }
+
+    memcpy(shaMsg + shaLen, MockL2c_Ptr(SrcAddr), Lenth);
+    shaLen += Lenth;
+    counters.shaCalls++;
+
+    if (LastFlag)
+    {
+        MockL2c_Sha(shaMsg, shaLen, shaType == L2C_SHA_TYPE_224, MockL2c_Ptr(DstAddr));
+        shaType = -1;
+    }
+
+    return L2CTLSDRV_OK;
+}
+
+/* Driver ------------------------------------------------------------------ */
+
+void L2CTlsInit(void)
+{
+    clocked = 1;
+    counters.inits++;
+}
+
+void L2CTlsDeInit(void)
+{
+    clocked = 0;
+}
+
+int32_t L2CTlsCheckMode(L2CModeType ModeType, L2CSHAType ShaType)
+{
+    return L2CTLSDRV_OK;
+}
+
+void HT_MockL2c_Reset(void)
+{
+    memset(&counters, 0, sizeof(counters));
+    failArmed = 0;
+}
+
+const HT_MockL2cCounters *HT_MockL2c_Counters(void)
+{
+    return &counters;
+}
+
+void HT_MockL2c_FailAfter(uint32_t calls)
+{
+    failAfter = calls;
+    failArmed = 1;
+}
@@ -0,0 +1,495 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Mock_Lfs.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MOCK_LFS_MAGIC      0x4D53464CUL    // Set by LFS_Format
+#define MOCK_LFS_FILES      64
+#define MOCK_LFS_META       2               // Superblock / root directory metadata pair
+#define MOCK_LFS_META_PROG  64              // Bytes of a metadata commit
+
+typedef struct {
+    char name[LFS_NAME_MAX + 1];
+    uint32_t size;                          // Committed size
+    uint32_t blocks;
+    int16_t block[HT_MOCK_LFS_BLOCKS];
+} HT_MockLfsFile;
+
+typedef struct {
+    HT_MockLfsCounters counters;
+    uint32_t magic;
+    uint8_t used[HT_MOCK_LFS_BLOCKS];
+    HT_MockLfsFile files[MOCK_LFS_FILES];
+    uint8_t image[HT_MOCK_LFS_BLOCKS][HT_MOCK_LFS_BLOCK_SIZE];
+} HT_MockLfs;
+
+static HT_MockLfs privateFs;
+static HT_MockLfs *fs = &privateFs;
+
+/*
+ * An open file keeps its state in the lfs_file_t itself: id is the file
+ * slot, pos the position, ctz.size the size seen through the handle,
+ * off the first offset changed since the last commit and cache.buffer a
+ * private copy of the contents once written (LFS_F_DIRTY).
+ */
+
+static HT_MockLfsFile *HT_MockLfs_Find(const char *path, int *slot)
+{
+    while (*path == '/')
+        path++;
+
+    for (int i = 0; i < MOCK_LFS_FILES; i++)
+    {
+        if (fs->files[i].name[0] && strcmp(fs->files[i].name, path) == 0)
+        {
+            *slot = i;
+            return &fs->files[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t HT_MockLfs_Free(void)
+{
+    uint32_t free = 0;
+
+    for (int b = MOCK_LFS_META; b < HT_MOCK_LFS_BLOCKS; b++)
+        free += !fs->used[b];
+
+    return free;
+}
+
+static uint32_t HT_MockLfs_Blocks(uint32_t size)
+{
+    return (size + HT_MOCK_LFS_BLOCK_SIZE - 1) / HT_MOCK_LFS_BLOCK_SIZE;
+}
+
+/**
+ * @brief Blocks a commit of the handle would allocate: every block from the
+ *        first changed one is rewritten.
+ */
+static uint32_t HT_MockLfs_Needed(const lfs_file_t *file)
+{
+    uint32_t first = file->off / HT_MOCK_LFS_BLOCK_SIZE;
+    uint32_t blocks = HT_MockLfs_Blocks(file->ctz.size);
+
+    return blocks > first ? blocks - first : 0;
+}
+
+static void HT_MockLfs_MetaCommit(void)
+{
+    fs->counters.progs++;
+    fs->counters.progBytes += MOCK_LFS_META_PROG;
+}
+
+static int HT_MockLfs_Commit(lfs_file_t *file)
+{
+    HT_MockLfsFile *f = &fs->files[file->id];
+    uint32_t first = file->off / HT_MOCK_LFS_BLOCK_SIZE;
+    uint32_t blocks = HT_MockLfs_Blocks(file->ctz.size);
+    int16_t fresh[HT_MOCK_LFS_BLOCKS];
+    uint32_t n = 0, len;
+
+    if (!(file->flags & LFS_F_DIRTY))
+        return 0;
+    if (HT_MockLfs_Needed(file) > HT_MockLfs_Free())
+        return LFS_ERR_NOSPC;
+
+    // Copy on write: new blocks for the changed tail, then the old ones go back
+    for (int b = MOCK_LFS_META; b < HT_MOCK_LFS_BLOCKS && first + n < blocks; b++)
+    {
+        if (fs->used[b])
+            continue;
+        fs->used[b] = 1;
+        fresh[n] = (int16_t)b;
+
+        len = file->ctz.size - (first + n) * HT_MOCK_LFS_BLOCK_SIZE;
+        if (len > HT_MOCK_LFS_BLOCK_SIZE)
+            len = HT_MOCK_LFS_BLOCK_SIZE;
+        memcpy(fs->image[b], (uint8_t *)file->cache.buffer + (first + n) * HT_MOCK_LFS_BLOCK_SIZE, len);
+        fs->counters.erases++;
+        fs->counters.progs++;
+        fs->counters.progBytes += len;
+        n++;
+    }
+
+    for (uint32_t i = first; i < f->blocks; i++)
+        fs->used[f->block[i]] = 0;
+    for (uint32_t i = 0; i < n; i++)
+        f->block[first + i] = fresh[i];
+    f->blocks = blocks;
+    f->size = file->ctz.size;
+    HT_MockLfs_MetaCommit();
+
+    file->flags &= ~LFS_F_DIRTY;
+    file->off = file->ctz.size;
+
+    return 0;
+}
+
+/**
+ * @brief Gives the handle its private copy of the contents before a change.
+ */
+static int HT_MockLfs_Own(lfs_file_t *file, uint32_t size)
+{
+    HT_MockLfsFile *f = &fs->files[file->id];
+    uint32_t have = file->cache.buffer ? file->cache.size : 0;
+    uint32_t capacity = HT_MockLfs_Blocks(size) * HT_MOCK_LFS_BLOCK_SIZE;
+    uint32_t keep = 0;
+    uint8_t *buffer;
+
+    if (capacity > HT_MOCK_LFS_BLOCKS * HT_MOCK_LFS_BLOCK_SIZE)
+        return LFS_ERR_NOSPC;
+
+    if (file->cache.buffer == NULL)
+    {
+        keep = (file->flags & LFS_O_TRUNC) ? 0 : f->blocks;
+        if (capacity < keep * HT_MOCK_LFS_BLOCK_SIZE)
+            capacity = keep * HT_MOCK_LFS_BLOCK_SIZE;
+        if (capacity == 0)
+            capacity = HT_MOCK_LFS_BLOCK_SIZE;
+    }
+    else if (capacity <= have)
+    {
+        return 0;
+    }
+
+    buffer = realloc(file->cache.buffer, capacity);
+    if (buffer == NULL)
+        return LFS_ERR_NOMEM;
+    memset(buffer + have, 0, capacity - have);
+    for (uint32_t i = 0; i < keep; i++)
+        memcpy(buffer + i * HT_MOCK_LFS_BLOCK_SIZE, fs->image[f->block[i]], HT_MOCK_LFS_BLOCK_SIZE);
+
+    file->cache.buffer = buffer;
+    file->cache.size = capacity;
+
+    return 0;
+}
+
+void HT_MockLfs_Init(void)
+{
+    void *shared = mmap(NULL, sizeof(HT_MockLfs), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (shared != MAP_FAILED)
+        fs = shared;
+    memset(fs, 0, sizeof(*fs));
+    memset(fs->image, 0xFF, sizeof(fs->image));
+}
+
+const HT_MockLfsCounters *HT_MockLfs_Counters(void)
+{
+    return &fs->counters;
+}
+
+const char *HT_MockLfs_Name(void)
+{
+    return "model";
+}
+
+int LFS_Format(void)
+{
+    HT_MockLfsCounters counters = fs->counters;
+
+    memset(fs, 0, offsetof(HT_MockLfs, image));
+    fs->counters = counters;
+    fs->magic = MOCK_LFS_MAGIC;
+    fs->used[0] = fs->used[1] = 1;
+    fs->counters.erases += MOCK_LFS_META;
+    HT_MockLfs_MetaCommit();
+
+    return 0;
+}
+
+int LFS_Init(void)
+{
+    // Mount, formatting a blank partition as the SDK does
+    fs->counters.reads++;
+    fs->counters.readBytes += MOCK_LFS_META_PROG;
+
+    return fs->magic == MOCK_LFS_MAGIC ? 0 : LFS_Format();
+}
+
+void LFS_Deinit(void)
+{
+}
+
+int LFS_Remove(const char *path)
+{
+    HT_MockLfsFile *f;
+    int slot;
+
+    f = HT_MockLfs_Find(path, &slot);
+    if (f == NULL)
+        return LFS_ERR_NOENT;
+
+    for (uint32_t i = 0; i < f->blocks; i++)
+        fs->used[f->block[i]] = 0;
+    memset(f, 0, sizeof(*f));
+    HT_MockLfs_MetaCommit();
+
+    return 0;
+}
+
+int LFS_FileOpen(lfs_file_t *file, const char *path, int flags)
+{
+    HT_MockLfsFile *f;
+    int slot;
+
+    memset(file, 0, sizeof(*file));
+
+    f = HT_MockLfs_Find(path, &slot);
+    if (f == NULL)
+    {
+        if (!(flags & LFS_O_CREAT))
+            return LFS_ERR_NOENT;
+
+        while (*path == '/')
+            path++;
+        if (strlen(path) > LFS_NAME_MAX)
+            return LFS_ERR_NAMETOOLONG;
+
+        // The entry is created, empty, at open
+        for (slot = 0; slot < MOCK_LFS_FILES && fs->files[slot].name[0]; slot++)
+            ;
+        if (slot == MOCK_LFS_FILES)
+            return LFS_ERR_NOSPC;
+        f = &fs->files[slot];
+        strcpy(f->name, path);
+        HT_MockLfs_MetaCommit();
+    }
+    else if ((flags & LFS_O_CREAT) && (flags & LFS_O_EXCL))
+    {
+        return LFS_ERR_EXIST;
+    }
+
+    file->id = (uint16_t)slot;
+    file->flags = (uint32_t)flags | LFS_F_OPENED;
+    file->ctz.size = f->size;
+    file->off = f->size;
+
+    if (flags & LFS_O_TRUNC)
+    {
+        file->ctz.size = 0;
+        file->off = 0;
+        file->flags |= LFS_F_DIRTY;
+        if (HT_MockLfs_Own(file, 0) < 0)
+            return LFS_ERR_NOMEM;
+    }
+
+    fs->counters.reads++;
+    fs->counters.readBytes += MOCK_LFS_META_PROG;
+
+    return 0;
+}
+
+int LFS_FileSync(lfs_file_t *file)
+{
+    if (file->flags & LFS_F_ERRED)
+        return 0;
+
+    return HT_MockLfs_Commit(file);
+}
+
+int LFS_FileClose(lfs_file_t *file)
+{
+    int err = LFS_FileSync(file);
+
+    free(file->cache.buffer);
+    memset(file, 0, sizeof(*file));
+
+    return err;
+}
+
+lfs_ssize_t LFS_FileRead(lfs_file_t *file, void *buffer, lfs_size_t size)
+{
+    HT_MockLfsFile *f = &fs->files[file->id];
+    lfs_size_t done = 0, chunk, off;
+
+    if ((file->flags & LFS_O_RDONLY) == 0)
+        return LFS_ERR_BADF;
+    if (file->pos >= file->ctz.size)
+        return 0;
+    if (size > file->ctz.size - file->pos)
+        size = file->ctz.size - file->pos;
+
+    if (file->cache.buffer)
+    {
+        memcpy(buffer, (uint8_t *)file->cache.buffer + file->pos, size);
+        file->pos += size;
+        return (lfs_ssize_t)size;
+    }
+
+    while (done < size)
+    {
+        off = file->pos % HT_MOCK_LFS_BLOCK_SIZE;
+        chunk = HT_MOCK_LFS_BLOCK_SIZE - off;
+        if (chunk > size - done)
+            chunk = size - done;
+        memcpy((uint8_t *)buffer + done, fs->image[f->block[file->pos / HT_MOCK_LFS_BLOCK_SIZE]] + off, chunk);
+        fs->counters.reads++;
+        fs->counters.readBytes += chunk;
+        file->pos += chunk;
+        done += chunk;
+    }
+
+    return (lfs_ssize_t)size;
+}
+
+lfs_ssize_t LFS_FileWrite(lfs_file_t *file, const void *buffer, lfs_size_t size)
+{
+    uint32_t end;
+    int err;
+
+    if ((file->flags & LFS_O_WRONLY) == 0)
+        return LFS_ERR_BADF;
+    if (file->flags & LFS_F_ERRED)
+        return LFS_ERR_IO;
+
+    if (file->flags & LFS_O_APPEND)
+        file->pos = file->ctz.size;
+    end = file->pos + size;
+
+    err = HT_MockLfs_Own(file, end > file->ctz.size ? end : file->ctz.size);
+    if (err < 0)
+        return err;
+
+    if (!(file->flags & LFS_F_DIRTY) || file->pos < file->off)
+        file->off = file->pos;
+    memcpy((uint8_t *)file->cache.buffer + file->pos, buffer, size);
+    file->pos = end;
+    if (end > file->ctz.size)
+        file->ctz.size = end;
+    file->flags |= LFS_F_DIRTY;
+
+    // littlefs allocates as its cache fills: no room shows up at the write
+    if (HT_MockLfs_Needed(file) > HT_MockLfs_Free())
+    {
+        file->flags |= LFS_F_ERRED;
+        return LFS_ERR_NOSPC;
+    }
+
+    return (lfs_ssize_t)size;
+}
+
+lfs_soff_t LFS_FileSeek(lfs_file_t *file, lfs_soff_t off, int whence)
+{
+    lfs_soff_t pos = off;
+
+    if (whence == LFS_SEEK_CUR)
+        pos += (lfs_soff_t)file->pos;
+    else if (whence == LFS_SEEK_END)
+        pos += (lfs_soff_t)file->ctz.size;
+    if (pos < 0)
+        return LFS_ERR_INVAL;
+
+    file->pos = (lfs_off_t)pos;
+
+    return pos;
+}
+
+int LFS_FileTruncate(lfs_file_t *file, lfs_off_t size)
+{
+    int err;
+
+    if ((file->flags & LFS_O_WRONLY) == 0)
+        return LFS_ERR_BADF;
+
+    err = HT_MockLfs_Own(file, size);
+    if (err < 0)
+        return err;
+
+    if (size > file->ctz.size)
+        memset((uint8_t *)file->cache.buffer + file->ctz.size, 0, size - file->ctz.size);
+    if (!(file->flags & LFS_F_DIRTY) || size < file->off)
+        file->off = size;
+    file->ctz.size = size;
+    file->flags |= LFS_F_DIRTY;
+
+    return 0;
+}
+
+lfs_soff_t LFS_FileTell(lfs_file_t *file)
+{
+    return (lfs_soff_t)file->pos;
+}
+
+int LFS_FileRewind(lfs_file_t *file)
+{
+    file->pos = 0;
+
+    return 0;
+}
+
+lfs_soff_t LFS_FileSize(lfs_file_t *file)
+{
+    return (lfs_soff_t)file->ctz.size;
+}
+
+int LFS_DirOpen(lfs_dir_t *dir, const char *path)
+{
+    memset(dir, 0, sizeof(*dir));
+
+    return strcmp(path, "/") == 0 ? 0 : LFS_ERR_NOENT;
+}
+
+int LFS_DirClose(lfs_dir_t *dir)
+{
+    return 0;
+}
+
+int LFS_DirRead(lfs_dir_t *dir, struct lfs_info *info)
+{
+    memset(info, 0, sizeof(*info));
+
+    // "." and ".." first, as littlefs lists them
+    if (dir->pos < 2)
+    {
+        info->type = LFS_TYPE_DIR;
+        strcpy(info->name, dir->pos ? ".." : ".");
+        dir->pos++;
+        return 1;
+    }
+
+    for (; dir->pos - 2 < MOCK_LFS_FILES; dir->pos++)
+    {
+        HT_MockLfsFile *f = &fs->files[dir->pos - 2];
+
+        if (f->name[0])
+        {
+            info->type = LFS_TYPE_REG;
+            info->size = f->size;
+            strcpy(info->name, f->name);
+            dir->pos++;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int LFS_Statfs(lfs_status_t *status)
+{
+    status->total_block = HT_MOCK_LFS_BLOCKS;
+    status->block_used = HT_MOCK_LFS_BLOCKS - HT_MockLfs_Free();
+    status->block_size = HT_MOCK_LFS_BLOCK_SIZE;
+
+    return 0;
+}
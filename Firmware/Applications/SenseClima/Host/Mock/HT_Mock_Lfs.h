@@ -0,0 +1,46 @@
+/**
+ * @file HT_Mock_Lfs.h
+ * @brief Host stand-in for the littlefs partition behind the LFS_* port
+ *        API (lfs_port.h): the 344064-byte "fs" region of Debug/format.json
+ *        in RAM, 84 blocks of 4 KB.
+ *
+ * Two implementations: HT_Mock_Lfs.c models the littlefs behaviour the
+ * callers rely on (copy-on-write blocks, changes visible only once synced
+ * or closed, block accounting and LFS_ERR_NOSPC); HT_Mock_LfsRam.c runs the
+ * littlefs sources over a RAM block device, when they are available.
+ */
+
+#ifndef __HOST_MOCK_LFS_H__
+#define __HOST_MOCK_LFS_H__
+
+#include <stdint.h>
+#include "lfs_port.h"
+
+#define HT_MOCK_LFS_BLOCK_SIZE  4096
+#define HT_MOCK_LFS_BLOCKS      84
+
+/**
+ * @brief Places the partition in shared memory, so it outlives forked
+ *        "boots", and erases it. LFS_Init formats it.
+ */
+void HT_MockLfs_Init(void);
+
+/**
+ * @brief Block device traffic since HT_MockLfs_Init, across processes.
+ */
+typedef struct {
+    uint32_t reads;
+    uint32_t readBytes;
+    uint32_t progs;
+    uint32_t progBytes;
+    uint32_t erases;
+} HT_MockLfsCounters;
+
+const HT_MockLfsCounters *HT_MockLfs_Counters(void);
+
+/**
+ * @brief Name of the implementation: "model" or "littlefs".
+ */
+const char *HT_MockLfs_Name(void);
+
+#endif /* __HOST_MOCK_LFS_H__ */
@@ -0,0 +1,211 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Mock_Lfs.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MOCK_LFS_PAGE       256     // QSPI page: read, program and cache unit
+
+typedef struct {
+    HT_MockLfsCounters counters;
+    uint8_t image[HT_MOCK_LFS_BLOCKS][HT_MOCK_LFS_BLOCK_SIZE];
+} HT_MockLfsRam;
+
+static HT_MockLfsRam privateRam;
+static HT_MockLfsRam *ram = &privateRam;
+static lfs_t lfs;
+
+static int HT_MockLfs_Read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
+{
+    memcpy(buffer, ram->image[block] + off, size);
+    ram->counters.reads++;
+    ram->counters.readBytes += size;
+
+    return 0;
+}
+
+static int HT_MockLfs_Prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    const uint8_t *data = buffer;
+
+    // NOR programming only clears bits
+    for (lfs_size_t i = 0; i < size; i++)
+        ram->image[block][off + i] &= data[i];
+    ram->counters.progs++;
+    ram->counters.progBytes += size;
+
+    return 0;
+}
+
+static int HT_MockLfs_Erase(const struct lfs_config *c, lfs_block_t block)
+{
+    memset(ram->image[block], 0xFF, HT_MOCK_LFS_BLOCK_SIZE);
+    ram->counters.erases++;
+
+    return 0;
+}
+
+static int HT_MockLfs_Sync(const struct lfs_config *c)
+{
+    return 0;
+}
+
+static const struct lfs_config lfsConfig = {
+    .read = HT_MockLfs_Read,
+    .prog = HT_MockLfs_Prog,
+    .erase = HT_MockLfs_Erase,
+    .sync = HT_MockLfs_Sync,
+    .read_size = MOCK_LFS_PAGE,
+    .prog_size = MOCK_LFS_PAGE,
+    .block_size = HT_MOCK_LFS_BLOCK_SIZE,
+    .block_count = HT_MOCK_LFS_BLOCKS,
+    .block_cycles = 500,
+    .cache_size = MOCK_LFS_PAGE,
+    .lookahead_size = 16,
+    .name_max = LFS_NAME_MAX,
+};
+
+void lfs_assert(bool test)
+{
+    if (!test)
+        abort();
+}
+
+void HT_MockLfs_Init(void)
+{
+    void *shared = mmap(NULL, sizeof(HT_MockLfsRam), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (shared != MAP_FAILED)
+        ram = shared;
+    memset(&ram->counters, 0, sizeof(ram->counters));
+    memset(ram->image, 0xFF, sizeof(ram->image));
+}
+
+const HT_MockLfsCounters *HT_MockLfs_Counters(void)
+{
+    return &ram->counters;
+}
+
+const char *HT_MockLfs_Name(void)
+{
+    return "littlefs";
+}
+
+int LFS_Format(void)
+{
+    return lfs_format(&lfs, &lfsConfig);
+}
+
+int LFS_Init(void)
+{
+    // Mount, formatting a blank partition as the SDK does
+    if (lfs_mount(&lfs, &lfsConfig) == 0)
+        return 0;
+    if (LFS_Format() < 0)
+        return LFS_ERR_CORRUPT;
+
+    return lfs_mount(&lfs, &lfsConfig);
+}
+
+void LFS_Deinit(void)
+{
+    lfs_unmount(&lfs);
+}
+
+int LFS_Remove(const char *path)
+{
+    return lfs_remove(&lfs, path);
+}
+
+int LFS_FileOpen(lfs_file_t *file, const char *path, int flags)
+{
+    return lfs_file_open(&lfs, file, path, flags);
+}
+
+int LFS_FileClose(lfs_file_t *file)
+{
+    return lfs_file_close(&lfs, file);
+}
+
+lfs_ssize_t LFS_FileRead(lfs_file_t *file, void *buffer, lfs_size_t size)
+{
+    return lfs_file_read(&lfs, file, buffer, size);
+}
+
+lfs_ssize_t LFS_FileWrite(lfs_file_t *file, const void *buffer, lfs_size_t size)
+{
+    return lfs_file_write(&lfs, file, buffer, size);
+}
+
+int LFS_FileSync(lfs_file_t *file)
+{
+    return lfs_file_sync(&lfs, file);
+}
+
+lfs_soff_t LFS_FileSeek(lfs_file_t *file, lfs_soff_t off, int whence)
+{
+    return lfs_file_seek(&lfs, file, off, whence);
+}
+
+int LFS_FileTruncate(lfs_file_t *file, lfs_off_t size)
+{
+    return lfs_file_truncate(&lfs, file, size);
+}
+
+lfs_soff_t LFS_FileTell(lfs_file_t *file)
+{
+    return lfs_file_tell(&lfs, file);
+}
+
+int LFS_FileRewind(lfs_file_t *file)
+{
+    return lfs_file_rewind(&lfs, file);
+}
+
+lfs_soff_t LFS_FileSize(lfs_file_t *file)
+{
+    return lfs_file_size(&lfs, file);
+}
+
+int LFS_DirOpen(lfs_dir_t *dir, const char *path)
+{
+    return lfs_dir_open(&lfs, dir, path);
+}
+
+int LFS_DirClose(lfs_dir_t *dir)
+{
+    return lfs_dir_close(&lfs, dir);
+}
+
+int LFS_DirRead(lfs_dir_t *dir, struct lfs_info *info)
+{
+    return lfs_dir_read(&lfs, dir, info);
+}
+
+int LFS_Statfs(lfs_status_t *status)
+{
+    lfs_ssize_t used = lfs_fs_size(&lfs);
+
+    if (used < 0)
+        return (int)used;
+
+    status->total_block = HT_MOCK_LFS_BLOCKS;
+    status->block_used = (uint32_t)used;
+    status->block_size = HT_MOCK_LFS_BLOCK_SIZE;
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file HT_Mock_Os.c
+ * @brief Manually driven kernel tick for host builds.
+ */
+
+#include "cmsis_os2.h"
+
+static uint32_t tickCount;
+
+uint32_t osKernelGetTickCount(void)
+{
+    return tickCount;
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return 1000;
+}
+
+void HT_MockOs_SetTick(uint32_t tick)
+{
+    tickCount = tick;
+}
+
+int32_t osKernelLock(void)
+{
+    return 0;
+}
+
+int32_t osKernelRestoreLock(int32_t lock)
+{
+    return lock;
+}
+
+osMutexId_t osMutexNew(const void *attr)
+{
+    static uint8_t mutex;
+
+    return &mutex;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    return osOK;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    return osOK;
+}
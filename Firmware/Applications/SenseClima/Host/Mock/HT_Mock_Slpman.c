@@ -0,0 +1,28 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "slpman_qcx212.h"
+
+// Same size as the UNLOAD_DRAM_USRNV region; zeroed like a blank flash image.
+static uint8_t usrNvMem[1024];
+
+uint8_t *slpManGetUsrNVMem(void)
+{
+    return usrNvMem;
+}
+
+void slpManUpdateUserNVMem(void)
+{
+}
@@ -0,0 +1,34 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file bsp.h
+ * @brief Host stand-in for the board support header.
+ *
+ * Only the pad/GPIO/delay subset used by the sensor drivers is declared here.
+ * Everything is implemented by HT_Mock_Gpio.c against a virtual clock.
+ */
+
+#ifndef __HOST_MOCK_BSP_H__
+#define __HOST_MOCK_BSP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pad_qcx212.h"
+#include "gpio_qcx212.h"
+
+void delay_us(uint32_t us);
+
+#endif /* __HOST_MOCK_BSP_H__ */
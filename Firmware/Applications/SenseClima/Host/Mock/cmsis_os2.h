@@ -0,0 +1,37 @@
+/**
+ * @file cmsis_os2.h
+ * @brief Host stand-in for the CMSIS-RTOS2 kernel tick and mutex subset.
+ */
+
+#ifndef __HOST_MOCK_CMSIS_OS2_H__
+#define __HOST_MOCK_CMSIS_OS2_H__
+
+#include <stdint.h>
+
+#define osWaitForever   0xFFFFFFFFU
+
+typedef enum {
+    osOK    = 0,
+    osError = -1
+} osStatus_t;
+
+typedef void *osMutexId_t;
+
+uint32_t osKernelGetTickCount(void);
+uint32_t osKernelGetTickFreq(void);
+
+/**
+ * @brief Sets the value returned by osKernelGetTickCount (1 kHz ticks).
+ */
+void HT_MockOs_SetTick(uint32_t tick);
+
+/* Single threaded: the scheduler lock only reports the previous state. */
+int32_t osKernelLock(void);
+int32_t osKernelRestoreLock(int32_t lock);
+
+/* Single threaded: mutexes always succeed. */
+osMutexId_t osMutexNew(const void *attr);
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+osStatus_t osMutexRelease(osMutexId_t mutex_id);
+
+#endif /* __HOST_MOCK_CMSIS_OS2_H__ */
@@ -0,0 +1,44 @@
+/**
+ * @file flash_qcx212_rt.h
+ * @brief Host stand-in for the QSPI flash driver (safe erase/write/read
+ *        subset) over a RAM image with NOR semantics.
+ */
+
+#ifndef __HOST_MOCK_FLASH_QCX212_RT_H__
+#define __HOST_MOCK_FLASH_QCX212_RT_H__
+
+#include <stdint.h>
+
+#define QSPI_OK            ((uint8_t)0x00)
+#define QSPI_ERROR         ((uint8_t)0x01)
+
+#define HT_MOCK_FLASH_SIZE 0x400000
+
+uint8_t BSP_QSPI_Erase_Safe(uint32_t SectorAddress, uint32_t Size);
+uint8_t BSP_QSPI_Write_Safe(uint8_t* pData, uint32_t WriteAddr, uint32_t Size);
+uint8_t BSP_QSPI_Read_Safe(uint8_t* pData, uint32_t WriteAddr, uint32_t Size);
+
+/**
+ * @brief Places the image in shared memory, so it outlives forked "boots".
+ */
+void HT_MockFlash_Init(void);
+
+/**
+ * @brief Makes the next write program only its first len bytes and then
+ *        end the process, as a reset in the middle of a page program.
+ */
+void HT_MockFlash_TearNextWrite(uint32_t len);
+
+/**
+ * @brief Operation counters since HT_MockFlash_Init, across processes.
+ */
+typedef struct {
+    uint32_t erases;
+    uint32_t writes;
+    uint32_t writeBytes;
+    uint32_t reads;
+} HT_MockFlashCounters;
+
+const HT_MockFlashCounters *HT_MockFlash_Counters(void);
+
+#endif /* __HOST_MOCK_FLASH_QCX212_RT_H__ */
@@ -0,0 +1,36 @@
+/**
+ * @file gpio_qcx212.h
+ * @brief Host stand-in for the QCX212 GPIO driver (subset).
+ */
+
+#ifndef __HOST_MOCK_GPIO_QCX212_H__
+#define __HOST_MOCK_GPIO_QCX212_H__
+
+#include <stdint.h>
+
+typedef enum {
+    GPIO_DirectionInput  = 0U,
+    GPIO_DirectionOutput = 1U
+} gpio_pin_direction_t;
+
+typedef enum {
+    GPIO_InterruptDisabled    = 0U,
+    GPIO_InterruptLowLevel    = 1U,
+    GPIO_InterruptHighLevel   = 2U,
+    GPIO_InterruptFallingEdge = 3U,
+    GPIO_InterruptRisingEdge  = 4U
+} gpio_interrupt_config_t;
+
+typedef struct {
+    gpio_pin_direction_t pinDirection;
+    union {
+        gpio_interrupt_config_t interruptConfig;
+        uint32_t                initOutput;
+    } misc;
+} gpio_pin_config_t;
+
+void GPIO_PinConfig(uint32_t port, uint16_t pin, const gpio_pin_config_t *config);
+void GPIO_PinWrite(uint32_t port, uint16_t pinMask, uint16_t output);
+uint32_t GPIO_PinRead(uint32_t port, uint16_t pin);
+
+#endif /* __HOST_MOCK_GPIO_QCX212_H__ */
@@ -0,0 +1,78 @@
+/**
+ * @file l2ctls_qcx212.h
+ * @brief Host stand-in for the L2C crypto engine driver: reference AES
+ *        (ECB/CBC, 128/192-bit keys) and SHA-224/256 with call counters.
+ */
+
+#ifndef __HOST_MOCK_L2CTLS_QCX212_H__
+#define __HOST_MOCK_L2CTLS_QCX212_H__
+
+#include <stdint.h>
+
+typedef enum
+{
+    L2C_SHA_TYPE_1 = 0,
+    L2C_SHA_TYPE_224 = 1,
+    L2C_SHA_TYPE_256 = 2,
+} L2CSHAType;
+
+typedef enum
+{
+    L2C_AES_MODE = 0,
+    L2C_SHA_MODE = 1,
+} L2CModeType;
+
+typedef struct
+{
+    uint32_t Encrypt : 1;
+    uint32_t ChainMode : 2;
+    uint32_t PaddingMode : 3;
+    uint32_t KeySize : 2;
+    uint32_t KeyType : 1;
+    uint32_t Reserved0 : 7;
+    uint32_t Reserved1 : 16;
+} L2CTlsAesCtrl;
+
+typedef struct L2CTlsAesStruct_Tag {
+    uint32_t IVAddress;
+    uint32_t InputData;
+    uint32_t OutputData;
+    uint32_t KeyAddress;
+    uint32_t DataLen;
+    uint32_t HeadLen;
+    L2CTlsAesCtrl Ctrl;
+} L2CTlsAesStruct;
+
+#define L2CTLSDRV_OK            0
+#define L2CTLSDRV_BusyErr       (-1)
+#define L2CTLSDRV_UnsupportErr  (-4)
+#define L2CTLSDRV_ParameterErr  (-5)
+
+void L2CTlsInit(void);
+void L2CTlsDeInit(void);
+int32_t L2CTlsCheckMode(L2CModeType ModeType, L2CSHAType ShaType);
+void L2CShaComInit(L2CSHAType ShaType);
+int32_t L2CShaUpdate(uint32_t SrcAddr, uint32_t DstAddr, uint32_t Lenth, uint32_t LastFlag);
+int32_t L2CTlsAesProcess(L2CTlsAesStruct *AESInfoPtr);
+
+/**
+ * @brief Engine work since the last HT_MockL2c_Reset.
+ */
+typedef struct {
+    uint32_t aesCalls;          /**< L2CTlsAesProcess calls. */
+    uint32_t aesBlocks;         /**< 16-byte blocks processed. */
+    uint32_t shaCalls;          /**< L2CShaUpdate calls. */
+    uint32_t shaBlocks;         /**< Compressions, padding included. */
+    uint32_t inits;             /**< L2CTlsInit calls: clock ungated. */
+    uint32_t errors;            /**< Calls rejected for bad parameters or state. */
+} HT_MockL2cCounters;
+
+void HT_MockL2c_Reset(void);
+const HT_MockL2cCounters *HT_MockL2c_Counters(void);
+
+/**
+ * @brief Makes one engine call fail with L2CTLSDRV_BusyErr, after calls more succeed.
+ */
+void HT_MockL2c_FailAfter(uint32_t calls);
+
+#endif /* __HOST_MOCK_L2CTLS_QCX212_H__ */
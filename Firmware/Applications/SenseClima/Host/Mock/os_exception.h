@@ -0,0 +1,10 @@
+/**
+ * @file os_exception.h
+ * @brief Host stand-in for the SDK exception header included by
+ *        lfs_util.h: littlefs asserts go to lfs_assert (HT_Mock_LfsRam.c).
+ */
+
+#ifndef __HOST_MOCK_OS_EXCEPTION_H__
+#define __HOST_MOCK_OS_EXCEPTION_H__
+
+#endif /* __HOST_MOCK_OS_EXCEPTION_H__ */
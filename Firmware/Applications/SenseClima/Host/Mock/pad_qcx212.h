@@ -0,0 +1,42 @@
+/**
+ * @file pad_qcx212.h
+ * @brief Host stand-in for the QCX212 pad driver (subset).
+ */
+
+#ifndef __HOST_MOCK_PAD_QCX212_H__
+#define __HOST_MOCK_PAD_QCX212_H__
+
+#include <stdint.h>
+
+typedef enum {
+    PAD_MuxAlt0 = 0U,
+    PAD_MuxAlt1,
+    PAD_MuxAlt2,
+    PAD_MuxAlt3,
+    PAD_MuxAlt4,
+    PAD_MuxAlt5,
+    PAD_MuxAlt6,
+    PAD_MuxAlt7
+} pad_mux_t;
+
+typedef enum {
+    PAD_InternalPullUp   = 0U,
+    PAD_InternalPullDown = 1U,
+    PAD_AutoPull         = 2U
+} pad_pull_config_t;
+
+typedef struct {
+    uint32_t  pullSelect;
+    uint32_t  pullUpEnable;
+    uint32_t  pullDownEnable;
+    pad_mux_t mux;
+    uint32_t  inputForceDisable;
+    uint32_t  swOutputEnable;
+    uint32_t  swOutputValue;
+} pad_config_t;
+
+void PAD_GetDefaultConfig(pad_config_t *config);
+void PAD_SetPinConfig(uint32_t pin, const pad_config_t *config);
+void PAD_SetPinPullConfig(uint32_t pin, pad_pull_config_t config);
+
+#endif /* __HOST_MOCK_PAD_QCX212_H__ */
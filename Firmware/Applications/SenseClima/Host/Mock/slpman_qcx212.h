@@ -0,0 +1,14 @@
+/**
+ * @file slpman_qcx212.h
+ * @brief Host stand-in for the sleep manager (user NVMem subset).
+ */
+
+#ifndef __HOST_MOCK_SLPMAN_QCX212_H__
+#define __HOST_MOCK_SLPMAN_QCX212_H__
+
+#include <stdint.h>
+
+uint8_t *slpManGetUsrNVMem(void);
+void slpManUpdateUserNVMem(void);
+
+#endif /* __HOST_MOCK_SLPMAN_QCX212_H__ */
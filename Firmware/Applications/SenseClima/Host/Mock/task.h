@@ -0,0 +1,14 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for the FreeRTOS scheduler lock used by the drivers.
+ */
+
+#ifndef __HOST_MOCK_TASK_H__
+#define __HOST_MOCK_TASK_H__
+
+#include <stdint.h>
+
+void vTaskSuspendAll(void);
+int32_t xTaskResumeAll(void);
+
+#endif /* __HOST_MOCK_TASK_H__ */
@@ -0,0 +1,124 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Adc.h
+ * @brief Oversampled battery, die temperature and analog input readings.
+ *
+ * HT_Adc_Start queues one conversion on every channel as the APP user of
+ * the SDK ADC driver. Each completion callback, in the ADC interrupt, adds
+ * the raw code to the channel sum and queues the next conversion until
+ * HT_ADC_OVERSAMPLE codes are summed, so the channels interleave in the
+ * driver FIFO and the caller is free meanwhile. HT_Adc_Wait blocks only
+ * for what is left.
+ *
+ * The sum is converted in one step with the two point efuse calibration
+ * (codes at 500 mV and 900 mV, BatMon_EfuseDataGet), which keeps the
+ * fraction of a code that averaging gains. Parts without efuse data fall
+ * back to BatMon_CalibrateRawCode on the rounded mean. VBAT is sampled
+ * through the 3/16 divider, which keeps 4.2 V inside the calibrated span.
+ *
+ * The analog input (HT_ADC_AIO_ENABLE in the Makefile) reads AIO2 without
+ * divider, 0 to 1.2 V.
+ */
+
+#ifndef __HT_ADC_H__
+#define __HT_ADC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_ADC_OVERSAMPLE       16      /**< Conversions summed per channel and reading. */
+#define HT_ADC_TIMEOUT_MS       100     /**< Default HT_Adc_Wait timeout; a reading takes a few ms. */
+#define HT_ADC_TEMP_INVALID     INT16_MIN /**< temp_x10 when the efuse holds no thermal data. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Channels of a reading.
+ */
+typedef enum {
+    HT_ADC_VBAT = 0,            /**< Battery, through the internal divider. */
+    HT_ADC_THERMAL,             /**< Internal die temperature sensor. */
+#ifdef HT_ADC_AIO_ENABLE
+    HT_ADC_AIO,                 /**< External analog input. */
+#endif
+    HT_ADC_CHANNELS
+} HT_AdcChannel;
+
+/**
+ * @brief One calibrated reading.
+ */
+typedef struct {
+    uint16_t vbat_mv;           /**< Battery voltage in mV, 0 if not measured. */
+    int16_t temp_x10;           /**< Die temperature in 0.1 C, HT_ADC_TEMP_INVALID if not measured. */
+    uint16_t aio_mv;            /**< Analog input in mV, 0 if disabled or not measured. */
+    uint8_t valid;              /**< Bit (1 << HT_AdcChannel) set for each measured channel. */
+} HT_AdcReading;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Configures the channels and loads the efuse calibration.
+ *
+ * Called once per boot before HT_Adc_Start.
+ */
+void HT_Adc_Init(void);
+
+/**
+ * @brief Queues the oversampled conversions of every channel and returns.
+ * @return 0 on success, -1 if a reading is still in progress.
+ */
+int32_t HT_Adc_Start(void);
+
+/**
+ * @brief Waits for the reading started by HT_Adc_Start and calibrates it.
+ * @param timeout_ms Longest wait in milliseconds.
+ * @param out Receives the reading; channels that did not complete are
+ *            left out of valid. May be NULL.
+ * @return 0 if every channel completed, -1 otherwise.
+ */
+int32_t HT_Adc_Wait(uint32_t timeout_ms, HT_AdcReading *out);
+
+/**
+ * @brief Returns the last reading of this boot (valid is 0 before the first).
+ */
+const HT_AdcReading *HT_Adc_Last(void);
+
+/**
+ * @brief Writes the last reading and the error count as a JSON member.
+ *
+ * Format: "adc":{"vbat":mV,"temp":0.1C,"aio":mV,"cal":0|1,"ms":N,"err":N}
+ * where cal tells whether efuse calibration is used, ms is the duration of
+ * the last reading and err counts failed conversions and timeouts.
+ *
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written, as snprintf.
+ */
+int HT_Adc_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_ADC_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,136 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Aggregate.h
+ * @brief Streaming per-window statistics of the temperature and humidity samples.
+ *
+ * Every sample updates a running mean and variance (Welford) together with
+ * the minimum and maximum and the time they occurred. At the end of an
+ * upload window the statistics are published as one compact JSON record
+ * instead of the individual readings, then the window restarts.
+ *
+ * All arithmetic is fixed point. The running mean is kept in Q8 of the
+ * sensor unit (0.1 C or 0.1 %RH) so rounding does not accumulate over long
+ * windows. Timestamps are seconds of the retained device clock
+ * (HT_Retained_Now).
+ */
+
+#ifndef __HT_AGGREGATE_H__
+#define __HT_AGGREGATE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_AGGREGATE_MEAN_SHIFT     8   /**< Fractional bits of the running mean. */
+#define HT_AGGREGATE_RECORD_SIZE    256 /**< Buffer size sufficient for HT_Aggregate_Format. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Statistics of one channel over the current window.
+ */
+typedef struct {
+    int32_t  mean_q8;       /**< Running mean, Q8 of 0.1 units. */
+    int16_t  min;           /**< Smallest sample (0.1 units). */
+    int16_t  max;           /**< Largest sample (0.1 units). */
+    uint64_t m2_q16;        /**< Sum of squared deviations, Q16 of (0.1 units)^2. */
+    uint32_t minAt_s;       /**< Device time of the minimum. */
+    uint32_t maxAt_s;       /**< Device time of the maximum. */
+} HT_AggChannel;
+
+/**
+ * @brief Window state, kept in retained memory between wakes.
+ */
+typedef struct {
+    uint32_t start_s;       /**< Device time the window was opened. */
+    uint32_t last_s;        /**< Device time of the latest sample. */
+    uint32_t count;         /**< Samples in the window. */
+    HT_AggChannel temp;     /**< Temperature (0.1 C). */
+    HT_AggChannel humi;     /**< Relative humidity (0.1 %RH). */
+} HT_AggregateState;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Starts an empty window.
+ * @param st Window state.
+ * @param now_s Device time the window opens.
+ */
+void HT_Aggregate_Reset(HT_AggregateState *st, uint32_t now_s);
+
+/**
+ * @brief Adds one sample to the window.
+ * @param st Window state.
+ * @param now_s Device time of the sample.
+ * @param temp_x10 Temperature in 0.1 C.
+ * @param humi_x10 Humidity in 0.1 %RH.
+ */
+void HT_Aggregate_Add(HT_AggregateState *st, uint32_t now_s, int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief HT_Aggregate_Add on the retained window at the current device time, then commits it.
+ */
+void HT_Aggregate_Update(int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief Tells whether the retained window has reached the upload window.
+ * @param window_s Upload window: upload_window_s stretched by the battery tier.
+ * @return 1 if the window holds samples and is at least window_s old, 0 otherwise.
+ */
+uint8_t HT_Aggregate_WindowDue(uint32_t window_s);
+
+/**
+ * @brief Restarts the retained window at the current device time and commits it.
+ */
+void HT_Aggregate_Restart(void);
+
+/**
+ * @brief Writes a window as the compact aggregate record.
+ *
+ * {"n":N,"t0":T,"dur":S,"t":[mean,sd,min,min_dt,max,max_dt],"h":[...],"dp":D,"ah":A,"vb":V}
+ * Temperature, humidity, their means and the dew point are in 0.1 units,
+ * standard deviations in 0.01 units, absolute humidity in 0.01 g/m3.
+ * min_dt/max_dt are seconds from t0. Dew point and absolute humidity are
+ * derived from the window means. vb is the battery voltage in mV at upload.
+ *
+ * @param st Window state.
+ * @param vbat_mv Battery voltage in mV, 0 if not measured.
+ * @param buf Output buffer (HT_AGGREGATE_RECORD_SIZE is enough).
+ * @param len Size of the output buffer.
+ * @return Number of characters written, 0 if the window is empty or the buffer too small.
+ */
+int HT_Aggregate_Format(const HT_AggregateState *st, uint16_t vbat_mv, char *buf, size_t len);
+
+/**
+ * @brief Writes the retained window summary as a JSON member ("aggregate":{...}).
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written.
+ */
+int HT_Aggregate_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_AGGREGATE_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,167 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Alarm.h
+ * @brief Threshold alarm rules evaluated on every sample.
+ *
+ * A rule watches one channel (temperature or humidity) for crossing a bound
+ * upwards or downwards. It trips when the sample goes past the threshold and
+ * only re-arms once the sample has come back by the hysteresis, so noise
+ * around the bound does not toggle it. A trip preempts the upload schedule:
+ * the wake brings the link up and publishes the alarm at QoS1, even if the
+ * sample was taken with the radio off.
+ *
+ * Alarm uploads are rate limited by the alarm_holdoff configuration, counted
+ * from the last publish and from the last preempting attempt, successful or
+ * not. A trip inside the holdoff stays pending and goes out with the next
+ * upload, or on the first wake after the holdoff if the rule is still active.
+ *
+ * Rules are set with "<index>=<t|h><'>'|'<'><threshold>/<hysteresis>" pairs,
+ * values in 0.1 units, e.g. "0=t>300/10;1=h<200/20" or "1=off".
+ */
+
+#ifndef __HT_ALARM_H__
+#define __HT_ALARM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_ALARM_MAX_RULES          4       /**< Number of rule slots. */
+#define HT_ALARM_DEFAULT_HOLDOFF_S  600     /**< Minimum time between preempting alarm uploads. */
+#define HT_ALARM_RECORD_SIZE        96      /**< Buffer size sufficient for HT_Alarm_Format. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Channel watched by a rule.
+ */
+typedef enum {
+    HT_ALARM_TEMPERATURE = 0,   /**< Temperature (0.1 C). */
+    HT_ALARM_HUMIDITY           /**< Relative humidity (0.1 %RH). */
+} HT_AlarmChannel;
+
+/**
+ * @brief One alarm rule and its trip state.
+ */
+typedef struct {
+    uint8_t  enabled;       /**< 1 if the slot holds a rule. */
+    uint8_t  channel;       /**< HT_AlarmChannel. */
+    uint8_t  above;         /**< 1 trips above the threshold, 0 below it. */
+    uint8_t  active;        /**< 1 while tripped and not yet re-armed. */
+    int16_t  threshold;     /**< Bound in 0.1 units. */
+    uint16_t hysteresis;    /**< Distance back past the bound needed to re-arm (0.1 units). */
+    int16_t  tripValue;     /**< Sample that tripped the rule. */
+    uint32_t tripAt_s;      /**< Device time of the trip. */
+} HT_AlarmRule;
+
+/**
+ * @brief Alarm rules and rate limiting state, kept in retained memory.
+ */
+typedef struct {
+    HT_AlarmRule rules[HT_ALARM_MAX_RULES];
+    uint8_t  pending;       /**< Bit mask of trips not yet published. */
+    uint32_t lastSent_s;    /**< Device time of the last alarm publish. */
+    uint32_t lastTry_s;     /**< Device time of the last preempting upload attempt. */
+    uint32_t tries;         /**< Preempting upload attempts. */
+    uint32_t sent;          /**< Alarms published. */
+    uint32_t suppressed;    /**< Trips that cleared before they could be published. */
+} HT_AlarmState;
+
+/**
+ * @brief Result codes of HT_Alarm_Apply.
+ */
+typedef enum {
+    HT_ALARM_OK         = 0,    /**< Rules applied. */
+    HT_ALARM_BAD_INDEX  = -1,   /**< Rule index out of range. */
+    HT_ALARM_SYNTAX     = -2    /**< Malformed rule. */
+} HT_AlarmStatus;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Clears every rule and the rate limiting state.
+ * @param st Alarm state.
+ */
+void HT_Alarm_Reset(HT_AlarmState *st);
+
+/**
+ * @brief Evaluates every rule against a sample.
+ * @param st Alarm state.
+ * @param now_s Device time of the sample.
+ * @param holdoff_s Minimum time between alarm publishes, and between preempting attempts.
+ * @param temp_x10 Temperature in 0.1 C.
+ * @param humi_x10 Humidity in 0.1 %RH.
+ * @return 1 if pending alarms must be published now, recorded as an attempt; 0 otherwise.
+ */
+uint8_t HT_Alarm_Step(HT_AlarmState *st, uint32_t now_s, uint32_t holdoff_s, int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief HT_Alarm_Step on the retained state at the current device time, then commits it.
+ * @return 1 if the upload schedule must be preempted, 0 otherwise.
+ */
+uint8_t HT_Alarm_Evaluate(int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief Returns the bit mask of retained alarms waiting to be published.
+ */
+uint8_t HT_Alarm_Pending(void);
+
+/**
+ * @brief Writes the alarm record of a rule.
+ *
+ * {"rule":I,"ch":"t","op":">","th":300,"hy":10,"v":312,"at":T}
+ *
+ * @param index Rule index.
+ * @param buf Output buffer (HT_ALARM_RECORD_SIZE is enough).
+ * @param len Size of the output buffer.
+ * @return Number of characters written, 0 on error.
+ */
+int HT_Alarm_Format(uint8_t index, char *buf, size_t len);
+
+/**
+ * @brief Marks the alarm of a rule as published and commits it.
+ * @param index Rule index.
+ */
+void HT_Alarm_MarkSent(uint8_t index);
+
+/**
+ * @brief Applies a list of rule definitions separated by ';' or newlines, and persists them.
+ * @param payload Text to parse (need not be NUL terminated).
+ * @param len Length of the payload.
+ * @return HT_ALARM_OK or the status of the first failing rule; earlier rules stay applied.
+ */
+HT_AlarmStatus HT_Alarm_Apply(const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Writes the alarm summary as a JSON member ("alarm":{...}).
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written.
+ */
+int HT_Alarm_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_ALARM_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
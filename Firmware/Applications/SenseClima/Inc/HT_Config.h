@@ -0,0 +1,136 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Config.h
+ * @brief Runtime configuration of the SenseClima application.
+ *
+ * All tunables live in one flat structure kept in retained memory (see
+ * HT_Retained.h), so they survive hibernate and power cycles. Values are
+ * changed by name with "key=value" pairs, which is the format accepted on
+ * the MQTT config topic.
+ */
+
+#ifndef __HT_CONFIG_H__
+#define __HT_CONFIG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_CONFIG_DEFAULT_INTERVAL_S    60      /**< Fixed sample/upload period in seconds. */
+#define HT_CONFIG_MAX_INTERVAL_S        86400   /**< Upper bound accepted for any period. */
+#define HT_CONFIG_REPORT_RAW            0       /**< report_mode: publish every reading. */
+#define HT_CONFIG_REPORT_AGGREGATE      1       /**< report_mode: publish one aggregate record per window. */
+#define HT_CONFIG_MAX_UART_IDLE_MS      60000   /**< Upper bound of uart_idle_ms. */
+#define HT_CONFIG_MAX_CONNECT_S         600     /**< Upper bound of connect_s. */
+#define HT_CONFIG_TIERS                 3       /**< Battery tiers with their own settings (see HT_Power.h). */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Operating settings of one battery tier.
+ */
+typedef struct {
+    uint32_t scale;             /**< Multiplier of the sample period. */
+    uint32_t batch;             /**< Raw mode: upload every batch-th reading; aggregate mode: window multiplier. */
+    uint32_t qos;               /**< MQTT QoS of the data publishes. */
+    uint32_t log;               /**< Lowest HT_LOG level emitted (HT_LOG_LEVEL_*). */
+} HT_ConfigTier;
+
+/**
+ * @brief Persisted application configuration.
+ */
+typedef struct {
+    uint32_t interval_s;        /**< Fixed sample period, also the adaptive starting point. */
+    uint32_t adaptive;          /**< 1 enables the rate-of-change sampler, 0 uses interval_s. */
+    uint32_t min_interval_s;    /**< Shortest period the adaptive sampler may choose. */
+    uint32_t max_interval_s;    /**< Longest period the adaptive sampler may choose. */
+    uint32_t temp_tol_x10;      /**< Temperature change tolerated between samples (0.1 C). */
+    uint32_t humi_tol_x10;      /**< Humidity change tolerated between samples (0.1 %RH). */
+    uint32_t ew_shift;          /**< EW filter weight as a shift: alpha = 1 / 2^ew_shift. */
+    uint32_t report_mode;       /**< HT_CONFIG_REPORT_RAW or HT_CONFIG_REPORT_AGGREGATE. */
+    uint32_t upload_window_s;   /**< Aggregate mode: seconds of samples per uploaded record. */
+    uint32_t alarm_holdoff_s;   /**< Minimum time between alarm publishes. */
+    uint32_t uart_idle_ms;      /**< Debug UART clock is gated after this long without traffic, 0 never gates. */
+    uint32_t saver_pct;         /**< Battery charge (%) below which the saver tier applies. */
+    uint32_t low_pct;           /**< Battery charge (%) below which the low tier applies. */
+    uint32_t critical_pct;      /**< Battery charge (%) below which the device goes into last gasp. */
+    uint32_t horizon_h;         /**< Hours of battery trend looked ahead when picking the tier, 0 ignores the trend. */
+    uint32_t connect_s;         /**< Seconds an upload wake may wait for the SIM, the network and the broker. */
+    HT_ConfigTier tier[HT_CONFIG_TIERS]; /**< Normal, saver and low tier settings. */
+} HT_ConfigData;
+
+/**
+ * @brief Result codes of the configuration setters.
+ */
+typedef enum {
+    HT_CONFIG_OK            = 0,   /**< Value applied. */
+    HT_CONFIG_UNKNOWN_KEY   = -1,  /**< No such key. */
+    HT_CONFIG_BAD_VALUE     = -2,  /**< Value not numeric or out of range. */
+    HT_CONFIG_SYNTAX        = -3   /**< Malformed "key=value" pair. */
+} HT_ConfigStatus;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Fills a configuration with factory defaults.
+ * @param cfg Configuration to initialize.
+ */
+void HT_Config_Defaults(HT_ConfigData *cfg);
+
+/**
+ * @brief Returns the live configuration (stored in retained memory).
+ */
+HT_ConfigData *HT_Config_Get(void);
+
+/**
+ * @brief Sets one configuration value by name and persists it.
+ * @param key Key name, e.g. "interval".
+ * @param value Decimal value as text.
+ * @return HT_CONFIG_OK or a negative HT_ConfigStatus.
+ */
+HT_ConfigStatus HT_Config_Set(const char *key, const char *value);
+
+/**
+ * @brief Applies a list of "key=value" pairs separated by ';', ',' or newlines.
+ *
+ * Pairs are applied in order; the first failing pair stops the parse.
+ *
+ * @param payload Text to parse (need not be NUL terminated).
+ * @param len Length of the payload.
+ * @return HT_CONFIG_OK or the status of the first failing pair.
+ */
+HT_ConfigStatus HT_Config_Apply(const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief Writes every key as "key=value" pairs separated by ';'.
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written (excluding the terminator).
+ */
+int HT_Config_Format(char *buf, size_t len);
+
+#endif /* __HT_CONFIG_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
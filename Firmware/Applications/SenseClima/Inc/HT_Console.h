@@ -0,0 +1,98 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Console.h
+ * @brief Line console on the debug UART (UART1, 115200 8N1).
+ *
+ * Reception runs on DMA into a ring; the USART reports a frame each time
+ * the line goes idle, so there is no interrupt per byte. Lines end with
+ * CR or LF. Commands:
+ *
+ *   help                   list the commands
+ *   get                    print the configuration as "key=value" pairs
+ *   set key=value[;...]    apply pairs, same syntax as the MQTT config topic
+ *   diag                   print the diagnostics record
+ *   cycle                  sample and upload now instead of at the next wakeup
+ *   ts [seconds]           print the stored readings of the last seconds (3600)
+ *                          as "t_s temp humi vbat_mv flags", oldest first
+ *   dtls host text         send text over DTLS to host:HT_DTLS_PORT, print the
+ *                          reply and keep the connection (HT_DTLS builds)
+ *
+ * The first received line opens a session, which keeps the device out of
+ * sleep until HT_CONSOLE_SESSION_MS pass without input. With nothing
+ * connected the RX line stays idle and the console never votes.
+ *
+ * When the print ring is empty and nothing was received for the uart_idle
+ * configuration (milliseconds, 0 disables it), the UART functional clock
+ * is gated (HAL_USART_PrintGate). Any printf starts it again. UART1 RX is
+ * not a wakeup pad, so while gated the RX pad is switched to its GPIO with
+ * a falling edge interrupt instead: the first character typed into a gated
+ * console only wakes it and is lost.
+ */
+
+#ifndef __HT_CONSOLE_H__
+#define __HT_CONSOLE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_CONSOLE_RING_SIZE        256         /**< DMA receive ring. */
+#define HT_CONSOLE_LINE_MAX         96          /**< Longest accepted command line. */
+#define HT_CONSOLE_SESSION_MS       30000       /**< Sleep is held this long after the last input. */
+#if defined(HT_DTLS)
+#define HT_CONSOLE_STACK_SIZE       (1024*4)    /**< Console task stack, the dtls command runs the handshake. */
+#else
+#define HT_CONSOLE_STACK_SIZE       (1024*2)    /**< Console task stack (printf and the diagnostics buffer). */
+#endif
+
+#define HT_CONSOLE_RX_GPIO_INSTANCE 0           /**< GPIO behind the UART1 RX pad (RTE_UART1_RX_PAD_ID). */
+#define HT_CONSOLE_RX_GPIO_PIN      13
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Starts DMA reception on the debug UART and the console task.
+ *
+ * Call after HAL_USART_InitPrint and HT_Retained_Init.
+ */
+void HT_Console_Init(void);
+
+/**
+ * @brief Writes the console counters as a JSON member.
+ *
+ * Format: "console":{"lines":N,"err":N,"drop":N,"uart_ms":N,"gates":N}
+ * where err counts UART line errors, drop counts bytes lost to a full ring
+ * or an overlong line, uart_ms is the time the UART clock ran since boot
+ * and gates how many times it was gated.
+ *
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written (excluding the terminator), as snprintf.
+ */
+int HT_Console_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_CONSOLE_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,87 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_CryptoBench.h
+ * @brief On-target comparison of TLS crypto in software and on the L2C engine.
+ *
+ * Built with HT_CRYPTO_BENCH = y in the application Makefile (which needs
+ * HT_TLS_HW_CRYPTO = y). HT_CryptoBench_Run encrypts the same records with
+ * AES-128-GCM and AES-128-CCM, and runs the HMAC-SHA256 of a PRF step, once
+ * with the engine disabled and once enabled, checks both give the same
+ * result and logs the rates. Handshakes are compared across wakes: the
+ * engine is switched off on even wakes and on on odd ones, and every
+ * handshake is logged with the engine state and counters.
+ *
+ * The host counterpart, with an engine model, is Host/HT_Crypto_Bench.c.
+ */
+
+#ifndef __HT_CRYPTO_BENCH_H__
+#define __HT_CRYPTO_BENCH_H__
+
+#include <stdint.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_CRYPTO_BENCH_RECORD      1024    /**< Plaintext bytes per record, the negotiated max fragment length. */
+#define HT_CRYPTO_BENCH_RECORDS     32      /**< Records per cipher and engine state. */
+#define HT_CRYPTO_BENCH_HMACS       256     /**< HMAC-SHA256 runs per engine state. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Rates of one engine state.
+ */
+typedef struct {
+    uint32_t gcm_bps;           /**< AES-128-GCM record encryption, plaintext bytes per second. */
+    uint32_t ccm_bps;           /**< AES-128-CCM record encryption, plaintext bytes per second. */
+    uint32_t hmac_ps;           /**< HMAC-SHA256 of a 77 byte PRF seed, per second. */
+    uint32_t hw_calls;          /**< AES engine calls. */
+    uint32_t sw_blocks;         /**< AES blocks run in software. */
+    uint32_t sha_hw;            /**< Digests computed by the engine. */
+} HT_CryptoBenchRates;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Runs the record and HMAC comparison and logs it.
+ * @param result Receives the software [0] and engine [1] rates. May be NULL.
+ * @return 0 on success, -1 if the engine and software results differ.
+ */
+int32_t HT_CryptoBench_Run(HT_CryptoBenchRates result[2]);
+
+/**
+ * @brief Enables the engine on odd wakes, disables it on even ones.
+ *
+ * Call before the TLS handshake.
+ */
+void HT_CryptoBench_SelectEngine(void);
+
+/**
+ * @brief Logs a handshake duration with the engine state and counters.
+ * @param handshake_ms Duration reported by HT_MQTT_TLSConnect.
+ */
+void HT_CryptoBench_Handshake(uint32_t handshake_ms);
+
+#endif /* __HT_CRYPTO_BENCH_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -9,6 +9,19 @@
 #define DHT22_GPIO_PIN      2
 #define DHT22_PAD_ID        13
 
+// Timeout values in microseconds for the read loop (converted to poll iterations
+// with the boot calibration, see DHT22_Calibrate).
+// Overridable at build time so they can be tuned with the host simulator (Host/).
+#ifndef DHT22_TIMEOUT_RESPONSE_START
+#define DHT22_TIMEOUT_RESPONSE_START    80
+#endif
+#ifndef DHT22_TIMEOUT_RESPONSE_PULSE
+#define DHT22_TIMEOUT_RESPONSE_PULSE    150
+#endif
+#ifndef DHT22_TIMEOUT_DATA_PULSE
+#define DHT22_TIMEOUT_DATA_PULSE        100
+#endif
+
 /**
  * @brief Enum for DHT22_Read function return codes.
  */
@@ -26,6 +39,20 @@ typedef enum {
  */
 void DHT22_Init(void);
 
+/**
+ * @brief Measures the pulse poll loop speed against the core cycle counter.
+ *
+ * Called by DHT22_Init on the first initialization after boot. The data line
+ * must be idle (high). Falls back to a conservative default if the cycle
+ * counter is not available or the line is not idle.
+ */
+void DHT22_Calibrate(void);
+
+/**
+ * @brief Returns the calibrated poll loop speed, in iterations per microsecond (Q8).
+ */
+uint32_t DHT22_LoopsPerUsQ8(void);
+
 /**
  * @brief Reads temperature and humidity from the DHT22 sensor.
  * @param temperature Pointer to store the read temperature.
@@ -0,0 +1,53 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Diag.h
+ * @brief Diagnostics record published alongside the sensor data.
+ *
+ * The record is a single JSON object. Each module contributes one member
+ * through its *_DiagFormat function; HT_Diag_Format stitches them together.
+ */
+
+#ifndef __HT_DIAG_H__
+#define __HT_DIAG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_DIAG_BUFFER_SIZE     960     /**< Size of the diagnostics payload buffer. */
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Builds the diagnostics JSON object.
+ * @param buf Output buffer.
+ * @param len Size of the output buffer (HT_DIAG_BUFFER_SIZE is enough).
+ * @return Length of the payload, or 0 if it did not fit.
+ */
+int HT_Diag_Format(char *buf, size_t len);
+
+#endif /* __HT_DIAG_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,120 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Dtls.h
+ * @brief DTLS 1.2 over UDP with Connection ID, kept across hibernate.
+ *
+ * Secure datagram transport to a DTLS server, PSK-AES-128-CCM-8 with the
+ * credentials of HT_Psk.h. The client offers the Connection ID extension
+ * (RFC 9146) with an empty CID of its own and uses the one the server
+ * hands out: the server then finds the connection by CID rather than by
+ * address, and a wake that comes back from a new NAT binding or a new
+ * source port is still the same connection.
+ *
+ * At close the whole connection, keys, record sequence numbers and CID,
+ * is serialized into the retained TLS slot (HT_TlsSession.h) instead of
+ * being torn down. The next open loads it and the first datagram is
+ * application data: no handshake round trip at all. A stored connection
+ * is only loaded after an orderly sleep (sleep2 or hibernate), or if it
+ * was kept earlier in this boot: after a reset the flash copy may predate
+ * records already sent with it, and loading it would send two records
+ * with the same sequence number, i.e. reuse a CCM nonce. It is then only
+ * mined for its session and resumed with an abbreviated handshake, which
+ * derives fresh keys.
+ *
+ * A server that no longer knows the connection drops its records
+ * silently; the first exchange times out and is retried once after a
+ * handshake resuming the session, then a full one if that is refused.
+ * A server without Connection ID support gets the session kept instead:
+ * one round trip per wake.
+ *
+ * mbedtls 2.23 implements draft 05 of the extension, not the final RFC:
+ * extension type 254 instead of 54, and the draft's additional data for
+ * the record AEAD. The server has to speak the draft;
+ * Debug/Scripts/dtls_server.py is a local stand-in that does.
+ */
+
+#ifndef __HT_DTLS_H__
+#define __HT_DTLS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_DTLS_PORT                5684    /**< DTLS server port (CoAPS). */
+#define HT_DTLS_MTU                 1280    /**< Largest datagram sent, IP and UDP headers included. */
+#define HT_DTLS_HANDSHAKE_MIN_MS    2000    /**< First handshake retransmission timeout, doubled each time. */
+#define HT_DTLS_HANDSHAKE_MAX_MS    16000   /**< Handshake retransmissions stop past this timeout. */
+
+#define HT_DTLS_RESTORED            0       /**< Stored connection loaded, no handshake. */
+#define HT_DTLS_RESUMED             1       /**< Abbreviated handshake on the stored session. */
+#define HT_DTLS_FULL                2       /**< Full handshake. */
+#define HT_DTLS_ERROR               3       /**< No connection. */
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Opens the connection to host:port, restoring the stored one if allowed.
+ *
+ * Only one connection exists at a time. With a stored connection nothing
+ * is sent; otherwise the handshake runs here.
+ *
+ * @param host Server host name or address.
+ * @param port Server UDP port.
+ * @return HT_DTLS_RESTORED, HT_DTLS_RESUMED, HT_DTLS_FULL or HT_DTLS_ERROR.
+ */
+uint8_t HT_Dtls_Open(const char *host, uint16_t port);
+
+/**
+ * @brief Sends one datagram and waits for the server's reply.
+ *
+ * On a restored connection that gets no reply the handshake runs and the
+ * request is sent again once: the server may see it twice.
+ *
+ * @param req Request payload.
+ * @param reqLen Bytes in req, at most one record.
+ * @param resp Reply buffer.
+ * @param respSize Size of resp.
+ * @param timeout_ms Time to wait for the reply.
+ * @return Bytes of reply, 0 if none came, negative on error (connection lost).
+ */
+int HT_Dtls_Exchange(const uint8_t *req, size_t reqLen, uint8_t *resp, size_t respSize, uint32_t timeout_ms);
+
+/**
+ * @brief Returns how the current connection was set up: HT_DTLS_*.
+ */
+uint8_t HT_Dtls_Mode(void);
+
+/**
+ * @brief Closes the connection.
+ *
+ * @param keep 1 keeps the connection in retained memory for the next open,
+ *             without telling the server; 0 ends it with a close_notify
+ *             alert (the session stays for a resumption).
+ */
+void HT_Dtls_Close(uint8_t keep);
+
+#endif /* __HT_DTLS_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,74 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_FixedPoint.h
+ * @brief Integer math helpers shared by the sampling and aggregation code.
+ *
+ * Temperatures are in 0.1 C and relative humidity in 0.1 %RH throughout,
+ * matching the DHT22 resolution, so no floating point is needed.
+ */
+
+#ifndef __HT_FIXEDPOINT_H__
+#define __HT_FIXEDPOINT_H__
+
+#include <stdint.h>
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Integer square root (floor) of a 32-bit value.
+ */
+uint32_t HT_Isqrt32(uint32_t v);
+
+/**
+ * @brief Integer square root (floor) of a 64-bit value.
+ */
+uint32_t HT_Isqrt64(uint64_t v);
+
+/**
+ * @brief Saturation vapour pressure over water (Magnus), table based.
+ * @param temp_x10 Temperature in 0.1 C, clamped to -40.0..80.0 C.
+ * @return Pressure in 0.1 Pa.
+ */
+uint32_t HT_SatVapourPressure(int16_t temp_x10);
+
+/**
+ * @brief Dew point from temperature and relative humidity.
+ * @param temp_x10 Temperature in 0.1 C.
+ * @param humi_x10 Relative humidity in 0.1 %RH.
+ * @return Dew point in 0.1 C (clamped to the table range).
+ */
+int16_t HT_DewPoint(int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief Absolute humidity from temperature and relative humidity.
+ * @param temp_x10 Temperature in 0.1 C.
+ * @param humi_x10 Relative humidity in 0.1 %RH.
+ * @return Water vapour density in 0.01 g/m3.
+ */
+uint16_t HT_AbsHumidity(int16_t temp_x10, uint16_t humi_x10);
+
+#endif /* __HT_FIXEDPOINT_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
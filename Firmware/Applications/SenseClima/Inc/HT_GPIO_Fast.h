@@ -0,0 +1,129 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_GPIO_Fast.h
+ * @brief Inline register-level GPIO and cycle counter access for timing-critical loops.
+ *
+ * HT_GPIO_ReadPin/HT_GPIO_WritePin go through out-of-line driver calls that
+ * live in flash. These helpers touch the GPIO registers directly and inline
+ * into the caller, so a loop placed in RAM (PLAT_CODE_IN_RAM) runs with no
+ * flash accesses at all. They do no parameter checking: the pin must already
+ * be muxed to GPIO and configured with GPIO_PinConfig.
+ */
+
+#ifndef __HT_GPIO_FAST_H__
+#define __HT_GPIO_FAST_H__
+
+#include <stdint.h>
+#include "qcx212.h"         // GPIO_TypeDef, DWT, CoreDebug, SystemCoreClock
+#include "Driver_Common.h"  // PLAT_CODE_IN_RAM
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_GPIO_FAST_PORT(instance) \
+    ((GPIO_TypeDef *)(GPIO0_BASE_ADDR + (instance) * (GPIO1_BASE_ADDR - GPIO0_BASE_ADDR)))
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Reads the input level of a pin.
+ * @param instance GPIO instance.
+ * @param pin Pin number in the instance (0..15).
+ * @return 0 or 1.
+ */
+static inline uint32_t HT_GPIO_FastRead(uint32_t instance, uint16_t pin)
+{
+    return (HT_GPIO_FAST_PORT(instance)->DATA >> pin) & 1U;
+}
+
+/**
+ * @brief Drives the output level of a pin without touching the other pins.
+ *
+ * Uses the masked byte access registers, so no read-modify-write is needed.
+ *
+ * @param instance GPIO instance.
+ * @param pin Pin number in the instance (0..15).
+ * @param value 0 for low, non-zero for high.
+ */
+static inline void HT_GPIO_FastWrite(uint32_t instance, uint16_t pin, uint32_t value)
+{
+    uint32_t mask = 1UL << pin;
+
+    if (pin < 8)
+        HT_GPIO_FAST_PORT(instance)->MASKLOWBYTE[mask] = value ? mask : 0;
+    else
+        HT_GPIO_FAST_PORT(instance)->MASKHIGHBYTE[mask >> 8] = value ? mask : 0;
+}
+
+/**
+ * @brief Switches a pin to output (the last written level is driven).
+ */
+static inline void HT_GPIO_FastSetOutput(uint32_t instance, uint16_t pin)
+{
+    HT_GPIO_FAST_PORT(instance)->OUTENSET = 1UL << pin;
+}
+
+/**
+ * @brief Switches a pin to input.
+ */
+static inline void HT_GPIO_FastSetInput(uint32_t instance, uint16_t pin)
+{
+    HT_GPIO_FAST_PORT(instance)->OUTENCLR = 1UL << pin;
+}
+
+/**
+ * @brief Starts the DWT core cycle counter.
+ * @return 1 if the counter is running, 0 if the core does not implement it.
+ */
+static inline uint8_t HT_CycleCounter_Enable(void)
+{
+    uint32_t start;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    start = DWT->CYCCNT;
+    __NOP();
+    __NOP();
+
+    return DWT->CYCCNT != start;
+}
+
+/**
+ * @brief Returns the current core cycle count.
+ */
+static inline uint32_t HT_CycleCounter_Read(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Returns the cycle counter frequency in Hz.
+ */
+static inline uint32_t HT_CycleCounter_Hz(void)
+{
+    return SystemCoreClock;
+}
+
+#endif /* __HT_GPIO_FAST_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,215 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Log.h
+ * @brief Tokenized application logging.
+ *
+ * Mirrors the SDK HT_TRACE/HT_STRING scheme for application code: every call
+ * site names a unique sub ID, Debug/Scripts/log_db.py collects the format
+ * strings at build time into HT_Log_Ids.h and an ID database, and only the ID,
+ * a tick stamp and the raw arguments go out on the print UART.
+ * Debug/Scripts/log_decode.py turns the stream back into text.
+ *
+ *   HT_LOG(P_INFO, sampleRead_1, "T=%d H=%u", t, h);
+ *   HT_LOG_STRING(P_WARNING, configReject_1, "Config %s rejected (%d)", key, ret);
+ *
+ * Integer arguments are sent as 32 bit words (at most HT_LOG_MAX_ARGS), so
+ * formats may use d, i, u, x, X, o and c with l/h modifiers but not floats,
+ * pointers or 64 bit values. HT_LOG_STRING and HT_LOG_BUFFER carry one string,
+ * which must be the first conversion of the format (%s or %.*s).
+ *
+ * Levels below HT_LOG_LEVEL are removed by the preprocessor: neither the
+ * call nor its arguments are compiled. HT_Log_SetLevel raises the bar at
+ * run time, as the battery tiers of HT_Power.h do. Building with
+ * HT_LOG_TOKENIZED=0 prints the format strings with printf instead, for
+ * bring-up without the decoder; the run time level does not apply there.
+ *
+ * Tokenized frames are also kept in the flash ring of HT_LogStore.h.
+ * Production builds (HT_PRODUCTION = y in the Makefile) set HT_LOG_UART
+ * to 0, which leaves the flash ring as the only sink.
+ *
+ * Frame layout (little endian):
+ *   0xF5 | id u16 | argc u8 | tick u32 | argc x u32 | [len u8 | bytes] | sum u8
+ * argc bit 7 flags a string; sum is the 8 bit sum of id..string bytes.
+ * 0xF5 never occurs in ASCII or UTF-8 text, so frames and plain printf
+ * output can share the UART.
+ */
+
+#ifndef __HT_LOG_H__
+#define __HT_LOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* Defines  ------------------------------------------------------------------*/
+
+/* Levels, numbered as debugTraceLevelType. */
+#define HT_LOG_LEVEL_DEBUG      0
+#define HT_LOG_LEVEL_INFO       1
+#define HT_LOG_LEVEL_VALUE      2
+#define HT_LOG_LEVEL_SIG        3
+#define HT_LOG_LEVEL_WARNING    4
+#define HT_LOG_LEVEL_ERROR      5
+
+#ifndef HT_LOG_LEVEL
+#define HT_LOG_LEVEL            HT_LOG_LEVEL_INFO   /**< Lowest level compiled in. */
+#endif
+
+#ifndef HT_LOG_TOKENIZED
+#define HT_LOG_TOKENIZED        1                   /**< 0 prints formats as text. */
+#endif
+
+#ifndef HT_LOG_UART
+#ifdef HT_PRODUCTION
+#define HT_LOG_UART             0                   /**< Frames go to the flash ring only. */
+#else
+#define HT_LOG_UART             1                   /**< Frames also go out on the print UART. */
+#endif
+#endif
+
+#if defined(HT_PRODUCTION) && !HT_LOG_TOKENIZED
+#error "Production builds log through the flash ring, which needs HT_LOG_TOKENIZED"
+#endif
+
+#define HT_LOG_SYNC             0xF5    /**< Frame start byte. */
+#define HT_LOG_MAX_ARGS         8       /**< Integer arguments per call. */
+#define HT_LOG_STRING_MAX       64      /**< Longer strings are truncated. */
+#define HT_LOG_STRING_FLAG      0x80    /**< argc flag: frame carries a string. */
+#define HT_LOG_ID_VERSION       0       /**< Boot frame carrying HT_LOG_DB_VERSION. */
+#define HT_LOG_STRLEN_AUTO      ((size_t)-1)    /**< strLen: string is NUL terminated. */
+#define HT_LOG_FRAME_MAX        (1 + 2 + 1 + 4 + 4 * HT_LOG_MAX_ARGS + 1 + HT_LOG_STRING_MAX + 1)
+
+#if HT_LOG_TOKENIZED
+#include "HT_Log_Ids.h"
+#endif
+
+/* Compile-time level filter, selected by pasting the P_* level name. */
+#define HT_LOG_KEEP(...)        __VA_ARGS__
+#define HT_LOG_DROP(...)
+
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_DEBUG
+#define HT_LOG_ON_P_DEBUG       HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_DEBUG       HT_LOG_DROP
+#endif
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_INFO
+#define HT_LOG_ON_P_INFO        HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_INFO        HT_LOG_DROP
+#endif
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_VALUE
+#define HT_LOG_ON_P_VALUE       HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_VALUE       HT_LOG_DROP
+#endif
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_SIG
+#define HT_LOG_ON_P_SIG         HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_SIG         HT_LOG_DROP
+#endif
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_WARNING
+#define HT_LOG_ON_P_WARNING     HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_WARNING     HT_LOG_DROP
+#endif
+#if HT_LOG_LEVEL <= HT_LOG_LEVEL_ERROR
+#define HT_LOG_ON_P_ERROR       HT_LOG_KEEP
+#else
+#define HT_LOG_ON_P_ERROR       HT_LOG_DROP
+#endif
+
+/* Level number of each P_* name. */
+#define HT_LOG_LVL_P_DEBUG      HT_LOG_LEVEL_DEBUG
+#define HT_LOG_LVL_P_INFO       HT_LOG_LEVEL_INFO
+#define HT_LOG_LVL_P_VALUE      HT_LOG_LEVEL_VALUE
+#define HT_LOG_LVL_P_SIG        HT_LOG_LEVEL_SIG
+#define HT_LOG_LVL_P_WARNING    HT_LOG_LEVEL_WARNING
+#define HT_LOG_LVL_P_ERROR      HT_LOG_LEVEL_ERROR
+
+/* Number of variadic arguments, 0..HT_LOG_MAX_ARGS. */
+#define HT_LOG_NARGS(...)       HT_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define HT_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#if HT_LOG_TOKENIZED
+
+#define HT_LOG(level, subID, format, ...) \
+        HT_LOG_ON_##level(HT_Log_Write(HT_LOG_LVL_##level, HT_LOG_ID_##subID, NULL, 0, HT_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__))
+
+#define HT_LOG_STRING(level, subID, format, string, ...) \
+        HT_LOG_ON_##level(HT_Log_Write(HT_LOG_LVL_##level, HT_LOG_ID_##subID, (string), HT_LOG_STRLEN_AUTO, HT_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__))
+
+#define HT_LOG_BUFFER(level, subID, format, data, len, ...) \
+        HT_LOG_ON_##level(HT_Log_Write(HT_LOG_LVL_##level, HT_LOG_ID_##subID, (const char *)(data), (len), HT_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__))
+
+#else
+
+#define HT_LOG(level, subID, format, ...) \
+        HT_LOG_ON_##level(printf(format "\n", ##__VA_ARGS__))
+
+#define HT_LOG_STRING(level, subID, format, string, ...) \
+        HT_LOG_ON_##level(printf(format "\n", (string), ##__VA_ARGS__))
+
+#define HT_LOG_BUFFER(level, subID, format, data, len, ...) \
+        HT_LOG_ON_##level(printf(format "\n", (int)(len), (const char *)(data), ##__VA_ARGS__))
+
+#endif
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Opens the flash ring and emits the boot frame carrying the database
+ *        version, so the decoder can refuse a stream built from other sources.
+ */
+void HT_Log_Init(void);
+
+/**
+ * @brief Drops frames below a level at run time, on every sink. The boot
+ *        frame is always emitted.
+ * @param level HT_LOG_LEVEL_*; HT_LOG_LEVEL_DEBUG emits everything compiled in.
+ */
+void HT_Log_SetLevel(uint8_t level);
+
+/**
+ * @brief Emits one frame. Called through the HT_LOG macros.
+ * @param level HT_LOG_LEVEL_* of the call.
+ * @param id Message ID from HT_Log_Ids.h.
+ * @param str String argument, NULL if none.
+ * @param strLen Length of str or HT_LOG_STRLEN_AUTO, truncated to HT_LOG_STRING_MAX.
+ * @param argc Number of 32 bit arguments that follow.
+ */
+void HT_Log_Write(uint8_t level, uint16_t id, const char *str, size_t strLen, uint8_t argc, ...);
+
+/**
+ * @brief Checks the frame at the start of a buffer.
+ * @param buf Bytes starting at a frame.
+ * @param len Number of valid bytes in buf.
+ * @return Length of the frame, 0 if buf does not start with a complete frame
+ *         with a good checksum.
+ */
+size_t HT_Log_FrameLength(const uint8_t *buf, size_t len);
+
+#endif /* __HT_LOG_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
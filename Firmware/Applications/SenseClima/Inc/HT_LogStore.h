@@ -0,0 +1,111 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_LogStore.h
+ * @brief Post-mortem ring of tokenized log frames in flash.
+ *
+ * Every HT_LOG frame is also appended to a ring of HT_LOGSTORE_SECTORS
+ * flash sectors, written through the wear-aware BSP_QSPI_*_Safe path, so
+ * the recent history survives hibernate, resets and crashes. The frames are
+ * stored exactly as sent on the UART (see HT_Log.h), so an upload decodes
+ * with Debug/Scripts/log_decode.py. Each boot starts with the database
+ * version frame, which separates the runs (tick stamps restart at 0).
+ *
+ * Frames are staged in RAM and programmed a page at a time, when a frame
+ * of HT_LOGSTORE_FLUSH_LEVEL or above is logged, and before sleep
+ * (HT_LogStore_Flush). A full sector rotates to the oldest one, which is
+ * erased. After a reset the end of the newest sector is found by walking
+ * its frames; a frame torn by a power loss ends the sector there.
+ *
+ * The region sits in the unused gap between the FOTA area and the sleep
+ * backup area of the flash map (SDK/HT_API/Startup/Inc/mem_map.h).
+ */
+
+#ifndef __HT_LOGSTORE_H__
+#define __HT_LOGSTORE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HT_Log.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_LOGSTORE_FLASH_BASE      0x320000    /**< Flash offset, FLASH_FOTA_REGION_END. */
+#define HT_LOGSTORE_SECTOR_SIZE     0x1000      /**< Erase granularity. */
+#define HT_LOGSTORE_SECTORS         2           /**< Ring length; one sector is lost per rotation. */
+#define HT_LOGSTORE_MAGIC           0x474C5448UL /**< "HTLG", sector header. */
+#define HT_LOGSTORE_STAGE_SIZE      256         /**< RAM staging, one flash page. */
+#define HT_LOGSTORE_FLUSH_LEVEL     HT_LOG_LEVEL_WARNING /**< Frames at this level or above are programmed at once. */
+#define HT_LOGSTORE_UPLOAD_MAX      896         /**< Upload size, fits HT_MQTT_BUFFER_SIZE with the topic. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Counters of the store since boot.
+ */
+typedef struct {
+    uint32_t seq;               /**< Sequence number of the sector being written. */
+    uint32_t offset;            /**< Programmed bytes in that sector, header included. */
+    uint32_t programs;          /**< Flash program operations. */
+    uint32_t erases;            /**< Sector erases. */
+    uint32_t errors;            /**< Failed flash operations. */
+} HT_LogStoreStats;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Locates the newest sector and its end, formatting the ring if no
+ *        sector is valid. Called by HT_Log_Init; frames logged before are
+ *        not stored.
+ */
+void HT_LogStore_Init(void);
+
+/**
+ * @brief Stages one frame. Called by HT_Log_Write.
+ * @param frame Complete frame.
+ * @param len Length of the frame, at most HT_LOG_FRAME_MAX.
+ * @param urgent Non-zero programs the staged frames before returning.
+ */
+void HT_LogStore_Append(const uint8_t *frame, size_t len, uint8_t urgent);
+
+/**
+ * @brief Programs the staged frames. Call before sleep.
+ */
+void HT_LogStore_Flush(void);
+
+/**
+ * @brief Copies the newest stored frames, oldest first, in whole frames.
+ * @param buf Destination.
+ * @param len Size of buf; HT_LOGSTORE_UPLOAD_MAX for an upload.
+ * @return Number of bytes written.
+ */
+size_t HT_LogStore_Read(uint8_t *buf, size_t len);
+
+/**
+ * @brief Returns the store counters.
+ */
+const HT_LogStoreStats *HT_LogStore_Stats(void);
+
+#endif /* __HT_LOGSTORE_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
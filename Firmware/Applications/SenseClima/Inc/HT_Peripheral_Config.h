@@ -81,17 +81,17 @@ ________________________________________________________________________________
 #define RTE_UART0_RX_IO_MODE    POLLING_MODE
 #define USART0_RX_TRIG_LVL      (30)
 
-#define RTE_UART1_TX_IO_MODE    POLLING_MODE
-#define RTE_UART1_RX_IO_MODE    POLLING_MODE
+#define RTE_UART1_TX_IO_MODE    IRQ_MODE
+#define RTE_UART1_RX_IO_MODE    DMA_MODE        // Console (HT_Console.c), frames end on RX timeout
 
 #define RTE_UART2_TX_IO_MODE    POLLING_MODE
 #define RTE_UART2_RX_IO_MODE    POLLING_MODE
 
 #define RTE_SPI0_IO_MODE        POLLING_MODE
-#define RTE_SPI1_IO_MODE        POLLING_MODE
+#define RTE_SPI1_IO_MODE        DMA_MODE        // External NOR (HT_SpiNor.c) through the queued bus, HAL_SPI_Submit
 
 #define I2C0_INIT_MODE          POLLING_MODE
-#define I2C1_INIT_MODE          POLLING_MODE
+#define I2C1_INIT_MODE          DMA_MODE        // Queued transactions (HAL_I2C_Submit), polled calls still work
 
 
 // I2C0 (Inter-integrated Circuit Interface) [Driver_I2C0]
@@ -131,11 +131,11 @@ ________________________________________________________________________________
 // DMA
 //   Tx
 //     Channel     <0=>0 <1=>1 <2=>2 <3=>3 <4=>4 <5=>5 <6=>6 <7=>7
-#define RTE_I2C1_DMA_TX_EN              0
+#define RTE_I2C1_DMA_TX_EN              1
 #define RTE_I2C1_DMA_TX_REQID           DMA_RequestI2C1TX
 //   Rx
 //     Channel     <0=>0 <1=>1 <2=>2 <3=>3 <4=>4 <5=>5 <6=>6 <7=>7
-#define RTE_I2C1_DMA_RX_EN              0
+#define RTE_I2C1_DMA_RX_EN              1
 #define RTE_I2C1_DMA_RX_REQID           DMA_RequestI2C1RX
 
 
@@ -268,7 +268,9 @@ ________________________________________________________________________________
 // { PAD_PIN14},  // 0 : gpio3 / 1 : UART0 CTSn / 3 : SPI1 MOSI
 // { PAD_PIN15},  // 0 : gpio4 / 1 : UART0 RXD  / 3 : SPI1 MISO
 // { PAD_PIN16},  // 0 : gpio5 / 1 : UART0 TXD  / 3 : SPI1 SCLK
-#define RTE_SPI1_SSN_PAD_ID                13
+// { PAD_PIN25},  // 0 : gpio10 / 3 : SPI1 SSn1
+// SSn on pad 25, pad 13 is the DHT22 data line
+#define RTE_SPI1_SSN_PAD_ID                25
 #define RTE_SPI1_SSN_FUNC               PAD_MuxAlt3
 
 #define RTE_SPI1_MOSI_PAD_ID               14
@@ -281,7 +283,7 @@ ________________________________________________________________________________
 #define RTE_SPI1_SCLK_FUNC              PAD_MuxAlt3
 
 #define RTE_SPI1_SSN_GPIO_INSTANCE      0
-#define RTE_SPI1_SSN_GPIO_INDEX         2
+#define RTE_SPI1_SSN_GPIO_INDEX         10
 
 // DMA
 //   Tx
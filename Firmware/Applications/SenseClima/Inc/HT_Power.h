@@ -0,0 +1,183 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Power.h
+ * @brief Battery-aware operating tiers.
+ *
+ * Every wake feeds the VBAT reading of HT_Adc.h and the SDK low battery
+ * flag (BatVoltIsLow) to the policy. The voltage is smoothed and mapped to
+ * a state of charge with a Li-ion discharge curve; its slope (mV per day,
+ * over at least HT_POWER_TREND_MIN_S) is projected horizon hours ahead and
+ * the lower of the present and projected charge picks the tier:
+ *
+ *   normal    above saver_pct
+ *   saver     below saver_pct
+ *   low       below low_pct
+ *   critical  below critical_pct, or the SDK flags a low battery
+ *
+ * Normal, saver and low apply their HT_ConfigTier: the sample period is
+ * multiplied by scale, uploads are batched (raw mode uploads every
+ * batch-th reading, aggregate mode stretches the window batch times), data
+ * is published at qos and HT_LOG drops frames below log. A tier is left
+ * for a better one only once the charge is HT_POWER_HYSTERESIS_PCT above
+ * its threshold.
+ *
+ * Critical is the last gasp: one low battery alert is published at QoS1,
+ * then the device samples at the longest period (HT_CONFIG_MAX_INTERVAL_S)
+ * and stays off the air, alarms included, until the battery recovers or a
+ * cycle is forced. It keeps the qos and log settings of the low tier.
+ *
+ * The tiers are configured with the *_pct, horizon and <tier>_scale,
+ * <tier>_batch, <tier>_qos, <tier>_log keys of HT_Config.h.
+ */
+
+#ifndef __HT_POWER_H__
+#define __HT_POWER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_POWER_TIER_NORMAL        0
+#define HT_POWER_TIER_SAVER         1
+#define HT_POWER_TIER_LOW           2
+#define HT_POWER_TIER_CRITICAL      3
+
+#define HT_POWER_EW_SHIFT           2       /**< Voltage filter weight: alpha = 1 / 2^shift. */
+#define HT_POWER_TREND_MIN_S        3600    /**< Shortest span a slope is measured over. */
+#define HT_POWER_HYSTERESIS_PCT     5       /**< Charge above a threshold needed to leave its tier. */
+#define HT_POWER_ALERT_SIZE         96      /**< Buffer size sufficient for HT_Power_AlertFormat. */
+
+#define HT_POWER_ALERT_NONE         0
+#define HT_POWER_ALERT_PENDING      1       /**< Entered critical, the alert is still to be published. */
+#define HT_POWER_ALERT_SENT         2
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Policy state, kept in retained memory between wakes.
+ */
+typedef struct {
+    uint32_t vbat_q4;           /**< Smoothed battery voltage (mV * 16), 0 before the first reading. */
+    uint32_t trendRef_q4;       /**< Smoothed voltage at the start of the slope span. */
+    uint32_t trendAt_s;         /**< Device clock at the start of the slope span. */
+    int32_t slope;              /**< Smoothed voltage slope (mV per day). */
+    uint16_t rawCount;          /**< Raw mode readings since the last upload. */
+    uint8_t tier;               /**< HT_POWER_TIER_*. */
+    uint8_t alert;              /**< HT_POWER_ALERT_*. */
+    uint8_t batLow;             /**< SDK low battery flag at the last update. */
+    uint8_t trendValid;         /**< slope holds a measurement. */
+} HT_PowerState;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Clears the policy history; the device starts in the normal tier.
+ * @param st Policy state.
+ */
+void HT_Power_Reset(HT_PowerState *st);
+
+/**
+ * @brief Applies the settings of the retained tier. Call after HT_Retained_Init.
+ */
+void HT_Power_Init(void);
+
+/**
+ * @brief Feeds the battery readings of this wake and picks the tier.
+ * @param vbat_mv Battery voltage in mV, 0 if not measured (the tier is kept).
+ * @param batLow Non-zero if the SDK battery monitor flags a low battery.
+ * @return HT_POWER_TIER_* in effect.
+ */
+uint8_t HT_Power_Update(uint16_t vbat_mv, uint8_t batLow);
+
+/**
+ * @brief Returns the tier in effect.
+ */
+uint8_t HT_Power_Tier(void);
+
+/**
+ * @brief Stretches a sample period by the tier scale.
+ * @param period_ms Period chosen by the sampler.
+ * @return Period to sleep, at most HT_CONFIG_MAX_INTERVAL_S.
+ */
+uint32_t HT_Power_PeriodMs(uint32_t period_ms);
+
+/**
+ * @brief Returns the aggregate window multiplier of the tier.
+ */
+uint32_t HT_Power_Batch(void);
+
+/**
+ * @brief Counts one raw mode reading due for upload.
+ * @return 1 if the batch is complete and this reading must be uploaded.
+ */
+uint8_t HT_Power_RawDue(void);
+
+/**
+ * @brief Returns the MQTT QoS of data publishes in the tier.
+ */
+uint8_t HT_Power_Qos(void);
+
+/**
+ * @brief Returns 1 if the low battery alert is still to be published.
+ */
+uint8_t HT_Power_AlertPending(void);
+
+/**
+ * @brief Writes the low battery alert record.
+ *
+ * Format: {"vb":mV,"soc":%,"slope":mV/day,"low":0|1}
+ *
+ * @param buf Output buffer (HT_POWER_ALERT_SIZE is enough).
+ * @param len Size of the output buffer.
+ * @return Number of characters written, 0 if the buffer is too small.
+ */
+int HT_Power_AlertFormat(char *buf, size_t len);
+
+/**
+ * @brief Marks the low battery alert as published.
+ */
+void HT_Power_AlertSent(void);
+
+/**
+ * @brief Returns the state of charge (%) of a resting Li-ion cell.
+ * @param mv Cell voltage in mV.
+ */
+uint8_t HT_Power_ChargePct(uint32_t mv);
+
+/**
+ * @brief Writes the policy state as a JSON member.
+ *
+ * Format: "power":{"tier":T,"vb":mV,"soc":%,"slope":mV/day,"low":0|1,"alert":A}
+ * where vb is the smoothed voltage and alert is HT_POWER_ALERT_*.
+ *
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written, as snprintf.
+ */
+int HT_Power_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_POWER_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
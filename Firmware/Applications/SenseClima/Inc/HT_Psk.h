@@ -0,0 +1,104 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Psk.h
+ * @brief Pre-shared key for MQTT over TLS (PSK-AES-128-CCM-8).
+ *
+ * With a pre-shared key the TLS handshake skips the certificate chain,
+ * ECDHE and signatures entirely: the client and the broker prove they hold
+ * the key through the Finished messages. Built with HT_TLS_PSK = y, the
+ * connection runs in PSK mode whenever a key is provisioned and in
+ * certificate mode otherwise. HT_TLS_PSK_ONLY = y also swaps the mbedtls
+ * configuration for config_ec_ssl_psk.h, dropping X.509, public key and
+ * bignum code from the image: certificate mode is gone.
+ *
+ * The key and identity live in the software application field of the
+ * efuse (EFUSE_SW_APP_BYTELOC, 80 bytes), one-time programmable and read
+ * only from the application, as an HT_PskRecord burned at provisioning
+ * (Debug/Scripts/psk_record.py builds it). A blank field leaves the device
+ * in certificate mode, except in development builds, which fall back to
+ * the HT_PSK_DEV_* credentials so a bench broker works out of the box.
+ *
+ * The key is read into RAM only for the handshake; mbedtls keeps its own
+ * copy in the TLS configuration and zeroizes it on release.
+ */
+
+#ifndef __HT_PSK_H__
+#define __HT_PSK_H__
+
+#include <stdint.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_PSK_KEY_MAX          16      /**< AES-128 key, MBEDTLS_PSK_MAX_LEN in config_ec_ssl_psk.h. */
+#define HT_PSK_IDENTITY_MAX     58      /**< Identity bytes left in the efuse field. */
+#define HT_PSK_MAGIC            0xA5    /**< First byte of a provisioned record. */
+
+#define HT_PSK_OK               0       /**< Credentials read from the efuse. */
+#define HT_PSK_DEV              1       /**< Blank efuse, development credentials. */
+#define HT_PSK_BLANK            2       /**< Blank efuse, no credentials: certificate mode. */
+#define HT_PSK_INVALID          3       /**< Record present but corrupt or out of range. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Efuse record, the whole EFUSE_SW_APP field.
+ */
+typedef struct {
+    uint8_t magic;                              /**< HT_PSK_MAGIC, 0 in a blank efuse. */
+    uint8_t keyLen;                             /**< Bytes in key, 1 to HT_PSK_KEY_MAX. */
+    uint8_t identityLen;                        /**< Bytes in identity, 1 to HT_PSK_IDENTITY_MAX. */
+    uint8_t reserved;                           /**< 0. */
+    uint8_t key[HT_PSK_KEY_MAX];                /**< Pre-shared key. */
+    uint8_t identity[HT_PSK_IDENTITY_MAX];      /**< PSK identity, not NUL terminated. */
+    uint16_t crc;                               /**< HT_Crc16 from 0xFFFF of the bytes above, little endian. */
+} HT_PskRecord;
+
+/**
+ * @brief Credentials handed to HT_MQTT_TLSConnect.
+ */
+typedef struct {
+    uint8_t key[HT_PSK_KEY_MAX];                /**< Pre-shared key. */
+    uint8_t keyLen;                             /**< Bytes in key. */
+    uint8_t identity[HT_PSK_IDENTITY_MAX];      /**< PSK identity. */
+    uint8_t identityLen;                        /**< Bytes in identity. */
+} HT_Psk;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Reads the provisioned credentials.
+ * @param psk Receives the key and identity, zeroized unless HT_PSK_OK or HT_PSK_DEV.
+ * @return HT_PSK_OK, HT_PSK_DEV, HT_PSK_BLANK or HT_PSK_INVALID.
+ */
+uint8_t HT_Psk_Load(HT_Psk *psk);
+
+/**
+ * @brief Zeroizes credentials read by HT_Psk_Load.
+ * @param psk Credentials.
+ */
+void HT_Psk_Clear(HT_Psk *psk);
+
+#endif /* __HT_PSK_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
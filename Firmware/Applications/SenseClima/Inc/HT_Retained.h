@@ -0,0 +1,124 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Retained.h
+ * @brief Application state kept across hibernate and power cycles.
+ *
+ * The state is a single structure mirrored in the SDK user NVMem area
+ * (slpManGetUsrNVMem), which the SDK restores after sleep2, hibernate and
+ * power-on and writes back to flash before going to sleep. A magic, layout
+ * version and CRC guard against stale or corrupted contents; on mismatch
+ * every module falls back to its defaults.
+ */
+
+#ifndef __HT_RETAINED_H__
+#define __HT_RETAINED_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HT_Config.h"
+#include "HT_Sampler.h"
+#include "HT_Aggregate.h"
+#include "HT_Alarm.h"
+#include "HT_Power.h"
+#include "HT_TlsSession.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_RETAINED_MAGIC       0x53434C4DUL  /**< "SCLM" */
+#define HT_RETAINED_VERSION     11            /**< Bump whenever HT_RetainedData changes layout. */
+#define HT_RETAINED_MAX_SIZE    1024          /**< UNLOAD_DRAM_USRNV region size in the linker script. */
+
+#define HT_RETAINED_FLAG_FORCE_CYCLE    (1UL << 0)  /**< Upload on the next wake whatever the schedule says. */
+#define HT_RETAINED_FLAG_LOG_UPLOAD     (1UL << 1)  /**< Publish the log ring at the next upload. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Retained memory layout.
+ */
+typedef struct {
+    uint32_t magic;             /**< HT_RETAINED_MAGIC when valid. */
+    uint16_t version;           /**< HT_RETAINED_VERSION of the writer. */
+    uint16_t length;            /**< sizeof(HT_RetainedData) of the writer. */
+    uint32_t wakeCount;         /**< Application starts since the state was created. */
+    uint32_t clock_s;           /**< Device clock at this boot (s since the state was created). */
+    uint32_t flags;             /**< HT_RETAINED_FLAG_* requests carried to the next wake. */
+    HT_ConfigData config;       /**< Runtime configuration. */
+    HT_SamplerState sampler;    /**< Adaptive sampling controller state. */
+    HT_AggregateState aggregate; /**< Statistics of the current upload window. */
+    HT_AlarmState alarm;        /**< Alarm rules and trip state. */
+    HT_PowerState power;        /**< Battery tier policy state. */
+    HT_TlsSessionState tls;     /**< Stored TLS session and handshake statistics. */
+    uint16_t crc;               /**< CRC-16/CCITT of every preceding byte. */
+} HT_RetainedData;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Loads the retained state, resetting it to defaults if invalid.
+ *
+ * Must be called once at startup before any module reads its state.
+ */
+void HT_Retained_Init(void);
+
+/**
+ * @brief Returns the working copy of the retained state.
+ */
+HT_RetainedData *HT_Retained_Get(void);
+
+/**
+ * @brief Seals the working copy and schedules it for write-back before sleep.
+ */
+void HT_Retained_Commit(void);
+
+/**
+ * @brief Returns the device clock: seconds since the retained state was created.
+ *
+ * Advances with the kernel tick while awake and by the programmed sleep
+ * time across hibernate (see HT_Retained_AdvanceClock). It is monotonic but
+ * not wall time; the broker timestamps records on arrival.
+ */
+uint32_t HT_Retained_Now(void);
+
+/**
+ * @brief Moves the device clock past the coming sleep and commits it.
+ *
+ * Call right before programming the deep sleep timer.
+ *
+ * @param sleep_ms Deep sleep duration in milliseconds.
+ */
+void HT_Retained_AdvanceClock(uint32_t sleep_ms);
+
+/**
+ * @brief Computes a CRC-16/CCITT (poly 0x1021).
+ * @param crc Initial value (0xFFFF for a fresh computation).
+ * @param data Data to checksum.
+ * @param len Number of bytes.
+ * @return Updated CRC.
+ */
+uint16_t HT_Crc16(uint16_t crc, const void *data, size_t len);
+
+#endif /* __HT_RETAINED_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,109 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Sampler.h
+ * @brief Rate-of-change adaptive sampling controller.
+ *
+ * Tracks an exponentially weighted (EW) slope and slope variance for
+ * temperature and humidity and picks the next sample period so that the
+ * expected change between two samples stays within a configured tolerance.
+ * Stable conditions stretch the period up to max_interval_s, transients
+ * shrink it down to min_interval_s. The result feeds the deep sleep timer.
+ *
+ * Everything is integer fixed point; no FPU is needed.
+ */
+
+#ifndef __HT_SAMPLER_H__
+#define __HT_SAMPLER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "HT_Config.h"
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Controller state, kept in retained memory between wakes.
+ */
+typedef struct {
+    int16_t  lastTemp;      /**< Previous temperature sample (0.1 C). */
+    uint16_t lastHumi;      /**< Previous humidity sample (0.1 %RH). */
+    int32_t  tempSlope;     /**< EW temperature slope (0.1 C per hour). */
+    int32_t  humiSlope;     /**< EW humidity slope (0.1 %RH per hour). */
+    uint32_t tempVar;       /**< EW variance of the temperature slope ((0.1 C/h)^2). */
+    uint32_t humiVar;       /**< EW variance of the humidity slope ((0.1 %RH/h)^2). */
+    uint32_t period_s;      /**< Period to sleep before the next sample. */
+    uint32_t samples;       /**< Samples fed since the last reset. */
+    uint32_t lastAt_s;      /**< Device time of the previous sample. */
+} HT_SamplerState;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Clears the controller history and restarts from the configured interval.
+ * @param st Controller state.
+ * @param cfg Configuration providing interval_s.
+ */
+void HT_Sampler_Reset(HT_SamplerState *st, const HT_ConfigData *cfg);
+
+/**
+ * @brief Feeds one sample and computes the next sample period.
+ *
+ * Slopes are taken over the time measured since the previous sample, not
+ * the period planned for it: the battery tier stretches the sleep, failed
+ * reads and forced cycles shorten it. With cfg->adaptive cleared the estimators still run (for diagnostics) but
+ * the period stays at cfg->interval_s.
+ *
+ * @param st Controller state.
+ * @param cfg Configuration.
+ * @param now_s Device time of the sample.
+ * @param temp_x10 Temperature in 0.1 C.
+ * @param humi_x10 Humidity in 0.1 %RH.
+ * @return Next sample period in seconds.
+ */
+uint32_t HT_Sampler_Step(HT_SamplerState *st, const HT_ConfigData *cfg, uint32_t now_s, int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief HT_Sampler_Step on the retained state and configuration at the
+ *        current device time, then commits it.
+ * @return Next sample period in seconds.
+ */
+uint32_t HT_Sampler_Update(int16_t temp_x10, uint16_t humi_x10);
+
+/**
+ * @brief Returns the period to program into the deep sleep timer, in milliseconds.
+ */
+uint32_t HT_Sampler_PeriodMs(void);
+
+/**
+ * @brief Writes the controller state as a JSON member ("sampler":{...}).
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written.
+ */
+int HT_Sampler_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_SAMPLER_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -39,9 +39,11 @@
 #include "HT_GPIO_Api.h"
 #include "cmsis_os2.h"
 #include "MQTTClient.h"
+#include "slpman_qcx212.h"
 
 /* Defines  ------------------------------------------------------------------*/
 #define TASK_STACK_SIZE             (1024*4) /**< Stack size for application tasks, originally named after LED tasks. */
+#define HT_FORCE_CYCLE_DELAY_MS     1000     /**< Hibernate time before a forced cycle. */
 #define HT_MQTT_KEEP_ALIVE_INTERVAL 240      /**< MQTT keep-alive interval in seconds. */
 #define HT_MQTT_VERSION             4        /**< MQTT protocol version. */
 
@@ -88,11 +90,56 @@ typedef enum {
 void interval_manager(uint8_t *payload, uint8_t payload_len,
     uint8_t *topic, uint8_t topic_len);
 
+/**
+ * @brief Reads the sensor and feeds the sampler and the window statistics.
+ *
+ * Runs on every wake before the radio is brought up.
+ *
+ * @return 1 if this wake must upload (raw mode, a forced cycle, or the
+ *         aggregate window elapsed), with the uplink queue already
+ *         committed; 0 if the device can go back to sleep with the radio off.
+ */
+uint8_t HT_SenseClima_SampleWake(void);
+
+/**
+ * @brief Turns the modem off and hibernates until the next sample is due.
+ * @param mode The desired sleep state (e.g., SLP_HIB_STATE).
+ */
+void sleepWithMode(slpManSlpState_t mode);
+
+/**
+ * @brief Starts the connection budget of this upload wake: connect_s
+ *        seconds for the SIM, the network attach and the broker.
+ */
+void HT_SenseClima_ConnectStart(void);
+
+/**
+ * @brief Returns the milliseconds left of the connection budget, 0 once spent.
+ */
+uint32_t HT_SenseClima_ConnectLeftMs(void);
+
+/**
+ * @brief Gives up the upload of this wake: commits the uplink queue and
+ *        hibernates until the next sample, radio off. The readings wait in
+ *        the queue for the next upload that connects. Does not return.
+ */
+void HT_SenseClima_Offline(void);
+
+/**
+ * @brief Requests a full sample and upload cycle as soon as possible.
+ *
+ * The request is kept in retained memory and honoured by the next
+ * HT_SenseClima_SampleWake. If the device is already waiting to hibernate,
+ * the wakeup timer is cut short to HT_FORCE_CYCLE_DELAY_MS.
+ */
+void HT_SenseClima_ForceCycle(void);
+
 /**
  * @brief Implements the Finite State Machine for the SenseClima application.
  *
  * Connects to the MQTT Broker, subscribes to topics, and handles data publishing
- * (e.g., sensor data) and subscribed messages.
+ * (e.g., sensor data) and subscribed messages. Past the connection budget
+ * (HT_SenseClima_ConnectLeftMs) the wake is given up (HT_SenseClima_Offline).
  */
 void HT_Fsm(void);
 
@@ -0,0 +1,165 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_SpiNor.h
+ * @brief External SPI NOR flash for bulk data logging.
+ *
+ * The chip sits on SPI1 (pads 14/15/16, chip-select on pad 25) behind the
+ * queued SPI bus of the HAL (HAL_SPI_Submit), which powers the instance down
+ * whenever the queue drains. SPI1 shares pads 15/16 with I2C1, so the two
+ * cannot be enabled together. Built only with HT_SPI_NOR_ENABLE = y in the
+ * application Makefile; HT_SPI_NOR_BENCH = y also runs HT_SpiNor_Benchmark
+ * once per boot.
+ *
+ * Standard 3-byte address commands are used (JEDEC 0x9F, fast read 0x0B,
+ * page program 0x02, 4 KB sector erase 0x20), which every 25-series part
+ * up to 128 Mbit understands. The functions block the calling task and are
+ * not reentrant.
+ */
+
+#ifndef __HT_SPI_NOR_H__
+#define __HT_SPI_NOR_H__
+
+#include <stdint.h>
+#include "htnb32lxxx_hal_spi.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#ifndef HT_SPI_NOR_BUS_SPEED
+#define HT_SPI_NOR_BUS_SPEED        13000000    /**< SCLK in bps, SPI_SetBusSpeed picks the nearest divider. */
+#endif
+
+#define HT_SPI_NOR_CS_PAD           25          /**< Chip-select pad (GPIO10). */
+#define HT_SPI_NOR_CS_INSTANCE      0
+#define HT_SPI_NOR_CS_INDEX         10
+
+#define HT_SPI_NOR_PAGE_SIZE        256         /**< Program granularity. */
+#define HT_SPI_NOR_SECTOR_SIZE      4096        /**< Erase granularity. */
+#define HT_SPI_NOR_READ_CHUNK       4096        /**< Bytes per fast read command, below HAL_DMA_MAX_DESC_LEN. */
+#define HT_SPI_NOR_STREAM_BLOCK     512         /**< Ping-pong buffer size of the streaming read. */
+
+#define HT_SPI_NOR_PROGRAM_TIMEOUT_MS   5       /**< Page program, typically 0.7 ms. */
+#define HT_SPI_NOR_ERASE_TIMEOUT_MS     400     /**< Sector erase, typically 45 ms. */
+
+#ifndef HT_SPI_NOR_BENCH_ADDR
+#define HT_SPI_NOR_BENCH_ADDR       0x000000    /**< Benchmark area, sector aligned; erased by the benchmark. */
+#endif
+#ifndef HT_SPI_NOR_BENCH_LEN
+#define HT_SPI_NOR_BENCH_LEN        (16 * 1024)
+#endif
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Result codes of the NOR functions.
+ */
+typedef enum {
+    HT_SPI_NOR_OK               = 0,   /**< Success. */
+    HT_SPI_NOR_ERROR_BUS        = -1,  /**< SPI transaction failed. */
+    HT_SPI_NOR_ERROR_ID         = -2,  /**< No chip answered the JEDEC ID command. */
+    HT_SPI_NOR_ERROR_TIMEOUT    = -3,  /**< Program/erase still busy or transaction not finished in time. */
+    HT_SPI_NOR_ERROR_PARAM      = -4,  /**< Bad address, length or alignment. */
+    HT_SPI_NOR_ERROR_VERIFY     = -5   /**< Benchmark read back differs from what was programmed. */
+} HT_SpiNorStatus;
+
+/**
+ * @brief Throughput measured by HT_SpiNor_Benchmark.
+ */
+typedef struct {
+    uint32_t bytes;             /**< Size of the benchmark area. */
+    uint32_t erase_ms;          /**< Time to erase the area. */
+    uint32_t program_bps;       /**< Page program rate, including status polling (bytes/s). */
+    uint32_t read_bps;          /**< Chunked fast read rate into one buffer (bytes/s). */
+    uint32_t stream_bps;        /**< Single command streaming read through the ping-pong buffers (bytes/s). */
+    uint32_t power_ups;         /**< SPI1 power ups during the run (idle power down at work). */
+} HT_SpiNorBench;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Sets up the SPI1 bus and the chip-select and checks that a chip answers.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_Init(void);
+
+/**
+ * @brief Returns the JEDEC ID read by HT_SpiNor_Init (manufacturer << 16 | type << 8 | capacity).
+ */
+uint32_t HT_SpiNor_JedecId(void);
+
+/**
+ * @brief Reads any range with fast read commands of up to HT_SPI_NOR_READ_CHUNK bytes.
+ * @param addr Start address.
+ * @param buf Destination.
+ * @param len Bytes to read.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_Read(uint32_t addr, uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Programs a range, split at page boundaries. The range must be erased.
+ * @param addr Start address.
+ * @param data Data to program.
+ * @param len Bytes to program.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_Program(uint32_t addr, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Erases the 4 KB sector containing addr.
+ * @param addr Any address inside the sector.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_EraseSector(uint32_t addr);
+
+/**
+ * @brief Reads a range with one fast read command through two DMA buffers.
+ *
+ * onBlock gets each filled HT_SPI_NOR_STREAM_BLOCK buffer from IRQ context
+ * while the other one is being filled, so it must be done with the data
+ * before the next block completes.
+ *
+ * @param addr Start address.
+ * @param len Bytes to read.
+ * @param onBlock Block callback.
+ * @param context User data, available as stream->context in the callback.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_StreamRead(uint32_t addr, uint32_t len, HAL_SPI_StreamCallback_t onBlock, void *context);
+
+/**
+ * @brief Measures erase, program, read and streaming read rates on a scratch area.
+ *
+ * The area is erased, programmed with an address pattern, read back both
+ * ways and verified. Results are logged and returned in result.
+ *
+ * @param addr Sector aligned start of the area (its content is lost).
+ * @param len Size of the area, a multiple of HT_SPI_NOR_SECTOR_SIZE.
+ * @param result Measured rates, may be NULL.
+ * @return HT_SPI_NOR_OK or a negative HT_SpiNorStatus.
+ */
+HT_SpiNorStatus HT_SpiNor_Benchmark(uint32_t addr, uint32_t len, HT_SpiNorBench *result);
+
+#endif /* __HT_SPI_NOR_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,202 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_TimeSeries.h
+ * @brief Time-series store of the readings on the littlefs partition.
+ *
+ * Every reading is appended as a fixed-size HT_TsRecord to a segment file
+ * of at most HT_TS_SEGMENT_RECORDS records (one 4 KB littlefs block), so
+ * the history outlives a broker or cell outage, resets and a drained
+ * battery. Records are buffered by littlefs and committed every
+ * HT_TS_SYNC_RECORDS appends and before sleep (HT_TimeSeries_Sync); a
+ * power loss loses at most the uncommitted ones, never a committed one.
+ * littlefs copies the partial last block of the segment at every commit,
+ * 2 KB programmed on average; with one reading per wake that is the cost
+ * of each reading, spread over the partition by littlefs wear leveling.
+ *
+ * A full segment is sealed: its first and last timestamps, record count
+ * and CRC go into the index file, which littlefs rewrites atomically, and
+ * the next segment file starts. Range queries skip the segments outside
+ * the range from the index alone and binary search the first record in
+ * the first segment they read. The oldest segments are evicted beyond
+ * HT_TS_MAX_SEGMENTS, and whenever fewer than HT_TS_RESERVE_BLOCKS blocks
+ * would be left for the other files of the partition (SDK settings, the
+ * uplink queue position) after the next commit, checked before each one.
+ *
+ * Timestamps are store time: the device clock (HT_Retained_Now) plus an
+ * offset kept in the index, raised when the device clock restarts below
+ * the newest record (retained state lost), so that records stay in time
+ * order. HT_TimeSeries_Time converts.
+ *
+ * Every record also has a sequence number, its place in the store: the
+ * segment sequence number times HT_TS_SEGMENT_RECORDS plus its index in
+ * the segment. Sequence numbers only grow, with gaps where segments were
+ * evicted or sealed short (rebuilt from a damaged file); the uplink queue
+ * (HT_Uplink.h) keeps its position as one. An uncommitted record lost to a
+ * reset leaves its number to the next append, but readers see committed
+ * records only, so a number once read always names the same record.
+ *
+ * The port API (lfs_port.h) has no mkdir: the files live in the root,
+ * HT_TS_INDEX_PATH and one HT_TS_SEGMENT_NAME per segment.
+ */
+
+#ifndef __HT_TIMESERIES_H__
+#define __HT_TIMESERIES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_TS_SEGMENT_RECORDS   340         /**< Records per segment, 4080 bytes: one block. */
+#define HT_TS_MAX_SEGMENTS      32          /**< Sealed segments kept, about 11000 readings. */
+#define HT_TS_RESERVE_BLOCKS    16          /**< Free blocks left to the other files of the partition. */
+#define HT_TS_SYNC_RECORDS      16          /**< Appends between commits within a wake. */
+#define HT_TS_MAGIC             0x53544854UL /**< "HTTS", index header. */
+#define HT_TS_INDEX_PATH        "ts_index"  /**< Index of the sealed segments. */
+#define HT_TS_SEGMENT_NAME      "ts_%08lx"  /**< Segment file name, from its sequence number. */
+
+#define HT_TS_FLAG_BAT_LOW      0x0001      /**< The battery monitor reported a low voltage. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief One stored reading.
+ */
+typedef struct {
+    uint32_t t_s;               /**< Store time (s); device clock when appended. */
+    int16_t temp;               /**< Temperature (0.1 C). */
+    uint16_t humi;              /**< Relative humidity (0.1 %RH). */
+    uint16_t vbat_mv;           /**< Battery voltage (mV). */
+    uint16_t flags;             /**< HT_TS_FLAG_* */
+} HT_TsRecord;
+
+/**
+ * @brief Index entry of a segment.
+ */
+typedef struct {
+    uint32_t seq;               /**< Sequence number, names the file. */
+    uint32_t first_s;           /**< Store time of the first record. */
+    uint32_t last_s;            /**< Store time of the last record. */
+    uint16_t count;             /**< Records in the segment. */
+    uint16_t crc;               /**< HT_Crc16 from 0xFFFF of the records (sealed segments). */
+} HT_TsSegment;
+
+/**
+ * @brief State and counters of the store.
+ */
+typedef struct {
+    uint32_t segments;          /**< Segments holding records, the open one included. */
+    uint32_t records;           /**< Records stored. */
+    uint32_t oldest_s;          /**< Store time of the oldest record. */
+    uint32_t newest_s;          /**< Store time of the newest record. */
+    uint32_t evicted;           /**< Segments evicted since the store was created. */
+    uint32_t appends;           /**< Records appended since boot. */
+    uint32_t syncs;             /**< Commits since boot. */
+    uint32_t errors;            /**< Failed file operations since boot. */
+} HT_TimeSeriesStats;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Loads the index and the open segment, after the filesystem is
+ *        mounted. A missing or corrupted index is rebuilt from the segment
+ *        files (one read of each).
+ * @return 0, or a negative LFS_ERR_* code; the store is then unusable.
+ */
+int HT_TimeSeries_Init(void);
+
+/**
+ * @brief Appends a reading, sealing the segment when it is full.
+ * @param rec Reading, t_s being the device clock (HT_Retained_Now).
+ * @return 0, or a negative LFS_ERR_* code.
+ */
+int HT_TimeSeries_Append(const HT_TsRecord *rec);
+
+/**
+ * @brief Commits the records appended since the last commit. Call before sleep.
+ * @return 0, or a negative LFS_ERR_* code.
+ */
+int HT_TimeSeries_Sync(void);
+
+/**
+ * @brief Copies the records with from_s <= t_s <= to_s, oldest first.
+ *
+ * For the next page, query again from the t_s of the last record copied
+ * plus one: readings are never less than a second apart.
+ *
+ * @param from_s Start of the range, store time.
+ * @param to_s End of the range, store time.
+ * @param out Destination.
+ * @param max Size of out in records.
+ * @return Number of records copied.
+ */
+size_t HT_TimeSeries_Query(uint32_t from_s, uint32_t to_s, HT_TsRecord *out, size_t max);
+
+/**
+ * @brief Copies the consecutive records from sequence number seq on, or
+ *        from the first one stored after it if seq is gone.
+ * @param seq Sequence number of the first record wanted.
+ * @param out Destination.
+ * @param max Size of out in records.
+ * @param first Set to the sequence number of out[0].
+ * @return Number of records copied, numbered *first onwards with no gap.
+ */
+size_t HT_TimeSeries_ReadSeq(uint32_t seq, HT_TsRecord *out, size_t max, uint32_t *first);
+
+/**
+ * @brief Returns the sequence number of the next record appended.
+ */
+uint32_t HT_TimeSeries_NextSeq(void);
+
+/**
+ * @brief Returns the number of records stored with a sequence number of
+ *        seq or above, from the index alone.
+ */
+uint32_t HT_TimeSeries_CountFrom(uint32_t seq);
+
+/**
+ * @brief Converts a device clock reading to store time.
+ */
+uint32_t HT_TimeSeries_Time(uint32_t clock_s);
+
+/**
+ * @brief Checks the record count and CRC of every sealed segment.
+ * @return Number of segments that failed.
+ */
+uint32_t HT_TimeSeries_Verify(void);
+
+/**
+ * @brief Returns the store state and counters.
+ */
+const HT_TimeSeriesStats *HT_TimeSeries_Stats(void);
+
+/**
+ * @brief Writes the "ts" diagnostics member: segments, records, evicted
+ *        segments and errors.
+ */
+int HT_TimeSeries_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_TIMESERIES_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,169 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_TlsSession.h
+ * @brief TLS session resumption across hibernate.
+ *
+ * After every TLS handshake the negotiated mbedtls_ssl_session is
+ * serialized (mbedtls_ssl_session_save) into retained memory, which the SDK
+ * writes to flash before hibernate. On the next wake it is offered to the
+ * broker (mbedtls_ssl_set_session), by session ticket if the broker issued
+ * one, else by session ID. An accepted offer skips the certificate chain,
+ * ECDHE and signatures: an abbreviated handshake is two round trips of
+ * symmetric crypto.
+ *
+ * A broker that no longer knows the session just runs a full handshake in
+ * the same connection (counted as rejected). A handshake that fails with a
+ * session offered drops the session and is retried at once without it.
+ * A session is also dropped once older than HT_TLS_SESSION_MAX_AGE_S or
+ * the ticket lifetime, and when the broker host or port changes.
+ *
+ * The DTLS transport (HT_Dtls.h) keeps a whole connection in the same
+ * slot instead (mbedtls_ssl_context_save): keys, record sequence numbers
+ * and Connection ID, so the next wake sends application data with no
+ * handshake at all. One slot serves both, the retained area has no room
+ * for a second one; switching between the broker and the DTLS server
+ * drops it like any change of peer.
+ *
+ * The stored session holds the master secret, it is zeroized when dropped.
+ */
+
+#ifndef __HT_TLSSESSION_H__
+#define __HT_TLSSESSION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_TLS_SESSION_MAX          448     /**< Serialized session capacity; a larger ticket falls back to the session ID. */
+#define HT_TLS_SESSION_MAX_AGE_S    86400   /**< Oldest session offered, whatever the ticket lifetime. */
+
+#define HT_TLS_HANDSHAKE_FULL       0       /**< Full handshake, no session offered. */
+#define HT_TLS_HANDSHAKE_RESUMED    1       /**< Abbreviated handshake, the session was accepted. */
+#define HT_TLS_HANDSHAKE_REJECTED   2       /**< Session offered, the broker ran a full handshake. */
+#define HT_TLS_HANDSHAKE_FAILED     3       /**< Handshake failed with a session offered. */
+
+#define HT_TLS_SLOT_SESSION         0       /**< The slot holds an mbedtls_ssl_session_save output. */
+#define HT_TLS_SLOT_CONNECTION      1       /**< The slot holds an mbedtls_ssl_context_save output (DTLS). */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Stored session and handshake statistics, kept in retained memory.
+ */
+typedef struct {
+    uint8_t session[HT_TLS_SESSION_MAX]; /**< mbedtls_ssl_session_save output. */
+    uint16_t sessionLen;        /**< Bytes in session, 0 if none. */
+    uint16_t peer;              /**< CRC-16 of the broker host and port the session belongs to. */
+    uint8_t kind;               /**< HT_TLS_SLOT_SESSION or HT_TLS_SLOT_CONNECTION. */
+    uint8_t reserved;           /**< 0. */
+    uint32_t expires_s;         /**< Device clock after which the session is not offered. */
+    uint16_t full;              /**< Full handshakes, rejected offers included. */
+    uint16_t resumed;           /**< Abbreviated handshakes. */
+    uint16_t rejected;          /**< Offers the broker turned down. */
+    uint16_t failed;            /**< Handshakes that failed with a session offered. */
+    uint32_t full_ms;           /**< Total duration of the full handshakes. */
+    uint32_t resumed_ms;        /**< Total duration of the abbreviated handshakes. */
+    uint16_t restored;          /**< DTLS connections reused from the slot, no handshake. */
+    uint16_t lost;              /**< Restored connections the server no longer knew. */
+} HT_TlsSessionState;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Returns the session buffer for a connection to host:port.
+ *
+ * The buffer (HT_TLS_SESSION_MAX bytes) is handed to HT_MQTT_TLSConnect
+ * as both the session to offer and the place for the new one. A session
+ * stored for another peer, or expired, is dropped first, and so is a
+ * DTLS connection.
+ *
+ * @param host Broker host name or address.
+ * @param port Broker port.
+ * @param len Receives the length of the session to offer, 0 if none.
+ * @return Session buffer.
+ */
+uint8_t *HT_TlsSession_Slot(const char *host, uint16_t port, size_t *len);
+
+/**
+ * @brief Records a handshake and keeps the session it produced.
+ * @param outcome HT_TLS_HANDSHAKE_*.
+ * @param ms Handshake duration in milliseconds.
+ * @param len Length of the new session in the slot, 0 if none (dropped).
+ * @param lifetime_s Ticket lifetime hint, 0 if none.
+ */
+void HT_TlsSession_Record(uint8_t outcome, uint32_t ms, size_t len, uint32_t lifetime_s);
+
+/**
+ * @brief Takes the DTLS connection or session stored for host:port.
+ *
+ * A connection (HT_TLS_SLOT_CONNECTION) is removed from the slot as it is
+ * handed out: once loaded its record sequence numbers are spent, the same
+ * bytes must never be loaded twice. The caller puts the connection back
+ * with HT_TlsSession_KeepConnection when it closes. Anything stored for
+ * another peer, or expired, is dropped first.
+ *
+ * @param host Server host name or address.
+ * @param port Server port.
+ * @param len Receives the length of what is stored, 0 if none.
+ * @param kind Receives HT_TLS_SLOT_SESSION or HT_TLS_SLOT_CONNECTION.
+ * @return Slot buffer, HT_TLS_SESSION_MAX bytes, also the place for the next one.
+ */
+uint8_t *HT_TlsSession_Take(const char *host, uint16_t port, size_t *len, uint8_t *kind);
+
+/**
+ * @brief Keeps the DTLS connection serialized in the slot.
+ * @param len Length of the connection in the slot, 0 if none (the slot is dropped).
+ */
+void HT_TlsSession_KeepConnection(size_t len);
+
+/**
+ * @brief Counts a DTLS connection reused from the slot.
+ * @param lost 1 if the server no longer knew it and a handshake followed.
+ */
+void HT_TlsSession_Restored(uint8_t lost);
+
+/**
+ * @brief Writes the handshake statistics as a JSON member.
+ *
+ * Format: "tls":{"full":N,"res":N,"rej":N,"fail":N,"full_ms":avg,"res_ms":avg,"held":0|1|2,
+ * "rest":N,"lost":N,"arena":{"peak":N,"hs":N,"frag":N,"leak":N}} where the
+ * averages are in milliseconds, held tells whether a session (1) or a DTLS
+ * connection (2) is stored, rest and lost count the DTLS connections
+ * restored and those the server had forgotten. arena is the
+ * mbedTLS arena of this wake (all 0 without HT_TLS_ARENA): peak and
+ * handshake peak in bytes, to hold against HT_TLS_ARENA_SIZE,
+ * fragmentation after the last handshake in percent of the free bytes
+ * outside the largest free block, and the disconnects that found blocks
+ * still allocated.
+ *
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written, as snprintf.
+ */
+int HT_TlsSession_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_TLSSESSION_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
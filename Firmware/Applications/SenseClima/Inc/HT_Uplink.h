@@ -0,0 +1,152 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/**
+ * @file HT_Uplink.h
+ * @brief Store-and-forward queue of the readings between the time-series
+ *        store and the broker.
+ *
+ * The queue is the time-series store (HT_TimeSeries.h) itself: a reading
+ * is enqueued when it is appended, before the radio is brought up, under
+ * its record sequence number. The queue position is the sequence number of
+ * the oldest record not yet acknowledged, kept in HT_UPLINK_CURSOR_PATH,
+ * which littlefs rewrites atomically; the retained memory is flushed only
+ * before sleep and would not survive a brownout within the wake.
+ *
+ * Once connected, HT_Uplink_Drain publishes the queue oldest first in
+ * batches of consecutive records filling a payload of HT_UPLINK_BATCH_MAX
+ * bytes, at QoS1, and moves the position past a batch only once the
+ * broker acknowledged it. A reset or brownout between the acknowledgment
+ * and the rewrite of the position sends that batch again at the next
+ * drain: never a loss, at most one batch twice, which the consumer drops
+ * by sequence number. Readings evicted from the store before they were
+ * sent (a backlog beyond HT_TS_MAX_SEGMENTS segments) are counted as
+ * dropped.
+ *
+ * Batch format:
+ * {"seq":S,"now":N,"t":T,"r":[[dt,temp,humi,vbat,flags],...]}
+ * where S is the sequence number of the first record, the next ones being
+ * S+1, S+2..., N the store time at publish, T the store time of the first
+ * record and dt the seconds since the previous record (0 for the first).
+ * Store time is not wall time: the consumer dates a record arrival - (N - t).
+ * temp is in 0.1 C, humi in 0.1 %RH, vbat in mV and flags are HT_TS_FLAG_*.
+ */
+
+#ifndef __HT_UPLINK_H__
+#define __HT_UPLINK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_UPLINK_BATCH_MAX         896         /**< Batch payload, fits HT_MQTT_BUFFER_SIZE with the topic. */
+#define HT_UPLINK_BATCH_RECORDS     48          /**< Records read per batch, more than a payload holds. */
+#define HT_UPLINK_DRAIN_BATCHES     32          /**< Batches per upload at most, about 1300 readings. */
+#define HT_UPLINK_MAGIC             0x4C554854UL /**< "HTUL", queue position file. */
+#define HT_UPLINK_CURSOR_PATH       "ul_cursor" /**< Queue position, next to the time-series files. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * @brief Publishes one batch.
+ * @param payload Batch record, not NUL-terminated.
+ * @param len Length of the batch record.
+ * @param ctx Context of HT_Uplink_Drain.
+ * @return 0 once the broker acknowledged the batch.
+ */
+typedef int (*HT_UplinkPublish)(const uint8_t *payload, size_t len, void *ctx);
+
+/**
+ * @brief Counters of the queue.
+ */
+typedef struct {
+    uint32_t position;          /**< Sequence number of the oldest record not acknowledged. */
+    uint32_t sent;              /**< Records acknowledged since boot. */
+    uint32_t batches;           /**< Batches acknowledged since boot. */
+    uint32_t nacks;             /**< Batches left unacknowledged since boot. */
+    uint32_t dropped;           /**< Records evicted unsent since boot. */
+    uint32_t errors;            /**< Failed position rewrites and formats since boot. */
+} HT_UplinkStats;
+
+/* Functions ------------------------------------------------------------------*/
+
+/**
+ * @brief Loads the queue position, after HT_TimeSeries_Init. Without one
+ *        (first boot) the queue starts at the next reading; the history
+ *        stored before is not sent.
+ * @return 0, or a negative LFS_ERR_* code.
+ */
+int HT_Uplink_Init(void);
+
+/**
+ * @brief Commits the readings enqueued so far, before the radio is brought
+ *        up: a brownout is likeliest while it transmits.
+ * @return 0, or a negative LFS_ERR_* code.
+ */
+int HT_Uplink_Prepare(void);
+
+/**
+ * @brief Publishes the queue oldest first, one batch at a time, until it
+ *        is empty, maxBatches were sent or a batch was not acknowledged.
+ *
+ * A missing acknowledgment ends the drain: the MQTT client closes the
+ * session on it, so the batch waits for the next upload that connects.
+ * @param publish Publishes a batch, returning 0 on acknowledgment.
+ * @param ctx Passed to publish.
+ * @param maxBatches Batches sent at most.
+ * @return Number of records acknowledged.
+ */
+uint32_t HT_Uplink_Drain(HT_UplinkPublish publish, void *ctx, uint32_t maxBatches);
+
+/**
+ * @brief Empties the queue without sending it, when the readings went out
+ *        another way (aggregate mode).
+ */
+void HT_Uplink_Skip(void);
+
+/**
+ * @brief Returns the number of readings waiting in the queue.
+ */
+uint32_t HT_Uplink_Depth(void);
+
+/**
+ * @brief Returns the counters of the queue.
+ */
+const HT_UplinkStats *HT_Uplink_Stats(void);
+
+/**
+ * @brief Writes the "uplink" diagnostics member.
+ *
+ * Format: "uplink":{"depth":N,"age_s":N,"sent":N,"nack":N,"drop":N,"err":N}
+ * where depth is the number of readings waiting and age_s the age of the
+ * oldest one (0 with an empty queue).
+ *
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @return Number of characters written, as snprintf.
+ */
+int HT_Uplink_DiagFormat(char *buf, size_t len);
+
+#endif /* __HT_UPLINK_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,247 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Adc.h"
+#include <stdio.h>
+#include "cmsis_os2.h"          // Required for osSemaphore*, osKernelGetTickCount
+#include "adc_qcx212.h"         // Required for ADC_ChannelInit, ADC_StartConversion
+#include "batmon_qcx212.h"      // Required for BatMon_EfuseDataGet, BatMon_CalibrateRawCode
+#include "hal_adc.h"            // Required for HAL_ADC_ConvertThermalRawCodeToTemperature
+#include "HT_Log.h"
+
+#define ADC_EFUSE_LOW_MV    500     // Calibration points of the efuse codes
+#define ADC_EFUSE_HIGH_MV   900
+#define ADC_THERMAL_INVALID 0x7FFFFFFF
+
+typedef struct {
+    adc_channel_t channel;
+    uint8_t config;             // adc_channel_config_t value for the channel
+    uint8_t div16;              // Divider ratio in sixteenths, 16 without divider
+    adc_callback_t callback;
+} HT_AdcChannelDef;
+
+static void HT_Adc_VbatDone(uint32_t raw);
+static void HT_Adc_ThermalDone(uint32_t raw);
+#ifdef HT_ADC_AIO_ENABLE
+static void HT_Adc_AioDone(uint32_t raw);
+#endif
+
+static const HT_AdcChannelDef adcChannels[HT_ADC_CHANNELS] = {
+    [HT_ADC_VBAT]    = { ADC_ChannelVbat, ADC_VbatResDivRatio3Over16, 3, HT_Adc_VbatDone },
+    [HT_ADC_THERMAL] = { ADC_ChannelThermal, ADC_ThermalInputDisable, 16, HT_Adc_ThermalDone },
+#ifdef HT_ADC_AIO_ENABLE
+    [HT_ADC_AIO]     = { ADC_ChannelAio2, ADC_AioResDivRatio1, 16, HT_Adc_AioDone },
+#endif
+};
+
+static volatile uint32_t adcSum[HT_ADC_CHANNELS];
+static volatile uint8_t adcCount[HT_ADC_CHANNELS];
+static volatile uint8_t adcPending;     // Channels still converting, the last one releases adcDone
+static volatile uint32_t adcErrors;
+static uint8_t adcBusy;
+static osSemaphoreId_t adcDone;
+
+static uint16_t adcCode500, adcCode900; // Efuse codes, adcCode900 <= adcCode500 when absent
+static uint32_t adcStartTick;
+static uint32_t adcDurationMs;
+static HT_AdcReading adcLast = { 0, HT_ADC_TEMP_INVALID, 0, 0 };
+
+/**
+ * @brief Channel completion, ADC interrupt: sums the code and queues the
+ *        next conversion until the channel has HT_ADC_OVERSAMPLE codes.
+ */
+static void HT_Adc_Sampled(HT_AdcChannel ch, uint32_t raw)
+{
+    adcSum[ch] += raw;
+
+    if (++adcCount[ch] < HT_ADC_OVERSAMPLE)
+    {
+        if (ADC_StartConversion(adcChannels[ch].channel, ADC_UserAPP) == 0)
+            return;
+        adcErrors++;
+    }
+
+    if (--adcPending == 0)
+        osSemaphoreRelease(adcDone);
+}
+
+static void HT_Adc_VbatDone(uint32_t raw)
+{
+    HT_Adc_Sampled(HT_ADC_VBAT, raw);
+}
+
+static void HT_Adc_ThermalDone(uint32_t raw)
+{
+    HT_Adc_Sampled(HT_ADC_THERMAL, raw);
+}
+
+#ifdef HT_ADC_AIO_ENABLE
+static void HT_Adc_AioDone(uint32_t raw)
+{
+    HT_Adc_Sampled(HT_ADC_AIO, raw);
+}
+#endif
+
+/**
+ * @brief Converts a sum of n codes to the voltage before the divider.
+ * @return Millivolts, rounded.
+ */
+static uint32_t HT_Adc_Millivolts(uint32_t sum, uint32_t n, uint8_t div16)
+{
+    int64_t num, den;
+
+    if (adcCode900 <= adcCode500)
+        return (BatMon_CalibrateRawCode((sum + n / 2) / n) * 16U + div16 / 2U) / div16;
+
+    // Input mV * n * span, interpolated between the efuse points, then scaled by the divider
+    num = ((int64_t)ADC_EFUSE_LOW_MV * n * (adcCode900 - adcCode500) +
+           ((int64_t)sum - (int64_t)n * adcCode500) * (ADC_EFUSE_HIGH_MV - ADC_EFUSE_LOW_MV)) * 16;
+    den = (int64_t)n * (adcCode900 - adcCode500) * div16;
+
+    return num <= 0 ? 0 : (uint32_t)((num + den / 2) / den);
+}
+
+void HT_Adc_Init(void)
+{
+    adc_config_t config;
+
+    if (adcDone != NULL)
+        return;
+
+    adcDone = osSemaphoreNew(1, 0, NULL);
+    BatMon_EfuseDataGet(&adcCode500, &adcCode900);
+
+    for (uint32_t i = 0; i < HT_ADC_CHANNELS; i++)
+    {
+        ADC_GetDefaultConfig(&config);
+        if (adcChannels[i].channel == ADC_ChannelVbat)
+            config.channelConfig.vbatResDiv = (adc_vbat_resdiv_ratio_t)adcChannels[i].config;
+        else if (adcChannels[i].channel == ADC_ChannelThermal)
+            config.channelConfig.thermalInput = (adc_thermal_input_t)adcChannels[i].config;
+        else
+            config.channelConfig.aioResDiv = (adc_aio_resdiv_ratio_t)adcChannels[i].config;
+
+        ADC_ChannelInit(adcChannels[i].channel, ADC_UserAPP, &config, adcChannels[i].callback);
+    }
+
+    HT_LOG(P_DEBUG, HT_Adc_Init_1, "ADC efuse codes 500 mV: %u, 900 mV: %u", adcCode500, adcCode900);
+}
+
+int32_t HT_Adc_Start(void)
+{
+    uint32_t mask;
+
+    if (adcDone == NULL)
+        return -1;
+
+    // A reading that timed out may have completed since
+    if (adcBusy && osSemaphoreAcquire(adcDone, 0) != osOK)
+        return -1;
+
+    adcBusy = 1;
+    adcStartTick = osKernelGetTickCount();
+    adcPending = HT_ADC_CHANNELS;
+
+    for (uint32_t i = 0; i < HT_ADC_CHANNELS; i++)
+    {
+        adcSum[i] = 0;
+        adcCount[i] = 0;
+    }
+
+    for (uint32_t i = 0; i < HT_ADC_CHANNELS; i++)
+    {
+        if (ADC_StartConversion(adcChannels[i].channel, ADC_UserAPP) == 0)
+            continue;
+
+        // Completions of the other channels also decrement adcPending
+        mask = SaveAndSetIRQMask();
+        adcErrors++;
+        if (--adcPending == 0)
+            osSemaphoreRelease(adcDone);
+        RestoreIRQMask(mask);
+    }
+
+    return 0;
+}
+
+int32_t HT_Adc_Wait(uint32_t timeout_ms, HT_AdcReading *out)
+{
+    HT_AdcReading reading = { 0, HT_ADC_TEMP_INVALID, 0, 0 };
+    uint32_t n, mv;
+    int32_t centi;
+
+    if (!adcBusy)
+        return -1;
+
+    if (osSemaphoreAcquire(adcDone, timeout_ms * osKernelGetTickFreq() / 1000U + 1U) != osOK)
+    {
+        // The conversions in flight still complete and release adcDone, which the next Start takes
+        adcErrors++;
+        HT_LOG(P_WARNING, HT_Adc_Wait_1, "ADC reading timed out, %u channels pending.", adcPending);
+        return -1;
+    }
+
+    adcBusy = 0;
+    adcDurationMs = (uint32_t)(((uint64_t)(osKernelGetTickCount() - adcStartTick) * 1000U) / osKernelGetTickFreq());
+
+    for (uint32_t i = 0; i < HT_ADC_CHANNELS; i++)
+    {
+        n = adcCount[i];
+        if (n == 0)
+            continue;
+
+        if (i == HT_ADC_THERMAL)
+        {
+            centi = HAL_ADC_ConvertThermalRawCodeToTemperature((adcSum[i] + n / 2) / n);
+            if (centi == ADC_THERMAL_INVALID)
+                continue;
+            reading.temp_x10 = (int16_t)((centi + (centi < 0 ? -5 : 5)) / 10);
+        }
+        else
+        {
+            mv = HT_Adc_Millivolts(adcSum[i], n, adcChannels[i].div16);
+            if (mv > UINT16_MAX)
+                mv = UINT16_MAX;
+            if (i == HT_ADC_VBAT)
+                reading.vbat_mv = (uint16_t)mv;
+            else
+                reading.aio_mv = (uint16_t)mv;
+        }
+        reading.valid |= 1U << i;
+    }
+
+    adcLast = reading;
+    if (out != NULL)
+        *out = reading;
+
+    HT_LOG(P_VALUE, HT_Adc_Wait_2, "VBAT: %u mV | Die: %d (0.1 C) | AIO: %u mV | %u ms",
+           reading.vbat_mv, reading.temp_x10, reading.aio_mv, adcDurationMs);
+
+    return reading.valid == (1U << HT_ADC_CHANNELS) - 1U ? 0 : -1;
+}
+
+const HT_AdcReading *HT_Adc_Last(void)
+{
+    return &adcLast;
+}
+
+int HT_Adc_DiagFormat(char *buf, size_t len)
+{
+    return snprintf(buf, len, "\"adc\":{\"vbat\":%u,\"temp\":%d,\"aio\":%u,\"cal\":%u,\"ms\":%lu,\"err\":%lu}",
+                    adcLast.vbat_mv, adcLast.temp_x10, adcLast.aio_mv, adcCode900 > adcCode500,
+                    (unsigned long)adcDurationMs, (unsigned long)adcErrors);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,157 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Aggregate.h"
+#include "HT_Retained.h"
+#include "HT_FixedPoint.h"
+#include <stdio.h>
+
+static void HT_Aggregate_ChannelReset(HT_AggChannel *ch)
+{
+    ch->mean_q8 = 0;
+    ch->min = INT16_MAX;
+    ch->max = INT16_MIN;
+    ch->m2_q16 = 0;
+    ch->minAt_s = 0;
+    ch->maxAt_s = 0;
+}
+
+/**
+ * @brief Welford update: mean += d / n, m2 += d * (x - mean').
+ */
+static void HT_Aggregate_ChannelAdd(HT_AggChannel *ch, uint32_t n, uint32_t now_s, int16_t x)
+{
+    int32_t x_q8 = (int32_t)x * (1L << HT_AGGREGATE_MEAN_SHIFT);
+    int32_t delta = x_q8 - ch->mean_q8;
+
+    ch->mean_q8 += delta / (int32_t)n;
+    // mean' lies between mean and x, so both factors share the sign of delta.
+    ch->m2_q16 += (uint64_t)((int64_t)delta * (x_q8 - ch->mean_q8));
+
+    if (x < ch->min)
+    {
+        ch->min = x;
+        ch->minAt_s = now_s;
+    }
+    if (x > ch->max)
+    {
+        ch->max = x;
+        ch->maxAt_s = now_s;
+    }
+}
+
+static int16_t HT_Aggregate_Mean(const HT_AggChannel *ch)
+{
+    int32_t half = 1L << (HT_AGGREGATE_MEAN_SHIFT - 1);
+
+    return (int16_t)((ch->mean_q8 >= 0 ? ch->mean_q8 + half : ch->mean_q8 - half) / (1L << HT_AGGREGATE_MEAN_SHIFT));
+}
+
+/**
+ * @brief Sample standard deviation in 0.01 units.
+ */
+static uint32_t HT_Aggregate_StdDev(const HT_AggChannel *ch, uint32_t n)
+{
+    // sqrt(m2 / (n - 1)) is in Q8 of 0.1 units; scale by 10 for 0.01 units.
+    if (n < 2)
+        return 0;
+
+    return (uint32_t)(((uint64_t)HT_Isqrt64(ch->m2_q16 / (n - 1)) * 10 + (1U << (HT_AGGREGATE_MEAN_SHIFT - 1))) >> HT_AGGREGATE_MEAN_SHIFT);
+}
+
+void HT_Aggregate_Reset(HT_AggregateState *st, uint32_t now_s)
+{
+    st->start_s = now_s;
+    st->last_s = now_s;
+    st->count = 0;
+    HT_Aggregate_ChannelReset(&st->temp);
+    HT_Aggregate_ChannelReset(&st->humi);
+}
+
+void HT_Aggregate_Add(HT_AggregateState *st, uint32_t now_s, int16_t temp_x10, uint16_t humi_x10)
+{
+    if (st->count == UINT32_MAX)
+        return;
+
+    if (st->count == 0)
+        st->start_s = now_s;
+
+    st->count++;
+    st->last_s = now_s;
+    HT_Aggregate_ChannelAdd(&st->temp, st->count, now_s, temp_x10);
+    HT_Aggregate_ChannelAdd(&st->humi, st->count, now_s, (int16_t)humi_x10);
+}
+
+void HT_Aggregate_Update(int16_t temp_x10, uint16_t humi_x10)
+{
+    HT_Aggregate_Add(&HT_Retained_Get()->aggregate, HT_Retained_Now(), temp_x10, humi_x10);
+    HT_Retained_Commit();
+}
+
+uint8_t HT_Aggregate_WindowDue(uint32_t window_s)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+
+    if (r->aggregate.count == 0)
+        return 0;
+
+    return (HT_Retained_Now() - r->aggregate.start_s) >= window_s;
+}
+
+void HT_Aggregate_Restart(void)
+{
+    HT_Aggregate_Reset(&HT_Retained_Get()->aggregate, HT_Retained_Now());
+    HT_Retained_Commit();
+}
+
+static int HT_Aggregate_FormatChannel(const HT_AggregateState *st, const HT_AggChannel *ch, char *buf, size_t len)
+{
+    return snprintf(buf, len, "[%d,%lu,%d,%lu,%d,%lu]",
+                    HT_Aggregate_Mean(ch), (unsigned long)HT_Aggregate_StdDev(ch, st->count),
+                    ch->min, (unsigned long)(ch->minAt_s - st->start_s),
+                    ch->max, (unsigned long)(ch->maxAt_s - st->start_s));
+}
+
+int HT_Aggregate_Format(const HT_AggregateState *st, uint16_t vbat_mv, char *buf, size_t len)
+{
+    char temp[64], humi[64];
+    int16_t meanTemp, meanHumi;
+    int n;
+
+    if (st->count == 0)
+        return 0;
+
+    meanTemp = HT_Aggregate_Mean(&st->temp);
+    meanHumi = HT_Aggregate_Mean(&st->humi);
+    HT_Aggregate_FormatChannel(st, &st->temp, temp, sizeof(temp));
+    HT_Aggregate_FormatChannel(st, &st->humi, humi, sizeof(humi));
+
+    n = snprintf(buf, len, "{\"n\":%lu,\"t0\":%lu,\"dur\":%lu,\"t\":%s,\"h\":%s,\"dp\":%d,\"ah\":%u,\"vb\":%u}",
+                 (unsigned long)st->count, (unsigned long)st->start_s, (unsigned long)(st->last_s - st->start_s),
+                 temp, humi, HT_DewPoint(meanTemp, (uint16_t)meanHumi), HT_AbsHumidity(meanTemp, (uint16_t)meanHumi), vbat_mv);
+
+    return (n < 0 || (size_t)n >= len) ? 0 : n;
+}
+
+int HT_Aggregate_DiagFormat(char *buf, size_t len)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+
+    return snprintf(buf, len, "\"aggregate\":{\"report\":%lu,\"window\":%lu,\"n\":%lu,\"age\":%lu}",
+                    (unsigned long)r->config.report_mode, (unsigned long)r->config.upload_window_s,
+                    (unsigned long)r->aggregate.count, (unsigned long)(HT_Retained_Now() - r->aggregate.start_s));
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
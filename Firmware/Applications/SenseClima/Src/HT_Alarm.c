@@ -0,0 +1,253 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Alarm.h"
+#include "HT_Retained.h"
+#include "HT_Log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HT_ALARM_RULE_MAX_LEN   24
+
+/**
+ * @brief Updates the trip state of a rule.
+ * @return 1 if the rule tripped on this sample.
+ */
+static uint8_t HT_Alarm_RuleStep(HT_AlarmRule *rule, uint32_t now_s, int16_t value)
+{
+    int32_t v = value, th = rule->threshold, hy = rule->hysteresis;
+
+    if (!rule->active)
+    {
+        if ((rule->above && v > th) || (!rule->above && v < th))
+        {
+            rule->active = 1;
+            rule->tripValue = value;
+            rule->tripAt_s = now_s;
+            return 1;
+        }
+    }
+    else if ((rule->above && v < th - hy) || (!rule->above && v > th + hy))
+    {
+        rule->active = 0; // Re-armed.
+    }
+
+    return 0;
+}
+
+void HT_Alarm_Reset(HT_AlarmState *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+uint8_t HT_Alarm_Step(HT_AlarmState *st, uint32_t now_s, uint32_t holdoff_s, int16_t temp_x10, uint16_t humi_x10)
+{
+    for (uint8_t i = 0; i < HT_ALARM_MAX_RULES; i++)
+    {
+        HT_AlarmRule *rule = &st->rules[i];
+        uint8_t bit = (uint8_t)(1U << i);
+
+        if (!rule->enabled)
+            continue;
+
+        if (HT_Alarm_RuleStep(rule, now_s, rule->channel == HT_ALARM_TEMPERATURE ? temp_x10 : (int16_t)humi_x10))
+        {
+            st->pending |= bit;
+        }
+        else if (!rule->active && (st->pending & bit))
+        {
+            // Cleared again before it could be published.
+            st->pending &= (uint8_t)~bit;
+            st->suppressed++;
+        }
+    }
+
+    if (!st->pending)
+        return 0;
+
+    // Failed attempts count too: a broker that never acknowledges must not wake the radio every sample.
+    if ((st->sent && now_s - st->lastSent_s < holdoff_s) || (st->tries && now_s - st->lastTry_s < holdoff_s))
+        return 0;
+
+    st->lastTry_s = now_s;
+    st->tries++;
+    return 1;
+}
+
+uint8_t HT_Alarm_Evaluate(int16_t temp_x10, uint16_t humi_x10)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    uint8_t preempt = HT_Alarm_Step(&r->alarm, HT_Retained_Now(), r->config.alarm_holdoff_s, temp_x10, humi_x10);
+
+    HT_Retained_Commit();
+
+    return preempt;
+}
+
+uint8_t HT_Alarm_Pending(void)
+{
+    return HT_Retained_Get()->alarm.pending;
+}
+
+int HT_Alarm_Format(uint8_t index, char *buf, size_t len)
+{
+    const HT_AlarmRule *rule;
+    int n;
+
+    if (index >= HT_ALARM_MAX_RULES)
+        return 0;
+    rule = &HT_Retained_Get()->alarm.rules[index];
+
+    n = snprintf(buf, len, "{\"rule\":%u,\"ch\":\"%c\",\"op\":\"%c\",\"th\":%d,\"hy\":%u,\"v\":%d,\"at\":%lu}",
+                 index, rule->channel == HT_ALARM_TEMPERATURE ? 't' : 'h', rule->above ? '>' : '<',
+                 rule->threshold, rule->hysteresis, rule->tripValue, (unsigned long)rule->tripAt_s);
+
+    return (n < 0 || (size_t)n >= len) ? 0 : n;
+}
+
+void HT_Alarm_MarkSent(uint8_t index)
+{
+    HT_AlarmState *st = &HT_Retained_Get()->alarm;
+
+    if (index >= HT_ALARM_MAX_RULES)
+        return;
+
+    st->pending &= (uint8_t)~(1U << index);
+    st->lastSent_s = HT_Retained_Now();
+    st->sent++;
+    HT_Retained_Commit();
+}
+
+/**
+ * @brief Parses "t>300/10", "h<200" or "off" into a rule.
+ */
+static HT_AlarmStatus HT_Alarm_ParseRule(const char *text, HT_AlarmRule *rule)
+{
+    char *end = NULL;
+    long th, hy = 0;
+
+    memset(rule, 0, sizeof(*rule));
+
+    if (strcmp(text, "off") == 0)
+        return HT_ALARM_OK;
+
+    if ((text[0] != 't' && text[0] != 'h') || (text[1] != '>' && text[1] != '<'))
+        return HT_ALARM_SYNTAX;
+
+    th = strtol(&text[2], &end, 10);
+    if (end == &text[2] || th < INT16_MIN || th > INT16_MAX)
+        return HT_ALARM_SYNTAX;
+
+    if (*end == '/')
+    {
+        const char *hyText = end + 1;
+
+        hy = strtol(hyText, &end, 10);
+        if (end == hyText || hy < 0 || hy > 1000)
+            return HT_ALARM_SYNTAX;
+    }
+    if (*end != '\0')
+        return HT_ALARM_SYNTAX;
+
+    rule->enabled = 1;
+    rule->channel = (text[0] == 't') ? HT_ALARM_TEMPERATURE : HT_ALARM_HUMIDITY;
+    rule->above = (text[1] == '>');
+    rule->threshold = (int16_t)th;
+    rule->hysteresis = (uint16_t)hy;
+
+    return HT_ALARM_OK;
+}
+
+HT_AlarmStatus HT_Alarm_Apply(const uint8_t *payload, uint16_t len)
+{
+    HT_AlarmState *st = &HT_Retained_Get()->alarm;
+    HT_AlarmStatus ret = HT_ALARM_OK;
+    uint16_t pos = 0;
+
+    while (pos < len && ret == HT_ALARM_OK)
+    {
+        char text[HT_ALARM_RULE_MAX_LEN];
+        uint8_t n = 0;
+        char *end = NULL;
+        unsigned long index;
+        HT_AlarmRule rule;
+
+        // Extract one "<index>=<rule>" definition, skipping blanks.
+        for (; pos < len && payload[pos] != ';' && payload[pos] != '\n'; pos++)
+        {
+            char c = (char)payload[pos];
+
+            if (c == ' ' || c == '\r' || c == '\0')
+                continue;
+            if (n >= sizeof(text) - 1)
+            {
+                ret = HT_ALARM_SYNTAX; // Over-long rule; the ones before it still get committed.
+                break;
+            }
+            text[n++] = c;
+        }
+        pos++; // Skip the separator.
+
+        if (n == 0)
+            continue;
+        text[n] = '\0';
+
+        if (ret == HT_ALARM_OK)
+        {
+            index = strtoul(text, &end, 10);
+            if (end == text || *end != '=')
+                ret = HT_ALARM_SYNTAX;
+            else if (index >= HT_ALARM_MAX_RULES)
+                ret = HT_ALARM_BAD_INDEX;
+            else
+                ret = HT_Alarm_ParseRule(end + 1, &rule);
+        }
+
+        if (ret != HT_ALARM_OK)
+        {
+            HT_LOG_STRING(P_WARNING, HT_Alarm_Apply_1, "Alarm: %s rejected (%d)", text, ret);
+            break;
+        }
+
+        st->rules[index] = rule;
+        st->pending &= (uint8_t)~(1U << index);
+    }
+
+    HT_Retained_Commit();
+
+    return ret;
+}
+
+int HT_Alarm_DiagFormat(char *buf, size_t len)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    const HT_AlarmState *st = &r->alarm;
+    uint8_t enabled = 0, active = 0;
+
+    for (uint8_t i = 0; i < HT_ALARM_MAX_RULES; i++)
+    {
+        if (st->rules[i].enabled)
+            enabled |= (uint8_t)(1U << i);
+        if (st->rules[i].active)
+            active |= (uint8_t)(1U << i);
+    }
+
+    return snprintf(buf, len, "\"alarm\":{\"rules\":%u,\"active\":%u,\"pending\":%u,\"tries\":%lu,\"sent\":%lu,\"suppressed\":%lu}",
+                    enabled, active, st->pending, (unsigned long)st->tries, (unsigned long)st->sent,
+                    (unsigned long)st->suppressed);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,216 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Config.h"
+#include "HT_Retained.h"
+#include "HT_Log.h"
+#include "HT_Alarm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HT_CONFIG_KEY_MAX_LEN   24
+#define HT_CONFIG_VALUE_MAX_LEN 16
+
+/**
+ * @brief Describes one configurable field.
+ */
+typedef struct {
+    const char *key;   /**< Name used on the wire. */
+    uint16_t offset;   /**< Offset of the uint32_t field in HT_ConfigData. */
+    uint32_t min;      /**< Smallest accepted value. */
+    uint32_t max;      /**< Largest accepted value. */
+} HT_ConfigItem;
+
+static const HT_ConfigItem configItems[] = {
+    { "interval",     offsetof(HT_ConfigData, interval_s),     10, HT_CONFIG_MAX_INTERVAL_S },
+    { "adaptive",     offsetof(HT_ConfigData, adaptive),       0,  1 },
+    { "min_interval", offsetof(HT_ConfigData, min_interval_s), 10, HT_CONFIG_MAX_INTERVAL_S },
+    { "max_interval", offsetof(HT_ConfigData, max_interval_s), 10, HT_CONFIG_MAX_INTERVAL_S },
+    { "temp_tol",     offsetof(HT_ConfigData, temp_tol_x10),   1,  100 },
+    { "humi_tol",     offsetof(HT_ConfigData, humi_tol_x10),   1,  200 },
+    { "ew_shift",     offsetof(HT_ConfigData, ew_shift),       0,  6 },
+    { "report",       offsetof(HT_ConfigData, report_mode),    HT_CONFIG_REPORT_RAW, HT_CONFIG_REPORT_AGGREGATE },
+    { "window",       offsetof(HT_ConfigData, upload_window_s), 60, HT_CONFIG_MAX_INTERVAL_S },
+    { "alarm_holdoff", offsetof(HT_ConfigData, alarm_holdoff_s), 0, HT_CONFIG_MAX_INTERVAL_S },
+    { "uart_idle",    offsetof(HT_ConfigData, uart_idle_ms),   0,  HT_CONFIG_MAX_UART_IDLE_MS },
+    { "saver_pct",    offsetof(HT_ConfigData, saver_pct),      0,  100 },
+    { "low_pct",      offsetof(HT_ConfigData, low_pct),        0,  100 },
+    { "critical_pct", offsetof(HT_ConfigData, critical_pct),   0,  100 },
+    { "horizon",      offsetof(HT_ConfigData, horizon_h),      0,  720 },
+    { "connect",      offsetof(HT_ConfigData, connect_s),      10, HT_CONFIG_MAX_CONNECT_S },
+    { "normal_scale", offsetof(HT_ConfigData, tier[0].scale),  1,  64 },
+    { "normal_batch", offsetof(HT_ConfigData, tier[0].batch),  1,  16 },
+    { "normal_qos",   offsetof(HT_ConfigData, tier[0].qos),    0,  1 },
+    { "normal_log",   offsetof(HT_ConfigData, tier[0].log),    HT_LOG_LEVEL_DEBUG, HT_LOG_LEVEL_ERROR },
+    { "saver_scale",  offsetof(HT_ConfigData, tier[1].scale),  1,  64 },
+    { "saver_batch",  offsetof(HT_ConfigData, tier[1].batch),  1,  16 },
+    { "saver_qos",    offsetof(HT_ConfigData, tier[1].qos),    0,  1 },
+    { "saver_log",    offsetof(HT_ConfigData, tier[1].log),    HT_LOG_LEVEL_DEBUG, HT_LOG_LEVEL_ERROR },
+    { "low_scale",    offsetof(HT_ConfigData, tier[2].scale),  1,  64 },
+    { "low_batch",    offsetof(HT_ConfigData, tier[2].batch),  1,  16 },
+    { "low_qos",      offsetof(HT_ConfigData, tier[2].qos),    0,  1 },
+    { "low_log",      offsetof(HT_ConfigData, tier[2].log),    HT_LOG_LEVEL_DEBUG, HT_LOG_LEVEL_ERROR },
+};
+
+#define HT_CONFIG_ITEM_COUNT (sizeof(configItems) / sizeof(configItems[0]))
+
+static uint32_t *HT_Config_Field(HT_ConfigData *cfg, const HT_ConfigItem *item)
+{
+    return (uint32_t *)((uint8_t *)cfg + item->offset);
+}
+
+void HT_Config_Defaults(HT_ConfigData *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->interval_s = HT_CONFIG_DEFAULT_INTERVAL_S;
+    cfg->adaptive = 1;
+    cfg->min_interval_s = 30;
+    cfg->max_interval_s = 900;
+    cfg->temp_tol_x10 = 5;   // 0.5 C
+    cfg->humi_tol_x10 = 25;  // 2.5 %RH
+    cfg->ew_shift = 2;       // alpha = 0.25
+    cfg->report_mode = HT_CONFIG_REPORT_RAW;
+    cfg->upload_window_s = 900;
+    cfg->alarm_holdoff_s = HT_ALARM_DEFAULT_HOLDOFF_S;
+    cfg->uart_idle_ms = 2000;
+    cfg->saver_pct = 40;
+    cfg->low_pct = 15;
+    cfg->critical_pct = 5;
+    cfg->horizon_h = 24;
+    cfg->connect_s = 90;
+    cfg->tier[0] = (HT_ConfigTier){ 1, 1, 1, HT_LOG_LEVEL_INFO };
+    cfg->tier[1] = (HT_ConfigTier){ 2, 2, 0, HT_LOG_LEVEL_SIG };
+    cfg->tier[2] = (HT_ConfigTier){ 4, 4, 0, HT_LOG_LEVEL_WARNING };
+}
+
+HT_ConfigData *HT_Config_Get(void)
+{
+    return &HT_Retained_Get()->config;
+}
+
+HT_ConfigStatus HT_Config_Set(const char *key, const char *value)
+{
+    HT_ConfigData *cfg = HT_Config_Get();
+    HT_ConfigData candidate = *cfg;
+    char *end = NULL;
+    unsigned long v;
+
+    for (size_t i = 0; i < HT_CONFIG_ITEM_COUNT; i++)
+    {
+        if (strcmp(key, configItems[i].key) != 0)
+            continue;
+
+        v = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || v < configItems[i].min || v > configItems[i].max)
+            return HT_CONFIG_BAD_VALUE;
+
+        *HT_Config_Field(&candidate, &configItems[i]) = (uint32_t)v;
+
+        // Keep the adaptive bounds and the tier thresholds consistent with each other.
+        if (candidate.min_interval_s > candidate.max_interval_s ||
+            candidate.critical_pct > candidate.low_pct || candidate.low_pct > candidate.saver_pct)
+            return HT_CONFIG_BAD_VALUE;
+
+        *cfg = candidate;
+        HT_Retained_Commit();
+
+        return HT_CONFIG_OK;
+    }
+
+    return HT_CONFIG_UNKNOWN_KEY;
+}
+
+HT_ConfigStatus HT_Config_Apply(const uint8_t *payload, uint16_t len)
+{
+    uint16_t pos = 0;
+
+    while (pos < len)
+    {
+        char key[HT_CONFIG_KEY_MAX_LEN];
+        char value[HT_CONFIG_VALUE_MAX_LEN];
+        uint8_t k = 0, v = 0, inValue = 0;
+        HT_ConfigStatus ret;
+
+        // Split one "key=value" pair, skipping blanks.
+        for (; pos < len && payload[pos] != ';' && payload[pos] != ',' && payload[pos] != '\n'; pos++)
+        {
+            char c = (char)payload[pos];
+
+            if (c == ' ' || c == '\r' || c == '\0')
+                continue;
+            if (c == '=' && !inValue)
+            {
+                inValue = 1;
+                continue;
+            }
+
+            if (inValue)
+            {
+                if (v >= sizeof(value) - 1)
+                    return HT_CONFIG_SYNTAX;
+                value[v++] = c;
+            }
+            else
+            {
+                if (k >= sizeof(key) - 1)
+                    return HT_CONFIG_SYNTAX;
+                key[k++] = c;
+            }
+        }
+        pos++; // Skip the separator.
+
+        if (k == 0 && v == 0)
+            continue; // Empty pair, e.g. trailing separator.
+        if (!inValue || k == 0 || v == 0)
+            return HT_CONFIG_SYNTAX;
+
+        key[k] = '\0';
+        value[v] = '\0';
+
+        ret = HT_Config_Set(key, value);
+        if (ret != HT_CONFIG_OK)
+        {
+            HT_LOG_STRING(P_WARNING, HT_Config_Apply_1, "Config: %s rejected (%d)", key, ret);
+            return ret;
+        }
+    }
+
+    return HT_CONFIG_OK;
+}
+
+int HT_Config_Format(char *buf, size_t len)
+{
+    HT_ConfigData *cfg = HT_Config_Get();
+    int written = 0;
+
+    if (len == 0)
+        return 0;
+    buf[0] = '\0';
+
+    for (size_t i = 0; i < HT_CONFIG_ITEM_COUNT; i++)
+    {
+        int n = snprintf(buf + written, len - written, "%s%s=%lu", i ? ";" : "",
+                         configItems[i].key, (unsigned long)*HT_Config_Field(cfg, &configItems[i]));
+
+        if (n < 0 || (size_t)n >= len - written)
+            break;
+        written += n;
+    }
+
+    return written;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
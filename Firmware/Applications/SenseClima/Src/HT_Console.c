@@ -0,0 +1,469 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Console.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os2.h"              // Required for osThreadNew, osSemaphore*
+#include "FreeRTOS.h"               // Required for StaticTask_t
+#include "slpman_qcx212.h"          // Required for the platform sleep vote
+#include "htnb32lxxx_hal_usart.h"   // Required for HAL_USART_Receive_DMA, HAL_USART_PrintGate
+#include "bsp.h"                    // Required for PAD_SetPinMux, GPIO_InterruptConfig, XIC_SetVector
+#include "HT_Config.h"              // Required for HT_Config_Format, HT_Config_Apply
+#include "HT_Diag.h"                // Required for HT_Diag_Format
+#include "HT_SenseClima.h"          // Required for HT_SenseClima_ForceCycle
+#include "HT_Retained.h"            // Required for HT_Retained_Now
+#include "HT_TimeSeries.h"          // Required for HT_TimeSeries_Query
+#if defined(HT_DTLS)
+#include "HT_Dtls.h"                // Required for HT_Dtls_Open, HT_Dtls_Exchange
+#endif
+#include "HT_Log.h"
+
+#define CONSOLE_RX_ERRORS   (ARM_USART_EVENT_RX_OVERFLOW | ARM_USART_EVENT_RX_BREAK | \
+                             ARM_USART_EVENT_RX_FRAMING_ERROR | ARM_USART_EVENT_RX_PARITY_ERROR)
+
+extern USART_HandleTypeDef huart1;
+
+static uint8_t consoleRing[HT_CONSOLE_RING_SIZE];
+static volatile uint32_t consoleHead;   // Bytes received since init: completed laps plus the DMA count
+static uint32_t consoleLap;             // Bytes of the completed laps (IRQ only)
+static uint32_t consoleTail;            // Bytes consumed by the task
+
+static char consoleLine[HT_CONSOLE_LINE_MAX + 1];
+static uint32_t consoleLineLen;
+static uint8_t consoleLineBad;          // Current line overflowed, dropped at its end
+static uint8_t consoleLastCr;           // Swallow the LF of a CR LF pair
+
+static volatile uint32_t consoleErrors;
+static uint32_t consoleDropped;
+static uint32_t consoleLines;
+
+static osSemaphoreId_t consoleRx;
+static uint8_t consoleVote = 0xFF;
+static uint8_t consoleSession = 0;
+
+static uint32_t consoleLastRx;          // Tick of the last RX frame or wake edge
+static uint32_t consoleActiveSince;     // Tick the UART clock last started
+static uint64_t consoleActiveTicks;     // Clocked time of the finished active periods
+static uint32_t consoleGates;
+
+static StaticTask_t consoleTask;
+static uint8_t consoleTaskStack[HT_CONSOLE_STACK_SIZE];
+
+/**
+ * @brief USART1 events, from IRQ context. Overrides the weak HAL default.
+ */
+void HT_USART_Callback(uint32_t event)
+{
+    if (event & CONSOLE_RX_ERRORS)
+        consoleErrors++;
+
+    if (event & (ARM_USART_EVENT_RECEIVE_COMPLETE | ARM_USART_EVENT_DMA_RX_COMPLETE))
+    {
+        // Ring end reached: wrap the DMA back to the start
+        consoleLap += HT_CONSOLE_RING_SIZE;
+        consoleHead = consoleLap;
+        HAL_USART_Receive_DMA(&huart1, consoleRing, HT_CONSOLE_RING_SIZE);
+        osSemaphoreRelease(consoleRx);
+    }
+    else if (event & ARM_USART_EVENT_RX_TIMEOUT)
+    {
+        consoleHead = consoleLap + (uint32_t)HAL_USART_GetRxCount(&huart1);
+        osSemaphoreRelease(consoleRx);
+    }
+}
+
+/**
+ * @brief RX pin edge while the UART clock is gated. The GPIO interrupt is
+ *        shared, only the RX pin is armed by this module.
+ */
+static void HT_Console_RxEdgeIRQ(void)
+{
+    if (GPIO_GetInterruptFlags(HT_CONSOLE_RX_GPIO_INSTANCE) & (1U << HT_CONSOLE_RX_GPIO_PIN))
+    {
+        GPIO_ClearInterruptFlags(HT_CONSOLE_RX_GPIO_INSTANCE, 1U << HT_CONSOLE_RX_GPIO_PIN);
+        HAL_USART_PrintUngate();
+    }
+}
+
+/**
+ * @brief UART clock gated or running again, with interrupts masked. While
+ *        gated the RX pad is handed to its GPIO so the first incoming edge
+ *        brings the clock back; that character itself is lost.
+ */
+static void HT_Console_GateChanged(bool gated)
+{
+    uint32_t now = osKernelGetTickCount();
+
+    if (gated)
+    {
+        consoleActiveTicks += now - consoleActiveSince;
+        consoleGates++;
+        GPIO_ClearInterruptFlags(HT_CONSOLE_RX_GPIO_INSTANCE, 1U << HT_CONSOLE_RX_GPIO_PIN);
+        PAD_SetPinMux(RTE_UART1_RX_PAD_ID, PAD_MuxAlt0);
+        GPIO_InterruptConfig(HT_CONSOLE_RX_GPIO_INSTANCE, HT_CONSOLE_RX_GPIO_PIN, GPIO_InterruptFallingEdge);
+    }
+    else
+    {
+        GPIO_InterruptConfig(HT_CONSOLE_RX_GPIO_INSTANCE, HT_CONSOLE_RX_GPIO_PIN, GPIO_InterruptDisabled);
+        PAD_SetPinMux(RTE_UART1_RX_PAD_ID, RTE_UART1_RX_FUNC);
+        consoleActiveSince = now;
+
+        // Restart the idle countdown of the task, whoever ungated (masked IRQs count as ISR context)
+        osSemaphoreRelease(consoleRx);
+    }
+}
+
+/**
+ * @brief Opens or closes the session, which holds the platform sleep vote.
+ */
+static void HT_Console_Session(uint8_t open)
+{
+    if (open == consoleSession)
+        return;
+
+    consoleSession = open;
+    if (open)
+    {
+        slpManPlatVoteDisableSleep(consoleVote, SLP_SLP1_STATE);
+        HT_LOG(P_INFO, HT_Console_Session_1, "Console session open, sleep held.");
+    }
+    else
+    {
+        slpManPlatVoteEnableSleep(consoleVote, SLP_SLP1_STATE);
+        HT_LOG(P_INFO, HT_Console_Session_2, "Console session closed.");
+    }
+}
+
+static void HT_Console_Help(void)
+{
+#if defined(HT_DTLS)
+    printf("help | get | set key=value[;...] | diag | cycle | ts [seconds] | dtls host text\r\n");
+#else
+    printf("help | get | set key=value[;...] | diag | cycle | ts [seconds]\r\n");
+#endif
+}
+
+#define CONSOLE_TS_DEFAULT_S        3600
+#define CONSOLE_TS_PAGE             16
+
+/**
+ * @brief Prints the stored readings of the last seconds, a page at a time,
+ *        then "OK count".
+ */
+static void HT_Console_Series(const char *args)
+{
+    static HT_TsRecord page[CONSOLE_TS_PAGE];
+    uint32_t span = CONSOLE_TS_DEFAULT_S, now, from, total = 0;
+    char *end;
+    size_t n;
+
+    if (*args != '\0')
+    {
+        span = strtoul(args, &end, 10);
+        if (*end != '\0')
+        {
+            printf("ERR\r\n");
+            return;
+        }
+    }
+
+    now = HT_TimeSeries_Time(HT_Retained_Now());
+    from = now > span ? now - span : 0;
+
+    while ((n = HT_TimeSeries_Query(from, now, page, CONSOLE_TS_PAGE)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+            printf("%lu %d %u %u %u\r\n", (unsigned long)page[i].t_s, page[i].temp, page[i].humi,
+                   page[i].vbat_mv, page[i].flags);
+        total += n;
+        from = page[n - 1].t_s + 1;
+    }
+
+    printf("OK %lu\r\n", (unsigned long)total);
+}
+
+#if defined(HT_DTLS)
+#define CONSOLE_DTLS_TIMEOUT_MS     10000
+
+/**
+ * @brief Sends text to the DTLS server and prints "OK mode reply", mode
+ *        being HT_DTLS_RESTORED, HT_DTLS_RESUMED or HT_DTLS_FULL.
+ */
+static void HT_Console_Dtls(char *args, char *out, size_t outSize)
+{
+    char *text = strchr(args, ' ');
+    int len;
+
+    if (text == NULL || text[1] == '\0')
+    {
+        printf("ERR\r\n");
+        return;
+    }
+    *text++ = '\0';
+
+    if (HT_Dtls_Open(args, HT_DTLS_PORT) == HT_DTLS_ERROR)
+    {
+        printf("ERR\r\n");
+        return;
+    }
+
+    len = HT_Dtls_Exchange((const uint8_t *)text, strlen(text), (uint8_t *)out, outSize - 1, CONSOLE_DTLS_TIMEOUT_MS);
+    if (len < 0)
+    {
+        printf("ERR %d\r\n", len);
+        HT_Dtls_Close(0);
+        return;
+    }
+
+    printf("OK %u %.*s\r\n", HT_Dtls_Mode(), len, out);
+    HT_Dtls_Close(1);
+}
+#endif
+
+static void HT_Console_Execute(char *line)
+{
+    static char out[HT_DIAG_BUFFER_SIZE];
+    HT_ConfigStatus status;
+
+    if (strcmp(line, "help") == 0)
+    {
+        HT_Console_Help();
+    }
+    else if (strcmp(line, "get") == 0)
+    {
+        HT_Config_Format(out, sizeof(out));
+        printf("%s\r\n", out);
+    }
+    else if (strncmp(line, "set ", 4) == 0)
+    {
+        status = HT_Config_Apply((const uint8_t *)line + 4, (uint16_t)strlen(line + 4));
+        if (status == HT_CONFIG_OK)
+            printf("OK\r\n");
+        else
+            printf("ERR %d\r\n", status);
+    }
+    else if (strcmp(line, "diag") == 0)
+    {
+        if (HT_Diag_Format(out, sizeof(out)) > 0)
+            printf("%s\r\n", out);
+        else
+            printf("ERR\r\n");
+    }
+    else if (strcmp(line, "cycle") == 0)
+    {
+        HT_SenseClima_ForceCycle();
+        printf("OK\r\n");
+        HT_Console_Session(0);  // Do not hold the device awake past the new wakeup
+    }
+    else if (strcmp(line, "ts") == 0 || strncmp(line, "ts ", 3) == 0)
+    {
+        HT_Console_Series(line[2] ? line + 3 : "");
+    }
+#if defined(HT_DTLS)
+    else if (strncmp(line, "dtls ", 5) == 0)
+    {
+        HT_Console_Dtls(line + 5, out, sizeof(out));
+    }
+#endif
+    else
+    {
+        printf("? ");
+        HT_Console_Help();
+    }
+}
+
+/**
+ * @brief Consumes the ring up to the DMA position: echoes it, edits the line
+ *        and runs each completed one.
+ */
+static void HT_Console_Drain(void)
+{
+    char echo[32];
+    uint32_t echoLen = 0;
+    uint32_t head = consoleHead;
+    char c;
+
+    // Data was overwritten before the task got to it
+    if (head - consoleTail > HT_CONSOLE_RING_SIZE)
+    {
+        consoleDropped += head - consoleTail - HT_CONSOLE_RING_SIZE;
+        consoleTail = head - HT_CONSOLE_RING_SIZE;
+        consoleLineBad = 1;
+    }
+
+    while (consoleTail != head)
+    {
+        c = (char)consoleRing[consoleTail % HT_CONSOLE_RING_SIZE];
+        consoleTail++;
+
+        if (c == '\n' && consoleLastCr)
+        {
+            consoleLastCr = 0;
+            continue;
+        }
+        consoleLastCr = (c == '\r');
+
+        if (c == '\r' || c == '\n')
+        {
+            if (echoLen)
+                printf("%.*s", (int)echoLen, echo);
+            echoLen = 0;
+            printf("\r\n");
+
+            consoleLine[consoleLineLen] = '\0';
+            if (consoleLineBad)
+                printf("ERR line too long\r\n");
+            else if (consoleLineLen)
+            {
+                consoleLines++;
+                HT_Console_Execute(consoleLine);
+            }
+
+            consoleLineLen = 0;
+            consoleLineBad = 0;
+            printf("> ");
+            continue;
+        }
+
+        if (c == '\b' || c == 0x7F)
+        {
+            if (consoleLineLen == 0)
+                continue;
+            consoleLineLen--;
+            if (echoLen + 3 > sizeof(echo))
+            {
+                printf("%.*s", (int)echoLen, echo);
+                echoLen = 0;
+            }
+            echo[echoLen++] = '\b';
+            echo[echoLen++] = ' ';
+            echo[echoLen++] = '\b';
+            continue;
+        }
+
+        if (consoleLineLen < HT_CONSOLE_LINE_MAX)
+            consoleLine[consoleLineLen++] = c;
+        else
+        {
+            consoleDropped++;
+            consoleLineBad = 1;
+        }
+
+        if (echoLen == sizeof(echo))
+        {
+            printf("%.*s", (int)echoLen, echo);
+            echoLen = 0;
+        }
+        echo[echoLen++] = c;
+    }
+
+    if (echoLen)
+        printf("%.*s", (int)echoLen, echo);
+}
+
+static void HT_Console_Thread(void *arg)
+{
+    uint32_t freq = osKernelGetTickFreq();
+    uint32_t session = HT_CONSOLE_SESSION_MS * freq / 1000U;
+    uint32_t idle, timeout, now;
+
+    for (;;)
+    {
+        idle = HT_Config_Get()->uart_idle_ms * freq / 1000U;
+
+        timeout = consoleSession ? session : osWaitForever;
+        if (idle && !HAL_USART_PrintIsGated() && idle < timeout)
+            timeout = idle;
+
+        if (osSemaphoreAcquire(consoleRx, timeout) == osOK)
+        {
+            consoleLastRx = osKernelGetTickCount();
+
+            // Wake edges and ungating by _write signal too, only input opens a session
+            if (consoleHead != consoleTail)
+            {
+                HT_Console_Session(1);
+                HT_Console_Drain();
+            }
+            continue;
+        }
+
+        now = osKernelGetTickCount();
+
+        // Nobody typed for a while: let the device sleep again
+        if (consoleSession && now - consoleLastRx >= session)
+            HT_Console_Session(0);
+
+        // Refused while output is pending, tried again one idle period later
+        if (idle && now - consoleLastRx >= idle)
+            HAL_USART_PrintGate();
+    }
+}
+
+void HT_Console_Init(void)
+{
+    osThreadAttr_t task_attr;
+    gpio_pin_config_t gpioConfig;
+
+    consoleRx = osSemaphoreNew(1, 0, NULL);
+    if (consoleRx == NULL)
+        return;
+
+    slpManApplyPlatVoteHandle("CONSOLE", &consoleVote);
+
+    // RX pin as a GPIO input, armed only while the UART clock is gated
+    gpioConfig.pinDirection = GPIO_DirectionInput;
+    gpioConfig.misc.interruptConfig = GPIO_InterruptDisabled;
+    GPIO_PinConfig(HT_CONSOLE_RX_GPIO_INSTANCE, HT_CONSOLE_RX_GPIO_PIN, &gpioConfig);
+    XIC_SetVector(PXIC_Gpio_IRQn, HT_Console_RxEdgeIRQ);
+    XIC_EnableIRQ(PXIC_Gpio_IRQn);
+
+    consoleActiveSince = osKernelGetTickCount();
+    consoleLastRx = consoleActiveSince;
+    HAL_USART_SetPrintGateCallback(HT_Console_GateChanged);
+
+    memset(&task_attr, 0, sizeof(task_attr));
+    task_attr.name = "console";
+    task_attr.stack_mem = consoleTaskStack;
+    task_attr.stack_size = HT_CONSOLE_STACK_SIZE;
+    task_attr.priority = osPriorityBelowNormal;
+    task_attr.cb_mem = &consoleTask;
+    task_attr.cb_size = sizeof(StaticTask_t);
+
+    if (osThreadNew(HT_Console_Thread, NULL, &task_attr) == NULL)
+        return;
+
+    HAL_USART_Receive_DMA(&huart1, consoleRing, HT_CONSOLE_RING_SIZE);
+}
+
+int HT_Console_DiagFormat(char *buf, size_t len)
+{
+    uint64_t active;
+    uint32_t mask;
+
+    mask = SaveAndSetIRQMask();
+    active = consoleActiveTicks;
+    if (!HAL_USART_PrintIsGated())
+        active += osKernelGetTickCount() - consoleActiveSince;
+    RestoreIRQMask(mask);
+
+    return snprintf(buf, len, "\"console\":{\"lines\":%lu,\"err\":%lu,\"drop\":%lu,\"uart_ms\":%lu,\"gates\":%lu}",
+                    (unsigned long)consoleLines, (unsigned long)consoleErrors, (unsigned long)consoleDropped,
+                    (unsigned long)(active * 1000U / osKernelGetTickFreq()), (unsigned long)consoleGates);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,147 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_CryptoBench.h"
+#include <string.h>
+#include "cmsis_os2.h"          // Required for osKernelGetTickCount
+#include "mbedtls/gcm.h"        // Required for mbedtls_gcm_*
+#include "mbedtls/ccm.h"        // Required for mbedtls_ccm_*
+#include "mbedtls/md.h"         // Required for mbedtls_md_hmac
+#include "l2c_alt.h"            // Required for mbedtls_l2c_*
+#include "HT_MQTT_Tls.h"        // Required for HT_MQTT_TLSArenaOpen, HT_MQTT_TLSArenaClose
+#include "HT_Retained.h"        // Required for HT_Retained_Get
+#include "HT_Log.h"
+
+static uint8_t benchIn[HT_CRYPTO_BENCH_RECORD];
+static uint8_t benchOut[HT_CRYPTO_BENCH_RECORD];
+
+static uint32_t HT_CryptoBench_Ms(void)
+{
+    return (uint32_t)(((uint64_t)osKernelGetTickCount() * 1000U) / osKernelGetTickFreq());
+}
+
+static uint32_t HT_CryptoBench_Rate(uint32_t count, uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)count * 1000U) / (ms ? ms : 1U));
+}
+
+/**
+ * @brief Runs every workload in the current engine state.
+ * @param check Receives the GCM tag, CCM tag and HMAC of the last run.
+ */
+static void HT_CryptoBench_Pass(HT_CryptoBenchRates *rates, uint8_t check[64])
+{
+    static const uint8_t key[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+    const mbedtls_md_info_t *sha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_gcm_context gcm;
+    mbedtls_ccm_context ccm;
+    mbedtls_l2c_stats *stats = mbedtls_l2c_get_stats();
+    uint8_t nonce[12] = { 0 }, aad[13] = { 0 }, secret[48] = { 0 }, seed[77];
+    uint32_t start, i;
+
+    mbedtls_l2c_reset_stats();
+    memset(seed, 0xA5, sizeof(seed));
+
+    // Records as the TLS layer sends them: explicit nonce and 13 byte header per record
+    mbedtls_gcm_init(&gcm);
+    mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128);
+    start = HT_CryptoBench_Ms();
+    for (i = 0; i < HT_CRYPTO_BENCH_RECORDS; i++)
+    {
+        nonce[11] = aad[7] = (uint8_t)i;
+        mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, sizeof(benchIn), nonce, sizeof(nonce),
+                                  aad, sizeof(aad), benchIn, benchOut, 16, check);
+    }
+    rates->gcm_bps = HT_CryptoBench_Rate(HT_CRYPTO_BENCH_RECORDS * sizeof(benchIn), HT_CryptoBench_Ms() - start);
+    mbedtls_gcm_free(&gcm);
+
+    mbedtls_ccm_init(&ccm);
+    mbedtls_ccm_setkey(&ccm, MBEDTLS_CIPHER_ID_AES, key, 128);
+    start = HT_CryptoBench_Ms();
+    for (i = 0; i < HT_CRYPTO_BENCH_RECORDS; i++)
+    {
+        nonce[11] = aad[7] = (uint8_t)i;
+        mbedtls_ccm_encrypt_and_tag(&ccm, sizeof(benchIn), nonce, sizeof(nonce),
+                                    aad, sizeof(aad), benchIn, benchOut, check + 16, 16);
+    }
+    rates->ccm_bps = HT_CryptoBench_Rate(HT_CRYPTO_BENCH_RECORDS * sizeof(benchIn), HT_CryptoBench_Ms() - start);
+    mbedtls_ccm_free(&ccm);
+
+    // One P_SHA256 step of the key derivation: 48 byte secret, label and randoms
+    start = HT_CryptoBench_Ms();
+    for (i = 0; i < HT_CRYPTO_BENCH_HMACS; i++)
+    {
+        seed[0] = (uint8_t)i;
+        mbedtls_md_hmac(sha256, secret, sizeof(secret), seed, sizeof(seed), check + 32);
+    }
+    rates->hmac_ps = HT_CryptoBench_Rate(HT_CRYPTO_BENCH_HMACS, HT_CryptoBench_Ms() - start);
+
+    rates->hw_calls = stats->aes_hw_calls;
+    rates->sw_blocks = stats->aes_sw_blocks;
+    rates->sha_hw = stats->sha_hw;
+}
+
+int32_t HT_CryptoBench_Run(HT_CryptoBenchRates result[2])
+{
+    HT_CryptoBenchRates rates[2];
+    uint8_t check[2][64];
+    int enabled = mbedtls_l2c_get_hw();
+
+    for (uint32_t i = 0; i < HT_CRYPTO_BENCH_RECORD; i++)
+        benchIn[i] = (uint8_t)i;
+
+    HT_MQTT_TLSArenaOpen(); // GCM, CCM and HMAC contexts allocate
+    for (int hw = 0; hw < 2; hw++)
+    {
+        mbedtls_l2c_set_hw(hw);
+        memset(check[hw], 0, sizeof(check[hw]));
+        HT_CryptoBench_Pass(&rates[hw], check[hw]);
+
+        HT_LOG(P_SIG, HT_CryptoBench_Run_1, "Crypto bench engine %u: GCM %u B/s, CCM %u B/s, HMAC %u/s, engine calls %u, sw blocks %u, hw digests %u",
+               hw, rates[hw].gcm_bps, rates[hw].ccm_bps, rates[hw].hmac_ps, rates[hw].hw_calls, rates[hw].sw_blocks, rates[hw].sha_hw);
+    }
+
+    HT_MQTT_TLSArenaClose();
+    mbedtls_l2c_set_hw(enabled);
+    mbedtls_l2c_reset_stats();
+
+    if (result)
+        memcpy(result, rates, sizeof(rates));
+
+    if (memcmp(check[0], check[1], sizeof(check[0])) != 0)
+    {
+        HT_LOG(P_ERROR, HT_CryptoBench_Run_2, "Crypto bench: engine and software results differ");
+        return -1;
+    }
+
+    return 0;
+}
+
+void HT_CryptoBench_SelectEngine(void)
+{
+    mbedtls_l2c_set_hw(HT_Retained_Get()->wakeCount & 1);
+    mbedtls_l2c_reset_stats();
+}
+
+void HT_CryptoBench_Handshake(uint32_t handshake_ms)
+{
+    const mbedtls_l2c_stats *stats = mbedtls_l2c_get_stats();
+
+    HT_LOG(P_SIG, HT_CryptoBench_Handshake_1, "Handshake bench engine %u: %u ms, engine calls %u, sw blocks %u, hw digests %u, sw digests %u, busy %u",
+           mbedtls_l2c_get_hw(), handshake_ms, stats->aes_hw_calls, stats->aes_sw_blocks, stats->sha_hw, stats->sha_sw, stats->busy);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -2,11 +2,121 @@
 #include "HT_GPIO_Api.h"
 #include "bsp.h"  // For pad_config_t, gpio_pin_config_t, delay_us and GPIO_PinRead
 #include "task.h" // For vTaskSuspendAll/xTaskResumeAll
+#include "HT_GPIO_Fast.h" // For the register-level pin access and cycle counter used by the RAM loop
+
+// Iterations of the poll loop timed by the boot calibration.
+#define DHT22_CAL_ITERATIONS        2000
+// Fallback loop rate (Q8 iterations per us) when the calibration cannot run.
+// Deliberately high so timeouts err on the long side.
+#define DHT22_DEFAULT_LOOPS_Q8      (32 << 8)
+
+static uint32_t loopsPerUsQ8 = 0; // Poll loop iterations per microsecond (Q8), 0 until calibrated.
+
+/**
+ * @brief Counts poll iterations while the data line stays at a level.
+ *
+ * Runs from RAM so the iteration time does not depend on the flash cache.
+ *
+ * @param level Level to wait on.
+ * @param limit Maximum iterations.
+ * @return Iterations spent at the level; greater than limit on timeout.
+ */
+PLAT_CODE_IN_RAM __attribute__((noinline)) static uint32_t DHT22_PollWhile(uint32_t level, uint32_t limit)
+{
+    uint32_t count = 0;
+
+    while (HT_GPIO_FastRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN) == level)
+    {
+        if (++count > limit)
+            break;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Converts a timeout in microseconds to poll loop iterations.
+ */
+static uint32_t DHT22_UsToLoops(uint32_t us)
+{
+    return (uint32_t)(((uint64_t)us * loopsPerUsQ8 + 255) >> 8);
+}
+
+/**
+ * @brief Converts poll loop iterations to microseconds.
+ */
+static uint16_t DHT22_LoopsToUs(uint32_t loops)
+{
+    uint32_t us = (uint32_t)((((uint64_t)loops << 8) + loopsPerUsQ8 / 2) / loopsPerUsQ8);
+
+    return (us > UINT16_MAX) ? UINT16_MAX : (uint16_t)us;
+}
+
+/**
+ * @brief Captures the sensor response and the 80 data pulses after the start signal.
+ *
+ * Runs from RAM with the scheduler suspended. Pulse widths are stored as
+ * raw poll loop iterations.
+ *
+ * @param loops Output, low/high iteration counts for each of the 40 bits.
+ * @return DHT22_OK or a DHT22_ERROR_TIMEOUT_* code.
+ */
+PLAT_CODE_IN_RAM static int DHT22_Capture(uint32_t *loops)
+{
+    uint32_t limitStart = DHT22_UsToLoops(DHT22_TIMEOUT_RESPONSE_START);
+    uint32_t limitPulse = DHT22_UsToLoops(DHT22_TIMEOUT_RESPONSE_PULSE);
+    uint32_t limitData = DHT22_UsToLoops(DHT22_TIMEOUT_DATA_PULSE);
+
+    // === STEP 2: Wait for sensor response ===
+    // Line goes LOW (first part of the response), then HIGH, then LOW again (start of data).
+    if (DHT22_PollWhile(1, limitStart) > limitStart)
+        return DHT22_ERROR_TIMEOUT_START;
+    if (DHT22_PollWhile(0, limitPulse) > limitPulse)
+        return DHT22_ERROR_TIMEOUT_LOW;
+    if (DHT22_PollWhile(1, limitPulse) > limitPulse)
+        return DHT22_ERROR_TIMEOUT_HIGH;
+
+    // === STEP 3: Read all 40 bits (80 pulses) ===
+    for (int i = 0; i < 80; i++)
+    {
+        // Even entries: LOW pulse (~50us). Odd entries: HIGH pulse (26-28us for bit 0, 70us for bit 1).
+        loops[i] = DHT22_PollWhile(i & 1, limitData);
+        if (loops[i] > limitData)
+            return DHT22_ERROR_TIMEOUT_DATA;
+    }
+
+    return DHT22_OK;
+}
+
+void DHT22_Calibrate(void)
+{
+    uint32_t start, cycles, count;
+
+    loopsPerUsQ8 = DHT22_DEFAULT_LOOPS_Q8;
+
+    if (!HT_CycleCounter_Enable())
+        return;
+
+    // The line idles high (pull-up), so the poll loop runs to its limit exactly like a pulse does.
+    vTaskSuspendAll();
+    start = HT_CycleCounter_Read();
+    count = DHT22_PollWhile(1, DHT22_CAL_ITERATIONS);
+    cycles = HT_CycleCounter_Read() - start;
+    xTaskResumeAll();
+
+    if (count <= DHT22_CAL_ITERATIONS || cycles == 0)
+        return; // Line not idle, keep the fallback.
+
+    loopsPerUsQ8 = (uint32_t)(((uint64_t)count * HT_CycleCounter_Hz() * 256ULL) / ((uint64_t)cycles * 1000000ULL));
+    if (loopsPerUsQ8 == 0)
+        loopsPerUsQ8 = 1;
+}
+
+uint32_t DHT22_LoopsPerUsQ8(void)
+{
+    return loopsPerUsQ8;
+}
 
-// Timeout values in microseconds for the read loop
-#define DHT22_TIMEOUT_RESPONSE_START    80
-#define DHT22_TIMEOUT_RESPONSE_PULSE    100
-#define DHT22_TIMEOUT_DATA_PULSE        100
 
 /**
  * @brief Initializes the GPIO pin for the DHT22 sensor.
@@ -30,6 +140,10 @@ void DHT22_Init(void)
     GPIO_PinConfig(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN, &config);
     // NOTE: An external 4.7k pull-up resistor is MANDATORY for DHT22 operation.
     PAD_SetPinPullConfig(DHT22_PAD_ID, PAD_AutoPull);
+
+    // Time the poll loop once per boot; the clock setup does not change afterwards.
+    if (loopsPerUsQ8 == 0)
+        DHT22_Calibrate();
 }
 
 /**
@@ -41,98 +155,29 @@ void DHT22_Init(void)
 int DHT22_Read(float *temperature, float *humidity)
 {
     uint8_t data[5] = {0, 0, 0, 0, 0};
-    uint16_t cycles[80]; // Stores pulse durations (low and high for each bit)
+    uint32_t loops[80]; // Pulse widths in poll loop iterations (low and high for each bit)
     int ret = 0;
-    gpio_pin_config_t config;
+
+    if (loopsPerUsQ8 == 0)
+        DHT22_Calibrate();
 
     // --- Start of critical section ---
     // Disable task switching to ensure precise timing for sensor communication.
     vTaskSuspendAll();
 
     // === STEP 1: Send start signal ===
-    // Temporarily configure pin as output to pull it low.
-    config.pinDirection = GPIO_DirectionOutput;
-    GPIO_PinConfig(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN, &config);
-
-    // Pull line low for > 1ms to signal the sensor.
-    HT_GPIO_WritePin(DHT22_GPIO_PIN, DHT22_GPIO_INSTANCE, 0);
+    // Temporarily configure pin as output and pull the line low for > 1ms to signal the sensor.
+    HT_GPIO_FastSetOutput(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN);
+    HT_GPIO_FastWrite(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN, 0);
     delay_us(1100); // 1.1ms
 
     // Pull line high and switch back to input to prepare for sensor response.
-    HT_GPIO_WritePin(DHT22_GPIO_PIN, DHT22_GPIO_INSTANCE, 1);
+    HT_GPIO_FastWrite(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN, 1);
     delay_us(40);
+    HT_GPIO_FastSetInput(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN);
 
-    config.pinDirection = GPIO_DirectionInput;
-    GPIO_PinConfig(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN, &config);
-
-    delay_us(1); // Small delay for pin to settle.
-
-    // === STEP 2: Wait for sensor response ===
-    uint16_t timeout_counter = 0;
-    // Wait for pin to go LOW (first part of sensor's response).
-    while (GPIO_PinRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN))
-    {
-        if (++timeout_counter > DHT22_TIMEOUT_RESPONSE_START)
-        {
-            ret = DHT22_ERROR_TIMEOUT_START;
-            goto end_read;
-        }
-        delay_us(1);
-    }
-    // Wait for pin to go HIGH (second part of sensor's response).
-    timeout_counter = 0;
-    while (!GPIO_PinRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN))
-    {
-        if (++timeout_counter > DHT22_TIMEOUT_RESPONSE_PULSE)
-        {
-            ret = DHT22_ERROR_TIMEOUT_LOW;
-            goto end_read;
-        }
-        delay_us(1);
-    }
-    // Wait for pin to go LOW again (start of data transmission).
-    timeout_counter = 0;
-    while (GPIO_PinRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN))
-    {
-        if (++timeout_counter > DHT22_TIMEOUT_RESPONSE_PULSE)
-        {
-            ret = DHT22_ERROR_TIMEOUT_HIGH;
-            goto end_read;
-        }
-        delay_us(1);
-    }
-
-    // === STEP 3: Read all 40 bits (80 pulses) into the cycles array ===
-    for (int i = 0; i < 80; i += 2)
-    {
-        // Measure LOW pulse duration (~50us)
-        uint16_t low_duration = 0;
-        while (!GPIO_PinRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN))
-        {
-            if (++low_duration > DHT22_TIMEOUT_DATA_PULSE)
-            {
-                ret = DHT22_ERROR_TIMEOUT_DATA;
-                goto end_read;
-            }
-            delay_us(1);
-        }
-        cycles[i] = low_duration;
-
-        // Measure HIGH pulse duration (26-28us for bit 0, 70us for bit 1)
-        uint16_t high_duration = 0;
-        while (GPIO_PinRead(DHT22_GPIO_INSTANCE, DHT22_GPIO_PIN))
-        {
-            if (++high_duration > DHT22_TIMEOUT_DATA_PULSE)
-            {
-                ret = DHT22_ERROR_TIMEOUT_DATA;
-                goto end_read;
-            }
-            delay_us(1);
-        }
-        cycles[i + 1] = high_duration;
-    }
+    ret = DHT22_Capture(loops);
 
-end_read:
     // --- End of critical section ---
     xTaskResumeAll();
 
@@ -141,15 +186,15 @@ end_read:
         return ret; // Return error code on timeout.
     }
 
-    // === STEP 4: Decode pulses from the array into data bytes ===
+    // === STEP 4: Decode pulses into data bytes ===
     for (int i = 0; i < 40; ++i)
     {
-        uint16_t lowCycles = cycles[2 * i];
-        uint16_t highCycles = cycles[2 * i + 1];
+        uint16_t lowUs = DHT22_LoopsToUs(loops[2 * i]);
+        uint16_t highUs = DHT22_LoopsToUs(loops[2 * i + 1]);
 
         data[i / 8] <<= 1;
-        // A bit is '1' if the high pulse duration is longer than the low pulse duration.
-        if (highCycles > lowCycles)
+        // A bit is '1' if the high pulse (~70us) is longer than the preceding low pulse (~50us).
+        if (highUs > lowUs)
         {
             data[i / 8] |= 1;
         }
@@ -0,0 +1,76 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Diag.h"
+#include "HT_Retained.h"
+#include "HT_Sampler.h"
+#include "HT_Aggregate.h"
+#include "HT_Alarm.h"
+#include "HT_Console.h"
+#include "HT_Adc.h"
+#include "HT_Power.h"
+#include "HT_TlsSession.h"
+#include "HT_TimeSeries.h"
+#include "HT_Uplink.h"
+#include <stdio.h>
+
+typedef int (*HT_DiagFormatter)(char *buf, size_t len);
+
+/**
+ * @brief Contributors to the diagnostics record, in output order.
+ */
+static const HT_DiagFormatter diagFormatters[] = {
+    HT_Sampler_DiagFormat,
+    HT_Aggregate_DiagFormat,
+    HT_Alarm_DiagFormat,
+    HT_Console_DiagFormat,
+    HT_Adc_DiagFormat,
+    HT_Power_DiagFormat,
+    HT_TlsSession_DiagFormat,
+    HT_TimeSeries_DiagFormat,
+    HT_Uplink_DiagFormat,
+};
+
+int HT_Diag_Format(char *buf, size_t len)
+{
+    int written;
+
+    written = snprintf(buf, len, "{\"wake\":%lu", (unsigned long)HT_Retained_Get()->wakeCount);
+    if (written < 0 || (size_t)written >= len)
+        return 0;
+
+    for (size_t i = 0; i < sizeof(diagFormatters) / sizeof(diagFormatters[0]); i++)
+    {
+        int n;
+
+        if ((size_t)written + 2 >= len)
+            return 0;
+        buf[written++] = ',';
+
+        n = diagFormatters[i](buf + written, len - written);
+        if (n < 0 || (size_t)n >= len - written)
+            return 0;
+        written += n;
+    }
+
+    if ((size_t)written + 2 > len)
+        return 0;
+    buf[written++] = '}';
+    buf[written] = '\0';
+
+    return written;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
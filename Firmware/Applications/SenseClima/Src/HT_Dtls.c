@@ -0,0 +1,423 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Dtls.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"               // Required for xTaskGetTickCount
+#include "task.h"
+#include "slpman_qcx212.h"          // Required for slpManGetLastSlpState
+#include "mbedtls/platform.h"       // Required for mbedtls_calloc, mbedtls_free
+#include "mbedtls/platform_util.h"  // Required for mbedtls_platform_zeroize
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/timing.h"         // Required for mbedtls_timing_set_delay, mbedtls_timing_get_delay
+#if defined(MBEDTLS_AES_ALT) || defined(MBEDTLS_SHA256_ALT)
+#include "l2c_alt.h"                // Required for mbedtls_l2c_idle
+#endif
+#include "HT_MQTT_Tls.h"            // Required for HT_MQTT_TLSDrbg, HT_MQTT_TLSArenaOpen
+#include "HT_Psk.h"
+#include "HT_TlsSession.h"
+#include "HT_Log.h"
+
+#if !defined(MBEDTLS_SSL_DTLS_CONNECTION_ID) || !defined(MBEDTLS_SSL_CONTEXT_SERIALIZATION)
+#error "HT_DTLS needs CONFIG_MBEDTLS_DTLS_CID in the mbedtls configuration"
+#endif
+
+/**
+ * @brief Everything a connection holds, allocated from the mbedTLS arena.
+ */
+typedef struct {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_net_context net;
+    mbedtls_timing_delay_context timer;
+} HT_DtlsConnection;
+
+// Only AEAD suites can be serialized, and the L2C engine runs AES-128
+static const int HT_DtlsCiphersuites[] = {
+    MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+    0
+};
+
+static HT_DtlsConnection *dtls;
+static uint8_t *dtlsSlot;               // Retained slot of the peer, HT_TLS_SESSION_MAX bytes
+static uint8_t dtlsMode = HT_DTLS_ERROR;
+static uint8_t dtlsRestorePending;      // Restored, no reply seen yet
+static uint8_t dtlsKept;                // A connection was kept during this boot: the slot in RAM is its latest state
+
+static void HT_Dtls_Release(void)
+{
+    mbedtls_net_free(&dtls->net);
+    mbedtls_ssl_free(&dtls->ssl);
+    mbedtls_ssl_config_free(&dtls->conf);
+    mbedtls_free(dtls);
+    dtls = NULL;
+    dtlsMode = HT_DTLS_ERROR;
+    dtlsRestorePending = 0;
+    HT_MQTT_TLSArenaClose();
+#if defined(MBEDTLS_AES_ALT) || defined(MBEDTLS_SHA256_ALT)
+    mbedtls_l2c_idle();
+#endif
+}
+
+/**
+ * @brief Binds a freshly initialized context to the configuration and the socket.
+ */
+static int HT_Dtls_Setup(void)
+{
+    int ret;
+
+    ret = mbedtls_ssl_setup(&dtls->ssl, &dtls->conf);
+    if (ret != 0)
+        return ret;
+
+    mbedtls_ssl_set_bio(&dtls->ssl, &dtls->net, mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
+    mbedtls_ssl_set_timer_cb(&dtls->ssl, &dtls->timer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+
+    return 0;
+}
+
+/**
+ * @brief Tells whether the server gave the connection a CID.
+ */
+static uint8_t HT_Dtls_PeerCid(void)
+{
+    unsigned char cid[MBEDTLS_SSL_CID_OUT_LEN_MAX];
+    size_t cidLen = 0;
+    int enabled = MBEDTLS_SSL_CID_DISABLED;
+
+    if (mbedtls_ssl_get_peer_cid(&dtls->ssl, &enabled, cid, &cidLen) != 0)
+        return 0;
+
+    return enabled == MBEDTLS_SSL_CID_ENABLED;
+}
+
+/**
+ * @brief Tells whether a stored connection may be loaded and used.
+ *
+ * After a reset the SDK restores the retained area from the flash copy of
+ * the last sleep, which misses whatever the connection sent since: loading
+ * it would repeat record sequence numbers, hence CCM nonces.
+ */
+static uint8_t HT_Dtls_SlotCurrent(void)
+{
+    slpManSlpState_t last = slpManGetLastSlpState();
+
+    return dtlsKept || last == SLP_SLP2_STATE || last == SLP_HIB_STATE;
+}
+
+/**
+ * @brief Swaps the loaded connection for a resumption of its session.
+ *
+ * Nothing is sent under the old keys: the handshake that follows derives
+ * new ones from the master secret and fresh randoms.
+ *
+ * @return 1 if the session is set for the next handshake.
+ */
+static uint8_t HT_Dtls_OfferOwnSession(void)
+{
+    mbedtls_ssl_session session;
+    uint8_t offered = 0;
+
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&dtls->ssl, &session) == 0 &&
+        mbedtls_ssl_session_reset(&dtls->ssl) == 0 &&
+        mbedtls_ssl_set_session(&dtls->ssl, &session) == 0)
+        offered = 1;
+    mbedtls_ssl_session_free(&session);
+
+    return offered;
+}
+
+/**
+ * @brief Runs one handshake and keeps its session in the slot.
+ * @param offered 1 if a session is set for resumption.
+ * @return HT_DTLS_RESUMED, HT_DTLS_FULL or HT_DTLS_ERROR.
+ */
+static uint8_t HT_Dtls_Handshake(uint8_t offered)
+{
+    mbedtls_ssl_session session;
+    TickType_t start = xTaskGetTickCount();
+    uint8_t full = 0;
+    size_t len = 0;
+    uint32_t ms;
+    int ret = 0;
+
+    mbedtls_ssl_set_mtu(&dtls->ssl, HT_DTLS_MTU);
+    // Empty CID of our own: the socket is connected, the server's CID is the one that matters
+    ret = mbedtls_ssl_set_cid(&dtls->ssl, MBEDTLS_SSL_CID_ENABLED, NULL, 0);
+
+    // Stepwise: only a full handshake goes through ClientKeyExchange
+    while (ret == 0 && dtls->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+    {
+        if (dtls->ssl.state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE)
+            full = 1;
+
+        ret = mbedtls_ssl_handshake_step(&dtls->ssl);
+        if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+            break;
+        ret = 0;
+    }
+    ms = (uint32_t)(xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+
+    if (ret != 0)
+    {
+        HT_LOG(P_ERROR, HT_Dtls_Handshake_1, "DTLS handshake failed: -0x%04X (session offered: %u).", -ret, offered);
+        if (offered)
+            HT_TlsSession_Record(HT_TLS_HANDSHAKE_FAILED, 0, 0, 0);
+        return HT_DTLS_ERROR;
+    }
+
+    // Kept until the close replaces it with the whole connection: a reset in between still resumes
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&dtls->ssl, &session) != 0 ||
+        mbedtls_ssl_session_save(&session, dtlsSlot, HT_TLS_SESSION_MAX, &len) != 0)
+        len = 0;
+    mbedtls_ssl_session_free(&session);
+
+    HT_TlsSession_Record(!full ? HT_TLS_HANDSHAKE_RESUMED : offered ? HT_TLS_HANDSHAKE_REJECTED : HT_TLS_HANDSHAKE_FULL,
+                         ms, len, 0);
+    HT_LOG(P_INFO, HT_Dtls_Handshake_2, "DTLS handshake done in %u ms (resumed: %u, connection ID: %u).", ms, !full,
+           HT_Dtls_PeerCid());
+
+    return full ? HT_DTLS_FULL : HT_DTLS_RESUMED;
+}
+
+/**
+ * @brief Handshakes, retrying once without the session if the offer failed.
+ */
+static uint8_t HT_Dtls_Connect(uint8_t offered)
+{
+    uint8_t mode = HT_Dtls_Handshake(offered);
+
+    // The server may choke on a stale session rather than ignore it
+    if (mode == HT_DTLS_ERROR && offered && mbedtls_ssl_session_reset(&dtls->ssl) == 0)
+        mode = HT_Dtls_Handshake(0);
+
+    return mode;
+}
+
+uint8_t HT_Dtls_Open(const char *host, uint16_t port)
+{
+    mbedtls_ctr_drbg_context *drbg;
+    mbedtls_ssl_session session;
+    HT_Psk psk;
+    char portStr[6];
+    uint32_t seed_ms;
+    size_t len;
+    uint8_t kind;
+    uint8_t offered = 0;
+    int ret;
+
+    // A connection left open still holds its context, and was not kept
+    if (dtls != NULL)
+        HT_Dtls_Release();
+
+    if (HT_Psk_Load(&psk) > HT_PSK_DEV)
+    {
+        HT_LOG(P_ERROR, HT_Dtls_Open_1, "DTLS needs a pre-shared key, none provisioned.");
+        return HT_DTLS_ERROR;
+    }
+
+    ret = HT_MQTT_TLSDrbg(&drbg, &seed_ms);
+    if (ret < 0)
+    {
+        HT_Psk_Clear(&psk);
+        return HT_DTLS_ERROR;
+    }
+    if (ret == 1)
+        HT_LOG(P_INFO, HT_Dtls_Open_2, "TLS DRBG seeded from the TRNG in %u ms.", seed_ms);
+
+    HT_MQTT_TLSArenaOpen();
+    dtls = mbedtls_calloc(1, sizeof(HT_DtlsConnection));
+    if (dtls == NULL)
+    {
+        HT_Psk_Clear(&psk);
+        HT_MQTT_TLSArenaClose();
+        return HT_DTLS_ERROR;
+    }
+
+    mbedtls_net_init(&dtls->net);
+    mbedtls_ssl_init(&dtls->ssl);
+    mbedtls_ssl_config_init(&dtls->conf);
+
+    ret = mbedtls_ssl_config_defaults(&dtls->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_DATAGRAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret == 0)
+        ret = mbedtls_ssl_conf_psk(&dtls->conf, psk.key, psk.keyLen, psk.identity, psk.identityLen);
+    if (ret == 0)
+        ret = mbedtls_ssl_conf_cid(&dtls->conf, 0, MBEDTLS_SSL_UNEXPECTED_CID_IGNORE);
+    HT_Psk_Clear(&psk);     // The configuration holds its own copy
+    if (ret == 0)
+    {
+        mbedtls_ssl_conf_rng(&dtls->conf, mbedtls_ctr_drbg_random, drbg);
+        mbedtls_ssl_conf_ciphersuites(&dtls->conf, HT_DtlsCiphersuites);
+        mbedtls_ssl_conf_handshake_timeout(&dtls->conf, HT_DTLS_HANDSHAKE_MIN_MS, HT_DTLS_HANDSHAKE_MAX_MS);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        // Resumption by session ID: with a ticket the connection would not fit the slot
+        mbedtls_ssl_conf_session_tickets(&dtls->conf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+#endif
+        ret = HT_Dtls_Setup();
+    }
+    if (ret == 0)
+    {
+        snprintf(portStr, sizeof(portStr), "%u", port);
+        ret = mbedtls_net_connect(&dtls->net, host, portStr, MBEDTLS_NET_PROTO_UDP);
+    }
+    if (ret != 0)
+    {
+        HT_LOG(P_ERROR, HT_Dtls_Open_3, "DTLS setup failed: -0x%04X.", -ret);
+        HT_Dtls_Release();
+        return HT_DTLS_ERROR;
+    }
+
+    dtlsSlot = HT_TlsSession_Take(host, port, &len, &kind);
+    if (len != 0 && kind == HT_TLS_SLOT_CONNECTION)
+    {
+        ret = mbedtls_ssl_context_load(&dtls->ssl, dtlsSlot, len);
+        mbedtls_platform_zeroize(dtlsSlot, len);
+        if (ret != 0)
+        {
+            // The load freed the context
+            HT_LOG(P_WARNING, HT_Dtls_Open_4, "DTLS connection not restored: -0x%04X.", -ret);
+            mbedtls_ssl_init(&dtls->ssl);
+            if (HT_Dtls_Setup() != 0)
+            {
+                HT_Dtls_Release();
+                return HT_DTLS_ERROR;
+            }
+        }
+        else if (HT_Dtls_SlotCurrent())
+        {
+            // load restored the MTU of the saved connection
+            mbedtls_ssl_set_mtu(&dtls->ssl, HT_DTLS_MTU);
+            dtlsMode = HT_DTLS_RESTORED;
+            dtlsRestorePending = 1;
+            HT_LOG(P_INFO, HT_Dtls_Open_5, "DTLS connection restored, no handshake.");
+            return dtlsMode;
+        }
+        else
+        {
+            HT_LOG(P_WARNING, HT_Dtls_Open_6, "DTLS connection older than this boot, resuming its session instead.");
+            offered = HT_Dtls_OfferOwnSession();
+        }
+    }
+    else if (len != 0)
+    {
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_session_load(&session, dtlsSlot, len) == 0 &&
+            mbedtls_ssl_set_session(&dtls->ssl, &session) == 0)
+            offered = 1;
+        mbedtls_ssl_session_free(&session);
+    }
+
+    dtlsMode = HT_Dtls_Connect(offered);
+    if (dtlsMode == HT_DTLS_ERROR)
+        HT_Dtls_Release();
+
+    return dtlsMode;
+}
+
+/**
+ * @brief Sends the request and reads one reply.
+ * @return Bytes of reply, 0 on timeout, negative on error.
+ */
+static int HT_Dtls_RoundTrip(const uint8_t *req, size_t reqLen, uint8_t *resp, size_t respSize, uint32_t timeout_ms)
+{
+    int ret;
+
+    do {
+        ret = mbedtls_ssl_write(&dtls->ssl, req, reqLen);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    if (ret < 0)
+        return ret;
+
+    mbedtls_ssl_conf_read_timeout(&dtls->conf, timeout_ms);
+    do {
+        ret = mbedtls_ssl_read(&dtls->ssl, resp, respSize);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ);
+
+    return ret == MBEDTLS_ERR_SSL_TIMEOUT ? 0 : ret;
+}
+
+int HT_Dtls_Exchange(const uint8_t *req, size_t reqLen, uint8_t *resp, size_t respSize, uint32_t timeout_ms)
+{
+    int ret;
+
+    if (dtls == NULL)
+        return -1;
+
+    ret = HT_Dtls_RoundTrip(req, reqLen, resp, respSize, timeout_ms);
+    if (!dtlsRestorePending)
+        return ret;
+
+    dtlsRestorePending = 0;
+    HT_TlsSession_Restored(ret <= 0);
+    if (ret > 0)
+        return ret;
+
+    // Silence on a restored connection: the server forgot it, or never saw the request
+    HT_LOG(P_WARNING, HT_Dtls_Exchange_1, "DTLS server did not answer the restored connection (%d), resuming its session.", ret);
+    dtlsMode = HT_Dtls_Connect(HT_Dtls_OfferOwnSession());
+    if (dtlsMode == HT_DTLS_ERROR)
+    {
+        HT_Dtls_Release();
+        return -1;
+    }
+
+    return HT_Dtls_RoundTrip(req, reqLen, resp, respSize, timeout_ms);
+}
+
+uint8_t HT_Dtls_Mode(void)
+{
+    return dtlsMode;
+}
+
+void HT_Dtls_Close(uint8_t keep)
+{
+    size_t len = 0;
+    int ret;
+
+    if (dtls == NULL)
+        return;
+
+    if (dtlsRestorePending)
+        HT_TlsSession_Restored(0);
+
+    if (keep && HT_Dtls_PeerCid())
+    {
+        // Resets the context: the slot is the only copy left
+        ret = mbedtls_ssl_context_save(&dtls->ssl, dtlsSlot, HT_TLS_SESSION_MAX, &len);
+        if (ret != 0)
+        {
+            HT_LOG(P_WARNING, HT_Dtls_Close_1, "DTLS connection does not fit the slot: -0x%04X, %u bytes.", -ret, (unsigned)len);
+            len = 0;
+        }
+        HT_TlsSession_KeepConnection(len);
+        dtlsKept |= len != 0;
+    }
+    else if (!keep)
+    {
+        do {
+            ret = mbedtls_ssl_close_notify(&dtls->ssl);
+        } while (ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+    }
+    // Kept without a CID, the session stored by the handshake stays: the next wake resumes it
+
+    HT_Dtls_Release();
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,151 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_FixedPoint.h"
+
+#define HT_SVP_MIN_C    (-40)
+#define HT_SVP_MAX_C    80
+
+/**
+ * @brief Saturation vapour pressure over water in 0.1 Pa, 1 C steps from -40 C to 80 C.
+ *
+ * Magnus form e = 610.94 * exp(17.625 T / (T + 243.04)) Pa (Alduchov & Eskridge).
+ */
+static const uint32_t svpTable[HT_SVP_MAX_C - HT_SVP_MIN_C + 1] = {
+    190, 210, 233, 258, 285, 315, 348, 383,
+    422, 464, 511, 561, 616, 675, 740, 810,
+    886, 968, 1057, 1154, 1258, 1370, 1492, 1623,
+    1764, 1916, 2080, 2256, 2446, 2649, 2868, 3102,
+    3353, 3622, 3911, 4219, 4549, 4902, 5278, 5680,
+    6109, 6567, 7055, 7574, 8127, 8716, 9341, 10007,
+    10713, 11464, 12260, 13105, 14001, 14950, 15955, 17020,
+    18146, 19338, 20597, 21928, 23334, 24819, 26386, 28038,
+    29781, 31617, 33552, 35590, 37735, 39992, 42367, 44863,
+    47486, 50242, 53137, 56176, 59364, 62710, 66217, 69894,
+    73747, 77783, 82009, 86433, 91062, 95904, 100968, 106261,
+    111793, 117571, 123606, 129906, 136481, 143341, 150497, 157958,
+    165735, 173839, 182282, 191075, 200230, 209759, 219674, 229989,
+    240716, 251869, 263461, 275507, 288020, 301017, 314511, 328518,
+    343054, 358135, 373778, 389999, 406816, 424246, 442307, 461018,
+    480397,
+};
+
+#define HT_SVP_LAST     (sizeof(svpTable) / sizeof(svpTable[0]) - 1)
+
+uint32_t HT_Isqrt32(uint32_t v)
+{
+    uint32_t res = 0, bit = 1UL << 30;
+
+    while (bit > v)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return res;
+}
+
+uint32_t HT_Isqrt64(uint64_t v)
+{
+    uint64_t res = 0, bit = 1ULL << 62;
+
+    while (bit > v)
+        bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (v >= res + bit)
+        {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)res;
+}
+
+uint32_t HT_SatVapourPressure(int16_t temp_x10)
+{
+    int32_t t = temp_x10 - HT_SVP_MIN_C * 10;
+    uint32_t idx, frac;
+
+    if (t <= 0)
+        return svpTable[0];
+    if (t >= (int32_t)HT_SVP_LAST * 10)
+        return svpTable[HT_SVP_LAST];
+
+    idx = (uint32_t)t / 10;
+    frac = (uint32_t)t % 10;
+
+    return svpTable[idx] + ((svpTable[idx + 1] - svpTable[idx]) * frac + 5) / 10;
+}
+
+int16_t HT_DewPoint(int16_t temp_x10, uint16_t humi_x10)
+{
+    uint32_t e, lo = 0, hi = HT_SVP_LAST;
+
+    if (humi_x10 > 1000)
+        humi_x10 = 1000;
+    if (humi_x10 == 0)
+        return HT_SVP_MIN_C * 10;
+
+    // Actual vapour pressure, then invert the table for the temperature where it saturates.
+    e = (uint32_t)(((uint64_t)HT_SatVapourPressure(temp_x10) * humi_x10 + 500) / 1000);
+
+    if (e <= svpTable[0])
+        return HT_SVP_MIN_C * 10;
+    if (e >= svpTable[HT_SVP_LAST])
+        return HT_SVP_MAX_C * 10;
+
+    while (hi - lo > 1)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (svpTable[mid] <= e)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return (int16_t)((int32_t)(lo + HT_SVP_MIN_C) * 10 +
+                     (int32_t)(((e - svpTable[lo]) * 10 + (svpTable[hi] - svpTable[lo]) / 2) / (svpTable[hi] - svpTable[lo])));
+}
+
+uint16_t HT_AbsHumidity(int16_t temp_x10, uint16_t humi_x10)
+{
+    // rho = e * Mw / (R * T) = e[Pa] * 2.1668 / T[K] g/m3.
+    uint64_t e_dPa = ((uint64_t)HT_SatVapourPressure(temp_x10) * humi_x10 + 500) / 1000;
+    uint32_t t_dK = (uint32_t)(temp_x10 + 2732);
+
+    return (uint16_t)((e_dPa * 21668ULL + (t_dK * 100ULL) / 2) / (t_dK * 100ULL));
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
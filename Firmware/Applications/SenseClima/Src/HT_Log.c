@@ -0,0 +1,144 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Log.h"
+#include "HT_LogStore.h"
+#include "cmsis_os2.h"
+#include <stdarg.h>
+#include <string.h>
+
+static uint8_t logLevel = HT_LOG_LEVEL_DEBUG;
+
+void HT_Log_SetLevel(uint8_t level)
+{
+    logLevel = level;
+}
+
+size_t HT_Log_FrameLength(const uint8_t *buf, size_t len)
+{
+    size_t flen;
+    uint8_t argc, sum = 0;
+
+    if (len < 9 || buf[0] != HT_LOG_SYNC)
+        return 0;
+
+    argc = buf[3] & ~HT_LOG_STRING_FLAG;
+    if (argc > HT_LOG_MAX_ARGS)
+        return 0;
+
+    flen = 8 + 4 * (size_t)argc;
+    if (buf[3] & HT_LOG_STRING_FLAG)
+    {
+        if (flen >= len || buf[flen] > HT_LOG_STRING_MAX)
+            return 0;
+        flen += 1 + buf[flen];
+    }
+
+    if (flen >= len)
+        return 0;
+
+    for (size_t i = 1; i < flen; i++)
+        sum += buf[i];
+
+    return sum == buf[flen] ? flen + 1 : 0;
+}
+
+#if HT_LOG_TOKENIZED
+
+static uint8_t *HT_Log_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+
+    return p + 4;
+}
+
+/**
+ * @brief Sends a complete frame in one write, so frames from different
+ *        threads never interleave within the stdio lock, and keeps it in
+ *        the flash ring.
+ */
+static void HT_Log_Sink(uint8_t level, const uint8_t *frame, size_t len)
+{
+#if HT_LOG_UART
+    fwrite(frame, 1, len, stdout);
+    fflush(stdout);
+#endif
+    HT_LogStore_Append(frame, len, level >= HT_LOGSTORE_FLUSH_LEVEL);
+}
+
+void HT_Log_Write(uint8_t level, uint16_t id, const char *str, size_t strLen, uint8_t argc, ...)
+{
+    uint8_t frame[HT_LOG_FRAME_MAX];
+    uint8_t *p = frame;
+    uint8_t sum = 0;
+    va_list ap;
+
+    if (level < logLevel && id != HT_LOG_ID_VERSION)
+        return;
+
+    if (argc > HT_LOG_MAX_ARGS)
+        argc = HT_LOG_MAX_ARGS;
+
+    if (str != NULL)
+    {
+        if (strLen == HT_LOG_STRLEN_AUTO)
+            strLen = strnlen(str, HT_LOG_STRING_MAX);
+        else if (strLen > HT_LOG_STRING_MAX)
+            strLen = HT_LOG_STRING_MAX;
+    }
+
+    *p++ = HT_LOG_SYNC;
+    *p++ = (uint8_t)id;
+    *p++ = (uint8_t)(id >> 8);
+    *p++ = argc | (str != NULL ? HT_LOG_STRING_FLAG : 0);
+    p = HT_Log_Put32(p, osKernelGetTickCount());
+
+    va_start(ap, argc);
+    for (uint8_t i = 0; i < argc; i++)
+        p = HT_Log_Put32(p, va_arg(ap, uint32_t));
+    va_end(ap);
+
+    if (str != NULL)
+    {
+        *p++ = (uint8_t)strLen;
+        memcpy(p, str, strLen);
+        p += strLen;
+    }
+
+    for (const uint8_t *q = frame + 1; q < p; q++)
+        sum += *q;
+    *p++ = sum;
+
+    HT_Log_Sink(level, frame, (size_t)(p - frame));
+}
+
+void HT_Log_Init(void)
+{
+    HT_LogStore_Init();
+    HT_Log_Write(HT_LOG_LEVEL_SIG, HT_LOG_ID_VERSION, NULL, 0, 1, (uint32_t)HT_LOG_DB_VERSION);
+}
+
+#else
+
+void HT_Log_Init(void)
+{
+}
+
+#endif
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,239 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_LogStore.h"
+#include <string.h>
+#include "cmsis_os2.h"          // Required for osMutex*
+#include "flash_qcx212_rt.h"    // Required for BSP_QSPI_*_Safe
+
+typedef struct {
+    uint32_t magic;     // HT_LOGSTORE_MAGIC once the sector is erased and claimed
+    uint32_t seq;       // Increments on every rotation, the highest one is written
+} HT_LogStoreHeader;
+
+static uint8_t storeStage[HT_LOGSTORE_STAGE_SIZE];
+static uint32_t storeStageLen;
+static uint32_t storeSector;
+static uint8_t storeReady;
+static osMutexId_t storeLock;
+static HT_LogStoreStats storeStats;
+
+static uint32_t HT_LogStore_Addr(uint32_t sector)
+{
+    return HT_LOGSTORE_FLASH_BASE + sector * HT_LOGSTORE_SECTOR_SIZE;
+}
+
+static uint8_t HT_LogStore_ReadHeader(uint32_t sector, HT_LogStoreHeader *header)
+{
+    if (BSP_QSPI_Read_Safe((uint8_t *)header, HT_LogStore_Addr(sector), sizeof(*header)) != QSPI_OK)
+    {
+        storeStats.errors++;
+        return 0;
+    }
+
+    return header->magic == HT_LOGSTORE_MAGIC;
+}
+
+/**
+ * @brief Reads the frame at offset into frame.
+ * @return Its length, 0 at the end of the sector's frames.
+ */
+static size_t HT_LogStore_ReadFrame(uint32_t sector, uint32_t offset, uint8_t *frame)
+{
+    size_t len = HT_LOGSTORE_SECTOR_SIZE - offset;
+
+    if (len > HT_LOG_FRAME_MAX)
+        len = HT_LOG_FRAME_MAX;
+
+    if (BSP_QSPI_Read_Safe(frame, HT_LogStore_Addr(sector) + offset, len) != QSPI_OK)
+    {
+        storeStats.errors++;
+        frame[0] = 0xFF;
+        return 0;
+    }
+
+    // Erased flash or a frame torn by a reset both end the sector
+    return HT_Log_FrameLength(frame, len);
+}
+
+/**
+ * @brief Erases the sector and claims it with the next sequence number.
+ */
+static void HT_LogStore_Claim(uint32_t sector, uint32_t seq)
+{
+    HT_LogStoreHeader header = { HT_LOGSTORE_MAGIC, seq };
+
+    storeSector = sector;
+    storeStats.seq = seq;
+    storeStats.offset = sizeof(header);
+
+    storeStats.erases++;
+    if (BSP_QSPI_Erase_Safe(HT_LogStore_Addr(sector), HT_LOGSTORE_SECTOR_SIZE) != QSPI_OK ||
+        BSP_QSPI_Write_Safe((uint8_t *)&header, HT_LogStore_Addr(sector), sizeof(header)) != QSPI_OK)
+        storeStats.errors++;
+}
+
+static void HT_LogStore_Program(void)
+{
+    if (storeStageLen == 0)
+        return;
+
+    storeStats.programs++;
+    if (BSP_QSPI_Write_Safe(storeStage, HT_LogStore_Addr(storeSector) + storeStats.offset, storeStageLen) != QSPI_OK)
+        storeStats.errors++;
+
+    storeStats.offset += storeStageLen;
+    storeStageLen = 0;
+}
+
+/**
+ * @brief Walks the stored frames from the oldest sector to the newest one.
+ * @param out Receives the frames from the point where at most len bytes
+ *            remain, NULL to only count them.
+ * @param total Bytes of all stored frames, from a counting pass.
+ * @return Bytes of the frames walked (out == NULL) or copied.
+ */
+static size_t HT_LogStore_Walk(uint8_t *out, size_t len, size_t total)
+{
+    uint8_t frame[HT_LOG_FRAME_MAX];
+    HT_LogStoreHeader header;
+    uint32_t sector, offset;
+    size_t seen = 0, copied = 0, flen;
+
+    for (uint32_t i = 1; i <= HT_LOGSTORE_SECTORS; i++)
+    {
+        sector = (storeSector + i) % HT_LOGSTORE_SECTORS;
+
+        // Skip sectors never claimed or left from a ring older than the current one
+        if (!HT_LogStore_ReadHeader(sector, &header) || storeStats.seq - header.seq >= HT_LOGSTORE_SECTORS)
+            continue;
+
+        offset = sizeof(header);
+        while ((flen = HT_LogStore_ReadFrame(sector, offset, frame)) > 0)
+        {
+            if (out != NULL && total - seen <= len)
+            {
+                memcpy(out + copied, frame, flen);
+                copied += flen;
+            }
+            seen += flen;
+            offset += flen;
+        }
+    }
+
+    return out != NULL ? copied : seen;
+}
+
+void HT_LogStore_Init(void)
+{
+    uint8_t frame[HT_LOG_FRAME_MAX];
+    HT_LogStoreHeader header;
+    uint8_t found = 0;
+    size_t flen;
+
+    if (storeReady)
+        return;
+
+    storeLock = osMutexNew(NULL);
+
+    for (uint32_t sector = 0; sector < HT_LOGSTORE_SECTORS; sector++)
+    {
+        if (!HT_LogStore_ReadHeader(sector, &header))
+            continue;
+
+        if (!found || (int32_t)(header.seq - storeStats.seq) > 0)
+        {
+            storeSector = sector;
+            storeStats.seq = header.seq;
+            found = 1;
+        }
+    }
+
+    if (!found)
+    {
+        HT_LogStore_Claim(0, 1);
+    }
+    else
+    {
+        storeStats.offset = sizeof(header);
+        while ((flen = HT_LogStore_ReadFrame(storeSector, storeStats.offset, frame)) > 0)
+            storeStats.offset += flen;
+
+        // Bytes after a torn frame are not erased: start over in the next sector
+        if (storeStats.offset < HT_LOGSTORE_SECTOR_SIZE && frame[0] != 0xFF)
+            HT_LogStore_Claim((storeSector + 1) % HT_LOGSTORE_SECTORS, storeStats.seq + 1);
+    }
+
+    storeReady = 1;
+}
+
+void HT_LogStore_Append(const uint8_t *frame, size_t len, uint8_t urgent)
+{
+    if (!storeReady || len > HT_LOG_FRAME_MAX)
+        return;
+
+    osMutexAcquire(storeLock, osWaitForever);
+
+    if (storeStats.offset + storeStageLen + len > HT_LOGSTORE_SECTOR_SIZE)
+    {
+        HT_LogStore_Program();
+        HT_LogStore_Claim((storeSector + 1) % HT_LOGSTORE_SECTORS, storeStats.seq + 1);
+    }
+    else if (storeStageLen + len > HT_LOGSTORE_STAGE_SIZE)
+    {
+        HT_LogStore_Program();
+    }
+
+    memcpy(storeStage + storeStageLen, frame, len);
+    storeStageLen += len;
+
+    if (urgent)
+        HT_LogStore_Program();
+
+    osMutexRelease(storeLock);
+}
+
+void HT_LogStore_Flush(void)
+{
+    if (!storeReady)
+        return;
+
+    osMutexAcquire(storeLock, osWaitForever);
+    HT_LogStore_Program();
+    osMutexRelease(storeLock);
+}
+
+size_t HT_LogStore_Read(uint8_t *buf, size_t len)
+{
+    size_t total;
+
+    if (!storeReady)
+        return 0;
+
+    osMutexAcquire(storeLock, osWaitForever);
+    HT_LogStore_Program();
+    total = HT_LogStore_Walk(NULL, 0, 0);
+    len = HT_LogStore_Walk(buf, len, total);
+    osMutexRelease(storeLock);
+
+    return len;
+}
+
+const HT_LogStoreStats *HT_LogStore_Stats(void)
+{
+    return &storeStats;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -16,6 +16,14 @@
 #include "HT_MQTT_Api.h"
 #include "HT_SenseClima.h"
 #include "HT_MQTT_Tls.h"
+#include "HT_Log.h"
+#include "HT_TlsSession.h"
+#ifdef HT_TLS_PSK
+#include "HT_Psk.h"
+#endif
+#ifdef HT_CRYPTO_BENCH
+#include "HT_CryptoBench.h"
+#endif
 
 extern volatile uint8_t subscribe_callback;
 
@@ -29,8 +37,13 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
                         char *username, char *password, uint8_t mqtt_version, uint32_t keep_alive_interval, uint8_t *sendbuf,
                         uint32_t sendbuf_size, uint8_t *readbuf, uint32_t readbuf_size)
 {
-
 #if MQTT_TLS_ENABLE == 1
+    int32_t tlsStatus;
+    MqttTlsArenaStats arena;
+#ifdef HT_TLS_PSK
+    HT_Psk psk;
+#endif
+
     mqtt_client_ctx.caCertLen = 0;
     mqtt_client_ctx.port = port;
     mqtt_client_ctx.host = addr;
@@ -50,14 +63,66 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
 
 #if MQTT_TLS_ENABLE == 1
 
-    printf("Starting TLS handshake...\n");
+    HT_LOG(P_INFO, HT_MQTT_Connect_1, "Starting TLS handshake...");
+#ifdef HT_CRYPTO_BENCH
+    HT_CryptoBench_SelectEngine();
+#endif
+
+    mqtt_client_ctx.session = HT_TlsSession_Slot(addr, (uint16_t)port, &mqtt_client_ctx.sessionLen);
+    mqtt_client_ctx.sessionSize = HT_TLS_SESSION_MAX;
+
+    mqtt_client_ctx.psk = NULL;
+    mqtt_client_ctx.pskLen = 0;
+#ifdef HT_TLS_PSK
+    // PSK mode whenever credentials are provisioned, certificates otherwise
+    if (HT_Psk_Load(&psk) <= HT_PSK_DEV)
+    {
+        mqtt_client_ctx.psk = psk.key;
+        mqtt_client_ctx.pskLen = psk.keyLen;
+        mqtt_client_ctx.pskIdentity = psk.identity;
+        mqtt_client_ctx.pskIdentityLen = psk.identityLen;
+    }
+#endif
+
+    tlsStatus = HT_MQTT_TLSConnect(&mqtt_client_ctx, mqtt_network);
+    if (tlsStatus != 0 && mqtt_client_ctx.sessionOffered)
+    {
+        // The broker may choke on a stale session rather than ignore it: retry once without
+        HT_LOG(P_WARNING, HT_MQTT_Connect_4, "TLS resumption failed, retrying with a full handshake.");
+        HT_TlsSession_Record(HT_TLS_HANDSHAKE_FAILED, 0, 0, 0);
+        mqtt_client_ctx.sessionLen = 0;
+        tlsStatus = HT_MQTT_TLSConnect(&mqtt_client_ctx, mqtt_network);
+    }
 
-    if (HT_MQTT_TLSConnect(&mqtt_client_ctx, mqtt_network) != 0)
+#ifdef HT_TLS_PSK
+    HT_Psk_Clear(&psk);
+    mqtt_client_ctx.psk = NULL;
+#endif
+
+    if (tlsStatus != 0)
     {
-        printf("TLS Connection Error!\n");
+        HT_LOG(P_ERROR, HT_MQTT_Connect_2, "TLS Connection Error!");
         return 1;
     }
 
+    HT_TlsSession_Record(mqtt_client_ctx.sessionResumed ? HT_TLS_HANDSHAKE_RESUMED :
+                         mqtt_client_ctx.sessionOffered ? HT_TLS_HANDSHAKE_REJECTED : HT_TLS_HANDSHAKE_FULL,
+                         mqtt_client_ctx.handshake_ms, mqtt_client_ctx.sessionLen, mqtt_client_ctx.sessionLifetime_s);
+    HT_LOG(P_INFO, HT_MQTT_Connect_3, "TLS handshake done in %u ms (resumed: %u, psk: %u).", mqtt_client_ctx.handshake_ms,
+           mqtt_client_ctx.sessionResumed, mqtt_client_ctx.pskLen != 0);
+    HT_MQTT_TLSArenaGetStats(&arena);
+    if (arena.size != 0)
+        HT_LOG(P_INFO, HT_MQTT_Connect_5, "TLS arena %u bytes: handshake peak %u, in use %u, largest free %u of %u.",
+               arena.size, arena.handshakePeak, arena.used, arena.largestFree, arena.freeBytes);
+    HT_LOG(P_INFO, HT_MQTT_Connect_6, "TLS record buffers: in %u, out %u bytes (fragment length acknowledged: %u).",
+           mqtt_client_ctx.recordInLen, mqtt_client_ctx.recordOutLen, mqtt_client_ctx.mflAccepted);
+    if (mqtt_client_ctx.rngSeeded)
+        HT_LOG(P_INFO, HT_MQTT_Connect_7, "TLS DRBG seeded from the TRNG in %u ms.", mqtt_client_ctx.rng_ms);
+#ifdef HT_CRYPTO_BENCH
+    if (!mqtt_client_ctx.sessionResumed)
+        HT_CryptoBench_Handshake(mqtt_client_ctx.handshake_ms);
+#endif
+
     MQTTClientInit(mqtt_client, mqtt_network, MQTT_GENERAL_TIMEOUT, (unsigned char *)sendbuf, sendbuf_size, (unsigned char *)readbuf, readbuf_size);
 
     if ((MQTTConnect(mqtt_client, &connectData)) != 0)
@@ -134,7 +199,8 @@ int HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint
 
 void HT_MQTT_SubscribeCallback(MessageData *msg)
 {
-    printf("Subscribe received: %s from topic:[%s]\n", msg->message->payload, msg->topicName->lenstring.data);
+    HT_LOG_BUFFER(P_INFO, HT_MQTT_SubscribeCallback_1, "Subscribe received on [%.*s] (%u bytes)",
+                  msg->topicName->lenstring.data, msg->topicName->lenstring.len, (unsigned)msg->message->payloadlen);
 
     // subscribe_callback = 1;
     // HT_FSM_SetSubscribeBuff((uint8_t *)msg->message->payload, (uint8_t)msg->message->payloadlen);
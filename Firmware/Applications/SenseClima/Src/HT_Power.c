@@ -0,0 +1,245 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Power.h"
+#include "HT_Retained.h"
+#include "HT_Log.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SECONDS_PER_DAY     86400L
+
+/**
+ * @brief Resting voltage (mV) and charge (%) of a single Li-ion cell,
+ *        from empty to full.
+ */
+static const uint16_t liIonCurve[][2] = {
+    { 3300, 0 },  { 3400, 2 },  { 3500, 5 },  { 3600, 12 }, { 3650, 20 }, { 3700, 30 },
+    { 3750, 42 }, { 3800, 52 }, { 3900, 67 }, { 4000, 80 }, { 4100, 90 }, { 4200, 100 },
+};
+
+#define LI_ION_POINTS (sizeof(liIonCurve) / sizeof(liIonCurve[0]))
+
+uint8_t HT_Power_ChargePct(uint32_t mv)
+{
+    uint32_t i;
+
+    if (mv <= liIonCurve[0][0])
+        return 0;
+
+    for (i = 1; i < LI_ION_POINTS; i++)
+    {
+        if (mv < liIonCurve[i][0])
+            return (uint8_t)(liIonCurve[i - 1][1] + (mv - liIonCurve[i - 1][0]) *
+                   (liIonCurve[i][1] - liIonCurve[i - 1][1]) / (liIonCurve[i][0] - liIonCurve[i - 1][0]));
+    }
+
+    return 100;
+}
+
+/**
+ * @brief Tier for a state of charge, with the thresholds raised by margin.
+ */
+static uint8_t HT_Power_TierFor(const HT_ConfigData *cfg, uint8_t soc, uint8_t margin)
+{
+    if (soc < cfg->critical_pct + margin)
+        return HT_POWER_TIER_CRITICAL;
+    if (soc < cfg->low_pct + margin)
+        return HT_POWER_TIER_LOW;
+    if (soc < cfg->saver_pct + margin)
+        return HT_POWER_TIER_SAVER;
+
+    return HT_POWER_TIER_NORMAL;
+}
+
+/**
+ * @brief Settings of the tier; critical runs with those of the low tier.
+ */
+static const HT_ConfigTier *HT_Power_Settings(void)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    uint8_t tier = r->power.tier;
+
+    return &r->config.tier[tier < HT_CONFIG_TIERS ? tier : HT_CONFIG_TIERS - 1];
+}
+
+/**
+ * @brief Updates the smoothed voltage and, once the span is long enough, the slope.
+ */
+static void HT_Power_Track(HT_PowerState *st, uint16_t vbat_mv, uint32_t now)
+{
+    uint32_t span = now - st->trendAt_s;
+    int32_t step;
+
+    if (st->vbat_q4 == 0)
+    {
+        st->vbat_q4 = (uint32_t)vbat_mv << 4;
+        st->trendRef_q4 = st->vbat_q4;
+        st->trendAt_s = now;
+        return;
+    }
+
+    st->vbat_q4 = (uint32_t)((int32_t)st->vbat_q4 + (((int32_t)((uint32_t)vbat_mv << 4) - (int32_t)st->vbat_q4) >> HT_POWER_EW_SHIFT));
+
+    if (span < HT_POWER_TREND_MIN_S)
+        return;
+
+    step = (int32_t)(((int64_t)((int32_t)st->vbat_q4 - (int32_t)st->trendRef_q4) * SECONDS_PER_DAY) / ((int64_t)span * 16));
+    st->slope = st->trendValid ? st->slope + ((step - st->slope) >> HT_POWER_EW_SHIFT) : step;
+    st->trendValid = 1;
+    st->trendRef_q4 = st->vbat_q4;
+    st->trendAt_s = now;
+}
+
+void HT_Power_Reset(HT_PowerState *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->tier = HT_POWER_TIER_NORMAL;
+}
+
+void HT_Power_Init(void)
+{
+    HT_Log_SetLevel((uint8_t)HT_Power_Settings()->log);
+}
+
+uint8_t HT_Power_Update(uint16_t vbat_mv, uint8_t batLow)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    HT_PowerState *st = &r->power;
+    int32_t projected;
+    uint8_t soc, ahead, down, up, tier = st->tier;
+
+    st->batLow = batLow != 0;
+
+    if (vbat_mv != 0)
+    {
+        HT_Power_Track(st, vbat_mv, HT_Retained_Now());
+
+        // A falling trend brings the next tier forward by the horizon
+        soc = HT_Power_ChargePct(st->vbat_q4 >> 4);
+        if (st->trendValid && st->slope < 0 && r->config.horizon_h != 0)
+        {
+            projected = (int32_t)(st->vbat_q4 >> 4) + st->slope * (int32_t)r->config.horizon_h / 24;
+            ahead = HT_Power_ChargePct(projected > 0 ? (uint32_t)projected : 0);
+            if (ahead < soc)
+                soc = ahead;
+        }
+
+        down = HT_Power_TierFor(&r->config, soc, 0);
+        up = HT_Power_TierFor(&r->config, soc, HT_POWER_HYSTERESIS_PCT);
+        if (down > tier)
+            tier = down;
+        else if (up < tier)
+            tier = up;
+    }
+
+    if (st->batLow)
+        tier = HT_POWER_TIER_CRITICAL;
+
+    if (tier != st->tier)
+    {
+        HT_LOG(P_SIG, HT_Power_Update_1, "Battery tier %u -> %u (%u mV, slope %d mV/day)",
+               st->tier, tier, (unsigned)(st->vbat_q4 >> 4), (int)st->slope);
+
+        if (tier == HT_POWER_TIER_CRITICAL)
+            st->alert = HT_POWER_ALERT_PENDING;
+        else
+            st->alert = HT_POWER_ALERT_NONE;
+
+        st->tier = tier;
+        st->rawCount = 0;
+    }
+
+    HT_Log_SetLevel((uint8_t)HT_Power_Settings()->log);
+    HT_Retained_Commit();
+
+    return tier;
+}
+
+uint8_t HT_Power_Tier(void)
+{
+    return HT_Retained_Get()->power.tier;
+}
+
+uint32_t HT_Power_PeriodMs(uint32_t period_ms)
+{
+    uint64_t scaled;
+
+    if (HT_Power_Tier() == HT_POWER_TIER_CRITICAL)
+        return HT_CONFIG_MAX_INTERVAL_S * 1000UL;
+
+    scaled = (uint64_t)period_ms * HT_Power_Settings()->scale;
+
+    return scaled > HT_CONFIG_MAX_INTERVAL_S * 1000ULL ? HT_CONFIG_MAX_INTERVAL_S * 1000UL : (uint32_t)scaled;
+}
+
+uint32_t HT_Power_Batch(void)
+{
+    return HT_Power_Settings()->batch;
+}
+
+uint8_t HT_Power_RawDue(void)
+{
+    HT_PowerState *st = &HT_Retained_Get()->power;
+
+    if (++st->rawCount < HT_Power_Batch())
+    {
+        HT_Retained_Commit();
+        return 0;
+    }
+
+    st->rawCount = 0;
+    HT_Retained_Commit();
+
+    return 1;
+}
+
+uint8_t HT_Power_Qos(void)
+{
+    return (uint8_t)HT_Power_Settings()->qos;
+}
+
+uint8_t HT_Power_AlertPending(void)
+{
+    return HT_Retained_Get()->power.alert == HT_POWER_ALERT_PENDING;
+}
+
+int HT_Power_AlertFormat(char *buf, size_t len)
+{
+    const HT_PowerState *st = &HT_Retained_Get()->power;
+    int n;
+
+    n = snprintf(buf, len, "{\"vb\":%lu,\"soc\":%u,\"slope\":%ld,\"low\":%u}",
+                 (unsigned long)(st->vbat_q4 >> 4), HT_Power_ChargePct(st->vbat_q4 >> 4), (long)st->slope, st->batLow);
+
+    return (n < 0 || (size_t)n >= len) ? 0 : n;
+}
+
+void HT_Power_AlertSent(void)
+{
+    HT_Retained_Get()->power.alert = HT_POWER_ALERT_SENT;
+    HT_Retained_Commit();
+}
+
+int HT_Power_DiagFormat(char *buf, size_t len)
+{
+    const HT_PowerState *st = &HT_Retained_Get()->power;
+
+    return snprintf(buf, len, "\"power\":{\"tier\":%u,\"vb\":%lu,\"soc\":%u,\"slope\":%ld,\"low\":%u,\"alert\":%u}",
+                    st->tier, (unsigned long)(st->vbat_q4 >> 4), HT_Power_ChargePct(st->vbat_q4 >> 4),
+                    (long)st->slope, st->batLow, st->alert);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
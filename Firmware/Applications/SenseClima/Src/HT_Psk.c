@@ -0,0 +1,100 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Psk.h"
+#include <stddef.h>
+#include <string.h>
+#include "qcx212.h"                 // Required for SaveAndSetIRQMask, RestoreIRQMask
+#include "efuse_qcx212.h"           // Required for EfuseInit, EFuseSWRead
+#include "mbedtls/platform_util.h"  // Required for mbedtls_platform_zeroize
+#include "HT_Retained.h"            // Required for HT_Crc16
+#include "HT_Log.h"
+
+#define HT_PSK_EFUSE_CHUNK      8   // EFuseSWRead reads at most 8 bytes per call
+
+#ifndef HT_PRODUCTION
+// Development credentials, used with a blank efuse only. Never in production builds
+static const uint8_t HT_PSK_DEV_KEY[] = {
+    0x53, 0x65, 0x6E, 0x73, 0x65, 0x43, 0x6C, 0x69, 0x6D, 0x61, 0x2D, 0x64, 0x65, 0x76, 0x30, 0x31
+};
+static const char HT_PSK_DEV_IDENTITY[] = "SIP_HTNB32L-XXX";
+#endif
+
+static int32_t HT_Psk_ReadEfuse(HT_PskRecord *rec)
+{
+    uint8_t *p = (uint8_t *)rec;
+    uint32_t mask;
+    int32_t ret = 0;
+
+    mask = SaveAndSetIRQMask();
+    EfuseInit();
+    for (uint8_t off = 0; off < sizeof(*rec) && ret == 0; off += HT_PSK_EFUSE_CHUNK)
+        ret = EFuseSWRead(EFUSE_SW_APP_BYTELOC + off, HT_PSK_EFUSE_CHUNK, p + off);
+    EfuseDeInit();
+    RestoreIRQMask(mask);
+
+    return ret;
+}
+
+uint8_t HT_Psk_Load(HT_Psk *psk)
+{
+    HT_PskRecord rec;
+    uint8_t status = HT_PSK_OK;
+
+    memset(psk, 0, sizeof(*psk));
+
+    if (HT_Psk_ReadEfuse(&rec) != 0)
+        status = HT_PSK_INVALID;
+    else if (rec.magic != HT_PSK_MAGIC)
+        status = HT_PSK_BLANK;
+    else if (rec.crc != HT_Crc16(0xFFFF, &rec, offsetof(HT_PskRecord, crc)) ||
+             rec.keyLen == 0 || rec.keyLen > HT_PSK_KEY_MAX ||
+             rec.identityLen == 0 || rec.identityLen > HT_PSK_IDENTITY_MAX)
+        status = HT_PSK_INVALID;
+
+    if (status == HT_PSK_OK)
+    {
+        memcpy(psk->key, rec.key, rec.keyLen);
+        psk->keyLen = rec.keyLen;
+        memcpy(psk->identity, rec.identity, rec.identityLen);
+        psk->identityLen = rec.identityLen;
+    }
+#ifndef HT_PRODUCTION
+    else if (status == HT_PSK_BLANK)
+    {
+        memcpy(psk->key, HT_PSK_DEV_KEY, sizeof(HT_PSK_DEV_KEY));
+        psk->keyLen = sizeof(HT_PSK_DEV_KEY);
+        memcpy(psk->identity, HT_PSK_DEV_IDENTITY, sizeof(HT_PSK_DEV_IDENTITY) - 1);
+        psk->identityLen = sizeof(HT_PSK_DEV_IDENTITY) - 1;
+        status = HT_PSK_DEV;
+    }
+#endif
+
+    mbedtls_platform_zeroize(&rec, sizeof(rec));
+
+    if (status == HT_PSK_INVALID)
+        HT_LOG(P_ERROR, HT_Psk_Load_1, "PSK efuse record invalid, not used.");
+    else if (status == HT_PSK_DEV)
+        HT_LOG(P_WARNING, HT_Psk_Load_2, "PSK efuse blank, using the development key.");
+
+    return status;
+}
+
+void HT_Psk_Clear(HT_Psk *psk)
+{
+    mbedtls_platform_zeroize(psk, sizeof(*psk));
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,100 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Retained.h"
+#include "HT_Log.h"
+#include <stdio.h>
+#include <string.h>
+#include "slpman_qcx212.h" // Required for the user NVMem API
+#include "cmsis_os2.h"     // Required for osKernelGetTickCount
+
+// The retained image must fit the user NVMem region.
+typedef char HT_RetainedSizeCheck[(sizeof(HT_RetainedData) <= HT_RETAINED_MAX_SIZE) ? 1 : -1];
+
+static HT_RetainedData retained;
+
+uint16_t HT_Crc16(uint16_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+static uint16_t HT_Retained_Crc(const HT_RetainedData *data)
+{
+    return HT_Crc16(0xFFFF, data, offsetof(HT_RetainedData, crc));
+}
+
+static void HT_Retained_Defaults(HT_RetainedData *data)
+{
+    memset(data, 0, sizeof(*data));
+    data->magic = HT_RETAINED_MAGIC;
+    data->version = HT_RETAINED_VERSION;
+    data->length = sizeof(HT_RetainedData);
+    HT_Config_Defaults(&data->config);
+    HT_Sampler_Reset(&data->sampler, &data->config);
+    HT_Aggregate_Reset(&data->aggregate, 0);
+    HT_Alarm_Reset(&data->alarm);
+    HT_Power_Reset(&data->power);
+}
+
+void HT_Retained_Init(void)
+{
+    const HT_RetainedData *nv = (const HT_RetainedData *)slpManGetUsrNVMem();
+
+    memcpy(&retained, nv, sizeof(retained));
+
+    if (retained.magic != HT_RETAINED_MAGIC || retained.version != HT_RETAINED_VERSION ||
+        retained.length != sizeof(HT_RetainedData) || retained.crc != HT_Retained_Crc(&retained))
+    {
+        HT_LOG(P_WARNING, HT_Retained_Init_1, "Retained state invalid, loading defaults.");
+        HT_Retained_Defaults(&retained);
+    }
+
+    retained.wakeCount++;
+    HT_Retained_Commit();
+}
+
+uint32_t HT_Retained_Now(void)
+{
+    return retained.clock_s + osKernelGetTickCount() / osKernelGetTickFreq();
+}
+
+void HT_Retained_AdvanceClock(uint32_t sleep_ms)
+{
+    retained.clock_s = HT_Retained_Now() + (sleep_ms + 500) / 1000;
+    HT_Retained_Commit();
+}
+
+HT_RetainedData *HT_Retained_Get(void)
+{
+    return &retained;
+}
+
+void HT_Retained_Commit(void)
+{
+    retained.crc = HT_Retained_Crc(&retained);
+    memcpy(slpManGetUsrNVMem(), &retained, sizeof(retained));
+    slpManUpdateUserNVMem(); // Written to flash by the SDK before sleep2/hibernate.
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,157 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Sampler.h"
+#include "HT_Retained.h"
+#include "HT_FixedPoint.h"
+#include <stdio.h>
+
+#define HT_SAMPLER_SLOPE_LIMIT  32767   // Keeps the squared deviation within 32 bits.
+#define HT_SAMPLER_MAX_GROWTH   2       // Period may at most double from one sample to the next.
+
+/**
+ * @brief Updates the EW slope/variance of one channel with a new observed slope.
+ */
+static void HT_Sampler_Filter(int32_t slope, uint32_t shift, int32_t *ewSlope, uint32_t *ewVar)
+{
+    int32_t d = slope - *ewSlope;
+    uint64_t d2 = (uint64_t)((int64_t)d * d);
+    uint64_t var = *ewVar;
+
+    *ewSlope += d / (1L << shift);
+
+    // var <- (1 - a) * (var + a * d^2), with a = 2^-shift.
+    var = var + (d2 >> shift);
+    var -= var >> shift;
+    *ewVar = (var > UINT32_MAX) ? UINT32_MAX : (uint32_t)var;
+}
+
+/**
+ * @brief Period (s) after which a channel with this activity would drift by tol.
+ */
+static uint32_t HT_Sampler_ChannelPeriod(int32_t ewSlope, uint32_t ewVar, uint32_t tol_x10, uint32_t maxPeriod)
+{
+    uint32_t activity = (uint32_t)(ewSlope < 0 ? -ewSlope : ewSlope) + HT_Isqrt32(ewVar);
+    uint64_t period;
+
+    if (activity == 0)
+        return maxPeriod;
+
+    period = ((uint64_t)tol_x10 * 3600ULL) / activity;
+
+    return (period > maxPeriod) ? maxPeriod : (uint32_t)period;
+}
+
+static int32_t HT_Sampler_Slope(int32_t delta_x10, uint32_t dt_s)
+{
+    int32_t slope = (int32_t)(((int64_t)delta_x10 * 3600) / (int64_t)(dt_s ? dt_s : 1));
+
+    if (slope > HT_SAMPLER_SLOPE_LIMIT)
+        return HT_SAMPLER_SLOPE_LIMIT;
+    if (slope < -HT_SAMPLER_SLOPE_LIMIT)
+        return -HT_SAMPLER_SLOPE_LIMIT;
+
+    return slope;
+}
+
+void HT_Sampler_Reset(HT_SamplerState *st, const HT_ConfigData *cfg)
+{
+    st->lastTemp = 0;
+    st->lastHumi = 0;
+    st->tempSlope = 0;
+    st->humiSlope = 0;
+    st->tempVar = 0;
+    st->humiVar = 0;
+    st->period_s = cfg->interval_s;
+    st->samples = 0;
+    st->lastAt_s = 0;
+}
+
+uint32_t HT_Sampler_Step(HT_SamplerState *st, const HT_ConfigData *cfg, uint32_t now_s, int16_t temp_x10, uint16_t humi_x10)
+{
+    uint32_t next, tPeriod, hPeriod, elapsed = now_s - st->lastAt_s;
+
+    if (st->samples > 0)
+    {
+        HT_Sampler_Filter(HT_Sampler_Slope(temp_x10 - st->lastTemp, elapsed), cfg->ew_shift,
+                          &st->tempSlope, &st->tempVar);
+        HT_Sampler_Filter(HT_Sampler_Slope((int32_t)humi_x10 - st->lastHumi, elapsed), cfg->ew_shift,
+                          &st->humiSlope, &st->humiVar);
+    }
+
+    st->lastAt_s = now_s;
+    st->lastTemp = temp_x10;
+    st->lastHumi = humi_x10;
+    if (st->samples < UINT32_MAX)
+        st->samples++;
+
+    if (!cfg->adaptive || st->samples < 2)
+    {
+        st->period_s = cfg->interval_s;
+        return st->period_s;
+    }
+
+    tPeriod = HT_Sampler_ChannelPeriod(st->tempSlope, st->tempVar, cfg->temp_tol_x10, cfg->max_interval_s);
+    hPeriod = HT_Sampler_ChannelPeriod(st->humiSlope, st->humiVar, cfg->humi_tol_x10, cfg->max_interval_s);
+    next = (tPeriod < hPeriod) ? tPeriod : hPeriod;
+
+    // Shrink immediately on a transient, but stretch gradually.
+    if (next > st->period_s * HT_SAMPLER_MAX_GROWTH)
+        next = st->period_s * HT_SAMPLER_MAX_GROWTH;
+    if (next < cfg->min_interval_s)
+        next = cfg->min_interval_s;
+    if (next > cfg->max_interval_s)
+        next = cfg->max_interval_s;
+
+    st->period_s = next;
+
+    return next;
+}
+
+uint32_t HT_Sampler_Update(int16_t temp_x10, uint16_t humi_x10)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    uint32_t period = HT_Sampler_Step(&r->sampler, &r->config, HT_Retained_Now(), temp_x10, humi_x10);
+
+    HT_Retained_Commit();
+
+    return period;
+}
+
+uint32_t HT_Sampler_PeriodMs(void)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    uint32_t period = r->sampler.period_s;
+
+    if (!r->config.adaptive || period == 0)
+        period = r->config.interval_s;
+
+    return period * 1000UL;
+}
+
+int HT_Sampler_DiagFormat(char *buf, size_t len)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+    const HT_SamplerState *st = &r->sampler;
+
+    return snprintf(buf, len,
+                    "\"sampler\":{\"adaptive\":%lu,\"period\":%lu,\"n\":%lu,"
+                    "\"t_slope\":%ld,\"t_std\":%lu,\"h_slope\":%ld,\"h_std\":%lu}",
+                    (unsigned long)r->config.adaptive, (unsigned long)st->period_s, (unsigned long)st->samples,
+                    (long)st->tempSlope, (unsigned long)HT_Isqrt32(st->tempVar),
+                    (long)st->humiSlope, (unsigned long)HT_Isqrt32(st->humiVar));
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
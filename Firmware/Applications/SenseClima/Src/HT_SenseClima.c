@@ -14,10 +14,23 @@
  */
 
 #include "HT_SenseClima.h"
-#include <stdio.h>    // Required for printf
+#include <stdio.h>    // Required for snprintf
 #include <string.h>   // Required for memset, memcpy, strlen
 #include "HT_DHT22.h" // Required for DHT22_Init, DHT22_Read
 #include "slpman_qcx212.h" // Required for sleep management functions
+#include "HT_Config.h"     // Required for HT_Config_Set, HT_Config_Apply
+#include "HT_Sampler.h"    // Required for HT_Sampler_Update, HT_Sampler_PeriodMs
+#include "HT_Diag.h"       // Required for HT_Diag_Format
+#include "HT_Aggregate.h"  // Required for HT_Aggregate_Update, HT_Aggregate_Format
+#include "HT_Retained.h"   // Required for HT_Retained_AdvanceClock
+#include "HT_Alarm.h"      // Required for HT_Alarm_Evaluate, HT_Alarm_Apply
+#include "HT_Log.h"        // Required for HT_LOG
+#include "HT_LogStore.h"   // Required for HT_LogStore_Read, HT_LogStore_Flush
+#include "HT_Adc.h"        // Required for HT_Adc_Start, HT_Adc_Wait
+#include "HT_Power.h"      // Required for HT_Power_Update, HT_Power_PeriodMs
+#include "HT_TimeSeries.h" // Required for HT_TimeSeries_Append, HT_TimeSeries_Sync
+#include "HT_Uplink.h"     // Required for HT_Uplink_Drain, HT_Uplink_Skip
+#include "batmon_qcx212.h" // Required for BatVoltIsLow
 
 /* Function prototypes  ------------------------------------------------------------------*/
 
@@ -28,7 +41,7 @@
 static HT_ConnectionStatus HT_FSM_MQTTConnect(void);
 
 /**
- * @brief Thread function for reading DHT22 sensor data and publishing it.
+ * @brief Thread function publishing the readings of this wake.
  * @param arg Thread parameter (unused).
  */
 static void HT_DhtThread(void *arg);
@@ -55,9 +68,21 @@ static const char addr[] = {"131.255.82.115"};
 
 static const char topic_temperature[] = {"hana/prototipagem/senseclima/01/temperature"};
 static const char topic_humidity[] = {"hana/prototipagem/senseclima/01/humidity"};
+static const char topic_battery[] = {"hana/prototipagem/senseclima/01/battery"};
+static const char topic_readings[] = {"hana/prototipagem/senseclima/01/readings"};
+static const char topic_battery_alert[] = {"hana/prototipagem/senseclima/01/battery/alert"};
 static const char topic_interval[] = {"hana/prototipagem/senseclima/01/interval"};
+static const char topic_config[] = {"hana/prototipagem/senseclima/01/config"};
+static const char topic_diagnostics[] = {"hana/prototipagem/senseclima/01/diagnostics"};
+static const char topic_aggregate[] = {"hana/prototipagem/senseclima/01/aggregate"};
+static const char topic_alarm[] = {"hana/prototipagem/senseclima/01/alarm"};
+static const char topic_alarm_rules[] = {"hana/prototipagem/senseclima/01/alarm/rules"};
+static const char topic_log[] = {"hana/prototipagem/senseclima/01/log"};
+static const char topic_log_request[] = {"hana/prototipagem/senseclima/01/log/request"};
 
 #define TIMER_ID 0
+#define SAMPLE_ATTEMPTS     3       /**< DHT22 reads tried per wake. */
+#define SAMPLE_RETRY_MS     2000    /**< The DHT22 needs 2 s between conversions. */
 
 uint8_t voteHandle = 0xFF;
 extern uint8_t mqttEpSlpHandler;
@@ -65,6 +90,14 @@ extern uint8_t mqttEpSlpHandler;
 static StaticTask_t dht_thread;
 static uint8_t dhtTaskStack[TASK_STACK_SIZE];
 
+static int16_t sampleTemp;      // Reading of this wake (0.1 C), valid if sampleValid.
+static uint16_t sampleHumi;     // Reading of this wake (0.1 %RH), valid if sampleValid.
+static uint8_t sampleValid = 0;
+
+static volatile uint8_t sleepArmed = 0;     // sleepWithMode programmed the wakeup timer.
+static uint32_t connectStartTick;           // Kernel tick at HT_SenseClima_ConnectStart.
+static uint32_t sleepClock_s;               // Device clock before it was moved past the sleep.
+
 /**
  * @brief Converts time components (days, hours, minutes, seconds) into total milliseconds.
  *
@@ -88,8 +121,7 @@ uint64_t time_ms(int days, int hours, int min, int sec)
 
     if (total_ms > 2088000000ULL)
     { // Approximately 580 hours in milliseconds
-        printf("\nTime exceeds the maximum supported by the device!\n");
-        printf(" Default value of 30s will be used.\n");
+        HT_LOG(P_WARNING, time_ms_1, "Time exceeds the maximum supported by the device! Default value of 30s will be used.");
         return 30 * 1000ULL;
     }
 
@@ -103,7 +135,8 @@ uint64_t time_ms(int days, int hours, int min, int sec)
  */
 void beforeHibernateCb(void *pdata, slpManLpState state)
 {
-    printf("[Callback] Before Hibernate\n");
+    HT_LOG(P_DEBUG, beforeHibernateCb_1, "[Callback] Before Hibernate");
+    HAL_USART_FlushPrint(); // Drain the print ring before the UART loses power.
 }
 
 /**
@@ -113,7 +146,42 @@ void beforeHibernateCb(void *pdata, slpManLpState state)
  */
 void afterHibernateCb(void *pdata, slpManLpState state)
 {
-    printf("[Callback] Woke up from Hibernate\n");
+    HT_LOG(P_DEBUG, afterHibernateCb_1, "[Callback] Woke up from Hibernate");
+}
+
+/**
+ * @brief Programs the deep sleep timer and moves the device clock past the sleep.
+ *
+ * May be called again while waiting for hibernate; the new sleep replaces
+ * the previous one instead of adding to the clock.
+ *
+ * @param sleep_ms Time until the next wake in milliseconds.
+ */
+static void armWakeup(uint32_t sleep_ms)
+{
+    HT_RetainedData *r = HT_Retained_Get();
+
+    if (!sleepArmed)
+    {
+        sleepClock_s = r->clock_s;
+        sleepArmed = 1;
+    }
+
+    r->clock_s = sleepClock_s;
+    HT_Retained_AdvanceClock(sleep_ms);
+    slpManDeepSlpTimerStart(TIMER_ID, sleep_ms);
+}
+
+void HT_SenseClima_ForceCycle(void)
+{
+    HT_Retained_Get()->flags |= HT_RETAINED_FLAG_FORCE_CYCLE;
+
+    if (sleepArmed)
+        armWakeup(HT_FORCE_CYCLE_DELAY_MS);
+    else
+        HT_Retained_Commit();
+
+    HT_LOG(P_SIG, HT_SenseClima_ForceCycle_1, "Cycle forced, uploading at the next wake.");
 }
 
 /**
@@ -127,7 +195,7 @@ void afterHibernateCb(void *pdata, slpManLpState state)
  */
 void sleepWithMode(slpManSlpState_t mode)
 {
-    printf("\n=== Entering Sleep Mode %d===\n", mode);
+    HT_LOG(P_INFO, sleepWithMode_1, "=== Entering Sleep Mode %d===", mode);
 
     appSetCFUN(0); // Set modem to minimum functionality.
     appSetEcSIMSleepSync(1); // Enable SIM sleep.
@@ -144,67 +212,326 @@ void sleepWithMode(slpManSlpState_t mode)
     // Enable sleep mode using the platform vote handle.
     slpManPlatVoteEnableSleep(voteHandle, mode);
 
-    // Activate RTC timer as wakeup source.
-    uint64_t interval_ms = time_ms(0, 0, 0, 60);
-    slpManDeepSlpTimerStart(TIMER_ID, interval_ms);
+    // Activate RTC timer as wakeup source, using the period chosen by the sampler and the battery tier.
+    uint32_t interval_ms = HT_Power_PeriodMs(HT_Sampler_PeriodMs());
+    HT_LOG(P_INFO, sleepWithMode_2, "Next sample in %lu s", (unsigned long)(interval_ms / 1000));
+    armWakeup(interval_ms);
+    HT_TimeSeries_Sync(); // Commit the readings of this wake to the time series.
+    HT_LogStore_Flush(); // Program the staged log frames while the flash is still ours.
 
     // Passive wait - the system should enter sleep automatically.
     while (1)
     {
-        printf("Hibernating ....");
+        HT_LOG(P_DEBUG, sleepWithMode_3, "Hibernating ....");
+        HT_LogStore_Flush();
         osDelay(2000); // After the timer expires, the system wakes up and messages are displayed.
+
+        // Held awake (console session) past the wakeup: without a timer the hibernate would never end.
+        if (!slpManDeepSlpTimerIsRunning(TIMER_ID))
+            armWakeup(HT_FORCE_CYCLE_DELAY_MS);
     }
 }
 
 /**
- * @brief Thread function for reading DHT22 sensor data and publishing it.
+ * @brief Formats a value in tenths as a decimal string, e.g. -5 as "-0.5".
+ * @param buf Output buffer.
+ * @param len Size of the output buffer.
+ * @param value_x10 Value in tenths.
+ */
+static void formatTenths(char *buf, size_t len, int32_t value_x10)
+{
+    uint32_t abs_x10 = (uint32_t)(value_x10 < 0 ? -value_x10 : value_x10);
+
+    snprintf(buf, len, "%s%lu.%lu", value_x10 < 0 ? "-" : "", (unsigned long)(abs_x10 / 10), (unsigned long)(abs_x10 % 10));
+}
+
+/**
+ * @brief Appends the reading of this wake to the time series, whether or
+ *        not it is uploaded.
+ */
+static void storeSample(void)
+{
+    HT_TsRecord rec = {
+        .t_s = HT_Retained_Now(),
+        .temp = sampleTemp,
+        .humi = sampleHumi,
+        .vbat_mv = HT_Adc_Last()->vbat_mv,
+        .flags = BatVoltIsLow() ? HT_TS_FLAG_BAT_LOW : 0,
+    };
+    int err = HT_TimeSeries_Append(&rec);
+
+    if (err < 0)
+        HT_LOG(P_WARNING, storeSample_1, "Reading not stored in the time series (%d)", err);
+}
+
+/**
+ * @brief Evaluates the alarms on the reading of this wake and decides
+ *        whether to upload, within the limits of the battery tier.
+ * @param forced Non-zero if a full cycle was requested.
+ * @return See HT_SenseClima_SampleWake.
+ */
+static uint8_t uploadDue(uint8_t forced)
+{
+    uint8_t aggregate = HT_Config_Get()->report_mode == HT_CONFIG_REPORT_AGGREGATE;
+    uint8_t critical = HT_Power_Tier() == HT_POWER_TIER_CRITICAL;
+    uint32_t window_s = HT_Config_Get()->upload_window_s * HT_Power_Batch();
+
+    if (!sampleValid)
+    {
+        HT_LOG(P_WARNING, HT_SenseClima_SampleWake_2, "DHT22 read failed, skipping this sample.");
+    }
+    else if (HT_Alarm_Evaluate(sampleTemp, sampleHumi) && !critical)
+    {
+        // A tripped alarm rule brings the link up regardless of the schedule.
+        HT_LOG(P_SIG, HT_SenseClima_SampleWake_4, "Alarm tripped, uploading now.");
+        return 1;
+    }
+
+    // Last gasp: only the low battery alert and forced cycles reach the radio.
+    if (forced || HT_Power_AlertPending())
+        return 1;
+
+    if (critical)
+        return 0;
+
+    if (aggregate)
+        return HT_Aggregate_WindowDue(window_s);
+
+    return sampleValid && HT_Power_RawDue();
+}
+
+uint8_t HT_SenseClima_SampleWake(void)
+{
+    float temp = 0.0f, humi = 0.0f;
+    HT_RetainedData *r = HT_Retained_Get();
+    uint8_t forced = (r->flags & HT_RETAINED_FLAG_FORCE_CYCLE) != 0;
+
+    if (forced)
+    {
+        r->flags &= ~HT_RETAINED_FLAG_FORCE_CYCLE;
+        HT_Retained_Commit();
+    }
+
+    HT_LOG(P_DEBUG, HT_SenseClima_SampleWake_1, "Initializing DHT sensor...");
+    DHT22_Init(); // Initialize the DHT22 sensor.
+
+    sampleValid = 0;
+    for (uint8_t attempt = 0; attempt < SAMPLE_ATTEMPTS && !sampleValid; attempt++)
+    {
+        if (attempt)
+            osDelay(SAMPLE_RETRY_MS); // Delay before next sensor read attempt.
+
+        if (DHT22_Read(&temp, &humi) == DHT22_OK) // Check if DHT22_Read was successful.
+        {
+            sampleTemp = (int16_t)(temp * 10);
+            sampleHumi = (uint16_t)(humi * 10);
+            sampleValid = 1;
+        }
+    }
+
+    // Battery and die temperature convert in the background while the reading is processed.
+    // Not earlier: ADC interrupts would stretch the pulse widths polled by DHT22_Read.
+    HT_Adc_Start();
+
+    if (sampleValid)
+    {
+        HT_LOG(P_VALUE, HT_SenseClima_SampleWake_3, "Temperature: %d (0.1 C) | Humidity: %u (0.1 %%)", sampleTemp, sampleHumi);
+
+        // Feed the adaptive sampler (next wakeup) and the window statistics.
+        HT_Sampler_Update(sampleTemp, sampleHumi);
+        HT_Aggregate_Update(sampleTemp, sampleHumi);
+    }
+
+    HT_Adc_Wait(HT_ADC_TIMEOUT_MS, NULL);
+    HT_Power_Update(HT_Adc_Last()->vbat_mv, BatVoltIsLow());
+
+    if (sampleValid)
+        storeSample();
+
+    if (!uploadDue(forced))
+        return 0;
+
+    // Committed before main brings the radio up: a brownout is likeliest while it transmits.
+    HT_Uplink_Prepare();
+    return 1;
+}
+
+void HT_SenseClima_ConnectStart(void)
+{
+    connectStartTick = osKernelGetTickCount();
+}
+
+uint32_t HT_SenseClima_ConnectLeftMs(void)
+{
+    uint64_t budget_ms = (uint64_t)HT_Config_Get()->connect_s * 1000U;
+    uint64_t spent_ms = ((uint64_t)(osKernelGetTickCount() - connectStartTick) * 1000U) / osKernelGetTickFreq();
+
+    return spent_ms < budget_ms ? (uint32_t)(budget_ms - spent_ms) : 0;
+}
+
+void HT_SenseClima_Offline(void)
+{
+    HT_LOG(P_WARNING, HT_SenseClima_Offline_1, "No connection within %lu s, %lu readings queued for the next upload.",
+           (unsigned long)HT_Config_Get()->connect_s, (unsigned long)HT_Uplink_Depth());
+    HT_Uplink_Prepare();
+    sleepWithMode(SLP_HIB_STATE); // Does not return.
+}
+
+/**
+ * @brief Publishes every pending alarm on the alarm topic at QoS1. A missing
+ *        PUBACK closes the session, so the first failure ends the loop and
+ *        the unsent alarms stay pending for the next wake.
+ */
+static void publishAlarms(void)
+{
+    char alarmString[HT_ALARM_RECORD_SIZE];
+    uint8_t pending = HT_Alarm_Pending();
+
+    for (uint8_t i = 0; i < HT_ALARM_MAX_RULES; i++)
+    {
+        if (!(pending & (1U << i)) || HT_Alarm_Format(i, alarmString, sizeof(alarmString)) == 0)
+            continue;
+
+        if (HT_MQTT_Publish(&mqttClient, (char *)topic_alarm, (uint8_t *)alarmString, strlen(alarmString), QOS1, 0, 0, 0) != 0)
+        {
+            HT_LOG(P_WARNING, publishAlarms_2, "Alarm publish failed, retrying at the next wake.");
+            return;
+        }
+
+        HT_LOG_STRING(P_INFO, publishAlarms_1, "Alarm published: %s", alarmString);
+        HT_Alarm_MarkSent(i);
+    }
+}
+
+/**
+ * @brief Publishes the low battery alert at QoS1 once, on entering the
+ *        critical tier. A failed publish leaves it latched for the next wake.
+ */
+static void publishBatteryAlert(void)
+{
+    char alertString[HT_POWER_ALERT_SIZE];
+
+    if (!HT_Power_AlertPending() || HT_Power_AlertFormat(alertString, sizeof(alertString)) == 0)
+        return;
+
+    if (HT_MQTT_Publish(&mqttClient, (char *)topic_battery_alert, (uint8_t *)alertString, strlen(alertString), QOS1, 0, 0, 0) != 0)
+    {
+        HT_LOG(P_WARNING, publishBatteryAlert_2, "Low battery alert publish failed, retrying at the next wake.");
+        return;
+    }
+
+    HT_LOG_STRING(P_WARNING, publishBatteryAlert_1, "Low battery alert published: %s", alertString);
+    HT_Power_AlertSent();
+}
+
+/**
+ * @brief Publishes the log ring at QoS1 if it was requested, in one message
+ *        of the newest frames (raw HT_LOG frames, see HT_LogStore.h).
+ */
+static void publishLog(void)
+{
+    static uint8_t logBuffer[HT_LOGSTORE_UPLOAD_MAX];
+    HT_RetainedData *r = HT_Retained_Get();
+    size_t len;
+
+    if (!(r->flags & HT_RETAINED_FLAG_LOG_UPLOAD))
+        return;
+
+    len = HT_LogStore_Read(logBuffer, sizeof(logBuffer));
+    if (HT_MQTT_Publish(&mqttClient, (char *)topic_log, logBuffer, len, QOS1, 0, 0, 0) != 0)
+    {
+        HT_LOG(P_WARNING, publishLog_1, "Log upload failed, retrying at the next upload.");
+        return;
+    }
+
+    HT_LOG(P_INFO, publishLog_2, "Log uploaded, %u bytes.", (unsigned)len);
+    r->flags &= ~HT_RETAINED_FLAG_LOG_UPLOAD;
+    HT_Retained_Commit();
+}
+
+/**
+ * @brief Publishes one batch of the uplink queue at QoS1 (HT_UplinkPublish).
+ */
+static int publishBatch(const uint8_t *payload, size_t len, void *ctx)
+{
+    return HT_MQTT_Publish(&mqttClient, (char *)topic_readings, (uint8_t *)payload, len, QOS1, 0, 0, 0);
+}
+
+/**
+ * @brief Thread function publishing the readings of this wake.
+ *
+ * In raw mode the reading of this wake is published on the temperature,
+ * humidity and battery (mV) topics, then the uplink queue (HT_Uplink.h) is
+ * drained on the readings topic at QoS1: every reading stored since the
+ * last acknowledged batch, those of outages and of the wakes batched by the
+ * battery tier included. In aggregate mode the statistics of the elapsed
+ * window and the battery voltage are published as one record and the queue
+ * is emptied. Either way the window restarts afterwards. Data goes out at
+ * the QoS of the battery tier; pending alarms and the low battery alert go
+ * out first. In the critical tier the queue waits for a better one.
+ *
  * @param arg Thread parameter (unused).
  */
 static void HT_DhtThread(void *arg)
 {
-    float temp = 0.0f, humi = 0.0f;
-    char tempString[10], humString[10];
+    char tempString[10], humString[10], batString[8];
+    enum QoS qos = HT_Power_Qos() ? QOS1 : QOS0;
+    static char diagString[HT_DIAG_BUFFER_SIZE];
+    static char aggString[HT_AGGREGATE_RECORD_SIZE];
 
-    while (1)
+    while (!mqttClient.isconnected) // Loop until connected.
     {
-        int dht_status = DHT22_Read(&temp, &humi); // Read sensor data.
+        if (HT_FSM_MQTTConnect() == HT_NOT_CONNECTED)
+        {
+            if (HT_SenseClima_ConnectLeftMs() < 5000)
+                HT_SenseClima_Offline();
+            HT_LOG(P_WARNING, HT_DhtThread_1, "MQTT Connection Error! Retrying in 5 seconds...");
+            osDelay(5000);
+        }
+    }
+
+    publishAlarms();
+    publishBatteryAlert();
 
-        if (dht_status == DHT22_OK) // Check if DHT22_Read was successful.
+    if (HT_Config_Get()->report_mode == HT_CONFIG_REPORT_AGGREGATE)
+    {
+        if (HT_Aggregate_Format(&HT_Retained_Get()->aggregate, HT_Adc_Last()->vbat_mv, aggString, sizeof(aggString)) > 0)
+        {
+            HT_MQTT_Publish(&mqttClient, (char *)topic_aggregate, (uint8_t *)aggString, strlen(aggString), qos, 0, 0, 0);
+            osDelay(2000);
+        }
+        HT_Uplink_Skip(); // The window statistics stand for the readings.
+    }
+    else
+    {
+        if (sampleValid)
         {
-            // Convert float temperature and humidity to string format.
-            int temp_int = (int)(temp * 10);
-            int hum_int = (int)(humi * 10);
-            sprintf(tempString, "%d.%d", temp_int / 10, temp_int % 10);
-            sprintf(humString, "%d.%d", hum_int / 10, hum_int % 10);
-
-            printf("\nTemperature: %s°C | Humidity: %s %%\n", tempString, humString);
-
-            while (1) // Loop until connected and published.
-            {
-                while (!mqttClient.isconnected)
-                {
-                    if (HT_FSM_MQTTConnect() == HT_NOT_CONNECTED)
-                    {
-                        printf("\nMQTT Connection Error! Retrying in 5 seconds...\n");
-                        osDelay(5000);
-                    }
-                }
-
-                HT_MQTT_Publish(&mqttClient, (char *)topic_temperature, (uint8_t *)tempString, strlen(tempString), QOS0, 0, 0, 0);
-                osDelay(2000);
-                HT_MQTT_Publish(&mqttClient, (char *)topic_humidity, (uint8_t *)humString, strlen(humString), QOS0, 0, 0, 0);
-                osDelay(2000);
-                printf("\nValues Published...\n");
-
-                break;
-            }
-
-            printf("\nInitiating deep sleep process.\n");
-            sleepWithMode(SLP_HIB_STATE); // Enter deep sleep.
+            // Convert temperature and humidity to string format.
+            formatTenths(tempString, sizeof(tempString), sampleTemp);
+            formatTenths(humString, sizeof(humString), sampleHumi);
+
+            HT_MQTT_Publish(&mqttClient, (char *)topic_temperature, (uint8_t *)tempString, strlen(tempString), qos, 0, 0, 0);
+            osDelay(2000);
+            HT_MQTT_Publish(&mqttClient, (char *)topic_humidity, (uint8_t *)humString, strlen(humString), qos, 0, 0, 0);
+            osDelay(2000);
+            snprintf(batString, sizeof(batString), "%u", HT_Adc_Last()->vbat_mv);
+            HT_MQTT_Publish(&mqttClient, (char *)topic_battery, (uint8_t *)batString, strlen(batString), qos, 0, 0, 0);
+            osDelay(2000);
         }
+        if (HT_Power_Tier() != HT_POWER_TIER_CRITICAL)
+            HT_Uplink_Drain(publishBatch, NULL, HT_UPLINK_DRAIN_BATCHES);
+    }
+    HT_Aggregate_Restart();
 
-        osDelay(1000); // Delay before next sensor read attempt.
+    if (HT_Diag_Format(diagString, sizeof(diagString)) > 0)
+    {
+        HT_MQTT_Publish(&mqttClient, (char *)topic_diagnostics, (uint8_t *)diagString, strlen(diagString), QOS0, 0, 0, 0);
     }
+    publishLog();
+    HT_LOG(P_INFO, HT_DhtThread_2, "Values Published...");
+
+    HT_LOG(P_INFO, HT_DhtThread_3, "Initiating deep sleep process.");
+    sleepWithMode(SLP_HIB_STATE); // Enter deep sleep.
 }
 
 /**
@@ -237,11 +564,11 @@ static HT_ConnectionStatus HT_FSM_MQTTConnect(void)
     if (HT_MQTT_Connect(&mqttClient, &mqttNetwork, (char *)addr, HT_MQTT_PORT, HT_MQTT_SEND_TIMEOUT, HT_MQTT_RECEIVE_TIMEOUT,
                         (char *)clientID, (char *)username, (char *)password, HT_MQTT_VERSION, HT_MQTT_KEEP_ALIVE_INTERVAL, mqttSendbuf, HT_MQTT_BUFFER_SIZE, mqttReadbuf, HT_MQTT_BUFFER_SIZE))
     {
-        printf("MQTT Connection Failed!\n");
+        HT_LOG(P_WARNING, HT_FSM_MQTTConnect_1, "MQTT Connection Failed!");
         return HT_NOT_CONNECTED;
     }
 
-    printf("MQTT Connection Success!\n");
+    HT_LOG(P_INFO, HT_FSM_MQTTConnect_2, "MQTT Connection Success!");
 
     return HT_CONNECTED;
 }
@@ -249,7 +576,13 @@ static HT_ConnectionStatus HT_FSM_MQTTConnect(void)
 /**
  * @brief Manages intervals based on received MQTT payload and topic.
  *
- * This function currently prints the received message and topic.
+ * The interval topic takes the fixed sample period in seconds. The config
+ * topic takes "key=value" pairs (see HT_Config.h), e.g. "adaptive=0;interval=300".
+ * The alarm rules topic takes rule definitions (see HT_Alarm.h), e.g. "0=t>300/10".
+ * Accepted values are persisted and take effect from the next sleep.
+ * Any non-empty message on the log request topic has the log ring published
+ * on the log topic at this or the next upload; send it retained, and clear
+ * it with an empty retained message once the log arrived.
  *
  * @param payload Pointer to the received payload data.
  * @param payload_len Length of the payload.
@@ -259,39 +592,71 @@ static HT_ConnectionStatus HT_FSM_MQTTConnect(void)
 void interval_manager(uint8_t *payload, uint8_t payload_len,
                       uint8_t *topic, uint8_t topic_len)
 {
-    // The original function only prints the message and topic.
-    printf("\nMessage: [%s] | Topic: [%s]\n", payload, topic);
+    char value[16];
+
+    HT_LOG_BUFFER(P_INFO, interval_manager_1, "Message on [%.*s] (%u bytes)", topic, topic_len, payload_len);
+
+    if (topic_len == strlen(topic_interval) && memcmp(topic, topic_interval, topic_len) == 0)
+    {
+        if (payload_len == 0 || payload_len >= sizeof(value))
+            return;
+
+        memcpy(value, payload, payload_len);
+        value[payload_len] = '\0';
+        if (HT_Config_Set("interval", value) != HT_CONFIG_OK)
+            HT_LOG_STRING(P_WARNING, interval_manager_2, "Invalid interval: %s", value);
+    }
+    else if (topic_len == strlen(topic_config) && memcmp(topic, topic_config, topic_len) == 0)
+    {
+        HT_Config_Apply(payload, payload_len);
+    }
+    else if (topic_len == strlen(topic_alarm_rules) && memcmp(topic, topic_alarm_rules, topic_len) == 0)
+    {
+        HT_Alarm_Apply(payload, payload_len);
+    }
+    else if (topic_len == strlen(topic_log_request) && memcmp(topic, topic_log_request, topic_len) == 0)
+    {
+        if (payload_len == 0)
+            return;
+
+        HT_Retained_Get()->flags |= HT_RETAINED_FLAG_LOG_UPLOAD;
+        HT_Retained_Commit();
+    }
 }
 
 /**
  * @brief Implements the Finite State Machine for the SenseClima application.
  *
  * Connects to the MQTT Broker, subscribes to topics, and handles data publishing
- * (e.g., sensor data) and subscribed messages.
+ * (e.g., sensor data) and subscribed messages. Past the connection budget
+ * (HT_SenseClima_ConnectLeftMs) the wake is given up (HT_SenseClima_Offline).
  */
 void HT_Fsm(void)
 {
-    printf("\nAttempting to connect to MQTT Client...");
+    HT_LOG(P_INFO, HT_Fsm_1, "Attempting to connect to MQTT Client...");
 
     // Loop until MQTT client is connected.
     while (!mqttClient.isconnected)
     {
         if (HT_FSM_MQTTConnect() == HT_NOT_CONNECTED)
         {
-            printf("\nMQTT Connection Error! Retrying in 5 seconds...\n");
+            // A broker outage must not keep the radio up: the readings wait in the queue
+            if (HT_SenseClima_ConnectLeftMs() < 5000)
+                HT_SenseClima_Offline();
+            HT_LOG(P_WARNING, HT_Fsm_2, "MQTT Connection Error! Retrying in 5 seconds...");
             osDelay(5000);
         }
     }
 
-    // Subscribe to the interval topic.
+    // Subscribe to the interval, configuration, alarm rule and log request topics.
     HT_MQTT_Subscribe(&mqttClient, topic_interval, QOS0);
+    HT_MQTT_Subscribe(&mqttClient, topic_config, QOS0);
+    HT_MQTT_Subscribe(&mqttClient, topic_alarm_rules, QOS0);
+    HT_MQTT_Subscribe(&mqttClient, topic_log_request, QOS0);
 
-    printf("\nInitializing DHT sensor...\n");
-    DHT22_Init(); // Initialize the DHT22 sensor.
-
-    HT_Dht_Thread(NULL); // Create and start the DHT sensor reading thread.
+    HT_Dht_Thread(NULL); // Create and start the publishing thread.
 
-    printf("Executing SenseClima application.\n");
+    HT_LOG(P_INFO, HT_Fsm_3, "Executing SenseClima application.");
     while (1)
     {
         osDelay(100); // Main loop delay.
@@ -0,0 +1,393 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_SpiNor.h"
+#include "HT_Log.h"
+#include <string.h>
+#include "cmsis_os2.h"     // Required for osSemaphore*, osKernelGetTickCount
+
+#define NOR_CMD_WRITE_ENABLE    0x06
+#define NOR_CMD_READ_STATUS     0x05
+#define NOR_CMD_READ_JEDEC_ID   0x9F
+#define NOR_CMD_FAST_READ       0x0B
+#define NOR_CMD_PAGE_PROGRAM    0x02
+#define NOR_CMD_SECTOR_ERASE    0x20
+
+#define NOR_STATUS_WIP          0x01
+
+// Fast read: opcode, 3 address bytes and one dummy byte
+#define NOR_FAST_READ_CMD_LEN   5
+
+// Wait for a queued transaction; a DMA read of HT_SPI_NOR_READ_CHUNK takes a few ms
+#define NOR_XFER_TIMEOUT_MS     100
+
+extern SPI_HandleTypeDef hspi1;
+
+static HAL_SPI_Device norDevice = {
+    ARM_SPI_CPOL0_CPHA0,
+    HT_SPI_NOR_BUS_SPEED,
+    HT_SPI_NOR_CS_PAD,
+    HT_SPI_NOR_CS_INSTANCE,
+    HT_SPI_NOR_CS_INDEX
+};
+
+// Write enable is queued in front of program/erase, both owned by this module
+static HAL_SPI_Transaction norWren;
+static HAL_SPI_Transaction norXfer;
+static HAL_SPI_Stream norStream;
+static uint8_t norWrenCmd = NOR_CMD_WRITE_ENABLE;
+static uint8_t norCmd[NOR_FAST_READ_CMD_LEN];
+static uint8_t norStatus;
+static uint8_t norStreamBuf[2][HT_SPI_NOR_STREAM_BLOCK];
+
+static osSemaphoreId_t norDone;
+static uint32_t norJedecId;
+
+static void HT_SpiNor_XferDone(HAL_SPI_Transaction *xfer, int32_t status)
+{
+    osSemaphoreRelease(norDone);
+}
+
+static uint32_t HT_SpiNor_Ms(void)
+{
+    return (uint32_t)(((uint64_t)osKernelGetTickCount() * 1000U) / osKernelGetTickFreq());
+}
+
+/**
+ * @brief Submits norXfer (after norWren when wren is set) and waits for it.
+ */
+static HT_SpiNorStatus HT_SpiNor_Run(int wren)
+{
+    if (wren)
+    {
+        HAL_SPI_PrepareCommand(&norWren, &norDevice, &norWrenCmd, 1, NULL, 0, HAL_SPI_SEG_WRITE, NULL, NULL);
+        if (HAL_SPI_Submit(&hspi1, &norWren) != ARM_DRIVER_OK)
+            return HT_SPI_NOR_ERROR_BUS;
+    }
+
+    norXfer.callback = HT_SpiNor_XferDone;
+    if (HAL_SPI_Submit(&hspi1, &norXfer) != ARM_DRIVER_OK)
+        return HT_SPI_NOR_ERROR_BUS;
+
+    if (osSemaphoreAcquire(norDone, NOR_XFER_TIMEOUT_MS * osKernelGetTickFreq() / 1000U + 1U) != osOK)
+        return HT_SPI_NOR_ERROR_TIMEOUT;
+
+    if (wren && norWren.status != ARM_DRIVER_OK)
+        return HT_SPI_NOR_ERROR_BUS;
+
+    return (norXfer.status == ARM_DRIVER_OK) ? HT_SPI_NOR_OK : HT_SPI_NOR_ERROR_BUS;
+}
+
+static void HT_SpiNor_SetCommand(uint8_t cmd, uint32_t addr)
+{
+    norCmd[0] = cmd;
+    norCmd[1] = (uint8_t)(addr >> 16);
+    norCmd[2] = (uint8_t)(addr >> 8);
+    norCmd[3] = (uint8_t)addr;
+    norCmd[4] = 0;
+}
+
+/**
+ * @brief Polls the status register until the write in progress bit clears.
+ * @param timeoutMs Give up after this long.
+ * @param sleep Sleep a tick between polls (erase) instead of polling back to back (program).
+ */
+static HT_SpiNorStatus HT_SpiNor_WaitReady(uint32_t timeoutMs, int sleep)
+{
+    uint32_t start = HT_SpiNor_Ms();
+    HT_SpiNorStatus ret;
+
+    for (;;)
+    {
+        norCmd[0] = NOR_CMD_READ_STATUS;
+        HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, 1, &norStatus, 1, HAL_SPI_SEG_READ, NULL, NULL);
+
+        ret = HT_SpiNor_Run(0);
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+
+        if (!(norStatus & NOR_STATUS_WIP))
+            return HT_SPI_NOR_OK;
+
+        if (HT_SpiNor_Ms() - start > timeoutMs)
+            return HT_SPI_NOR_ERROR_TIMEOUT;
+
+        if (sleep)
+            osDelay(1);
+    }
+}
+
+HT_SpiNorStatus HT_SpiNor_Init(void)
+{
+    uint8_t id[3];
+    HT_SpiNorStatus ret;
+
+    if (norDone == NULL)
+    {
+        norDone = osSemaphoreNew(1, 0, NULL);
+        if (norDone == NULL)
+            return HT_SPI_NOR_ERROR_BUS;
+    }
+
+    // Idle power down: the bus clock only runs while transactions are queued
+    if (HAL_SPI_BusInit(&hspi1, true) != ARM_DRIVER_OK)
+        return HT_SPI_NOR_ERROR_BUS;
+
+    // After the bus init, which muxes the SSn pad to SPI1
+    HAL_SPI_DeviceInit(&norDevice);
+
+    norCmd[0] = NOR_CMD_READ_JEDEC_ID;
+    HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, 1, id, sizeof(id), HAL_SPI_SEG_READ, NULL, NULL);
+
+    ret = HT_SpiNor_Run(0);
+    if (ret != HT_SPI_NOR_OK)
+        return ret;
+
+    norJedecId = ((uint32_t)id[0] << 16) | ((uint32_t)id[1] << 8) | id[2];
+
+    // Floating or shorted MISO
+    if (norJedecId == 0 || norJedecId == 0xFFFFFF)
+    {
+        HT_LOG(P_WARNING, HT_SpiNor_Init_1, "SPI NOR not found (id %06x)", norJedecId);
+        return HT_SPI_NOR_ERROR_ID;
+    }
+
+    HT_LOG(P_INFO, HT_SpiNor_Init_2, "SPI NOR id %06x at %u bps", norJedecId, hspi1.info->bus_speed);
+
+    return HT_SPI_NOR_OK;
+}
+
+uint32_t HT_SpiNor_JedecId(void)
+{
+    return norJedecId;
+}
+
+HT_SpiNorStatus HT_SpiNor_Read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    HT_SpiNorStatus ret;
+    uint32_t n;
+
+    if (buf == NULL)
+        return HT_SPI_NOR_ERROR_PARAM;
+
+    while (len)
+    {
+        n = (len > HT_SPI_NOR_READ_CHUNK) ? HT_SPI_NOR_READ_CHUNK : len;
+
+        HT_SpiNor_SetCommand(NOR_CMD_FAST_READ, addr);
+        HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, NOR_FAST_READ_CMD_LEN, buf, (uint16_t)n,
+                               HAL_SPI_SEG_READ, NULL, NULL);
+
+        ret = HT_SpiNor_Run(0);
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+
+        addr += n;
+        buf += n;
+        len -= n;
+    }
+
+    return HT_SPI_NOR_OK;
+}
+
+HT_SpiNorStatus HT_SpiNor_Program(uint32_t addr, const uint8_t *data, uint32_t len)
+{
+    HT_SpiNorStatus ret;
+    uint32_t n;
+
+    if (data == NULL)
+        return HT_SPI_NOR_ERROR_PARAM;
+
+    while (len)
+    {
+        // A page program wraps inside the page, never cross its end
+        n = HT_SPI_NOR_PAGE_SIZE - (addr % HT_SPI_NOR_PAGE_SIZE);
+        if (n > len)
+            n = len;
+
+        HT_SpiNor_SetCommand(NOR_CMD_PAGE_PROGRAM, addr);
+        HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, 4, (uint8_t *)data, (uint16_t)n,
+                               HAL_SPI_SEG_WRITE, NULL, NULL);
+
+        ret = HT_SpiNor_Run(1);
+        if (ret == HT_SPI_NOR_OK)
+            ret = HT_SpiNor_WaitReady(HT_SPI_NOR_PROGRAM_TIMEOUT_MS, 0);
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+
+        addr += n;
+        data += n;
+        len -= n;
+    }
+
+    return HT_SPI_NOR_OK;
+}
+
+HT_SpiNorStatus HT_SpiNor_EraseSector(uint32_t addr)
+{
+    HT_SpiNorStatus ret;
+
+    HT_SpiNor_SetCommand(NOR_CMD_SECTOR_ERASE, addr & ~(HT_SPI_NOR_SECTOR_SIZE - 1U));
+    HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, 4, NULL, 0, HAL_SPI_SEG_WRITE, NULL, NULL);
+
+    ret = HT_SpiNor_Run(1);
+    if (ret != HT_SPI_NOR_OK)
+        return ret;
+
+    return HT_SpiNor_WaitReady(HT_SPI_NOR_ERASE_TIMEOUT_MS, 1);
+}
+
+HT_SpiNorStatus HT_SpiNor_StreamRead(uint32_t addr, uint32_t len, HAL_SPI_StreamCallback_t onBlock, void *context)
+{
+    HT_SpiNorStatus ret;
+
+    if (len == 0)
+        return HT_SPI_NOR_ERROR_PARAM;
+
+    norStream.buf[0] = norStreamBuf[0];
+    norStream.buf[1] = norStreamBuf[1];
+    norStream.block = HT_SPI_NOR_STREAM_BLOCK;
+    norStream.total = len;
+    norStream.on_block = onBlock;
+    norStream.context = context;
+
+    HT_SpiNor_SetCommand(NOR_CMD_FAST_READ, addr);
+    HAL_SPI_PrepareCommand(&norXfer, &norDevice, norCmd, NOR_FAST_READ_CMD_LEN, NULL, 0,
+                           HAL_SPI_SEG_STREAM, NULL, NULL);
+    norXfer.stream = &norStream;
+
+    ret = HT_SpiNor_Run(0);
+
+    norXfer.stream = NULL;
+
+    return ret;
+}
+
+/* Benchmark ------------------------------------------------------------------*/
+
+typedef struct {
+    uint32_t addr;          /**< Address of the next streamed byte. */
+    uint32_t errors;        /**< Bytes differing from the pattern. */
+} HT_SpiNorBenchCheck;
+
+// Pattern byte of an address, changes every byte and between pages
+static uint8_t HT_SpiNor_Pattern(uint32_t addr)
+{
+    return (uint8_t)(addr ^ (addr >> 8) ^ 0x5A);
+}
+
+static void HT_SpiNor_BenchBlock(HAL_SPI_Stream *stream, uint8_t *data, uint32_t len)
+{
+    HT_SpiNorBenchCheck *check = (HT_SpiNorBenchCheck *)stream->context;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (data[i] != HT_SpiNor_Pattern(check->addr + i))
+            check->errors++;
+    }
+    check->addr += len;
+}
+
+static uint32_t HT_SpiNor_Rate(uint32_t bytes, uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)bytes * 1000U) / (ms ? ms : 1U));
+}
+
+HT_SpiNorStatus HT_SpiNor_Benchmark(uint32_t addr, uint32_t len, HT_SpiNorBench *result)
+{
+    static uint8_t buf[HT_SPI_NOR_READ_CHUNK];
+    HT_SpiNorBench bench;
+    HT_SpiNorBenchCheck check;
+    HT_SpiNorStatus ret;
+    uint32_t powerUps = hspi1.info->power_ups;
+    uint32_t start, ms, off, n, i;
+
+    if (len == 0 || (addr % HT_SPI_NOR_SECTOR_SIZE) || (len % HT_SPI_NOR_SECTOR_SIZE))
+        return HT_SPI_NOR_ERROR_PARAM;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.bytes = len;
+
+    start = HT_SpiNor_Ms();
+    for (off = 0; off < len; off += HT_SPI_NOR_SECTOR_SIZE)
+    {
+        ret = HT_SpiNor_EraseSector(addr + off);
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+    }
+    bench.erase_ms = HT_SpiNor_Ms() - start;
+
+    // Program time only, the pattern is generated before each chunk
+    ms = 0;
+    for (off = 0; off < len; off += n)
+    {
+        n = (len - off > sizeof(buf)) ? sizeof(buf) : len - off;
+        for (i = 0; i < n; i++)
+            buf[i] = HT_SpiNor_Pattern(addr + off + i);
+
+        start = HT_SpiNor_Ms();
+        ret = HT_SpiNor_Program(addr + off, buf, n);
+        ms += HT_SpiNor_Ms() - start;
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+    }
+    bench.program_bps = HT_SpiNor_Rate(len, ms);
+
+    check.addr = addr;
+    check.errors = 0;
+
+    ms = 0;
+    for (off = 0; off < len; off += n)
+    {
+        n = (len - off > sizeof(buf)) ? sizeof(buf) : len - off;
+
+        start = HT_SpiNor_Ms();
+        ret = HT_SpiNor_Read(addr + off, buf, n);
+        ms += HT_SpiNor_Ms() - start;
+        if (ret != HT_SPI_NOR_OK)
+            return ret;
+
+        for (i = 0; i < n; i++)
+        {
+            if (buf[i] != HT_SpiNor_Pattern(addr + off + i))
+                check.errors++;
+        }
+    }
+    bench.read_bps = HT_SpiNor_Rate(len, ms);
+
+    // Verification runs in the block callback, overlapped with the next block
+    start = HT_SpiNor_Ms();
+    ret = HT_SpiNor_StreamRead(addr, len, HT_SpiNor_BenchBlock, &check);
+    ms = HT_SpiNor_Ms() - start;
+    if (ret != HT_SPI_NOR_OK)
+        return ret;
+    bench.stream_bps = HT_SpiNor_Rate(len, ms);
+
+    bench.power_ups = hspi1.info->power_ups - powerUps;
+
+    HT_LOG(P_SIG, HT_SpiNor_Benchmark_1, "NOR bench %u B @%u bps: erase %u ms, program %u B/s, read %u B/s, stream %u B/s, power ups %u",
+           bench.bytes, hspi1.info->bus_speed, bench.erase_ms, bench.program_bps, bench.read_bps, bench.stream_bps, bench.power_ups);
+
+    if (result)
+        *result = bench;
+
+    if (check.errors)
+    {
+        HT_LOG(P_ERROR, HT_SpiNor_Benchmark_2, "NOR bench verify failed, %u bad bytes", check.errors);
+        return HT_SPI_NOR_ERROR_VERIFY;
+    }
+
+    return HT_SPI_NOR_OK;
+}
@@ -0,0 +1,785 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_TimeSeries.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os2.h"      // Required for osMutex*
+#include "lfs_port.h"       // Required for LFS_File*, LFS_Dir*, LFS_Statfs
+#include "HT_Retained.h"    // Required for HT_Crc16
+#include "HT_Log.h"
+
+#define TS_RECORD_SIZE      sizeof(HT_TsRecord)
+#define TS_CHUNK_RECORDS    16      // Records per read when a segment is walked
+#define TS_NAME_SIZE        12
+
+typedef struct {
+    uint32_t magic;             // HT_TS_MAGIC
+    uint16_t recordSize;        // sizeof(HT_TsRecord) of the writer
+    uint16_t segmentRecords;    // HT_TS_SEGMENT_RECORDS of the writer
+    uint32_t tailSeq;           // Sequence number of the open segment
+    uint32_t base;              // Store time minus device clock
+    uint32_t evicted;           // Segments evicted since the store was created
+    uint16_t sealed;            // Entries following the header
+    uint16_t crc;               // HT_Crc16 of the header up to here and of the entries
+} HT_TsIndexHeader;
+
+static HT_TsSegment tsIndex[HT_TS_MAX_SEGMENTS];   // Sealed segments, oldest first
+static uint32_t tsSealed;
+static HT_TsSegment tsTail;                         // Open segment, crc unused
+static uint32_t tsBase;
+static uint32_t tsEvicted;
+static lfs_file_t tsFile;                           // Open segment, appending
+static uint8_t tsFileOpen;
+static uint32_t tsUnsynced;
+static uint8_t tsReady;
+static osMutexId_t tsLock;
+static HT_TimeSeriesStats tsStats;
+
+static void HT_TimeSeries_Name(char *name, uint32_t seq)
+{
+    snprintf(name, TS_NAME_SIZE, HT_TS_SEGMENT_NAME, (unsigned long)seq);
+}
+
+static uint16_t HT_TimeSeries_IndexCrc(const HT_TsIndexHeader *header)
+{
+    return HT_Crc16(HT_Crc16(0xFFFF, header, offsetof(HT_TsIndexHeader, crc)), tsIndex, tsSealed * sizeof(HT_TsSegment));
+}
+
+/**
+ * @brief Rewrites the index; littlefs commits it as a whole at close.
+ */
+static int HT_TimeSeries_SaveIndex(void)
+{
+    HT_TsIndexHeader header = { HT_TS_MAGIC, TS_RECORD_SIZE, HT_TS_SEGMENT_RECORDS, tsTail.seq, tsBase, tsEvicted,
+                                (uint16_t)tsSealed, 0 };
+    lfs_size_t len = tsSealed * sizeof(HT_TsSegment);
+    lfs_file_t file;
+    int err;
+
+    header.crc = HT_TimeSeries_IndexCrc(&header);
+
+    err = LFS_FileOpen(&file, HT_TS_INDEX_PATH, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err < 0)
+        return err;
+
+    if (LFS_FileWrite(&file, &header, sizeof(header)) != (lfs_ssize_t)sizeof(header) ||
+        (len && LFS_FileWrite(&file, tsIndex, len) != (lfs_ssize_t)len))
+        err = LFS_ERR_IO;
+
+    if (LFS_FileClose(&file) < 0 && err == 0)
+        err = LFS_ERR_IO;
+
+    return err;
+}
+
+static int HT_TimeSeries_LoadIndex(void)
+{
+    HT_TsIndexHeader header;
+    lfs_file_t file;
+    int err;
+
+    err = LFS_FileOpen(&file, HT_TS_INDEX_PATH, LFS_O_RDONLY);
+    if (err < 0)
+        return err;
+
+    err = LFS_ERR_CORRUPT;
+    if (LFS_FileRead(&file, &header, sizeof(header)) == (lfs_ssize_t)sizeof(header) &&
+        header.magic == HT_TS_MAGIC && header.recordSize == TS_RECORD_SIZE &&
+        header.segmentRecords == HT_TS_SEGMENT_RECORDS && header.sealed <= HT_TS_MAX_SEGMENTS)
+    {
+        tsSealed = header.sealed;
+        if (LFS_FileRead(&file, tsIndex, tsSealed * sizeof(HT_TsSegment)) == (lfs_ssize_t)(tsSealed * sizeof(HT_TsSegment)) &&
+            header.crc == HT_TimeSeries_IndexCrc(&header))
+        {
+            tsTail.seq = header.tailSeq;
+            tsBase = header.base;
+            tsEvicted = header.evicted;
+            err = 0;
+        }
+    }
+
+    LFS_FileClose(&file);
+    if (err < 0)
+        tsSealed = 0;
+
+    return err;
+}
+
+/**
+ * @brief Reads the records of a closed segment file.
+ * @param seg In: seq. Out: count, first and last timestamps and CRC.
+ * @return 0, or a negative LFS_ERR_* code.
+ */
+static int HT_TimeSeries_Scan(HT_TsSegment *seg)
+{
+    HT_TsRecord chunk[TS_CHUNK_RECORDS];
+    char name[TS_NAME_SIZE];
+    lfs_file_t file;
+    lfs_ssize_t got;
+    int err;
+
+    seg->count = 0;
+    seg->crc = 0xFFFF;
+
+    HT_TimeSeries_Name(name, seg->seq);
+    err = LFS_FileOpen(&file, name, LFS_O_RDONLY);
+    if (err < 0)
+        return err;
+
+    while ((got = LFS_FileRead(&file, chunk, sizeof(chunk))) > 0)
+    {
+        uint32_t n = (uint32_t)got / TS_RECORD_SIZE;
+
+        if (n == 0)
+            break;
+        if (seg->count == 0)
+            seg->first_s = chunk[0].t_s;
+        seg->last_s = chunk[n - 1].t_s;
+        seg->crc = HT_Crc16(seg->crc, chunk, n * TS_RECORD_SIZE);
+        seg->count += n;
+    }
+
+    LFS_FileClose(&file);
+
+    return got < 0 ? (int)got : 0;
+}
+
+/**
+ * @brief Rebuilds the index from the segment files in the root directory:
+ *        the newest one is the open segment, the HT_TS_MAX_SEGMENTS before
+ *        it are read back as sealed ones.
+ */
+static int HT_TimeSeries_Rebuild(void)
+{
+    uint32_t seqs[HT_TS_MAX_SEGMENTS + 1];
+    uint32_t found = 0, seq, i;
+    struct lfs_info info;
+    lfs_dir_t dir;
+    char *end;
+    int err;
+
+    err = LFS_DirOpen(&dir, "/");
+    if (err < 0)
+        return err;
+
+    // The walk order of littlefs is not defined: keep the newest in ascending order
+    while (LFS_DirRead(&dir, &info) > 0)
+    {
+        if (info.type != LFS_TYPE_REG || strncmp(info.name, "ts_", 3) != 0 || strlen(info.name) != TS_NAME_SIZE - 1)
+            continue;
+        seq = strtoul(info.name + 3, &end, 16);
+        if (*end != '\0')
+            continue;
+
+        i = found;
+        if (found == HT_TS_MAX_SEGMENTS + 1)
+        {
+            if (seq < seqs[0])
+                continue;
+            memmove(seqs, seqs + 1, --i * sizeof(seqs[0]));
+        }
+        else
+        {
+            found++;
+        }
+        for (; i > 0 && seqs[i - 1] > seq; i--)
+            seqs[i] = seqs[i - 1];
+        seqs[i] = seq;
+    }
+    LFS_DirClose(&dir);
+
+    tsSealed = 0;
+    tsBase = 0;
+    tsEvicted = 0;
+    tsTail.seq = found ? seqs[found - 1] : 0;
+
+    for (i = 0; i + 1 < found; i++)
+    {
+        tsIndex[tsSealed].seq = seqs[i];
+        if (HT_TimeSeries_Scan(&tsIndex[tsSealed]) == 0 && tsIndex[tsSealed].count > 0)
+            tsSealed++;
+        else
+            tsStats.errors++;
+    }
+
+    HT_LOG(P_WARNING, HT_TimeSeries_Rebuild_1, "Time series index rebuilt: %lu sealed segments, open %lu",
+           (unsigned long)tsSealed, (unsigned long)tsTail.seq);
+
+    return HT_TimeSeries_SaveIndex();
+}
+
+/**
+ * @brief Finds the records of the open segment: its size, first and last record.
+ */
+static int HT_TimeSeries_LoadTail(void)
+{
+    char name[TS_NAME_SIZE];
+    lfs_file_t file;
+    lfs_soff_t size;
+    int err;
+
+    tsTail.count = 0;
+
+    HT_TimeSeries_Name(name, tsTail.seq);
+    err = LFS_FileOpen(&file, name, LFS_O_RDONLY);
+    if (err == LFS_ERR_NOENT)
+        return 0;
+    if (err < 0)
+        return err;
+
+    size = LFS_FileSize(&file);
+    if (size >= (lfs_soff_t)TS_RECORD_SIZE)
+    {
+        HT_TsRecord first, last;
+
+        tsTail.count = (uint16_t)(size / TS_RECORD_SIZE);
+        if (LFS_FileRead(&file, &first, sizeof(first)) != (lfs_ssize_t)sizeof(first) ||
+            LFS_FileSeek(&file, (tsTail.count - 1) * TS_RECORD_SIZE, LFS_SEEK_SET) < 0 ||
+            LFS_FileRead(&file, &last, sizeof(last)) != (lfs_ssize_t)sizeof(last))
+        {
+            err = LFS_ERR_IO;
+        }
+        else
+        {
+            tsTail.first_s = first.t_s;
+            tsTail.last_s = last.t_s;
+        }
+    }
+    LFS_FileClose(&file);
+
+    // Only whole records are ever committed, a trailing fragment is not ours to keep
+    if (err == 0 && size % TS_RECORD_SIZE)
+    {
+        err = LFS_FileOpen(&file, name, LFS_O_WRONLY);
+        if (err == 0)
+        {
+            LFS_FileTruncate(&file, tsTail.count * TS_RECORD_SIZE);
+            err = LFS_FileClose(&file);
+        }
+    }
+
+    return err;
+}
+
+static int HT_TimeSeries_CloseTail(void)
+{
+    int err = 0;
+
+    if (tsFileOpen)
+    {
+        err = LFS_FileClose(&tsFile);
+        tsFileOpen = 0;
+        if (tsUnsynced)
+            tsStats.syncs++;
+        tsUnsynced = 0;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Removes the oldest sealed segment and saves the index.
+ */
+static int HT_TimeSeries_Evict(void)
+{
+    char name[TS_NAME_SIZE];
+    int err;
+
+    // File first: a loss in between leaves an entry without a file, which queries skip
+    HT_TimeSeries_Name(name, tsIndex[0].seq);
+    err = LFS_Remove(name);
+    if (err < 0 && err != LFS_ERR_NOENT)
+        return err;
+
+    HT_LOG(P_WARNING, HT_TimeSeries_Evict_1, "Time series full, evicted segment %lu (%u records)",
+           (unsigned long)tsIndex[0].seq, tsIndex[0].count);
+
+    memmove(tsIndex, tsIndex + 1, (tsSealed - 1) * sizeof(HT_TsSegment));
+    tsSealed--;
+    tsEvicted++;
+
+    return HT_TimeSeries_SaveIndex();
+}
+
+/**
+ * @brief Evicts sealed segments until HT_TS_RESERVE_BLOCKS blocks are free
+ *        beyond the one the next commit takes: littlefs writes the last
+ *        block of the open segment to a fresh one (or starts it).
+ */
+static void HT_TimeSeries_MakeRoom(void)
+{
+    lfs_status_t status;
+
+    while (tsSealed > 0 && LFS_Statfs(&status) == 0 && status.total_block - status.block_used < HT_TS_RESERVE_BLOCKS + 1)
+    {
+        if (HT_TimeSeries_Evict() < 0)
+        {
+            tsStats.errors++;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Closes the full open segment, adds it to the index and starts the next one.
+ */
+static int HT_TimeSeries_Seal(void)
+{
+    HT_TsSegment seg = { .seq = tsTail.seq };
+    int err;
+
+    err = HT_TimeSeries_CloseTail();
+    if (err == 0)
+        err = HT_TimeSeries_Scan(&seg);
+    if (err < 0)
+        return err;
+
+    if (tsSealed == HT_TS_MAX_SEGMENTS && (err = HT_TimeSeries_Evict()) < 0)
+        return err;
+
+    tsIndex[tsSealed++] = seg;
+    tsTail.seq++;
+    tsTail.count = 0;
+
+    err = HT_TimeSeries_SaveIndex();
+    if (err == 0)
+        HT_TimeSeries_MakeRoom();
+
+    return err;
+}
+
+static int HT_TimeSeries_Write(const HT_TsRecord *rec)
+{
+    char name[TS_NAME_SIZE];
+    lfs_ssize_t written;
+    int err;
+
+    if (!tsFileOpen)
+    {
+        HT_TimeSeries_Name(name, tsTail.seq);
+        err = LFS_FileOpen(&tsFile, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+        if (err < 0)
+            return err;
+        tsFileOpen = 1;
+    }
+
+    written = LFS_FileWrite(&tsFile, rec, sizeof(*rec));
+    if (written == (lfs_ssize_t)sizeof(*rec))
+        return 0;
+
+    // The handle is unusable after a failed write: drop it with the uncommitted records
+    LFS_FileClose(&tsFile);
+    tsFileOpen = 0;
+    tsUnsynced = 0;
+
+    return written < 0 ? (int)written : LFS_ERR_IO;
+}
+
+static int HT_TimeSeries_SyncLocked(void)
+{
+    int err = 0;
+
+    if (tsFileOpen && tsUnsynced)
+    {
+        err = LFS_FileSync(&tsFile);
+        tsStats.syncs++;
+        tsUnsynced = 0;
+    }
+
+    return err;
+}
+
+static void HT_TimeSeries_UpdateStats(void)
+{
+    tsStats.segments = tsSealed + (tsTail.count > 0);
+    tsStats.records = tsTail.count;
+    for (uint32_t i = 0; i < tsSealed; i++)
+        tsStats.records += tsIndex[i].count;
+    tsStats.oldest_s = tsSealed ? tsIndex[0].first_s : (tsTail.count ? tsTail.first_s : 0);
+    tsStats.newest_s = tsTail.count ? tsTail.last_s : (tsSealed ? tsIndex[tsSealed - 1].last_s : 0);
+    tsStats.evicted = tsEvicted;
+}
+
+int HT_TimeSeries_Init(void)
+{
+    int err;
+
+    if (tsLock == NULL)
+        tsLock = osMutexNew(NULL);
+
+    osMutexAcquire(tsLock, osWaitForever);
+
+    tsReady = 0;
+    tsFileOpen = 0;
+    tsUnsynced = 0;
+
+    err = HT_TimeSeries_LoadIndex();
+    if (err < 0)
+    {
+        if (err != LFS_ERR_NOENT)
+            tsStats.errors++;
+        err = HT_TimeSeries_Rebuild();
+    }
+    if (err == 0)
+        err = HT_TimeSeries_LoadTail();
+    if (err == 0 && tsTail.count >= HT_TS_SEGMENT_RECORDS)
+        err = HT_TimeSeries_Seal();
+
+    if (err < 0)
+    {
+        tsStats.errors++;
+        HT_LOG(P_ERROR, HT_TimeSeries_Init_1, "Time series unavailable (%d)", err);
+    }
+    else
+    {
+        tsReady = 1;
+        HT_TimeSeries_UpdateStats();
+        HT_LOG(P_INFO, HT_TimeSeries_Init_2, "Time series: %lu records in %lu segments",
+               (unsigned long)tsStats.records, (unsigned long)tsStats.segments);
+    }
+
+    osMutexRelease(tsLock);
+
+    return err;
+}
+
+int HT_TimeSeries_Append(const HT_TsRecord *rec)
+{
+    HT_TsRecord stored = *rec;
+    uint32_t newest;
+    int err;
+
+    if (!tsReady)
+        return LFS_ERR_INVAL;
+
+    osMutexAcquire(tsLock, osWaitForever);
+
+    // A device clock started over must not put the record before the newest one
+    stored.t_s += tsBase;
+    newest = tsStats.newest_s;
+    if (tsStats.records && stored.t_s < newest)
+    {
+        tsBase += newest + 1 - stored.t_s;
+        stored.t_s = newest + 1;
+        if (HT_TimeSeries_SaveIndex() < 0)
+            tsStats.errors++;
+    }
+
+    // First record of a commit: the other files of the partition may have grown since the last one
+    if (tsUnsynced == 0)
+        HT_TimeSeries_MakeRoom();
+
+    err = HT_TimeSeries_Write(&stored);
+    if (err == LFS_ERR_NOSPC && tsSealed > 0)
+    {
+        // The partition filled up under us: the uncommitted records went with the handle
+        tsStats.errors++;
+        if (HT_TimeSeries_LoadTail() == 0 && HT_TimeSeries_Evict() == 0)
+            err = HT_TimeSeries_Write(&stored);
+    }
+
+    if (err < 0)
+    {
+        tsStats.errors++;
+    }
+    else
+    {
+        if (tsTail.count == 0)
+            tsTail.first_s = stored.t_s;
+        tsTail.last_s = stored.t_s;
+        tsTail.count++;
+        tsUnsynced++;
+        tsStats.appends++;
+
+        if (tsTail.count >= HT_TS_SEGMENT_RECORDS)
+            err = HT_TimeSeries_Seal();
+        else if (tsUnsynced >= HT_TS_SYNC_RECORDS)
+            err = HT_TimeSeries_SyncLocked();
+        if (err < 0)
+            tsStats.errors++;
+    }
+
+    HT_TimeSeries_UpdateStats();
+    osMutexRelease(tsLock);
+
+    return err;
+}
+
+int HT_TimeSeries_Sync(void)
+{
+    int err;
+
+    if (!tsReady)
+        return LFS_ERR_INVAL;
+
+    osMutexAcquire(tsLock, osWaitForever);
+    err = HT_TimeSeries_SyncLocked();
+    if (err < 0)
+        tsStats.errors++;
+    osMutexRelease(tsLock);
+
+    return err;
+}
+
+/**
+ * @brief Copies the records of one segment within the range.
+ * @param done Set once a record past to_s is met.
+ * @return Number of records copied.
+ */
+static size_t HT_TimeSeries_QuerySegment(const HT_TsSegment *seg, uint32_t from_s, uint32_t to_s,
+                                         HT_TsRecord *out, size_t max, uint8_t *done)
+{
+    char name[TS_NAME_SIZE];
+    uint32_t lo = 0, hi = seg->count, mid, t, n, chunk, end, kept = 0;
+    lfs_file_t file;
+    lfs_ssize_t got;
+
+    HT_TimeSeries_Name(name, seg->seq);
+    if (LFS_FileOpen(&file, name, LFS_O_RDONLY) < 0)
+    {
+        tsStats.errors++;
+        return 0;
+    }
+
+    // First record at or after from_s
+    while (seg->first_s < from_s && lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (LFS_FileSeek(&file, mid * TS_RECORD_SIZE, LFS_SEEK_SET) < 0 ||
+            LFS_FileRead(&file, &t, sizeof(t)) != (lfs_ssize_t)sizeof(t))
+        {
+            tsStats.errors++;
+            lo = hi = seg->count;
+        }
+        else if (t < from_s)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    n = seg->count - lo;
+    if (n > max)
+        n = (uint32_t)max;
+
+    // A chunk at a time straight into out, up to the first record past to_s
+    if (n && LFS_FileSeek(&file, lo * TS_RECORD_SIZE, LFS_SEEK_SET) >= 0)
+    {
+        while (kept < n && !*done)
+        {
+            chunk = n - kept < TS_CHUNK_RECORDS ? n - kept : TS_CHUNK_RECORDS;
+            got = LFS_FileRead(&file, out + kept, chunk * TS_RECORD_SIZE);
+            if (got != (lfs_ssize_t)(chunk * TS_RECORD_SIZE))
+            {
+                tsStats.errors++;
+                break;
+            }
+            for (end = kept + chunk; kept < end && out[kept].t_s <= to_s; kept++)
+                ;
+            *done = kept < end;
+        }
+    }
+    LFS_FileClose(&file);
+
+    return kept;
+}
+
+size_t HT_TimeSeries_Query(uint32_t from_s, uint32_t to_s, HT_TsRecord *out, size_t max)
+{
+    const HT_TsSegment *seg;
+    size_t copied = 0;
+    uint8_t done = 0;
+
+    if (!tsReady || from_s > to_s)
+        return 0;
+
+    osMutexAcquire(tsLock, osWaitForever);
+
+    // Readers see committed data only
+    if (HT_TimeSeries_SyncLocked() < 0)
+        tsStats.errors++;
+
+    for (uint32_t i = 0; i <= tsSealed && copied < max && !done; i++)
+    {
+        seg = i < tsSealed ? &tsIndex[i] : &tsTail;
+        if (seg->count == 0 || seg->last_s < from_s)
+            continue;
+        if (seg->first_s > to_s)
+            break;
+
+        copied += HT_TimeSeries_QuerySegment(seg, from_s, to_s, out + copied, max - copied, &done);
+    }
+
+    osMutexRelease(tsLock);
+
+    return copied;
+}
+
+/**
+ * @brief Reads n records of a segment from index at on.
+ * @return Number of records read.
+ */
+static uint32_t HT_TimeSeries_ReadAt(const HT_TsSegment *seg, uint32_t at, HT_TsRecord *out, uint32_t n)
+{
+    char name[TS_NAME_SIZE];
+    lfs_file_t file;
+    lfs_ssize_t got = -1;
+
+    HT_TimeSeries_Name(name, seg->seq);
+    if (LFS_FileOpen(&file, name, LFS_O_RDONLY) < 0)
+    {
+        tsStats.errors++;
+        return 0;
+    }
+
+    if (LFS_FileSeek(&file, at * TS_RECORD_SIZE, LFS_SEEK_SET) >= 0)
+        got = LFS_FileRead(&file, out, n * TS_RECORD_SIZE);
+    if (got != (lfs_ssize_t)(n * TS_RECORD_SIZE))
+        tsStats.errors++;
+    LFS_FileClose(&file);
+
+    return got > 0 ? (uint32_t)got / TS_RECORD_SIZE : 0;
+}
+
+size_t HT_TimeSeries_ReadSeq(uint32_t seq, HT_TsRecord *out, size_t max, uint32_t *first)
+{
+    const HT_TsSegment *seg;
+    uint32_t base, at, n, got;
+    size_t copied = 0;
+
+    if (!tsReady)
+        return 0;
+
+    osMutexAcquire(tsLock, osWaitForever);
+
+    // Readers see committed data only
+    if (HT_TimeSeries_SyncLocked() < 0)
+        tsStats.errors++;
+
+    for (uint32_t i = 0; i <= tsSealed && copied < max; i++)
+    {
+        seg = i < tsSealed ? &tsIndex[i] : &tsTail;
+        base = seg->seq * HT_TS_SEGMENT_RECORDS;
+        if (seg->count == 0 || base + seg->count <= seq)
+            continue;
+
+        at = seq > base ? seq - base : 0;
+        if (copied && base + at != *first + copied)
+            break;
+
+        n = seg->count - at;
+        if (n > max - copied)
+            n = (uint32_t)(max - copied);
+        got = HT_TimeSeries_ReadAt(seg, at, out + copied, n);
+
+        // An unreadable segment is skipped as if evicted, a short read ends the run
+        if (got == 0 && copied == 0)
+            continue;
+        if (copied == 0)
+            *first = base + at;
+        copied += got;
+        if (got < n)
+            break;
+    }
+
+    osMutexRelease(tsLock);
+
+    return copied;
+}
+
+uint32_t HT_TimeSeries_NextSeq(void)
+{
+    uint32_t seq;
+
+    if (!tsReady)
+        return 0;
+
+    osMutexAcquire(tsLock, osWaitForever);
+    seq = tsTail.seq * HT_TS_SEGMENT_RECORDS + tsTail.count;
+    osMutexRelease(tsLock);
+
+    return seq;
+}
+
+uint32_t HT_TimeSeries_CountFrom(uint32_t seq)
+{
+    const HT_TsSegment *seg;
+    uint32_t base, count = 0;
+
+    if (!tsReady)
+        return 0;
+
+    osMutexAcquire(tsLock, osWaitForever);
+    for (uint32_t i = 0; i <= tsSealed; i++)
+    {
+        seg = i < tsSealed ? &tsIndex[i] : &tsTail;
+        base = seg->seq * HT_TS_SEGMENT_RECORDS;
+        if (base + seg->count > seq)
+            count += base + seg->count - (seq > base ? seq : base);
+    }
+    osMutexRelease(tsLock);
+
+    return count;
+}
+
+uint32_t HT_TimeSeries_Time(uint32_t clock_s)
+{
+    return clock_s + tsBase;
+}
+
+uint32_t HT_TimeSeries_Verify(void)
+{
+    HT_TsSegment seg;
+    uint32_t bad = 0;
+
+    if (!tsReady)
+        return 0;
+
+    osMutexAcquire(tsLock, osWaitForever);
+
+    for (uint32_t i = 0; i < tsSealed; i++)
+    {
+        seg.seq = tsIndex[i].seq;
+        if (HT_TimeSeries_Scan(&seg) < 0 || seg.count != tsIndex[i].count || seg.crc != tsIndex[i].crc)
+        {
+            HT_LOG(P_ERROR, HT_TimeSeries_Verify_1, "Time series segment %lu corrupted", (unsigned long)seg.seq);
+            bad++;
+        }
+    }
+    tsStats.errors += bad;
+
+    osMutexRelease(tsLock);
+
+    return bad;
+}
+
+const HT_TimeSeriesStats *HT_TimeSeries_Stats(void)
+{
+    return &tsStats;
+}
+
+int HT_TimeSeries_DiagFormat(char *buf, size_t len)
+{
+    return snprintf(buf, len, "\"ts\":{\"seg\":%lu,\"rec\":%lu,\"evict\":%lu,\"err\":%lu}",
+                    (unsigned long)tsStats.segments, (unsigned long)tsStats.records,
+                    (unsigned long)tsStats.evicted, (unsigned long)tsStats.errors);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
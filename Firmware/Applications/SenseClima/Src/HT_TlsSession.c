@@ -0,0 +1,179 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_TlsSession.h"
+#include "HT_Retained.h"
+#include "HT_Log.h"
+#include "HT_MQTT_Tls.h"        // Required for HT_MQTT_TLSArenaGetStats
+#include <stdio.h>
+#include <string.h>
+
+static uint16_t HT_TlsSession_Peer(const char *host, uint16_t port)
+{
+    uint8_t portBytes[2] = { (uint8_t)(port >> 8), (uint8_t)port };
+
+    return HT_Crc16(HT_Crc16(0xFFFF, host, strlen(host)), portBytes, sizeof(portBytes));
+}
+
+static void HT_TlsSession_Drop(HT_TlsSessionState *st)
+{
+    memset(st->session, 0, sizeof(st->session));
+    st->sessionLen = 0;
+    st->kind = HT_TLS_SLOT_SESSION;
+}
+
+/**
+ * @brief Drops what the slot holds unless it belongs to host:port and is still valid.
+ */
+static HT_TlsSessionState *HT_TlsSession_Check(const char *host, uint16_t port)
+{
+    HT_TlsSessionState *st = &HT_Retained_Get()->tls;
+    uint16_t peer = HT_TlsSession_Peer(host, port);
+
+    if (st->sessionLen != 0 && (st->peer != peer || (int32_t)(HT_Retained_Now() - st->expires_s) >= 0))
+    {
+        HT_LOG(P_INFO, HT_TlsSession_Check_1, "TLS session dropped (%u: 0 other peer, 1 expired).", st->peer == peer);
+        HT_TlsSession_Drop(st);
+        HT_Retained_Commit();
+    }
+
+    st->peer = peer;
+
+    return st;
+}
+
+uint8_t *HT_TlsSession_Slot(const char *host, uint16_t port, size_t *len)
+{
+    HT_TlsSessionState *st = HT_TlsSession_Check(host, port);
+
+    if (st->sessionLen != 0 && st->kind != HT_TLS_SLOT_SESSION)
+    {
+        HT_TlsSession_Drop(st);
+        HT_Retained_Commit();
+    }
+
+    *len = st->sessionLen;
+
+    return st->session;
+}
+
+uint8_t *HT_TlsSession_Take(const char *host, uint16_t port, size_t *len, uint8_t *kind)
+{
+    HT_TlsSessionState *st = HT_TlsSession_Check(host, port);
+
+    *len = st->sessionLen;
+    *kind = st->kind;
+    if (st->sessionLen != 0 && st->kind == HT_TLS_SLOT_CONNECTION)
+    {
+        // Spent once loaded: the bytes stay for the caller, the length goes
+        st->sessionLen = 0;
+        st->kind = HT_TLS_SLOT_SESSION;
+        HT_Retained_Commit();
+    }
+
+    return st->session;
+}
+
+void HT_TlsSession_KeepConnection(size_t len)
+{
+    HT_TlsSessionState *st = &HT_Retained_Get()->tls;
+
+    if (len == 0 || len > sizeof(st->session))
+    {
+        HT_LOG(P_WARNING, HT_TlsSession_KeepConnection_1, "DTLS connection not kept, next wake runs a handshake.");
+        HT_TlsSession_Drop(st);
+    }
+    else
+    {
+        memset(st->session + len, 0, sizeof(st->session) - len);
+        st->sessionLen = (uint16_t)len;
+        st->kind = HT_TLS_SLOT_CONNECTION;
+    }
+
+    HT_Retained_Commit();
+}
+
+void HT_TlsSession_Restored(uint8_t lost)
+{
+    HT_TlsSessionState *st = &HT_Retained_Get()->tls;
+
+    st->restored++;
+    if (lost)
+        st->lost++;
+
+    HT_Retained_Commit();
+}
+
+void HT_TlsSession_Record(uint8_t outcome, uint32_t ms, size_t len, uint32_t lifetime_s)
+{
+    HT_TlsSessionState *st = &HT_Retained_Get()->tls;
+
+    switch (outcome)
+    {
+        case HT_TLS_HANDSHAKE_RESUMED:
+            st->resumed++;
+            st->resumed_ms += ms;
+            break;
+        case HT_TLS_HANDSHAKE_REJECTED:
+            st->rejected++;
+            // fall through
+        case HT_TLS_HANDSHAKE_FULL:
+            st->full++;
+            st->full_ms += ms;
+            break;
+        default:
+            st->failed++;
+            break;
+    }
+
+    if (len == 0 || len > sizeof(st->session))
+    {
+        if (outcome != HT_TLS_HANDSHAKE_FAILED)
+            HT_LOG(P_WARNING, HT_TlsSession_Record_1, "TLS session not kept, next connect runs a full handshake.");
+        HT_TlsSession_Drop(st);
+    }
+    else
+    {
+        // The slot was written in place by the handshake, bytes past the new session are stale
+        memset(st->session + len, 0, sizeof(st->session) - len);
+        st->sessionLen = (uint16_t)len;
+        st->kind = HT_TLS_SLOT_SESSION;
+        if (lifetime_s == 0 || lifetime_s > HT_TLS_SESSION_MAX_AGE_S)
+            lifetime_s = HT_TLS_SESSION_MAX_AGE_S;
+        st->expires_s = HT_Retained_Now() + lifetime_s;
+    }
+
+    HT_Retained_Commit();
+}
+
+int HT_TlsSession_DiagFormat(char *buf, size_t len)
+{
+    const HT_TlsSessionState *st = &HT_Retained_Get()->tls;
+    MqttTlsArenaStats arena;
+
+    HT_MQTT_TLSArenaGetStats(&arena);
+
+    return snprintf(buf, len, "\"tls\":{\"full\":%u,\"res\":%u,\"rej\":%u,\"fail\":%u,\"full_ms\":%lu,\"res_ms\":%lu,\"held\":%u,"
+                    "\"rest\":%u,\"lost\":%u,\"arena\":{\"peak\":%lu,\"hs\":%lu,\"frag\":%lu,\"leak\":%u}}",
+                    st->full, st->resumed, st->rejected, st->failed,
+                    (unsigned long)(st->full ? st->full_ms / st->full : 0),
+                    (unsigned long)(st->resumed ? st->resumed_ms / st->resumed : 0),
+                    st->sessionLen != 0 ? st->kind + 1 : 0, st->restored, st->lost,
+                    (unsigned long)arena.peak, (unsigned long)arena.handshakePeak,
+                    (unsigned long)(arena.freeBytes ? 100 - (uint64_t)arena.largestFree * 100 / arena.freeBytes : 0),
+                    arena.leaks);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
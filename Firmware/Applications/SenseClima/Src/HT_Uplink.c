@@ -0,0 +1,274 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Uplink.h"
+#include <stdio.h>
+#include <string.h>
+#include "lfs_port.h"       // Required for LFS_File*
+#include "HT_TimeSeries.h"  // Required for HT_TimeSeries_ReadSeq, HT_TimeSeries_NextSeq
+#include "HT_Retained.h"    // Required for HT_Retained_Now, HT_Crc16
+#include "HT_Log.h"
+
+#define UL_ENTRY_MAX        48      // Longest record entry, with its comma
+
+typedef struct {
+    uint32_t magic;             // HT_UPLINK_MAGIC
+    uint32_t position;          // Sequence number of the oldest record not acknowledged
+    uint16_t reserved;
+    uint16_t crc;               // HT_Crc16 of the fields above
+} HT_UplinkCursor;
+
+static uint32_t ulPosition;
+static uint8_t ulReady;
+static HT_UplinkStats ulStats;
+
+/**
+ * @brief Rewrites the queue position; littlefs commits it as a whole at close.
+ */
+static int HT_Uplink_Save(void)
+{
+    HT_UplinkCursor cursor = { HT_UPLINK_MAGIC, ulPosition, 0, 0 };
+    lfs_file_t file;
+    int err;
+
+    cursor.crc = HT_Crc16(0xFFFF, &cursor, offsetof(HT_UplinkCursor, crc));
+
+    err = LFS_FileOpen(&file, HT_UPLINK_CURSOR_PATH, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+    if (err < 0)
+        return err;
+
+    if (LFS_FileWrite(&file, &cursor, sizeof(cursor)) != (lfs_ssize_t)sizeof(cursor))
+        err = LFS_ERR_IO;
+
+    if (LFS_FileClose(&file) < 0 && err == 0)
+        err = LFS_ERR_IO;
+
+    return err;
+}
+
+static int HT_Uplink_Load(void)
+{
+    HT_UplinkCursor cursor;
+    lfs_file_t file;
+    int err;
+
+    err = LFS_FileOpen(&file, HT_UPLINK_CURSOR_PATH, LFS_O_RDONLY);
+    if (err < 0)
+        return err;
+
+    err = LFS_ERR_CORRUPT;
+    if (LFS_FileRead(&file, &cursor, sizeof(cursor)) == (lfs_ssize_t)sizeof(cursor) && cursor.magic == HT_UPLINK_MAGIC &&
+        cursor.crc == HT_Crc16(0xFFFF, &cursor, offsetof(HT_UplinkCursor, crc)))
+    {
+        ulPosition = cursor.position;
+        err = 0;
+    }
+    LFS_FileClose(&file);
+
+    return err;
+}
+
+/**
+ * @brief Writes a batch of consecutive records, as many as fit the buffer.
+ * @param used Set to the number of records written.
+ * @return Length of the batch, 0 if not even one record fits.
+ */
+static size_t HT_Uplink_Format(const HT_TsRecord *rec, size_t n, uint32_t first, char *buf, size_t len, size_t *used)
+{
+    size_t written;
+    int w;
+
+    *used = 0;
+    w = snprintf(buf, len, "{\"seq\":%lu,\"now\":%lu,\"t\":%lu,\"r\":[", (unsigned long)first,
+                 (unsigned long)HT_TimeSeries_Time(HT_Retained_Now()), (unsigned long)rec[0].t_s);
+    if (w < 0 || (size_t)w >= len)
+        return 0;
+    written = (size_t)w;
+
+    // Room kept for the closing "]}" and the terminator
+    for (size_t i = 0; i < n && written + UL_ENTRY_MAX + 3 <= len; i++)
+    {
+        w = snprintf(buf + written, len - written, "%s[%lu,%d,%u,%u,%u]", i ? "," : "",
+                     (unsigned long)(i ? rec[i].t_s - rec[i - 1].t_s : 0), rec[i].temp, rec[i].humi,
+                     rec[i].vbat_mv, rec[i].flags);
+        if (w < 0 || (size_t)w >= len - written)
+            break;
+        written += (size_t)w;
+        (*used)++;
+    }
+    if (*used == 0)
+        return 0;
+
+    buf[written++] = ']';
+    buf[written++] = '}';
+    buf[written] = '\0';
+
+    return written;
+}
+
+/**
+ * @brief Returns the sequence number of the oldest record stored.
+ */
+static uint32_t HT_Uplink_Oldest(void)
+{
+    HT_TsRecord rec;
+    uint32_t first;
+
+    return HT_TimeSeries_ReadSeq(0, &rec, 1, &first) == 1 ? first : HT_TimeSeries_NextSeq();
+}
+
+int HT_Uplink_Init(void)
+{
+    uint32_t next = HT_TimeSeries_NextSeq();
+    int err;
+
+    ulReady = 0;
+
+    err = HT_Uplink_Load();
+    if (err == LFS_ERR_NOENT)
+    {
+        ulPosition = next;
+        err = HT_Uplink_Save();
+    }
+    else if (err == 0 && ulPosition > next)
+    {
+        // The store started over (segment files lost): send what it holds
+        HT_LOG(P_WARNING, HT_Uplink_Init_1, "Uplink queue position %lu beyond the store (%lu), reset",
+               (unsigned long)ulPosition, (unsigned long)next);
+        ulPosition = HT_Uplink_Oldest();
+        err = HT_Uplink_Save();
+    }
+    else if (err < 0)
+    {
+        // A damaged position file: resending the whole store beats losing part of it
+        HT_LOG(P_ERROR, HT_Uplink_Init_2, "Uplink queue position unreadable (%d), sending the whole store", err);
+        ulPosition = HT_Uplink_Oldest();
+        err = HT_Uplink_Save();
+    }
+
+    if (err < 0)
+    {
+        ulStats.errors++;
+        HT_LOG(P_ERROR, HT_Uplink_Init_3, "Uplink queue unavailable (%d)", err);
+        return err;
+    }
+
+    ulReady = 1;
+    ulStats.position = ulPosition;
+    HT_LOG(P_INFO, HT_Uplink_Init_4, "Uplink queue: %lu readings from %lu",
+           (unsigned long)HT_Uplink_Depth(), (unsigned long)ulPosition);
+
+    return 0;
+}
+
+int HT_Uplink_Prepare(void)
+{
+    return HT_TimeSeries_Sync();
+}
+
+uint32_t HT_Uplink_Drain(HT_UplinkPublish publish, void *ctx, uint32_t maxBatches)
+{
+    static HT_TsRecord batch[HT_UPLINK_BATCH_RECORDS];
+    static char payload[HT_UPLINK_BATCH_MAX];
+    uint32_t acked = 0, first;
+    size_t n, len, used;
+
+    if (!ulReady)
+        return 0;
+
+    for (uint32_t b = 0; b < maxBatches; b++)
+    {
+        n = HT_TimeSeries_ReadSeq(ulPosition, batch, HT_UPLINK_BATCH_RECORDS, &first);
+        if (n == 0)
+            break;
+
+        // Evicted before they could be sent: the position moves with the next acknowledgment
+        if (first != ulPosition)
+        {
+            HT_LOG(P_WARNING, HT_Uplink_Drain_1, "Uplink queue lost %lu readings to eviction",
+                   (unsigned long)(first - ulPosition));
+            ulStats.dropped += first - ulPosition;
+            ulPosition = first;
+        }
+
+        len = HT_Uplink_Format(batch, n, first, payload, sizeof(payload), &used);
+        if (len == 0)
+        {
+            ulStats.errors++;
+            break;
+        }
+
+        // No PUBACK: the session is gone with it, no point in retrying on this wake
+        if (publish((const uint8_t *)payload, len, ctx) != 0)
+        {
+            ulStats.nacks++;
+            HT_LOG(P_WARNING, HT_Uplink_Drain_2, "Uplink batch at %lu not acknowledged, %lu readings left",
+                   (unsigned long)first, (unsigned long)HT_Uplink_Depth());
+            break;
+        }
+
+        // Acknowledged: only now past the batch. Unsaved, the batch goes again next time
+        ulPosition = first + (uint32_t)used;
+        if (HT_Uplink_Save() < 0)
+            ulStats.errors++;
+
+        acked += (uint32_t)used;
+        ulStats.sent += (uint32_t)used;
+        ulStats.batches++;
+    }
+
+    ulStats.position = ulPosition;
+    if (acked)
+        HT_LOG(P_INFO, HT_Uplink_Drain_3, "Uplink queue: %lu readings sent, %lu left",
+               (unsigned long)acked, (unsigned long)HT_Uplink_Depth());
+
+    return acked;
+}
+
+void HT_Uplink_Skip(void)
+{
+    if (!ulReady)
+        return;
+
+    ulPosition = HT_TimeSeries_NextSeq();
+    ulStats.position = ulPosition;
+    if (HT_Uplink_Save() < 0)
+        ulStats.errors++;
+}
+
+uint32_t HT_Uplink_Depth(void)
+{
+    return ulReady ? HT_TimeSeries_CountFrom(ulPosition) : 0;
+}
+
+const HT_UplinkStats *HT_Uplink_Stats(void)
+{
+    return &ulStats;
+}
+
+int HT_Uplink_DiagFormat(char *buf, size_t len)
+{
+    uint32_t depth = HT_Uplink_Depth(), age = 0, first;
+    HT_TsRecord oldest;
+
+    if (depth && HT_TimeSeries_ReadSeq(ulPosition, &oldest, 1, &first) == 1)
+        age = HT_TimeSeries_Time(HT_Retained_Now()) - oldest.t_s;
+
+    return snprintf(buf, len, "\"uplink\":{\"depth\":%lu,\"age_s\":%lu,\"sent\":%lu,\"nack\":%lu,\"drop\":%lu,\"err\":%lu}",
+                    (unsigned long)depth, (unsigned long)age, (unsigned long)ulStats.sent,
+                    (unsigned long)ulStats.nacks, (unsigned long)ulStats.dropped, (unsigned long)ulStats.errors);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -3,6 +3,19 @@
 #include "flash_qcx212.h"
 #include <stdio.h> // Required for printf
 #include <string.h> // Required for strlen, memcpy
+#include "HT_Retained.h" // Required for HT_Retained_Init
+#include "HT_Log.h" // Required for HT_LOG, HT_Log_Init
+#include "HT_Console.h" // Required for HT_Console_Init
+#include "HT_Adc.h" // Required for HT_Adc_Init
+#include "HT_Power.h" // Required for HT_Power_Init
+#include "HT_TimeSeries.h" // Required for HT_TimeSeries_Init
+#include "HT_Uplink.h" // Required for HT_Uplink_Init
+#ifdef HT_SPI_NOR_ENABLE
+#include "HT_SpiNor.h" // Required for HT_SpiNor_Init, HT_SpiNor_Benchmark
+#endif
+#ifdef HT_CRYPTO_BENCH
+#include "HT_CryptoBench.h" // Required for HT_CryptoBench_Run
+#endif
 
 // Global variables
 static StaticTask_t initTask;
@@ -36,7 +49,7 @@ static void HT_SetConnectioParameters(void) {
 
     ret = appSetBandModeSync(networkMode, bandNum, &band);
     if(ret == CMS_RET_SUCC) {
-        printf("SetBand Result: %d\n", ret);
+        HT_LOG(P_INFO, HT_SetConnectioParameters_1, "SetBand Result: %d", ret);
     }
 
     apnSetting.cid = 0;
@@ -156,15 +169,59 @@ static void HT_SenseClimaTask(void *arg){
     slpManPlatVoteDisableSleep(mqttEpSlpHandler, SLP_ACTIVE_STATE); // Set sleep state to active
     HT_TRACE(UNILOG_MQTT, mqttAppTask1, P_INFO, 0, "SenseClima application task started for the first time."); // Removed duplicate `first time run mqtt example` message by making it SenseClima specific.
 
+#ifndef HT_PRODUCTION
     HAL_USART_InitPrint(&huart1, GPR_UART1ClkSel_26M, uart_cntrl, 115200);
-    printf("HTNB32L-XXX SenseClima Device Initialized!\n");
-    printf("Trying to connect...\n");
-    while(!simReady);
+#endif
+    HT_Log_Init(); // Opens the flash log ring and tags the log stream with the ID database version.
+    HT_LOG(P_SIG, HT_SenseClimaTask_1, "HTNB32L-XXX SenseClima Device Initialized!");
+    HT_Retained_Init(); // Restore configuration and controller state kept across hibernate.
+    HT_Power_Init(); // Log verbosity of the battery tier.
+#ifndef HT_PRODUCTION
+    HT_Console_Init(); // Command line on the print UART, DMA receive.
+#endif
+    HT_Adc_Init(); // Battery and die temperature channels, efuse calibration.
+    HT_TimeSeries_Init(); // Reading history on the littlefs partition, mounted by the SDK at boot.
+    HT_Uplink_Init(); // Queue position of the readings not yet acknowledged by the broker.
+
+#ifdef HT_SPI_NOR_ENABLE
+    if (HT_SpiNor_Init() == HT_SPI_NOR_OK)
+    {
+#ifdef HT_SPI_NOR_BENCH
+        HT_SpiNor_Benchmark(HT_SPI_NOR_BENCH_ADDR, HT_SPI_NOR_BENCH_LEN, NULL);
+#endif
+    }
+#endif
+
+#ifdef HT_CRYPTO_BENCH
+    HT_CryptoBench_Run(NULL);
+#endif
+
+    if (!HT_SenseClima_SampleWake())
+    {
+        HT_LOG(P_INFO, HT_SenseClimaTask_2, "No upload due, radio stays off.");
+        sleepWithMode(SLP_HIB_STATE); // Does not return.
+    }
+
+    HT_SenseClima_ConnectStart(); // SIM, attach and broker share the connect_s budget.
+    appSetCFUN(1); // The modem was left at minimum functionality before sleep.
+    HT_LOG(P_INFO, HT_SenseClimaTask_3, "Trying to connect...");
+    while (!simReady)
+    {
+        if (HT_SenseClima_ConnectLeftMs() == 0)
+            HT_SenseClima_Offline(); // Does not return.
+        osDelay(100);
+    }
     HT_SetConnectioParameters();
 
     while (1)
     {
-        if (xQueueReceive(psEventQueueHandle, &queueItem, portMAX_DELAY))
+        // No bearer within the budget: back to sleep, the readings wait in the uplink queue
+        if (!xQueueReceive(psEventQueueHandle, &queueItem, pdMS_TO_TICKS(HT_SenseClima_ConnectLeftMs())))
+        {
+            HT_LOG(P_WARNING, HT_SenseClimaTask_4, "No IP bearer within the connection budget.");
+            HT_SenseClima_Offline(); // Does not return.
+        }
+        else
         {
             switch(queueItem->messageId)
             {
@@ -0,0 +1,108 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# file: bench_compare.py
+# brief: Compares two runs of a host bench that prints one JSON object per line
+#        (Applications/SenseClima/Host tls_bench) and lists the regressions.
+#        Lines are matched on their text fields (bench, config, mode, suite)
+#        and record size. Times (_us, _cycles, cycles_per_byte) and rates (_MBps)
+#        may move by --tolerance percent, host noise; anything else (heap,
+#        bytes, round trips) comes from a deterministic run and must not grow.
+#        Exits 1 on a regression, an error line or a measurement gone missing.
+# usage: python bench_compare.py baseline.json build/tls_bench.json
+#        python bench_compare.py --tolerance 20 baseline.json build/tls_bench.json
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import json
+import sys
+
+KEY_NUMBERS = ("record",)
+IGNORED = ("runs", "records", "handshake_us_min", "handshake_us_max", "arena")
+TIMED = ("_us", "_cycles", "cycles_per_byte", "_MBps")
+
+
+def load(path):
+    lines = {}
+    with open(path) as f:
+        for number, text in enumerate(f, 1):
+            text = text.strip()
+            if not text.startswith("{"):
+                continue
+            try:
+                line = json.loads(text)
+            except ValueError:
+                sys.stderr.write("bench_compare: {}:{}: not JSON\n".format(path, number))
+                continue
+            key = tuple((k, v) for k, v in line.items() if isinstance(v, str) or k in KEY_NUMBERS)
+            lines[key] = line
+    return lines
+
+
+def describe(key):
+    return " ".join(str(v) for k, v in key if k != "bench")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Lists the regressions between two host bench runs.")
+    parser.add_argument("baseline", help="JSON lines of the reference run")
+    parser.add_argument("current", help="JSON lines of the run to check")
+    parser.add_argument("--tolerance", type=float, default=10.0, help="percent times and rates may move")
+    args = parser.parse_args()
+
+    try:
+        baseline, current = load(args.baseline), load(args.current)
+    except OSError as e:
+        sys.stderr.write("bench_compare: error: {}\n".format(e))
+        return 2
+
+    regressions = 0
+    for key, line in current.items():
+        if "error" in line:
+            print("ERROR   {}: ret {}".format(describe(key), line.get("ret")))
+            regressions += 1
+    for key, old in baseline.items():
+        new = current.get(key)
+        if new is None:
+            print("MISSING {}".format(describe(key)))
+            regressions += 1
+            continue
+        for field, was in old.items():
+            now = new.get(field)
+            if field in IGNORED or field in KEY_NUMBERS or not isinstance(was, (int, float)) or \
+                    not isinstance(now, (int, float)):
+                continue
+            limit = args.tolerance if any(field.endswith(t) for t in TIMED) else 0.0
+            pct = (now - was) * 100.0 / was if was else (100.0 if now > was else 0.0)
+            # Rates regress downwards, everything else upwards
+            worse = -pct if field.endswith("_MBps") else pct
+            if worse > limit:
+                print("WORSE   {} {}: {} -> {} ({:+.1f}%)".format(describe(key), field, was, now, pct))
+                regressions += 1
+            elif worse < -limit:
+                print("better  {} {}: {} -> {} ({:+.1f}%)".format(describe(key), field, was, now, pct))
+
+    print("{} regression{}".format(regressions, "" if regressions == 1 else "s"))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
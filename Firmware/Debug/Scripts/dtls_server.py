@@ -0,0 +1,579 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+
+# file: dtls_server.py
+# brief: Local stand-in for the DTLS server of the HT_DTLS transport (Inc/HT_Dtls.h),
+#        to try connection restore across hibernate without a cloud server.
+#        DTLS 1.2, PSK-AES128-CCM8 only, with the Connection ID extension as
+#        mbedtls 2.23 implements it (draft 05: extension 254, content type 25),
+#        which no stock server speaks: OpenSSL has no CID, hence this script.
+#        Pure Python, no package needed, AES included.
+#        Every application datagram is echoed back. Connections are found by
+#        CID, so a device that wakes behind a new NAT binding or source port
+#        keeps its connection: the JSON line of that datagram shows the new
+#        address with "rebind": true and no handshake before it.
+#        --forget drops each connection after its reply, as a server that lost
+#        its state would: the device must time out, resume its session and
+#        resend. --no-cid ignores the extension: the device keeps its session
+#        and resumes it at every wake. --hello-verify adds the cookie exchange.
+#        Also answers plain DTLS 1.2 PSK clients, e.g.
+#        openssl s_client -dtls1_2 -psk 53656e7365436c696d612d6465763031 \
+#            -psk_identity SIP_HTNB32L-XXX -cipher PSK-AES128-CCM8 -connect 127.0.0.1:5684
+# usage: python dtls_server.py --port 5684
+#        python dtls_server.py --psk-identity SIP_HTNB32L-0001 --psk 000102030405060708090a0b0c0d0e0f
+#        python dtls_server.py --forget --hello-verify --count 3
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import binascii
+import hashlib
+import hmac
+import json
+import os
+import socket
+import sys
+import time
+
+CONTENT_CCS = 20
+CONTENT_ALERT = 21
+CONTENT_HANDSHAKE = 22
+CONTENT_APPLICATION = 23
+CONTENT_CID = 25
+DTLS_1_2 = b"\xfe\xfd"
+DTLS_1_0 = b"\xfe\xff"
+RECORD_HEADER = 13
+
+HS_CLIENT_HELLO = 1
+HS_SERVER_HELLO = 2
+HS_HELLO_VERIFY_REQUEST = 3
+HS_SERVER_HELLO_DONE = 14
+HS_CLIENT_KEY_EXCHANGE = 16
+HS_FINISHED = 20
+HS_HEADER = 12
+
+EXT_RENEGOTIATION_INFO = 0xFF01
+EXT_CID = 254                   # MBEDTLS_TLS_EXT_CID, draft-ietf-tls-dtls-connection-id-05
+SCSV_RENEGOTIATION = 0x00FF
+PSK_WITH_AES_128_CCM_8 = 0xC0A8
+
+ALERT_CLOSE_NOTIFY = 0
+ALERT_HANDSHAKE_FAILURE = 40
+ALERT_DECRYPT_ERROR = 51
+ALERT_UNKNOWN_PSK_IDENTITY = 115
+
+CID_LEN = 4                     # CIDs handed out; the device takes up to MBEDTLS_SSL_CID_OUT_LEN_MAX
+TAG_LEN = 8                     # CCM_8
+EXPLICIT_NONCE = 8
+
+# Development credentials of Src/HT_Psk.c, what a device with a blank efuse sends
+DEV_IDENTITY = "SIP_HTNB32L-XXX"
+DEV_KEY = "53656e7365436c696d612d6465763031"
+
+
+# AES-128, encryption only: CCM never runs the inverse cipher
+
+def _xtime(a):
+    return ((a << 1) ^ 0x1B) & 0xFF if a & 0x80 else a << 1
+
+
+def _sbox():
+    box, p, q = [0] * 256, 1, 1
+    box[0] = 0x63
+    while True:
+        p = p ^ _xtime(p)
+        q ^= q << 1
+        q ^= q << 2
+        q ^= q << 4
+        q &= 0xFF
+        if q & 0x80:
+            q ^= 0x09
+        r = q ^ ((q << 1 | q >> 7) & 0xFF) ^ ((q << 2 | q >> 6) & 0xFF) ^ ((q << 3 | q >> 5) & 0xFF) ^ ((q << 4 | q >> 4) & 0xFF)
+        box[p] = r ^ 0x63
+        if p == 1:
+            return box
+
+
+SBOX = _sbox()
+
+
+class Aes128:
+    def __init__(self, key):
+        words = [list(key[i:i + 4]) for i in range(0, 16, 4)]
+        rcon = 1
+        for i in range(4, 44):
+            w = list(words[i - 1])
+            if i % 4 == 0:
+                w = [SBOX[b] for b in w[1:] + w[:1]]
+                w[0] ^= rcon
+                rcon = _xtime(rcon)
+            words.append([a ^ b for a, b in zip(words[i - 4], w)])
+        self.round_keys = [sum(words[4 * r:4 * r + 4], []) for r in range(11)]
+
+    def encrypt(self, block):
+        s = [a ^ b for a, b in zip(block, self.round_keys[0])]
+        for r in range(1, 11):
+            s = [SBOX[b] for b in s]
+            s = [s[(i + 4 * (i % 4)) % 16] for i in range(16)]     # ShiftRows, column-major state
+            if r != 10:
+                mixed = []
+                for c in range(4):
+                    a = s[4 * c:4 * c + 4]
+                    t = a[0] ^ a[1] ^ a[2] ^ a[3]
+                    mixed += [a[i] ^ t ^ _xtime(a[i] ^ a[(i + 1) % 4]) for i in range(4)]
+                s = mixed
+            s = [a ^ b for a, b in zip(s, self.round_keys[r])]
+        return bytes(s)
+
+
+def _ccm_blocks(aes, nonce, aad, data):
+    # CBC-MAC over B0, the encoded additional data and the payload (RFC 3610, L = 15 - len(nonce))
+    q = 15 - len(nonce)
+    flags = (0x40 if aad else 0) | ((TAG_LEN - 2) // 2) << 3 | (q - 1)
+    mac = aes.encrypt(bytes([flags]) + nonce + len(data).to_bytes(q, "big"))
+    encoded = len(aad).to_bytes(2, "big") + aad if aad else b""
+    for chunk in (encoded, data):
+        chunk += b"\x00" * (-len(chunk) % 16)
+        for i in range(0, len(chunk), 16):
+            mac = aes.encrypt(bytes(a ^ b for a, b in zip(mac, chunk[i:i + 16])))
+    return mac[:TAG_LEN]
+
+
+def _ccm_ctr(aes, nonce, data):
+    q = 15 - len(nonce)
+    out = bytearray()
+    for i in range(0, len(data), 16):
+        stream = aes.encrypt(bytes([q - 1]) + nonce + (i // 16 + 1).to_bytes(q, "big"))
+        out += bytes(a ^ b for a, b in zip(data[i:i + 16], stream))
+    return bytes(out)
+
+
+def ccm_encrypt(aes, nonce, aad, plaintext):
+    tag = _ccm_blocks(aes, nonce, aad, plaintext)
+    s0 = aes.encrypt(bytes([14 - len(nonce)]) + nonce + bytes(15 - len(nonce)))
+    return _ccm_ctr(aes, nonce, plaintext) + bytes(a ^ b for a, b in zip(tag, s0))
+
+
+def ccm_decrypt(aes, nonce, aad, ciphertext):
+    if len(ciphertext) < TAG_LEN:
+        return None
+    plaintext = _ccm_ctr(aes, nonce, ciphertext[:-TAG_LEN])
+    s0 = aes.encrypt(bytes([14 - len(nonce)]) + nonce + bytes(15 - len(nonce)))
+    tag = bytes(a ^ b for a, b in zip(_ccm_blocks(aes, nonce, aad, plaintext), s0))
+    return plaintext if hmac.compare_digest(tag, ciphertext[-TAG_LEN:]) else None
+
+
+def prf(secret, label, seed, length):
+    # TLS 1.2 PRF, P_SHA256
+    seed = label + seed
+    out, a = b"", seed
+    while len(out) < length:
+        a = hmac.new(secret, a, hashlib.sha256).digest()
+        out += hmac.new(secret, a + seed, hashlib.sha256).digest()
+    return out[:length]
+
+
+def vector(data, size):
+    return len(data).to_bytes(size, "big") + data
+
+
+def extensions(body, pos):
+    # (type, data) of the extension block starting at pos, nothing if there is none
+    if pos + 2 > len(body):
+        return
+    end = min(len(body), pos + 2 + (body[pos] << 8 | body[pos + 1]))
+    pos += 2
+    while pos + 4 <= end:
+        ext_len = body[pos + 2] << 8 | body[pos + 3]
+        yield body[pos] << 8 | body[pos + 1], body[pos + 4:pos + 4 + ext_len]
+        pos += 4 + ext_len
+
+
+def parse_client_hello(body):
+    hello = {"random": body[2:34]}
+    pos = 34
+    hello["session_id"] = body[pos + 1:pos + 1 + body[pos]]
+    pos += 1 + body[pos]
+    hello["cookie"] = body[pos + 1:pos + 1 + body[pos]]
+    pos += 1 + body[pos]
+    suites_len = body[pos] << 8 | body[pos + 1]
+    hello["suites"] = [body[i] << 8 | body[i + 1] for i in range(pos + 2, pos + 2 + suites_len, 2)]
+    pos += 2 + suites_len
+    pos += 1 + body[pos]
+    hello["extensions"] = dict(extensions(body, pos))
+    return hello
+
+
+class Connection:
+    # One client: handshake state, then the epoch 1 keys. Found by CID once it has one
+
+    def __init__(self, server, addr):
+        self.server = server
+        self.addr = addr
+        self.cid = b""                  # Ours: the client puts it in every record it encrypts
+        self.peer_cid = b""             # The client's: empty for the device, its socket is connected
+        self.established = False
+        self.write_encrypted = False    # After our ChangeCipherSpec
+        self.resumed = False
+        self.session_id = b""
+        self.master = None
+        self.transcript = b""
+        self.send_msg_seq = 0
+        self.recv_msg_seq = 0
+        self.send_seq = [0, 0]          # Per epoch
+        self.read_epoch = 0
+        self.window_top = -1            # Anti-replay: highest epoch 1 sequence number seen
+        self.window = 0                 # Bit i: window_top - i seen
+        self.last_flight = []
+        self.client_random = self.server_random = b""
+        self.keys = None
+        self.datagrams = 0
+        self.handshakes = 0
+
+    # Records
+
+    def record(self, content, payload):
+        epoch = 1 if self.keys is not None and content != CONTENT_CCS and self.write_encrypted else 0
+        seq = self.send_seq[epoch]
+        self.send_seq[epoch] += 1
+        ctr = epoch.to_bytes(2, "big") + seq.to_bytes(6, "big")
+        if epoch == 0:
+            return bytes([content]) + DTLS_1_2 + ctr + vector(payload, 2)
+        nonce = self.keys["server_iv"] + ctr
+        if self.peer_cid:
+            inner = payload + bytes([content])
+            aad = ctr + bytes([CONTENT_CID]) + DTLS_1_2 + self.peer_cid + bytes([len(self.peer_cid)]) + len(inner).to_bytes(2, "big")
+            sealed = ctr + ccm_encrypt(self.keys["server"], nonce, aad, inner)
+            return bytes([CONTENT_CID]) + DTLS_1_2 + ctr + self.peer_cid + vector(sealed, 2)
+        aad = ctr + bytes([content]) + DTLS_1_2 + len(payload).to_bytes(2, "big")
+        sealed = ctr + ccm_encrypt(self.keys["server"], nonce, aad, payload)
+        return bytes([content]) + DTLS_1_2 + ctr + vector(sealed, 2)
+
+    def open(self, content, ctr, cid, sealed):
+        # Plaintext and real content type of an epoch 1 record, None if it does not authenticate
+        if self.keys is None or len(sealed) < EXPLICIT_NONCE + TAG_LEN:
+            return None, None
+        nonce = self.keys["client_iv"] + sealed[:EXPLICIT_NONCE]
+        body = sealed[EXPLICIT_NONCE:]
+        plain_len = len(body) - TAG_LEN
+        if content == CONTENT_CID:
+            aad = ctr + bytes([CONTENT_CID]) + DTLS_1_2 + cid + bytes([len(cid)]) + plain_len.to_bytes(2, "big")
+        else:
+            aad = ctr + bytes([content]) + DTLS_1_2 + plain_len.to_bytes(2, "big")
+        plain = ccm_decrypt(self.keys["client"], nonce, aad, body)
+        if plain is None or content != CONTENT_CID:
+            return plain, content
+        # DTLSInnerPlaintext: content, real type, zero padding
+        plain = plain.rstrip(b"\x00")
+        if not plain:
+            return None, None
+        return plain[:-1], plain[-1]
+
+    def fresh(self, seq):
+        # RFC 6347 4.1.2.6 sliding window; also tells whether the record is the newest yet
+        if seq > self.window_top:
+            self.window = (self.window << (seq - self.window_top) | 1) & ((1 << 64) - 1) if self.window_top >= 0 else 1
+            self.window_top = seq
+            return True, True
+        offset = self.window_top - seq
+        if offset >= 64 or self.window >> offset & 1:
+            return False, False
+        self.window |= 1 << offset
+        return True, False
+
+    # Handshake
+
+    def message(self, kind, body):
+        msg = bytes([kind]) + len(body).to_bytes(3, "big") + self.send_msg_seq.to_bytes(2, "big") + \
+            bytes(3) + len(body).to_bytes(3, "big") + body
+        self.send_msg_seq += 1
+        return msg
+
+    def flight(self, records):
+        self.last_flight = records
+        self.server.send(self, records)
+
+    def derive_keys(self):
+        block = prf(self.master, b"key expansion", self.server_random + self.client_random, 40)
+        self.keys = {"client": Aes128(block[0:16]), "server": Aes128(block[16:32]),
+                     "client_iv": block[32:36], "server_iv": block[36:40]}
+
+    def finished(self, label):
+        return prf(self.master, label, hashlib.sha256(self.transcript).digest(), 12)
+
+    def client_hello(self, msg, body):
+        args = self.server.args
+        hello = parse_client_hello(body)
+        if args.hello_verify and not hmac.compare_digest(hello["cookie"], self.server.cookie(self.addr)):
+            # Not part of the transcript; the client repeats its ClientHello with the cookie
+            hvr = self.message(HS_HELLO_VERIFY_REQUEST, DTLS_1_0 + vector(self.server.cookie(self.addr), 1))
+            self.transcript = b""
+            self.flight([self.record(CONTENT_HANDSHAKE, hvr)])
+            return
+        if PSK_WITH_AES_128_CCM_8 not in hello["suites"]:
+            self.server.alert(self, ALERT_HANDSHAKE_FAILURE)
+            return
+
+        self.write_encrypted = False
+        self.keys = None
+        self.read_epoch = 0
+        self.window_top, self.window = -1, 0
+        self.send_seq[1] = 0
+        self.handshakes += 1
+        self.client_random = hello["random"]
+        self.server_random = int(time.time()).to_bytes(4, "big") + os.urandom(28)
+        self.transcript = msg
+
+        exts = b""
+        if EXT_RENEGOTIATION_INFO in hello["extensions"] or SCSV_RENEGOTIATION in hello["suites"]:
+            exts += EXT_RENEGOTIATION_INFO.to_bytes(2, "big") + vector(b"\x00", 2)
+        self.peer_cid, self.cid = b"", b""
+        if EXT_CID in hello["extensions"] and not args.no_cid:
+            data = hello["extensions"][EXT_CID]
+            self.peer_cid = data[1:1 + data[0]]
+            self.cid = self.server.new_cid()
+            exts += EXT_CID.to_bytes(2, "big") + vector(vector(self.cid, 1), 2)
+
+        cached = self.server.sessions.get(bytes(hello["session_id"])) if hello["session_id"] else None
+        self.resumed = cached is not None
+        self.session_id = bytes(hello["session_id"]) if cached else os.urandom(32)
+        server_hello = self.message(HS_SERVER_HELLO, DTLS_1_2 + self.server_random + vector(self.session_id, 1) +
+                                    PSK_WITH_AES_128_CCM_8.to_bytes(2, "big") + b"\x00" + vector(exts, 2))
+        self.transcript += server_hello
+        if self.resumed:
+            # Abbreviated: ServerHello, ChangeCipherSpec, Finished, then the client's
+            self.master = cached
+            self.derive_keys()
+            fin = self.message(HS_FINISHED, self.finished(b"server finished"))
+            self.transcript += fin
+            records = [self.record(CONTENT_HANDSHAKE, server_hello), self.record(CONTENT_CCS, b"\x01")]
+            self.write_encrypted = True
+            records.append(self.record(CONTENT_HANDSHAKE, fin))
+            self.flight(records)
+        else:
+            done = self.message(HS_SERVER_HELLO_DONE, b"")
+            self.transcript += done
+            self.flight([self.record(CONTENT_HANDSHAKE, server_hello + done)])
+
+    def client_key_exchange(self, msg, body):
+        identity = bytes(body[2:2 + (body[0] << 8 | body[1])])
+        psk = self.server.psk.get(identity)
+        if psk is None:
+            self.server.alert(self, ALERT_UNKNOWN_PSK_IDENTITY)
+            return
+        pms = vector(bytes(len(psk)), 2) + vector(psk, 2)
+        self.master = prf(pms, b"master secret", self.client_random + self.server_random, 48)
+        self.derive_keys()
+        self.transcript += msg
+
+    def client_finished(self, msg, body):
+        label = b"client finished"
+        if not hmac.compare_digest(bytes(body), self.finished(label)):
+            self.server.alert(self, ALERT_DECRYPT_ERROR)
+            return
+        self.transcript += msg
+        if not self.resumed:
+            fin = self.message(HS_FINISHED, self.finished(b"server finished"))
+            records = [self.record(CONTENT_CCS, b"\x01")]
+            self.write_encrypted = True
+            records.append(self.record(CONTENT_HANDSHAKE, fin))
+            self.flight(records)
+        self.established = True
+        self.server.sessions[self.session_id] = self.master
+        self.server.established(self)
+
+    def handshake(self, data):
+        # Messages of one record, unfragmented: nothing the device sends comes near the MTU
+        pos = 0
+        while pos + HS_HEADER <= len(data):
+            kind = data[pos]
+            length = int.from_bytes(data[pos + 1:pos + 4], "big")
+            msg_seq = data[pos + 4] << 8 | data[pos + 5]
+            msg = bytes(data[pos:pos + HS_HEADER + length])
+            body = msg[HS_HEADER:]
+            pos += HS_HEADER + length
+            if msg_seq < self.recv_msg_seq:
+                # Retransmitted flight: ours was lost
+                if self.last_flight:
+                    self.server.send(self, self.last_flight)
+                return
+            self.recv_msg_seq = msg_seq + 1
+            if kind == HS_CLIENT_HELLO:
+                self.send_msg_seq = msg_seq
+                self.client_hello(msg, body)
+            elif kind == HS_CLIENT_KEY_EXCHANGE:
+                self.client_key_exchange(msg, body)
+            elif kind == HS_FINISHED:
+                self.client_finished(msg, body)
+
+
+class Server:
+    def __init__(self, args, sock):
+        self.args = args
+        self.sock = sock
+        self.psk = {args.psk_identity.encode(): binascii.unhexlify(args.psk)}
+        self.cookie_secret = os.urandom(32)
+        self.sessions = {}              # Session ID -> master secret, for resumption
+        self.by_cid = {}
+        self.by_addr = {}
+        self.replies = 0
+
+    def cookie(self, addr):
+        return hmac.new(self.cookie_secret, "{}:{}".format(*addr).encode(), hashlib.sha256).digest()[:16]
+
+    def new_cid(self):
+        while True:
+            cid = os.urandom(CID_LEN)
+            if cid not in self.by_cid:
+                return cid
+
+    def send(self, conn, records):
+        self.sock.sendto(b"".join(records), conn.addr)
+
+    def alert(self, conn, description):
+        self.send(conn, [conn.record(CONTENT_ALERT, bytes([2, description]))])
+        self.report({"event": "alert", "addr": "{}:{}".format(*conn.addr), "alert": description})
+        self.forget(conn)
+
+    def report(self, line):
+        print(json.dumps(line), flush=True)
+
+    def established(self, conn):
+        if conn.cid:
+            self.by_cid[conn.cid] = conn
+        self.report({"event": "handshake", "addr": "{}:{}".format(*conn.addr), "resumed": conn.resumed,
+                     "cid": conn.cid.hex(), "session": conn.session_id[:4].hex()})
+
+    def forget(self, conn):
+        self.by_cid.pop(conn.cid, None)
+        if self.by_addr.get(conn.addr) is conn:
+            del self.by_addr[conn.addr]
+
+    def application(self, conn, data, rebind):
+        conn.datagrams += 1
+        self.report({"event": "data", "addr": "{}:{}".format(*conn.addr), "cid": conn.cid.hex(), "bytes": len(data),
+                     "rebind": rebind, "handshakes": conn.handshakes, "datagrams": conn.datagrams})
+        conn.handshakes = 0
+        self.send(conn, [conn.record(CONTENT_APPLICATION, data)])
+        self.replies += 1
+        if self.args.forget:
+            self.forget(conn)
+
+    def datagram(self, data, addr):
+        pos = 0
+        while pos + RECORD_HEADER <= len(data):
+            content = data[pos]
+            ctr = data[pos + 3:pos + 11]
+            epoch = ctr[0] << 8 | ctr[1]
+            cid = b""
+            header = RECORD_HEADER
+            if content == CONTENT_CID:
+                cid = bytes(data[pos + 11:pos + 11 + CID_LEN])
+                header += CID_LEN
+            length = data[pos + header - 2] << 8 | data[pos + header - 1]
+            payload = data[pos + header:pos + header + length]
+            pos += header + length
+
+            # CID records find their connection wherever they come from; the client's
+            # Finished comes before the CID is registered, from the handshake address
+            conn = self.by_cid.get(cid) if cid else None
+            if conn is None:
+                conn = self.by_addr.get(addr)
+            if conn is not None and conn.established and content == CONTENT_HANDSHAKE and epoch == 0 \
+                    and payload[:1] == bytes([HS_CLIENT_HELLO]):
+                # A new handshake from the address of an established connection
+                self.forget(conn)
+                conn = None
+            if conn is None:
+                if content != CONTENT_HANDSHAKE or epoch != 0:
+                    # Unknown CID or address: dropped silently, as RFC 9146 asks
+                    self.report({"event": "dropped", "addr": "{}:{}".format(*addr), "cid": cid.hex()})
+                    continue
+                conn = Connection(self, addr)
+                self.by_addr[addr] = conn
+
+            if epoch == 0:
+                if content == CONTENT_HANDSHAKE:
+                    conn.addr = addr
+                    self.by_addr[addr] = conn
+                    conn.handshake(payload)
+                elif content == CONTENT_CCS:
+                    conn.read_epoch = 1
+                continue
+
+            plain, inner = conn.open(content, bytes(ctr), cid, bytes(payload))
+            if plain is None:
+                continue
+            seq = int.from_bytes(ctr[2:], "big")
+            fresh, newest = conn.fresh(seq)
+            if not fresh:
+                continue
+            rebind = addr != conn.addr
+            if rebind and newest:
+                # Only the newest record moves the connection (RFC 9146, section 6)
+                if self.by_addr.get(conn.addr) is conn:
+                    del self.by_addr[conn.addr]
+                conn.addr = addr
+                self.by_addr[addr] = conn
+            if inner == CONTENT_HANDSHAKE:
+                conn.handshake(plain)
+            elif inner == CONTENT_APPLICATION and conn.established:
+                self.application(conn, plain, rebind and newest)
+            elif inner == CONTENT_ALERT and len(plain) == 2:
+                self.report({"event": "alert", "addr": "{}:{}".format(*conn.addr), "alert": plain[1]})
+                if plain[1] == ALERT_CLOSE_NOTIFY or plain[0] == 2:
+                    self.forget(conn)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local DTLS 1.2 server stand-in with Connection ID.")
+    parser.add_argument("--host", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--port", type=int, default=5684, help="UDP port to listen on (HT_DTLS_PORT)")
+    parser.add_argument("--psk", default=DEV_KEY, help="pre-shared key, hex (default: the development key)")
+    parser.add_argument("--psk-identity", default=DEV_IDENTITY, help="PSK identity the client must send")
+    parser.add_argument("--no-cid", action="store_true", help="ignore the Connection ID extension")
+    parser.add_argument("--hello-verify", action="store_true", help="send a HelloVerifyRequest cookie first")
+    parser.add_argument("--forget", action="store_true", help="drop each connection after its first reply")
+    parser.add_argument("--count", type=int, default=0, help="exit after this many replies")
+    args = parser.parse_args()
+
+    try:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.bind((args.host, args.port))
+        server = Server(args, sock)
+    except (ValueError, OSError, binascii.Error) as e:
+        sys.stderr.write("dtls_server: error: {}\n".format(e))
+        return 1
+
+    sys.stderr.write("dtls_server: listening on {}:{}\n".format(args.host, args.port))
+    try:
+        while not args.count or server.replies < args.count:
+            data, addr = sock.recvfrom(4096)
+            server.datagram(data, addr)
+        return 0
+    except KeyboardInterrupt:
+        return 0
+    finally:
+        sock.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
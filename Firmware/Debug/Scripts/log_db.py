@@ -0,0 +1,157 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# file: log_db.py
+# brief: Collects HT_LOG format strings into the tokenized log database.
+#        Generates HT_Log_Ids.h (message IDs and database version) and a JSON
+#        database consumed by log_decode.py. Run by the application Makefile
+#        before compiling; the header is only rewritten when it changes.
+# usage: python log_db.py --src Src --header Build/HT_Log_Ids.h --db Build/log_db.json
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+import zlib
+
+MAX_ARGS = 8
+LEVELS = ["P_DEBUG", "P_INFO", "P_VALUE", "P_SIG", "P_WARNING", "P_ERROR"]
+
+CALL_RE = re.compile(r'\b(HT_LOG|HT_LOG_STRING|HT_LOG_BUFFER)\s*\(\s*(\w+)\s*,\s*(\w+)\s*,\s*((?:"(?:[^"\\\n]|\\.)*"\s*)+)')
+LITERAL_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+SPEC_RE = re.compile(r'%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t)?([a-zA-Z%])')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "\\": "\\", '"': '"', "'": "'", "0": "\0"}
+
+
+def unescape(text):
+    return re.sub(r'\\(.)', lambda m: ESCAPES.get(m.group(1), m.group(1)), text)
+
+
+def check_format(fmt, kind, where):
+    ints = 0
+    strings = 0
+
+    for n, m in enumerate(m for m in SPEC_RE.finditer(fmt) if m.group(5) != "%"):
+        conv, length = m.group(5), m.group(4)
+
+        if conv == "s":
+            if kind == "HT_LOG" or n != 0 or strings:
+                raise ValueError("{}: %s must be the first conversion of HT_LOG_STRING/HT_LOG_BUFFER".format(where))
+            if (m.group(3) == "*") != (kind == "HT_LOG_BUFFER"):
+                raise ValueError("{}: use %.*s with HT_LOG_BUFFER and %s with HT_LOG_STRING".format(where))
+            strings += 1
+        elif conv in "diuxXoc":
+            if length in ("ll", "j"):
+                raise ValueError("{}: 64 bit arguments are not supported".format(where))
+            if m.group(2) == "*" or m.group(3) == "*":
+                raise ValueError("{}: '*' width is only supported for strings".format(where))
+            ints += 1
+        else:
+            raise ValueError("{}: unsupported conversion %{}".format(where, conv))
+
+    if kind != "HT_LOG" and strings == 0:
+        raise ValueError("{}: {} needs a string conversion".format(where, kind))
+    if ints > MAX_ARGS:
+        raise ValueError("{}: more than {} arguments".format(where, MAX_ARGS))
+
+
+def collect(src_dirs):
+    messages = []
+    names = {}
+
+    for src in src_dirs:
+        for path in sorted(glob.glob(os.path.join(src, "*.c"))):
+            with open(path, "r", encoding="utf-8", errors="replace") as f:
+                text = f.read()
+
+            for m in CALL_RE.finditer(text):
+                kind, level, name, literals = m.groups()
+                line = text.count("\n", 0, m.start()) + 1
+                where = "{}:{}".format(path, line)
+
+                if level not in LEVELS:
+                    raise ValueError("{}: unknown level {}".format(where, level))
+                if name in names:
+                    raise ValueError("{}: sub ID {} already used at {}".format(where, name, names[name]))
+
+                fmt = "".join(unescape(l) for l in LITERAL_RE.findall(literals))
+                check_format(fmt, kind, where)
+
+                names[name] = where
+                messages.append({"name": name, "level": level, "file": os.path.basename(path),
+                                 "line": line, "format": fmt})
+
+    for i, msg in enumerate(messages):
+        msg["id"] = i + 1
+
+    return messages
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, "r") as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the HT_LOG ID database.")
+    parser.add_argument("--src", action="append", required=True, help="source directory (repeatable)")
+    parser.add_argument("--header", required=True, help="generated ID header")
+    parser.add_argument("--db", required=True, help="generated JSON database")
+    args = parser.parse_args()
+
+    try:
+        messages = collect(args.src)
+    except ValueError as e:
+        sys.stderr.write("log_db: error: {}\n".format(e))
+        return 1
+
+    body = json.dumps([[m["id"], m["level"], m["format"]] for m in messages], sort_keys=True)
+    version = zlib.crc32(body.encode("utf-8")) & 0xFFFFFFFF
+
+    lines = ["/* Generated by Debug/Scripts/log_db.py, do not edit. */",
+             "#ifndef __HT_LOG_IDS_H__",
+             "#define __HT_LOG_IDS_H__",
+             "",
+             "#define HT_LOG_DB_VERSION 0x{:08x}U".format(version),
+             "",
+             "typedef enum {",
+             "    HT_LOG_ID_START = 0,"]
+    lines += ["    HT_LOG_ID_{} = {},".format(m["name"], m["id"]) for m in messages]
+    lines += ["    HT_LOG_ID_END", "} HT_LogId;", "", "#endif", ""]
+    write_if_changed(args.header, "\n".join(lines))
+
+    db = {"version": "0x{:08x}".format(version), "levels": LEVELS,
+          "messages": {str(m["id"]): m for m in messages}}
+    write_if_changed(args.db, json.dumps(db, indent=2, sort_keys=True) + "\n")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,191 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# file: log_decode.py
+# brief: Decodes the tokenized HT_LOG stream using the database from log_db.py.
+#        Plain text on the same UART is passed through unchanged.
+# usage: python log_decode.py --db Build/log_db.json capture.bin
+#        python log_decode.py --db Build/log_db.json --port COM5 --baud 115200
+#        ./sampler_bench | python log_decode.py --db build/log_db.json
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+SYNC = 0xF5
+STRING_FLAG = 0x80
+ID_VERSION = 0
+SPEC_RE = re.compile(r'%([-+ #0]*)(\d+)?(?:\.(\d+|\*))?(?:hh|h|l|z|t)?([a-zA-Z%])')
+LEVEL_TAGS = {"P_DEBUG": "D", "P_INFO": "I", "P_VALUE": "V", "P_SIG": "S", "P_WARNING": "W", "P_ERROR": "E"}
+
+
+def render(fmt, words, string):
+    words = list(words)
+
+    def conv(m):
+        flags, width, prec, c = m.group(1), m.group(2) or "", m.group(3), m.group(4)
+        if c == "%":
+            return "%"
+        if c == "s":
+            spec = "%" + flags + width + "s"
+            return spec % (string if string is not None else "")
+        if not words:
+            return "<missing>"
+        value = words.pop(0)
+        if c in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+            c = "d"
+        elif c == "u":
+            c = "d"
+        elif c == "c":
+            value = chr(value & 0xFF)
+        spec = "%" + flags + width + ("." + prec if prec and prec != "*" else "") + c
+        return spec % value
+
+    return SPEC_RE.sub(conv, fmt)
+
+
+class Decoder:
+    def __init__(self, db, out):
+        self.messages = db["messages"]
+        self.version = int(db["version"], 16)
+        self.out = out
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.errors = 0
+
+    def flush_text(self):
+        if self.text:
+            self.out.write(self.text.decode("utf-8", errors="replace"))
+            self.text.clear()
+
+    def emit(self, tick, msg_id, words, string):
+        self.flush_text()
+
+        if msg_id == ID_VERSION:
+            got = words[0] if words else 0
+            state = "ok" if got == self.version else "MISMATCH, database is 0x{:08x}".format(self.version)
+            self.out.write("[{:>10}] log database 0x{:08x} ({})\n".format(tick, got, state))
+            return
+
+        msg = self.messages.get(str(msg_id))
+        if msg is None:
+            self.out.write("[{:>10}] ? unknown id {} args {}\n".format(tick, msg_id, words))
+            return
+
+        text = render(msg["format"], words, string).rstrip("\n")
+        self.out.write("[{:>10}] {} {}: {}\n".format(tick, LEVEL_TAGS.get(msg["level"], "?"), msg["name"], text))
+
+    def frame(self):
+        """Returns bytes consumed from buf, 0 if more input is needed."""
+        b = self.buf
+        if len(b) < 8:
+            return 0
+
+        msg_id, argc, tick = struct.unpack_from("<HBI", b, 1)
+        has_str = bool(argc & STRING_FLAG)
+        argc &= 0x7F
+        size = 8 + 4 * argc
+        if argc > 8:
+            return -1
+        if len(b) < size + (1 if has_str else 0) + 1:
+            return 0
+
+        slen = b[size] if has_str else 0
+        end = size + (1 + slen if has_str else 0)
+        if len(b) < end + 1:
+            return 0
+        if sum(b[1:end]) & 0xFF != b[end]:
+            return -1
+
+        words = struct.unpack_from("<{}I".format(argc), b, 8)
+        string = bytes(b[size + 1:end]).decode("utf-8", errors="replace") if has_str else None
+        self.emit(tick, msg_id, words, string)
+
+        return end + 1
+
+    def feed(self, data):
+        for byte in data:
+            if not self.buf:
+                if byte == SYNC:
+                    self.buf.append(byte)
+                else:
+                    self.text.append(byte)
+                    if byte == 0x0A:
+                        self.flush_text()
+                continue
+
+            self.buf.append(byte)
+            used = self.frame()
+            if used > 0:
+                del self.buf[:used]
+            elif used < 0:
+                # Corrupt frame: drop the sync byte and rescan the rest as text.
+                self.errors += 1
+                rest = bytes(self.buf[1:])
+                self.buf.clear()
+                self.feed(rest)
+
+    def close(self):
+        self.text += self.buf
+        self.buf.clear()
+        self.flush_text()
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the HT_LOG binary stream.")
+    parser.add_argument("--db", required=True, help="JSON database generated by log_db.py")
+    parser.add_argument("--port", help="serial port to read from (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("input", nargs="?", default="-", help="capture file, '-' for stdin")
+    args = parser.parse_args()
+
+    with open(args.db, "r") as f:
+        decoder = Decoder(json.load(f), sys.stdout)
+
+    try:
+        if args.port:
+            import serial
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                while True:
+                    decoder.feed(port.read(256))
+                    decoder.flush_text()
+        else:
+            stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+            with stream:
+                for chunk in iter(lambda: stream.read(4096), b""):
+                    decoder.feed(chunk)
+    except KeyboardInterrupt:
+        pass
+
+    decoder.close()
+    if decoder.errors:
+        sys.stderr.write("log_decode: {} corrupt frame(s) skipped\n".format(decoder.errors))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,94 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+
+# file: psk_record.py
+# brief: Builds the HT_PskRecord burned into the efuse software application
+#        field (80 bytes at EFUSE_SW_APP_BYTELOC), see Inc/HT_Psk.h.
+#        Writes the raw record, or prints it as hex for the burn tool.
+# usage: python psk_record.py --identity SIP_HTNB32L-0001 --key 000102030405060708090a0b0c0d0e0f --out psk.bin
+#        python psk_record.py --identity SIP_HTNB32L-0001 --key-file device.key --hex
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import binascii
+import struct
+import sys
+
+MAGIC = 0xA5
+KEY_MAX = 16
+IDENTITY_MAX = 58
+RECORD_LEN = 80
+
+
+def crc16(data, crc=0xFFFF):
+    # HT_Crc16, CRC-16/CCITT, MSB first
+    for b in bytearray(data):
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def build(identity, key):
+    if not 0 < len(key) <= KEY_MAX:
+        raise ValueError("key must be 1 to {} bytes".format(KEY_MAX))
+    if not 0 < len(identity) <= IDENTITY_MAX:
+        raise ValueError("identity must be 1 to {} bytes".format(IDENTITY_MAX))
+
+    body = struct.pack("<BBBB{}s{}s".format(KEY_MAX, IDENTITY_MAX), MAGIC, len(key), len(identity), 0, key, identity)
+    record = body + struct.pack("<H", crc16(body))
+    assert len(record) == RECORD_LEN
+    return record
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the efuse PSK record.")
+    parser.add_argument("--identity", required=True, help="PSK identity, as registered on the broker")
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--key", help="pre-shared key, hex")
+    group.add_argument("--key-file", help="file holding the raw pre-shared key")
+    parser.add_argument("--out", help="raw record output file")
+    parser.add_argument("--hex", action="store_true", help="print the record as hex")
+    args = parser.parse_args()
+
+    try:
+        if args.key is not None:
+            key = binascii.unhexlify(args.key)
+        else:
+            with open(args.key_file, "rb") as f:
+                key = f.read()
+        record = build(args.identity.encode("utf-8"), key)
+    except (ValueError, TypeError, binascii.Error, IOError) as e:
+        sys.stderr.write("psk_record: error: {}\n".format(e))
+        return 1
+
+    if args.out:
+        with open(args.out, "wb") as f:
+            f.write(record)
+    if args.hex or not args.out:
+        print(binascii.hexlify(record).decode("ascii"))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
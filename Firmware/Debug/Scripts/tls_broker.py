@@ -0,0 +1,370 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+
+# file: tls_broker.py
+# brief: Local stand-in for the MQTT over TLS broker, to try the TLS record profiles
+#        (HT_TLS_LOW_RAM) without a cloud broker. Speaks TLS 1.2 and just enough
+#        MQTT 3.1.1 (CONNACK, SUBACK, PUBACK, PINGRESP) for a SenseClima cycle, and
+#        prints one JSON line per connection: the maximum fragment length the
+#        client asked for and whether it was acknowledged, and the largest record
+#        each way. The device logs its side, HT_MQTT_Connect_5 (arena bytes in use
+#        after the handshake) and HT_MQTT_Connect_6 (record buffers kept):
+#        flashing HT_TLS_LOW_RAM = n, then y, and comparing both lines gives the
+#        steady-state RAM the profile saves.
+#        --strip-mfl drops the acknowledgement from the ServerHello: a low-RAM PSK
+#        client must then abort the handshake. --publish-size sends the device a
+#        packet larger than its fragment length once it subscribes.
+#        Without --cert, a self-signed P-256 certificate is made with the openssl
+#        tool: short enough for a 1 KB fragment. PSK needs Python 3.13.
+# usage: python tls_broker.py --port 8883
+#        python tls_broker.py --psk-identity SIP_HTNB32L-0001 --psk 000102030405060708090a0b0c0d0e0f
+#        python tls_broker.py --once --require-mfl 512 --publish-size 900
+# author: HT Micron Advanced R&D
+# link: https://github.com/htmicron
+# version: 0.1
+
+import argparse
+import binascii
+import json
+import os
+import shutil
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+
+RECORD_HEADER = 5
+CONTENT_CCS = 20
+CONTENT_HANDSHAKE = 22
+CONTENT_APPLICATION = 23
+HS_CLIENT_HELLO = 1
+HS_SERVER_HELLO = 2
+EXT_MAX_FRAGMENT_LENGTH = 1
+MFL_LENGTHS = {1: 512, 2: 1024, 3: 2048, 4: 4096}
+
+MQTT_CONNECT = 1
+MQTT_PUBLISH = 3
+MQTT_PUBREL = 6
+MQTT_SUBSCRIBE = 8
+MQTT_PINGREQ = 12
+MQTT_DISCONNECT = 14
+
+
+def extensions(body, pos):
+    # (type, data) of the extension block starting at pos, nothing if there is none
+    if pos + 2 > len(body):
+        return
+    end = min(len(body), pos + 2 + (body[pos] << 8 | body[pos + 1]))
+    pos += 2
+    while pos + 4 <= end:
+        ext_len = body[pos + 2] << 8 | body[pos + 3]
+        yield body[pos] << 8 | body[pos + 1], body[pos + 4:pos + 4 + ext_len], pos
+        pos += 4 + ext_len
+
+
+def client_hello_mfl(body):
+    # Fragment length in a ClientHello body, None if not asked for
+    pos = 2 + 32
+    pos += 1 + body[pos]
+    pos += 2 + (body[pos] << 8 | body[pos + 1])
+    pos += 1 + body[pos]
+    for ext, data, _ in extensions(body, pos):
+        if ext == EXT_MAX_FRAGMENT_LENGTH and len(data) == 1:
+            return MFL_LENGTHS.get(data[0], 0)
+    return None
+
+
+def server_hello_extensions(body):
+    # Offset of the extension block in a ServerHello body
+    return 2 + 32 + 1 + body[2 + 32] + 2 + 1
+
+
+def strip_server_hello_mfl(record):
+    # Removes max_fragment_length from a handshake record starting with the ServerHello.
+    # The Finished hashes no longer match, but a client that checks gives up long before
+    msgs = bytearray(record[RECORD_HEADER:])
+    if not msgs or msgs[0] != HS_SERVER_HELLO:
+        return record, False
+    hs_len = msgs[1] << 16 | msgs[2] << 8 | msgs[3]
+    body = msgs[4:4 + hs_len]
+    pos = server_hello_extensions(body)
+    for ext, data, at in extensions(body, pos):
+        if ext == EXT_MAX_FRAGMENT_LENGTH:
+            cut = 4 + len(data)
+            del body[at:at + cut]
+            ext_len = (body[pos] << 8 | body[pos + 1]) - cut
+            body[pos:pos + 2] = ext_len.to_bytes(2, "big")
+            rest = msgs[4 + hs_len:]
+            msgs = bytes([HS_SERVER_HELLO]) + len(body).to_bytes(3, "big") + bytes(body) + bytes(rest)
+            return record[:3] + len(msgs).to_bytes(2, "big") + msgs, True
+    return record, False
+
+
+class Records:
+    # Splits one direction of the byte stream into TLS records
+
+    def __init__(self):
+        self.buf = b""
+        self.count = 0
+        self.largest = 0
+        self.largest_app = 0
+        self.encrypted = False
+
+    def feed(self, data):
+        self.buf += data
+        while len(self.buf) >= RECORD_HEADER:
+            length = self.buf[3] << 8 | self.buf[4]
+            if len(self.buf) < RECORD_HEADER + length:
+                break
+            record, self.buf = self.buf[:RECORD_HEADER + length], self.buf[RECORD_HEADER + length:]
+            self.count += 1
+            self.largest = max(self.largest, length)
+            if record[0] == CONTENT_APPLICATION:
+                self.largest_app = max(self.largest_app, length)
+            yield record
+            if record[0] == CONTENT_CCS:
+                self.encrypted = True
+
+
+def mqtt_packets(stream):
+    # Complete MQTT packets at the head of stream, (type, flags, body), and the bytes they take
+    packets, used = [], 0
+    while used + 2 <= len(stream):
+        pos, length, shift = used + 1, 0, 0
+        while pos < len(stream):
+            length |= (stream[pos] & 0x7F) << shift
+            shift += 7
+            pos += 1
+            if not stream[pos - 1] & 0x80:
+                break
+        else:
+            break
+        if pos + length > len(stream):
+            break
+        packets.append((stream[used] >> 4, stream[used] & 0x0F, bytes(stream[pos:pos + length])))
+        used = pos + length
+    return packets, used
+
+
+def mqtt_publish(topic, payload):
+    body = len(topic).to_bytes(2, "big") + topic + payload
+    header = bytearray([MQTT_PUBLISH << 4])
+    length = len(body)
+    while True:
+        byte = length & 0x7F
+        length >>= 7
+        header.append(byte | 0x80 if length else byte)
+        if not length:
+            break
+    return bytes(header) + body
+
+
+class Connection:
+    def __init__(self, args, context, sock):
+        self.args = args
+        self.sock = sock
+        self.incoming = ssl.MemoryBIO()
+        self.outgoing = ssl.MemoryBIO()
+        self.tls = context.wrap_bio(self.incoming, self.outgoing, server_side=True)
+        self.rx = Records()
+        self.tx = Records()
+        self.stripped = False
+        self.report = {"peer": "{}:{}".format(*sock.getpeername()[:2]), "mfl": None, "mfl_acked": False,
+                       "resumed": False, "suite": None, "mqtt": {}, "result": "closed"}
+
+    def flush(self):
+        data = self.outgoing.read()
+        if not data:
+            return
+        out = b""
+        for record in self.tx.feed(data):
+            if record[0] == CONTENT_HANDSHAKE and not self.tx.encrypted and record[RECORD_HEADER] == HS_SERVER_HELLO:
+                body = record[RECORD_HEADER + 4:]
+                self.report["mfl_acked"] = any(ext == EXT_MAX_FRAGMENT_LENGTH for ext, _, _ in
+                                               extensions(body, server_hello_extensions(body)))
+                if self.args.strip_mfl:
+                    record, self.stripped = strip_server_hello_mfl(record)
+                    self.report["mfl_acked"] = self.report["mfl_acked"] and not self.stripped
+            out += record
+        self.sock.sendall(out)
+
+    def receive(self):
+        data = self.sock.recv(4096)
+        if not data:
+            raise EOFError
+        for record in self.rx.feed(data):
+            if record[0] == CONTENT_HANDSHAKE and not self.rx.encrypted and record[RECORD_HEADER] == HS_CLIENT_HELLO:
+                self.report["mfl"] = client_hello_mfl(record[RECORD_HEADER + 4:])
+        self.incoming.write(data)
+
+    def handshake(self):
+        while True:
+            try:
+                self.tls.do_handshake()
+                self.flush()
+                break
+            except ssl.SSLWantReadError:
+                self.flush()
+                self.receive()
+        self.report["resumed"] = self.tls.session_reused
+        self.report["suite"] = self.tls.cipher()[0]
+
+    def send(self, data):
+        self.tls.write(data)
+        self.flush()
+
+    def serve(self):
+        stream = bytearray()
+        counts = self.report["mqtt"]
+        while True:
+            try:
+                stream += self.tls.read(4096)
+            except ssl.SSLWantReadError:
+                self.flush()
+                self.receive()
+                continue
+            except ssl.SSLZeroReturnError:
+                return
+            packets, used = mqtt_packets(stream)
+            del stream[:used]
+            for kind, flags, body in packets:
+                name = {MQTT_CONNECT: "connect", MQTT_PUBLISH: "publish", MQTT_SUBSCRIBE: "subscribe",
+                        MQTT_PINGREQ: "ping", MQTT_DISCONNECT: "disconnect"}.get(kind, str(kind))
+                counts[name] = counts.get(name, 0) + 1
+                if kind == MQTT_CONNECT:
+                    self.send(b"\x20\x02\x00\x00")
+                elif kind == MQTT_PUBLISH:
+                    qos = (flags >> 1) & 3
+                    if qos:
+                        topic_len = body[0] << 8 | body[1]
+                        packet_id = body[2 + topic_len:4 + topic_len]
+                        self.send(bytes([0x40 if qos == 1 else 0x50, 2]) + packet_id)
+                elif kind == MQTT_PUBREL:
+                    self.send(b"\x70\x02" + body[:2])
+                elif kind == MQTT_SUBSCRIBE:
+                    # Packet ID, then (topic length, topic, QoS) per filter; QoS 1 at most
+                    topics, granted, pos = [], bytearray(), 2
+                    while pos + 3 <= len(body):
+                        length = body[pos] << 8 | body[pos + 1]
+                        topics.append(body[pos + 2:pos + 2 + length])
+                        granted.append(min(body[pos + 2 + length], 1) if pos + 2 + length < len(body) else 0x80)
+                        pos += 3 + length
+                    self.send(bytes([0x90, 2 + len(granted)]) + body[:2] + bytes(granted))
+                    if self.args.publish_size and topics:
+                        self.send(mqtt_publish(topics[0], b"x" * self.args.publish_size))
+                elif kind == MQTT_PINGREQ:
+                    self.send(b"\xd0\x00")
+                elif kind == MQTT_DISCONNECT:
+                    return
+
+    def run(self):
+        try:
+            self.handshake()
+            self.report["result"] = "handshake"
+            self.serve()
+            self.report["result"] = "ok" if "connect" in self.report["mqtt"] else "no mqtt"
+        except (EOFError, ConnectionError):
+            pass
+        except ssl.SSLError as e:
+            self.report["result"] = "tls error: {}".format(e.reason)
+        self.report["records_in"] = {"count": self.rx.count, "largest": self.rx.largest, "largest_app": self.rx.largest_app}
+        self.report["records_out"] = {"count": self.tx.count, "largest": self.tx.largest, "largest_app": self.tx.largest_app}
+        self.sock.close()
+        return self.report
+
+
+def self_signed(workdir):
+    # P-256 keeps the chain well under a 1 KB fragment
+    cert, key = os.path.join(workdir, "broker.crt"), os.path.join(workdir, "broker.key")
+    subprocess.run(["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+                    "-nodes", "-days", "1", "-subj", "/CN=tls_broker", "-keyout", key, "-out", cert],
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def make_context(args, workdir):
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.minimum_version = context.maximum_version = ssl.TLSVersion.TLSv1_2
+    if args.psk is not None:
+        if not hasattr(context, "set_psk_server_callback"):
+            raise ValueError("PSK needs Python 3.13 or later")
+        key = binascii.unhexlify(args.psk)
+        identity = args.psk_identity
+        context.set_ciphers("PSK-AES128-CCM8:@SECLEVEL=0")
+        context.set_psk_server_callback(lambda got: key if got == identity else b"")
+    else:
+        cert, key = (args.cert, args.key) if args.cert else self_signed(workdir)
+        context.load_cert_chain(cert, key)
+    return context
+
+
+def check(args, report):
+    if report["result"] != "ok":
+        return False
+    if args.require_mfl is not None:
+        return report["mfl"] is not None and report["mfl"] <= args.require_mfl
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local MQTT over TLS broker stand-in.")
+    parser.add_argument("--host", default="0.0.0.0", help="address to listen on")
+    parser.add_argument("--port", type=int, default=8883, help="port to listen on (HT_MQTT_PORT)")
+    parser.add_argument("--cert", help="broker certificate chain, PEM (default: self-signed P-256)")
+    parser.add_argument("--key", help="broker private key, PEM")
+    parser.add_argument("--psk", help="pre-shared key, hex: PSK-AES128-CCM8 instead of certificates")
+    parser.add_argument("--psk-identity", default="", help="PSK identity the client must send")
+    parser.add_argument("--strip-mfl", action="store_true", help="do not acknowledge the fragment length")
+    parser.add_argument("--publish-size", type=int, default=0, help="payload bytes published to the device on subscribe")
+    parser.add_argument("--require-mfl", type=int, help="with --once, fail unless the client asked for this fragment length or less")
+    parser.add_argument("--once", action="store_true", help="serve one connection, exit status tells whether it passed")
+    args = parser.parse_args()
+
+    if args.cert and not args.key:
+        parser.error("--cert needs --key")
+
+    workdir = tempfile.mkdtemp(prefix="tls_broker")
+    try:
+        context = make_context(args, workdir)
+        server = socket.create_server((args.host, args.port), reuse_port=False)
+    except (ValueError, OSError, ssl.SSLError, subprocess.CalledProcessError, binascii.Error) as e:
+        sys.stderr.write("tls_broker: error: {}\n".format(e))
+        shutil.rmtree(workdir, ignore_errors=True)
+        return 1
+
+    sys.stderr.write("tls_broker: listening on {}:{}\n".format(args.host, args.port))
+    try:
+        while True:
+            sock, _ = server.accept()
+            sock.settimeout(60)
+            report = Connection(args, context, sock).run()
+            print(json.dumps(report), flush=True)
+            if args.once:
+                return 0 if check(args, report) else 2
+    except KeyboardInterrupt:
+        return 0
+    finally:
+        server.close()
+        shutil.rmtree(workdir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
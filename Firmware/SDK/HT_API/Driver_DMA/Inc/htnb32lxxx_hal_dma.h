@@ -1,7 +1,290 @@
+/*
 
-#ifndef __HTNB32Lxxx_HAL_DMA_H__
-#define __HTNB32Lxxx_HAL_DMA_H__
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
 
+ Copyright (c) 2024 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
 
+*/
 
-#endif /*__HTNB32Lxxx_HAL_DMA_H__*/
+/*!
+ * \file htnb32lxxx_hal_dma.h
+ * \brief DMA HAL module driver.
+ *        This file provides channel allocation, register and descriptor chain transfers,
+ *        memory-to-memory copy/fill and completion callbacks on top of the QCX212 DMA engine.
+ *        Peripheral drivers (USART, SPI, I2C) allocate and run their channels through this API.
+ *
+ * \author HT Micron Advanced R&D,
+ *         Hêndrick Bataglin Gonçalves, Christian Roberto Lehmen,  Matheus da Silva Zorzeto, Felipe Kalinski Ferreira,
+ *         Leandro Borges, Mauricio Carlotto Ribeiro, Henrique Kuhn, Cleber Haack, Eduardo Mendel
+ *
+ * \link https://github.com/htmicron
+ * \version 1.0
+ * \date February 27, 2024
+ */
+
+#ifndef __HTNB32LXXX_HAL_DMA_H__
+#define __HTNB32LXXX_HAL_DMA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "qcx212.h"
+#include "dma_qcx212.h"
+#include "Driver_Common.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#define HAL_DMA_MAX_DESC_LEN        (0x1FFFU)   // Bytes per descriptor (CMDR.LEN field width)
+#define HAL_DMA_BURST_BYTES(b)      (4U << (b))  // dma_burst_size_t to bytes
+
+// Burst sizes, the single place to tune DMA bus usage per client
+#ifndef HAL_DMA_MEM_BURST
+#define HAL_DMA_MEM_BURST           DMA_Burst32Bytes
+#endif
+
+#ifndef HAL_DMA_USART_TX_BURST
+#define HAL_DMA_USART_TX_BURST      DMA_Burst16Bytes
+#endif
+
+#ifndef HAL_DMA_USART_RX_BURST
+#define HAL_DMA_USART_RX_BURST      DMA_Burst8Bytes    // Must match UART_DMA_BURST_SIZE
+#endif
+
+#ifndef HAL_DMA_SPI_BURST
+#define HAL_DMA_SPI_BURST           DMA_Burst8Bytes
+#endif
+
+#ifndef HAL_DMA_I2C_BURST
+#define HAL_DMA_I2C_BURST           DMA_Burst8Bytes
+#endif
+
+// Descriptors reserved for HAL_DMA_MemCopy/HAL_DMA_MemFill, bounds a single call to N * HAL_DMA_MAX_DESC_LEN
+#ifndef HAL_DMA_MEM_CHAIN_LEN
+#define HAL_DMA_MEM_CHAIN_LEN       4
+#endif
+
+#define HAL_DMA_MEM_MAX_LEN         (HAL_DMA_MEM_CHAIN_LEN * HAL_DMA_MAX_DESC_LEN)
+
+// Bytes written by the CPU before HAL_DMA_MemFill smears the pattern with DMA, at least two memory bursts
+#define HAL_DMA_FILL_SEED           64
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \brief DMA completion callback.
+ * \param[in] event    DMA_EVENT_ERROR, DMA_EVENT_START, DMA_EVENT_END, DMA_EVENT_EOR or DMA_EVENT_STOP.
+ * \param[in] context  Pointer given when the channel was opened.
+ */
+typedef void (*HAL_DMA_Callback_t)(uint32_t event, void *context);
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_OpenChannel(dma_request_source_t request, HAL_DMA_Callback_t callback, void *context)
+ * \brief Allocates a free DMA channel and binds it to a request source.
+ *
+ * \param[in]  dma_request_source_t request   Peripheral request line, DMA_MemoryToMemory for memory transfers.
+ * \param[in]  HAL_DMA_Callback_t callback    Event callback, called from the DMA IRQ. May be NULL.
+ * \param[in]  void *context                  Opaque pointer handed back to the callback.
+ * \param[out] none
+ *
+ * \retval Channel number or ARM_DMA_ERROR_CHANNEL_ALLOC.
+ *******************************************************************/
+int32_t HAL_DMA_OpenChannel(dma_request_source_t request, HAL_DMA_Callback_t callback, void *context);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_CloseChannel(uint32_t channel)
+ * \brief Stops and releases a channel allocated by HAL_DMA_OpenChannel.
+ *
+ * \param[in]  uint32_t channel    DMA channel.
+ * \param[out] none
+ *
+ * \retval ARM Driver status.
+ *******************************************************************/
+int32_t HAL_DMA_CloseChannel(uint32_t channel);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_Start(uint32_t channel, const dma_transfer_config *config)
+ * \brief Starts a single register mode transfer. DMA_EVENT_END is reported
+ *        to the channel callback and the channel holds the sleep vote until then.
+ *
+ * \param[in]  uint32_t channel                  DMA channel.
+ * \param[in]  const dma_transfer_config *config Transfer setup, totalLength up to HAL_DMA_MAX_DESC_LEN.
+ * \param[out] none
+ *
+ * \retval ARM Driver status.
+ *******************************************************************/
+int32_t HAL_DMA_Start(uint32_t channel, const dma_transfer_config *config);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_BuildChain(dma_descriptor_t *chain, uint32_t count, const dma_transfer_config *config, bool circular)
+ * \brief Splits a transfer into linked descriptors of at most HAL_DMA_MAX_DESC_LEN bytes.
+ *        A linear chain raises DMA_EVENT_END on its last descriptor; a circular chain
+ *        links back to the first one and raises DMA_EVENT_END on every lap.
+ *
+ * \param[in]  dma_descriptor_t *chain            Descriptor array, 16 byte aligned.
+ * \param[in]  uint32_t count                     Number of descriptors available in chain.
+ * \param[in]  const dma_transfer_config *config  Whole transfer setup.
+ * \param[in]  bool circular                      Link the last descriptor back to the first.
+ * \param[out] none
+ *
+ * \retval Number of descriptors used or ARM_DRIVER_ERROR_PARAMETER.
+ *******************************************************************/
+int32_t HAL_DMA_BuildChain(dma_descriptor_t *chain, uint32_t count, const dma_transfer_config *config, bool circular);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_StartChain(uint32_t channel, dma_descriptor_t *chain, bool circular)
+ * \brief Starts a descriptor chain. A circular chain keeps the sleep vote until HAL_DMA_Stop.
+ *
+ * \param[in]  uint32_t channel           DMA channel.
+ * \param[in]  dma_descriptor_t *chain    First descriptor, 16 byte aligned.
+ * \param[in]  bool circular              Whether the chain never ends by itself.
+ * \param[out] none
+ *
+ * \retval ARM Driver status.
+ *******************************************************************/
+int32_t HAL_DMA_StartChain(uint32_t channel, dma_descriptor_t *chain, bool circular);
+
+/*!******************************************************************
+ * \fn void HAL_DMA_ReloadChain(uint32_t channel, dma_descriptor_t *chain)
+ * \brief Loads a descriptor and runs it from IRQ context. Does not take the
+ *        sleep vote, meant for receive paths that re-arm while idle.
+ *
+ * \param[in]  uint32_t channel           DMA channel.
+ * \param[in]  dma_descriptor_t *chain    Descriptor to load.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_DMA_ReloadChain(uint32_t channel, dma_descriptor_t *chain);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_Stop(uint32_t channel, bool waitForStop)
+ * \brief Stops a channel and releases its sleep vote.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[in]  bool waitForStop      Wait until the channel is really stopped.
+ * \param[out] none
+ *
+ * \retval ARM Driver status.
+ *******************************************************************/
+int32_t HAL_DMA_Stop(uint32_t channel, bool waitForStop);
+
+/*!******************************************************************
+ * \fn void HAL_DMA_Abort(uint32_t channel)
+ * \brief Requests a channel stop without waiting or clearing its status, safe from IRQ context.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_DMA_Abort(uint32_t channel);
+
+/*!******************************************************************
+ * \fn bool HAL_DMA_IsBusy(uint32_t channel)
+ * \brief Checks whether a transfer started through this HAL is still running.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[out] none
+ *
+ * \retval true while the transfer is active.
+ *******************************************************************/
+bool HAL_DMA_IsBusy(uint32_t channel);
+
+/*!******************************************************************
+ * \fn uint32_t HAL_DMA_GetCount(uint32_t channel)
+ * \brief Gets the number of bytes still to be transferred by the current descriptor.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[out] none
+ *
+ * \retval Remaining bytes.
+ *******************************************************************/
+uint32_t HAL_DMA_GetCount(uint32_t channel);
+
+/*!******************************************************************
+ * \fn uint32_t HAL_DMA_GetTargetAddress(uint32_t channel, bool sync)
+ * \brief Gets the address the channel is currently writing to.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[in]  bool sync             Flush the channel internal FIFO before reading.
+ * \param[out] none
+ *
+ * \retval Current target address.
+ *******************************************************************/
+uint32_t HAL_DMA_GetTargetAddress(uint32_t channel, bool sync);
+
+/*!******************************************************************
+ * \fn void HAL_DMA_SetDescriptorLength(dma_descriptor_t *descriptor, uint32_t len)
+ * \brief Updates the transfer length of an already built descriptor.
+ *
+ * \param[in]  dma_descriptor_t *descriptor  Descriptor to update.
+ * \param[in]  uint32_t len                  New length, up to HAL_DMA_MAX_DESC_LEN.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_DMA_SetDescriptorLength(dma_descriptor_t *descriptor, uint32_t len);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_MemCopy(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context)
+ * \brief Copies memory with the DMA engine. Returns as soon as the transfer
+ *        is queued; callback receives DMA_EVENT_END or DMA_EVENT_ERROR.
+ *        The buffers must not overlap and must stay valid until then.
+ *
+ * \param[in]  void *dst                     Destination.
+ * \param[in]  const void *src               Source.
+ * \param[in]  uint32_t size                 Bytes to copy, up to HAL_DMA_MEM_MAX_LEN.
+ * \param[in]  HAL_DMA_Callback_t callback   Completion callback. May be NULL, poll HAL_DMA_MemBusy.
+ * \param[in]  void *context                 Opaque pointer handed back to the callback.
+ * \param[out] none
+ *
+ * \retval ARM Driver status, ARM_DRIVER_ERROR_BUSY while a previous memory transfer runs.
+ *******************************************************************/
+int32_t HAL_DMA_MemCopy(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context);
+
+/*!******************************************************************
+ * \fn int32_t HAL_DMA_MemFill(void *dst, uint8_t value, uint32_t size, HAL_DMA_Callback_t callback, void *context)
+ * \brief Fills memory with a byte value. The first HAL_DMA_FILL_SEED bytes are
+ *        written by the CPU and the DMA replicates them over the rest of the buffer.
+ *
+ * \param[in]  void *dst                     Destination.
+ * \param[in]  uint8_t value                 Fill value.
+ * \param[in]  uint32_t size                 Bytes to fill, up to HAL_DMA_MEM_MAX_LEN.
+ * \param[in]  HAL_DMA_Callback_t callback   Completion callback. May be NULL, poll HAL_DMA_MemBusy.
+ * \param[in]  void *context                 Opaque pointer handed back to the callback.
+ * \param[out] none
+ *
+ * \retval ARM Driver status, ARM_DRIVER_ERROR_BUSY while a previous memory transfer runs.
+ *******************************************************************/
+int32_t HAL_DMA_MemFill(void *dst, uint8_t value, uint32_t size, HAL_DMA_Callback_t callback, void *context);
+
+/*!******************************************************************
+ * \fn bool HAL_DMA_MemBusy(void)
+ * \brief Checks whether a HAL_DMA_MemCopy/HAL_DMA_MemFill transfer is running.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true while the memory channel is busy.
+ *******************************************************************/
+bool HAL_DMA_MemBusy(void);
+
+#endif /* __HTNB32LXXX_HAL_DMA_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -1,4 +1,382 @@
+/**
+ *
+ * Copyright (c) 2024 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
 
 #include "htnb32lxxx_hal_dma.h"
+#include "slpman_qcx212.h"
+#include "string.h"
 
-void HAL_DMA_Transfer()
\ No newline at end of file
+/* Private low level entry points of the DMA library, only used from this HAL */
+extern void DMA_StopChannelNoWait(uint32_t channel);
+extern uint32_t DMA_SetDescriptorTransferLen(uint32_t dcmd, uint32_t len);
+extern void DMA_ChannelLoadDescriptorAndRun(uint32_t channel, void* descriptorAddress);
+extern uint32_t DMA_ChannelGetCurrentTargetAddress(uint32_t channel, bool sync);
+
+_Static_assert(HAL_DMA_FILL_SEED >= (2 * HAL_DMA_BURST_BYTES(HAL_DMA_MEM_BURST)),
+               "HAL_DMA_FILL_SEED must cover at least two HAL_DMA_MEM_BURST bursts");
+
+typedef struct {
+    bool                open;
+    volatile bool       busy;
+    bool                circular;
+    HAL_DMA_Callback_t  callback;
+    void                *context;
+} HAL_DMA_ChannelTypeDef;
+
+static HAL_DMA_ChannelTypeDef g_dmaChannels[DMA_NUMBER_OF_HW_CHANNEL_SUPPORTED] = {0};
+static bool g_dmaInitialized = false;
+static uint32_t g_dmaBusyMask = 0;
+
+static int32_t g_dmaMemChannel = ARM_DMA_ERROR_CHANNEL_ALLOC;
+static HAL_DMA_Callback_t g_dmaMemCallback = NULL;
+static void *g_dmaMemContext = NULL;
+static __ALIGNED(16) dma_descriptor_t g_dmaMemChain[HAL_DMA_MEM_CHAIN_LEN];
+
+/*!******************************************************************
+ * \fn static void HAL_DMA_SetBusy(uint32_t channel, bool busy)
+ * \brief Tracks the active channels and votes against sleep while any is running.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[in]  bool busy             New channel state.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_DMA_SetBusy(uint32_t channel, bool busy);
+
+/*!******************************************************************
+ * \fn static void HAL_DMA_Dispatch(uint32_t channel, uint32_t event)
+ * \brief Common DMA event handler, releases finished channels and calls the user callback.
+ *
+ * \param[in]  uint32_t channel      DMA channel.
+ * \param[in]  uint32_t event        DMA event.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_DMA_Dispatch(uint32_t channel, uint32_t event);
+
+/*!******************************************************************
+ * \fn static void HAL_DMA_MemEvent(uint32_t event, void *context)
+ * \brief Event handler of the internal memory-to-memory channel.
+ *
+ * \param[in]  uint32_t event        DMA event.
+ * \param[in]  void *context         Unused.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+static void HAL_DMA_MemEvent(uint32_t event, void *context);
+
+/*!******************************************************************
+ * \fn static int32_t HAL_DMA_MemStart(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context)
+ * \brief Builds and starts a chain on the internal memory channel.
+ *
+ * \param[in]  void *dst                     Destination.
+ * \param[in]  const void *src               Source.
+ * \param[in]  uint32_t size                 Bytes to move.
+ * \param[in]  HAL_DMA_Callback_t callback   Completion callback.
+ * \param[in]  void *context                 Callback context.
+ * \param[out] none
+ *
+ * \retval ARM Driver status.
+ *******************************************************************/
+static int32_t HAL_DMA_MemStart(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context);
+
+/* The DMA library callback has no context, one trampoline per hardware channel */
+#define HAL_DMA_CHANNEL_EVENT(n)                                                    \
+    PLAT_CODE_IN_RAM static void HAL_DMA_Channel##n##Event(uint32_t event) {        \
+        HAL_DMA_Dispatch(n, event);                                                 \
+    }
+
+HAL_DMA_CHANNEL_EVENT(0)
+HAL_DMA_CHANNEL_EVENT(1)
+HAL_DMA_CHANNEL_EVENT(2)
+HAL_DMA_CHANNEL_EVENT(3)
+HAL_DMA_CHANNEL_EVENT(4)
+HAL_DMA_CHANNEL_EVENT(5)
+HAL_DMA_CHANNEL_EVENT(6)
+HAL_DMA_CHANNEL_EVENT(7)
+
+static const dma_callback_t g_dmaChannelEvents[DMA_NUMBER_OF_HW_CHANNEL_SUPPORTED] = {
+    HAL_DMA_Channel0Event, HAL_DMA_Channel1Event, HAL_DMA_Channel2Event, HAL_DMA_Channel3Event,
+    HAL_DMA_Channel4Event, HAL_DMA_Channel5Event, HAL_DMA_Channel6Event, HAL_DMA_Channel7Event
+};
+
+PLAT_CODE_IN_RAM static void HAL_DMA_SetBusy(uint32_t channel, bool busy) {
+    uint32_t mask;
+
+    mask = SaveAndSetIRQMask();
+
+    g_dmaChannels[channel].busy = busy;
+
+    if(busy)
+        g_dmaBusyMask |= (1U << channel);
+    else
+        g_dmaBusyMask &= ~(1U << channel);
+
+#ifdef PM_FEATURE_ENABLE
+    slpManDrvVoteSleep(SLP_VOTE_DMA, g_dmaBusyMask ? SLP_ACTIVE_STATE : SLP_SLP1_STATE);
+#endif
+
+    RestoreIRQMask(mask);
+}
+
+PLAT_CODE_IN_RAM static void HAL_DMA_Dispatch(uint32_t channel, uint32_t event) {
+    HAL_DMA_ChannelTypeDef *ch = &g_dmaChannels[channel];
+
+    if(ch->busy) {
+        if(event == DMA_EVENT_ERROR || event == DMA_EVENT_STOP || (event == DMA_EVENT_END && !ch->circular))
+            HAL_DMA_SetBusy(channel, false);
+    }
+
+    if(ch->callback)
+        ch->callback(event, ch->context);
+}
+
+int32_t HAL_DMA_OpenChannel(dma_request_source_t request, HAL_DMA_Callback_t callback, void *context) {
+    int32_t channel;
+
+    if(!g_dmaInitialized) {
+        DMA_Init();
+        g_dmaInitialized = true;
+    }
+
+    channel = DMA_OpenChannel();
+
+    if(channel == ARM_DMA_ERROR_CHANNEL_ALLOC)
+        return ARM_DMA_ERROR_CHANNEL_ALLOC;
+
+    g_dmaChannels[channel].open = true;
+    g_dmaChannels[channel].busy = false;
+    g_dmaChannels[channel].circular = false;
+    g_dmaChannels[channel].callback = callback;
+    g_dmaChannels[channel].context = context;
+
+    if(request != DMA_MemoryToMemory)
+        DMA_ChannelSetRequestSource(channel, request);
+
+    DMA_ChannelRigisterCallback(channel, g_dmaChannelEvents[channel]);
+
+    return channel;
+}
+
+int32_t HAL_DMA_CloseChannel(uint32_t channel) {
+    if(channel >= DMA_NUMBER_OF_HW_CHANNEL_SUPPORTED || !g_dmaChannels[channel].open)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    if(g_dmaChannels[channel].busy)
+        HAL_DMA_Stop(channel, true);
+
+    g_dmaChannels[channel].open = false;
+    g_dmaChannels[channel].callback = NULL;
+    g_dmaChannels[channel].context = NULL;
+
+    return DMA_CloseChannel(channel);
+}
+
+PLAT_CODE_IN_RAM int32_t HAL_DMA_Start(uint32_t channel, const dma_transfer_config *config) {
+    if(config->totalLength == 0 || config->totalLength > HAL_DMA_MAX_DESC_LEN)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    g_dmaChannels[channel].circular = false;
+    HAL_DMA_SetBusy(channel, true);
+
+    DMA_TransferSetup(channel, config);
+    DMA_EnableChannelInterrupts(channel, DMA_EndInterruptEnable);
+    DMA_StartChannel(channel);
+
+    return ARM_DRIVER_OK;
+}
+
+int32_t HAL_DMA_BuildChain(dma_descriptor_t *chain, uint32_t count, const dma_transfer_config *config, bool circular) {
+    dma_transfer_config step = *config;
+    dma_extra_config extra;
+    uint32_t used, remaining;
+    uint32_t i;
+
+    if((((uint32_t)chain) & 0xF) != 0 || config->totalLength == 0)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    used = (config->totalLength + HAL_DMA_MAX_DESC_LEN - 1) / HAL_DMA_MAX_DESC_LEN;
+
+    if(used > count)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    remaining = config->totalLength;
+
+    for(i = 0; i < used; i++) {
+        bool last = (i == used - 1);
+
+        step.totalLength = (remaining > HAL_DMA_MAX_DESC_LEN) ? HAL_DMA_MAX_DESC_LEN : remaining;
+
+        extra.nextDesriptorAddress = last ? &chain[0] : &chain[i + 1];
+        extra.stopDecriptorFetch = last && !circular;
+        extra.enableStartInterrupt = false;
+        extra.enableEndInterrupt = last;
+
+        DMA_BuildDescriptor(&chain[i], &step, &extra);
+
+        if(config->addressIncrement & DMA_AddressIncrementSource)
+            step.sourceAddress = (uint8_t *)step.sourceAddress + step.totalLength;
+        if(config->addressIncrement & DMA_AddressIncrementTarget)
+            step.targetAddress = (uint8_t *)step.targetAddress + step.totalLength;
+
+        remaining -= step.totalLength;
+    }
+
+    return (int32_t)used;
+}
+
+PLAT_CODE_IN_RAM int32_t HAL_DMA_StartChain(uint32_t channel, dma_descriptor_t *chain, bool circular) {
+    int32_t ret;
+
+    g_dmaChannels[channel].circular = circular;
+    HAL_DMA_SetBusy(channel, true);
+
+    ret = DMA_ChannelLoadFirstDescriptor(channel, (void *)chain);
+
+    if(ret != ARM_DRIVER_OK) {
+        HAL_DMA_SetBusy(channel, false);
+        return ret;
+    }
+
+    DMA_StartChannel(channel);
+
+    return ARM_DRIVER_OK;
+}
+
+PLAT_CODE_IN_RAM void HAL_DMA_ReloadChain(uint32_t channel, dma_descriptor_t *chain) {
+    DMA_ChannelLoadDescriptorAndRun(channel, (void *)chain);
+}
+
+PLAT_CODE_IN_RAM int32_t HAL_DMA_Stop(uint32_t channel, bool waitForStop) {
+    int32_t ret;
+
+    ret = DMA_StopChannel(channel, waitForStop);
+
+    if(g_dmaChannels[channel].busy)
+        HAL_DMA_SetBusy(channel, false);
+
+    return ret;
+}
+
+PLAT_CODE_IN_RAM void HAL_DMA_Abort(uint32_t channel) {
+    DMA_StopChannelNoWait(channel);
+
+    if(g_dmaChannels[channel].busy)
+        HAL_DMA_SetBusy(channel, false);
+}
+
+PLAT_CODE_IN_RAM bool HAL_DMA_IsBusy(uint32_t channel) {
+    return g_dmaChannels[channel].busy;
+}
+
+PLAT_CODE_IN_RAM uint32_t HAL_DMA_GetCount(uint32_t channel) {
+    return DMA_ChannelGetCount(channel);
+}
+
+PLAT_CODE_IN_RAM uint32_t HAL_DMA_GetTargetAddress(uint32_t channel, bool sync) {
+    return DMA_ChannelGetCurrentTargetAddress(channel, sync);
+}
+
+PLAT_CODE_IN_RAM void HAL_DMA_SetDescriptorLength(dma_descriptor_t *descriptor, uint32_t len) {
+    descriptor->CMDR = DMA_SetDescriptorTransferLen(descriptor->CMDR, len);
+}
+
+static void HAL_DMA_MemEvent(uint32_t event, void *context) {
+    HAL_DMA_Callback_t callback;
+    void *ctx;
+
+    if(event != DMA_EVENT_END && event != DMA_EVENT_ERROR)
+        return;
+
+    callback = g_dmaMemCallback;
+    ctx = g_dmaMemContext;
+    g_dmaMemCallback = NULL;
+
+    if(callback)
+        callback(event, ctx);
+}
+
+static int32_t HAL_DMA_MemStart(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context) {
+    dma_transfer_config config;
+    int32_t ret;
+
+    if(g_dmaMemChannel == ARM_DMA_ERROR_CHANNEL_ALLOC) {
+        g_dmaMemChannel = HAL_DMA_OpenChannel(DMA_MemoryToMemory, HAL_DMA_MemEvent, NULL);
+
+        if(g_dmaMemChannel == ARM_DMA_ERROR_CHANNEL_ALLOC)
+            return ARM_DMA_ERROR_CHANNEL_ALLOC;
+    }
+
+    config.sourceAddress = (void *)src;
+    config.targetAddress = dst;
+    config.flowControl = DMA_FlowControlNone;
+    config.addressIncrement = DMA_AddressIncrementBoth;
+    config.dataWidth = DMA_DataWidthNoUse;
+    config.burstSize = HAL_DMA_MEM_BURST;
+    config.totalLength = size;
+
+    ret = HAL_DMA_BuildChain(g_dmaMemChain, HAL_DMA_MEM_CHAIN_LEN, &config, false);
+    if(ret < 0)
+        return ret;
+
+    g_dmaMemCallback = callback;
+    g_dmaMemContext = context;
+
+    return HAL_DMA_StartChain(g_dmaMemChannel, g_dmaMemChain, false);
+}
+
+int32_t HAL_DMA_MemCopy(void *dst, const void *src, uint32_t size, HAL_DMA_Callback_t callback, void *context) {
+    if(dst == NULL || src == NULL || size == 0 || size > HAL_DMA_MEM_MAX_LEN)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    if(HAL_DMA_MemBusy())
+        return ARM_DRIVER_ERROR_BUSY;
+
+    return HAL_DMA_MemStart(dst, src, size, callback, context);
+}
+
+int32_t HAL_DMA_MemFill(void *dst, uint8_t value, uint32_t size, HAL_DMA_Callback_t callback, void *context) {
+    if(dst == NULL || size == 0 || size > HAL_DMA_MEM_MAX_LEN)
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    if(HAL_DMA_MemBusy())
+        return ARM_DRIVER_ERROR_BUSY;
+
+    // Short fills are cheaper on the CPU than a channel setup
+    if(size <= HAL_DMA_FILL_SEED) {
+        memset(dst, value, size);
+
+        if(callback)
+            callback(DMA_EVENT_END, context);
+
+        return ARM_DRIVER_OK;
+    }
+
+    // Each burst reads bytes written at least two bursts earlier, so the seed propagates forward
+    memset(dst, value, HAL_DMA_FILL_SEED);
+
+    return HAL_DMA_MemStart((uint8_t *)dst + HAL_DMA_FILL_SEED, dst, size - HAL_DMA_FILL_SEED, callback, context);
+}
+
+bool HAL_DMA_MemBusy(void) {
+    if(g_dmaMemChannel == ARM_DMA_ERROR_CHANNEL_ALLOC)
+        return false;
+
+    return g_dmaChannels[g_dmaMemChannel].busy;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
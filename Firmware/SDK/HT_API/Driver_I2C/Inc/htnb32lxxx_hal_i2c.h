@@ -41,6 +41,7 @@
 #include "bsp.h"
 #include "HT_Peripheral_Config.h"
 #include "HT_bsp.h"
+#include "htnb32lxxx_hal_dma.h"
 
 /* Defines  ------------------------------------------------------------------*/
 
@@ -52,6 +53,7 @@
 #define I2C_FLAG_MASTER_RX   BIT(4)        // Master rx
 #define I2C_FLAG_SLAVE_TX    BIT(5)        // Slave  tx
 #define I2C_FLAG_SLAVE_RX    BIT(6)        // Slave  rx
+#define I2C_FLAG_ASYNC       BIT(7)        // Queued transaction in progress
 
 #define  I2C_NO_STARTSTOP               (0x00000000U)
 #define  I2C_GENERATE_STOP              (I2C_SCR_STOP_Msk)
@@ -72,6 +74,26 @@
 #define I2C_BUS_CLEAR_MASK (1 << 2)
 #define I2C_ABORT_TRANSFER_MASK (1 << 3)
 
+#define I2C_FIFO_DEPTH                  16        // TX/RX FIFO entries
+#define I2C_SEGMENT_MAX_LEN             512       // SCR.BYTE_NUM field width
+
+// Transfer mode per instance, RTE_I2Cx_IO_MODE may be given directly or derived from I2Cx_INIT_MODE
+#ifndef RTE_I2C0_IO_MODE
+#define RTE_I2C0_IO_MODE                I2C0_INIT_MODE
+#endif
+
+#ifndef RTE_I2C1_IO_MODE
+#define RTE_I2C1_IO_MODE                I2C1_INIT_MODE
+#endif
+
+// Segments per queued transaction
+#ifndef HAL_I2C_MAX_SEGMENTS
+#define HAL_I2C_MAX_SEGMENTS            4
+#endif
+
+#define HAL_I2C_SEG_WRITE               0
+#define HAL_I2C_SEG_READ                1
+
 /* Typedefs  ------------------------------------------------------------------*/
 
 // I2C IRQ
@@ -98,6 +120,33 @@ typedef struct _I2C_DMA {
 } I2C_DMA;
 
 
+struct _HAL_I2C_Transaction;
+
+/**
+ * \brief Queued transaction completion callback, called from IRQ context.
+ * \param[in] xfer     Finished transaction.
+ * \param[in] status   ARM_DRIVER_OK or ARM_DRIVER_ERROR (see HAL_I2C_Transaction.status).
+ */
+typedef void (*HAL_I2C_TransactionCallback_t)(struct _HAL_I2C_Transaction *xfer, int32_t status);
+
+// One write or read phase of a transaction, separated from the next one by a repeated start
+typedef struct {
+  uint8_t                      *data;             // Data to send or receive buffer
+  uint16_t                      len;              // 1..I2C_SEGMENT_MAX_LEN
+  uint8_t                       dir;              // HAL_I2C_SEG_WRITE or HAL_I2C_SEG_READ
+} HAL_I2C_Segment;
+
+// Queued I2C master transaction, owned by the driver from HAL_I2C_Submit until the callback
+typedef struct _HAL_I2C_Transaction {
+  uint16_t                      addr;             // Slave address
+  uint8_t                       count;            // Segments used
+  HAL_I2C_Segment               segments[HAL_I2C_MAX_SEGMENTS];
+  HAL_I2C_TransactionCallback_t callback;         // Completion callback, may be NULL
+  void                         *context;          // User data for the callback
+  volatile int32_t              status;           // ARM_DRIVER_ERROR_BUSY until finished
+  struct _HAL_I2C_Transaction  *next;             // Queue link, driver private
+} HAL_I2C_Transaction;
+
 // I2C Control Information
 typedef struct {
   ARM_I2C_SignalEvent_t cb_event;           // Event callback
@@ -112,6 +161,10 @@ typedef struct {
   uint32_t              num;                // Number of bytes to transfer
   uint8_t              *sdata;              // Slave data to transfer
   uint32_t              snum;               // Number of bytes to transfer
+  HAL_I2C_Transaction  *xfer_head;          // Transaction on the bus
+  HAL_I2C_Transaction  *xfer_tail;          // Last queued transaction
+  uint8_t               seg;                // Current segment of xfer_head
+  uint8_t               seg_wait;           // Completion sources still pending for the segment
 } I2C_CTRL;
 
 
@@ -183,6 +236,44 @@ int32_t HAL_I2C_MasterTransmit_IT(I2C_HandleTypeDef *hi2c, uint32_t addr, uint8_
  *******************************************************************/
 int32_t HAL_I2C_MasterReceive_IT(I2C_HandleTypeDef *hi2c, uint32_t addr, uint8_t *pRxData, uint32_t size);
 
+/*!******************************************************************
+ * \fn int32_t HAL_I2C_Submit(I2C_HandleTypeDef *hi2c, HAL_I2C_Transaction *xfer)
+ * \brief Queues an I2C master transaction and returns immediately.
+ *        Segments are issued back to back with a repeated start and a single stop at the end.
+ *        Segments longer than I2C_FIFO_DEPTH are moved by DMA; the instance must be in
+ *        DMA_MODE for those, or in IRQ_MODE for FIFO sized segments only.
+ *        The driver holds the I2C sleep vote while the queue is not empty.
+ *        Completion is reported through xfer->callback (IRQ context) and xfer->status.
+ *
+ * \param[in] I2C_HandleTypeDef *hi2c           I2C handle.
+ * \param[in] HAL_I2C_Transaction *xfer         Transaction, must stay valid until completion.
+ * \param[out] none
+ *
+ * \retval ARM driver status.
+ *******************************************************************/
+int32_t HAL_I2C_Submit(I2C_HandleTypeDef *hi2c, HAL_I2C_Transaction *xfer);
+
+/*!******************************************************************
+ * \fn void HAL_I2C_PrepareWriteRead(HAL_I2C_Transaction *xfer, uint16_t addr, uint8_t *pTxData, uint16_t txSize,
+ *                                   uint8_t *pRxData, uint16_t rxSize, HAL_I2C_TransactionCallback_t callback, void *context)
+ * \brief Fills a transaction with a write phase followed by a read phase, e.g. a register burst read.
+ *        Either phase is left out when its size is zero.
+ *
+ * \param[in] HAL_I2C_Transaction *xfer                  Transaction to fill.
+ * \param[in] uint16_t addr                              I2C slave address.
+ * \param[in] uint8_t *pTxData                           Bytes to write (e.g. register address).
+ * \param[in] uint16_t txSize                            Amount of data to write.
+ * \param[in] uint8_t *pRxData                           RX buffer.
+ * \param[in] uint16_t rxSize                            Amount of data to read.
+ * \param[in] HAL_I2C_TransactionCallback_t callback     Completion callback.
+ * \param[in] void *context                              User data for the callback.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HAL_I2C_PrepareWriteRead(HAL_I2C_Transaction *xfer, uint16_t addr, uint8_t *pTxData, uint16_t txSize,
+                              uint8_t *pRxData, uint16_t rxSize, HAL_I2C_TransactionCallback_t callback, void *context);
+
 /*!******************************************************************
  * \fn void I2C_IRQHandler(I2C_HandleTypeDef *i2c)
  * \brief I2C Event Interrupt handler.
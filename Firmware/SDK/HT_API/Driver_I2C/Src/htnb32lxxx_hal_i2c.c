@@ -159,6 +159,12 @@ static void I2C_ExitLowPowerStateRestore(void* pdata, slpManLpState state)
 
 #define I2C_POLLING_TIMEOUT_CYCLES       1000000
 
+// Completion sources of a queued transaction segment
+#define I2C_WAIT_BUS                     BIT(0)        // I2C transfer done
+#define I2C_WAIT_DMA                     BIT(1)        // DMA end
+
+#define I2C_ASYNC_ERROR_Msk              (I2C_ISR_ARBITRATATION_LOST_Msk | I2C_ISR_BUS_ERROR_Msk | I2C_ISR_RX_NACK_Msk)
+
 /* Driver Version */
 static const ARM_DRIVER_VERSION DriverVersion =
 {
@@ -184,16 +190,16 @@ void HAL_I2C0_DmaTxEvent(uint32_t event);
 void HAL_I2C0_DmaRxEvent(uint32_t event);
 
 static I2C_DMA I2C0_DMA = {
-                            RTE_I2C0_DMA_TX_CH,
+                            -1,                             // Allocated in HAL_I2C_Initialize
                             RTE_I2C0_DMA_TX_REQID,
                             HAL_I2C0_DmaTxEvent,
-                            RTE_I2C0_DMA_RX_CH,
+                            -1,
                             RTE_I2C0_DMA_RX_REQID,
                             HAL_I2C0_DmaRxEvent
                           };
 #endif
 
-#if (RTE_I2C0_IO_MODE == IRQ_MODE)
+#if (RTE_I2C0_IO_MODE == IRQ_MODE) || (RTE_I2C0_IO_MODE == DMA_MODE)
 void HAL_I2C0_IRQHandler(void);
 
 static I2C_IRQ I2C0_IRQ = {
@@ -216,7 +222,7 @@ I2C_HandleTypeDef hi2c0 =
     NULL,
 #endif
 
-#if (RTE_I2C0_IO_MODE == IRQ_MODE)
+#if (RTE_I2C0_IO_MODE == IRQ_MODE) || (RTE_I2C0_IO_MODE == DMA_MODE)
     &I2C0_IRQ,
 #else
     NULL,
@@ -237,17 +243,17 @@ void HAL_I2C1_DmaTxEvent(uint32_t event);
 void HAL_I2C1_DmaRxEvent(uint32_t event);
 
 static I2C_DMA I2C1_DMA = {
-                            RTE_I2C1_DMA_TX_CH,
+                            -1,                             // Allocated in HAL_I2C_Initialize
                             RTE_I2C1_DMA_TX_REQID,
                             HAL_I2C1_DmaTxEvent,
-                            RTE_I2C1_DMA_RX_CH,
+                            -1,
                             RTE_I2C1_DMA_RX_REQID,
                             HAL_I2C1_DmaRxEvent
                           };
 
 #endif
 
-#if (RTE_I2C1_IO_MODE == IRQ_MODE)
+#if (RTE_I2C1_IO_MODE == IRQ_MODE) || (RTE_I2C1_IO_MODE == DMA_MODE)
 
 void HAL_I2C1_IRQHandler(void);
 
@@ -271,7 +277,7 @@ I2C_HandleTypeDef hi2c1 =
     NULL,
 #endif
 
-#if (RTE_I2C1_IO_MODE == IRQ_MODE)
+#if (RTE_I2C1_IO_MODE == IRQ_MODE) || (RTE_I2C1_IO_MODE == DMA_MODE)
     &I2C1_IRQ,
 #else
     NULL,
@@ -282,6 +288,18 @@ I2C_HandleTypeDef hi2c1 =
 
 /* Function prototypes  ------------------------------------------------------------------*/
 
+/*!******************************************************************
+ * \fn static void HAL_I2C_DmaEvent(uint32_t event, void *context)
+ * \brief Forwards a DMA HAL event to the I2C tx/rx DMA callback.
+ *
+ * \param[in]  uint32_t event        DMA event.
+ * \param[in]  void *context         Pointer to the callback member of the I2C DMA structure.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+static void HAL_I2C_DmaEvent(uint32_t event, void *context);
+
 /*!******************************************************************
  * \fn static uint32_t HAL_I2C_GetInstanceNumber(I2C_HandleTypeDef *i2c)
  * \brief Get instance number.
@@ -339,6 +357,30 @@ static void HAL_I2C_DmaTxEvent(uint32_t event, I2C_HandleTypeDef *i2c);
  *******************************************************************/
 static void HAL_I2C_DmaRxEvent(uint32_t event, I2C_HandleTypeDef *i2c);
 
+/*!******************************************************************
+ * \fn static void HAL_I2C_AsyncStartSegment(I2C_HandleTypeDef *i2c)
+ * \brief  Issues the current segment of the transaction at the head of the queue.
+ *
+ * \param[in]  I2C_HandleTypeDef *i2c           I2C handle.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+static void HAL_I2C_AsyncStartSegment(I2C_HandleTypeDef *i2c);
+
+/*!******************************************************************
+ * \fn static void HAL_I2C_AsyncProgress(I2C_HandleTypeDef *i2c, uint8_t done, int32_t status)
+ * \brief  Advances the queued transaction when a completion source fires or an error occurs.
+ *
+ * \param[in]  I2C_HandleTypeDef *i2c           I2C handle.
+ * \param[in]  uint8_t done                     I2C_WAIT_BUS and/or I2C_WAIT_DMA.
+ * \param[in]  int32_t status                   ARM_DRIVER_OK or error aborting the transaction.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+static void HAL_I2C_AsyncProgress(I2C_HandleTypeDef *i2c, uint8_t done, int32_t status);
+
 /* ---------------------------------------------------------------------------------------*/
 
 
@@ -398,29 +440,19 @@ int32_t HAL_I2C_Initialize(ARM_I2C_SignalEvent_t cb_event, I2C_HandleTypeDef *i2
     // Configure DMA if necessary
     if(i2c->dma)
     {
-        DMA_Init();
-
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)i2c->dma->tx_req, HAL_I2C_DmaEvent, &i2c->dma->tx_callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             i2c->dma->tx_ch = returnCode;
 
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)i2c->dma->rx_req, HAL_I2C_DmaEvent, &i2c->dma->rx_callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             i2c->dma->rx_ch = returnCode;
-
-
-        DMA_ChannelSetRequestSource(i2c->dma->tx_ch, (dma_request_source_t)i2c->dma->tx_req);
-        DMA_ChannelRigisterCallback(i2c->dma->tx_ch, i2c->dma->tx_callback);
-
-
-        DMA_ChannelSetRequestSource(i2c->dma->rx_ch, (dma_request_source_t)i2c->dma->rx_req);
-        DMA_ChannelRigisterCallback(i2c->dma->rx_ch, i2c->dma->rx_callback);
     }
 
     i2c->ctrl->flags |= I2C_FLAG_INIT;
@@ -493,8 +525,8 @@ int32_t HAL_I2C_PowerControl(ARM_POWER_STATE state, I2C_HandleTypeDef *i2c) {
             // DMA disable
             if(i2c->dma)
             {
-                DMA_StopChannel(i2c->dma->tx_ch, false);
-                DMA_StopChannel(i2c->dma->rx_ch, false);
+                HAL_DMA_Stop(i2c->dma->tx_ch, false);
+                HAL_DMA_Stop(i2c->dma->rx_ch, false);
             }
             // Disable I2C and other control bits
             i2c->reg->MCR = 0;
@@ -686,7 +718,7 @@ int32_t HAL_I2C_MasterReceive_DMA(I2C_HandleTypeDef *hi2c, uint32_t addr, uint8_
     dma_transfer_config dmaRxConfig = {(void *)&hi2c->reg->RDR, (void *)pRxData,
                                        DMA_FlowControlSource, DMA_AddressIncrementTarget,
                                        DMA_DataWidthOneByte,
-                                       DMA_Burst8Bytes, size};
+                                       HAL_DMA_I2C_BURST, size};
 
     if(!pRxData || !size || (addr > 0x3ff)) {
         return ARM_DRIVER_ERROR_PARAMETER;
@@ -739,10 +771,7 @@ int32_t HAL_I2C_MasterReceive_DMA(I2C_HandleTypeDef *hi2c, uint32_t addr, uint8_
     LOCK_SLEEP(instance);
 #endif
     // Configure rx DMA and start it
-    DMA_TransferSetup(hi2c->dma->rx_ch, &dmaRxConfig);
-    DMA_EnableChannelInterrupts(hi2c->dma->rx_ch, DMA_EndInterruptEnable);
-    
-    DMA_StartChannel(hi2c->dma->rx_ch);
+    HAL_DMA_Start(hi2c->dma->rx_ch, &dmaRxConfig);
 
     return ARM_DRIVER_OK;
 }
@@ -817,6 +846,235 @@ void HAL_I2C_MasterReceive_Polling(I2C_HandleTypeDef *hi2c, uint32_t addr, uint8
     
 }
 
+static void HAL_I2C_AsyncStartSegment(I2C_HandleTypeDef *i2c) {
+    HAL_I2C_Transaction *xfer = i2c->ctrl->xfer_head;
+    const HAL_I2C_Segment *seg = &xfer->segments[i2c->ctrl->seg];
+    uint32_t mcr = (I2C_MCR_CONTROL_MODE_Msk | I2C_MCR_I2C_EN_Msk);
+    uint32_t scr;
+    uint32_t i;
+    dma_transfer_config dmaConfig;
+
+    scr = ((xfer->addr << 1) & I2C_SCR_TARGET_SLAVE_ADDR_Msk) | ((seg->len - 1) << I2C_SCR_BYTE_NUM_Pos);
+    scr |= (i2c->ctrl->seg == 0) ? I2C_SCR_START_Msk : I2C_SCR_RESTART_Msk;
+
+    if(i2c->ctrl->seg == xfer->count - 1)
+        scr |= I2C_SCR_STOP_Msk;
+
+    if(seg->dir == HAL_I2C_SEG_READ)
+        scr |= I2C_SCR_TARGET_RWN_Msk;
+
+    i2c->ctrl->data = seg->data;
+    i2c->ctrl->num  = seg->len;
+    i2c->ctrl->cnt  = 0;
+    i2c->ctrl->seg_wait = I2C_WAIT_BUS;
+
+    // Payloads that do not fit the FIFO go through DMA
+    if(seg->len > I2C_FIFO_DEPTH) {
+        dmaConfig.dataWidth = DMA_DataWidthOneByte;
+        dmaConfig.burstSize = HAL_DMA_I2C_BURST;
+
+        if(seg->dir == HAL_I2C_SEG_READ) {
+            // Rx requests come per burst, the tail below one burst is read from the FIFO at the end
+            i2c->ctrl->cnt = seg->len & ~(HAL_DMA_BURST_BYTES(HAL_DMA_I2C_BURST) - 1);
+
+            dmaConfig.sourceAddress = (void *)&i2c->reg->RDR;
+            dmaConfig.targetAddress = (void *)seg->data;
+            dmaConfig.flowControl = DMA_FlowControlSource;
+            dmaConfig.addressIncrement = DMA_AddressIncrementTarget;
+            dmaConfig.totalLength = i2c->ctrl->cnt;
+
+            mcr |= I2C_MCR_RX_DMA_EN_Msk;
+            HAL_DMA_Start(i2c->dma->rx_ch, &dmaConfig);
+        } else {
+            i2c->ctrl->cnt = seg->len;
+
+            dmaConfig.sourceAddress = (void *)seg->data;
+            dmaConfig.targetAddress = (void *)&i2c->reg->TDR;
+            dmaConfig.flowControl = DMA_FlowControlTarget;
+            dmaConfig.addressIncrement = DMA_AddressIncrementSource;
+            dmaConfig.totalLength = seg->len;
+
+            mcr |= I2C_MCR_TX_DMA_EN_Msk;
+            HAL_DMA_Start(i2c->dma->tx_ch, &dmaConfig);
+        }
+
+        i2c->ctrl->seg_wait |= I2C_WAIT_DMA;
+    }
+
+    i2c->reg->MCR = mcr;
+    i2c->reg->SCR = scr;
+
+    // Short writes fit the FIFO entirely
+    if(seg->dir == HAL_I2C_SEG_WRITE && !(i2c->ctrl->seg_wait & I2C_WAIT_DMA)) {
+        for(i = 0; i < seg->len; i++)
+            i2c->reg->TDR = seg->data[i];
+
+        i2c->ctrl->cnt = seg->len;
+    }
+}
+
+static void HAL_I2C_AsyncProgress(I2C_HandleTypeDef *i2c, uint8_t done, int32_t status) {
+#ifdef PM_FEATURE_ENABLE
+    uint32_t instance = HAL_I2C_GetInstanceNumber(i2c);
+#endif
+    HAL_I2C_Transaction *xfer;
+    uint32_t mask;
+
+    mask = SaveAndSetIRQMask();
+
+    xfer = i2c->ctrl->xfer_head;
+
+    if(!(i2c->ctrl->flags & I2C_FLAG_ASYNC) || xfer == NULL) {
+        RestoreIRQMask(mask);
+        return;
+    }
+
+    if(status == ARM_DRIVER_OK) {
+        i2c->ctrl->seg_wait &= ~done;
+
+        if(i2c->ctrl->seg_wait) {
+            RestoreIRQMask(mask);
+            return;
+        }
+
+        // Read tail left in the FIFO after the DMA part
+        if(xfer->segments[i2c->ctrl->seg].dir == HAL_I2C_SEG_READ) {
+            while(i2c->ctrl->cnt < i2c->ctrl->num)
+                i2c->ctrl->data[i2c->ctrl->cnt++] = i2c->reg->RDR;
+        }
+
+        if(++i2c->ctrl->seg < xfer->count) {
+            HAL_I2C_AsyncStartSegment(i2c);
+            RestoreIRQMask(mask);
+            return;
+        }
+    } else {
+        if(i2c->ctrl->seg_wait & I2C_WAIT_DMA) {
+            HAL_DMA_Stop(i2c->dma->tx_ch, false);
+            HAL_DMA_Stop(i2c->dma->rx_ch, false);
+        }
+
+        i2c->reg->SCR |= (I2C_SCR_FLUSH_TX_FIFO_Msk | I2C_SCR_FLUSH_RX_FIFO_Msk);
+    }
+
+    // Transaction finished, start the next queued one or release the bus
+    i2c->ctrl->xfer_head = xfer->next;
+    if(i2c->ctrl->xfer_head == NULL)
+        i2c->ctrl->xfer_tail = NULL;
+
+    xfer->next = NULL;
+    xfer->status = status;
+
+    if(i2c->ctrl->xfer_head) {
+        i2c->ctrl->seg = 0;
+        HAL_I2C_AsyncStartSegment(i2c);
+    } else {
+        i2c->reg->IER = 0;
+        i2c->reg->MCR = (I2C_MCR_CONTROL_MODE_Msk | I2C_MCR_I2C_EN_Msk);
+        i2c->ctrl->flags &= ~I2C_FLAG_ASYNC;
+        i2c->ctrl->status.busy = 0;
+#ifdef PM_FEATURE_ENABLE
+        CHECK_TO_UNLOCK_SLEEP(instance);
+#endif
+    }
+
+    RestoreIRQMask(mask);
+
+    if(xfer->callback)
+        xfer->callback(xfer, status);
+}
+
+int32_t HAL_I2C_Submit(I2C_HandleTypeDef *hi2c, HAL_I2C_Transaction *xfer) {
+#ifdef PM_FEATURE_ENABLE
+    uint32_t instance = HAL_I2C_GetInstanceNumber(hi2c);
+#endif
+    uint32_t mask;
+    uint32_t i;
+
+    if(!xfer || !xfer->count || (xfer->count > HAL_I2C_MAX_SEGMENTS) || (xfer->addr > 0x3ff))
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    for(i = 0; i < xfer->count; i++) {
+        if(!xfer->segments[i].data || !xfer->segments[i].len || (xfer->segments[i].len > I2C_SEGMENT_MAX_LEN))
+            return ARM_DRIVER_ERROR_PARAMETER;
+
+        if((xfer->segments[i].len > I2C_FIFO_DEPTH) && !hi2c->dma)
+            return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+
+    if(!hi2c->irq)
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+
+    if(!(hi2c->ctrl->flags & I2C_FLAG_SETUP))
+        return ARM_DRIVER_ERROR;
+
+    xfer->status = ARM_DRIVER_ERROR_BUSY;
+    xfer->next = NULL;
+
+    mask = SaveAndSetIRQMask();
+
+    if(hi2c->ctrl->xfer_tail) {
+        hi2c->ctrl->xfer_tail->next = xfer;
+        hi2c->ctrl->xfer_tail = xfer;
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_OK;
+    }
+
+    if(hi2c->ctrl->status.busy) {
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    hi2c->ctrl->xfer_head = xfer;
+    hi2c->ctrl->xfer_tail = xfer;
+    hi2c->ctrl->seg = 0;
+    hi2c->ctrl->flags |= I2C_FLAG_ASYNC;
+    hi2c->ctrl->status.busy = 1;
+    hi2c->ctrl->status.mode = 1;
+    hi2c->ctrl->status.arbitration_lost = 0;
+    hi2c->ctrl->status.bus_error = 0;
+    hi2c->ctrl->status.rx_nack = 0;
+
+#ifdef PM_FEATURE_ENABLE
+    LOCK_SLEEP(instance);
+#endif
+
+    // Clear all flags first(W1C)
+    hi2c->reg->ISR = hi2c->reg->ISR;
+    hi2c->reg->IER = (I2C_IER_TRANSFER_DONE_Msk |
+                     I2C_IER_ARBITRATATION_LOST_Msk |
+                     I2C_IER_BUS_ERROR_Msk |
+                     I2C_IER_RX_NACK_Msk);
+
+    HAL_I2C_AsyncStartSegment(hi2c);
+
+    RestoreIRQMask(mask);
+
+    return ARM_DRIVER_OK;
+}
+
+void HAL_I2C_PrepareWriteRead(HAL_I2C_Transaction *xfer, uint16_t addr, uint8_t *pTxData, uint16_t txSize,
+                              uint8_t *pRxData, uint16_t rxSize, HAL_I2C_TransactionCallback_t callback, void *context) {
+    xfer->addr = addr;
+    xfer->count = 0;
+    xfer->callback = callback;
+    xfer->context = context;
+
+    if(txSize) {
+        xfer->segments[xfer->count].data = pTxData;
+        xfer->segments[xfer->count].len = txSize;
+        xfer->segments[xfer->count].dir = HAL_I2C_SEG_WRITE;
+        xfer->count++;
+    }
+
+    if(rxSize) {
+        xfer->segments[xfer->count].data = pRxData;
+        xfer->segments[xfer->count].len = rxSize;
+        xfer->segments[xfer->count].dir = HAL_I2C_SEG_READ;
+        xfer->count++;
+    }
+}
+
 static int32_t HAL_I2C_GetClockFreq(I2C_HandleTypeDef *i2c) {
     uint32_t instance = HAL_I2C_GetInstanceNumber(i2c);
 
@@ -921,6 +1179,18 @@ void I2C_IRQHandler(I2C_HandleTypeDef *i2c) {
 
     //i2c->reg->ISR = tmp_status;
 
+    if(i2c->ctrl->flags & I2C_FLAG_ASYNC) {
+        if(tmp_status & I2C_ASYNC_ERROR_Msk) {
+            HAL_I2C_MasterCheckStatus(i2c);
+            HAL_I2C_AsyncProgress(i2c, 0, ARM_DRIVER_ERROR);
+        } else if(tmp_status & I2C_ISR_TRANSFER_DONE_Msk) {
+            i2c->reg->ISR = I2C_ISR_TRANSFER_DONE_Msk | (tmp_status & I2C_ISR_DETECT_STOP_Msk);
+            HAL_I2C_AsyncProgress(i2c, I2C_WAIT_BUS, ARM_DRIVER_OK);
+        }
+
+        return;
+    }
+
     if(tmp_status & I2C_ISR_TRANSFER_DONE_Msk) {
         // //I2CDEBUG("I2C_IRQHandler transfer done\r\n");
 
@@ -993,11 +1263,24 @@ void I2C_IRQHandler(I2C_HandleTypeDef *i2c) {
     }
 }
 
+static void HAL_I2C_DmaEvent(uint32_t event, void *context) {
+    (*(dma_callback_t *)context)(event);
+}
+
 static void HAL_I2C_DmaTxEvent(uint32_t event, I2C_HandleTypeDef *i2c) {
 #ifdef PM_FEATURE_ENABLE
     uint32_t instance = HAL_I2C_GetInstanceNumber(i2c);
 #endif
 
+    if(i2c->ctrl->flags & I2C_FLAG_ASYNC) {
+        if(event == DMA_EVENT_END)
+            HAL_I2C_AsyncProgress(i2c, I2C_WAIT_DMA, ARM_DRIVER_OK);
+        else if(event == DMA_EVENT_ERROR)
+            HAL_I2C_AsyncProgress(i2c, 0, ARM_DRIVER_ERROR);
+
+        return;
+    }
+
     switch(event)
     {
         case DMA_EVENT_END:
@@ -1024,6 +1307,15 @@ static void HAL_I2C_DmaRxEvent(uint32_t event, I2C_HandleTypeDef *i2c) {
     uint32_t instance = HAL_I2C_GetInstanceNumber(i2c);
 #endif
 
+    if(i2c->ctrl->flags & I2C_FLAG_ASYNC) {
+        if(event == DMA_EVENT_END)
+            HAL_I2C_AsyncProgress(i2c, I2C_WAIT_DMA, ARM_DRIVER_OK);
+        else if(event == DMA_EVENT_ERROR)
+            HAL_I2C_AsyncProgress(i2c, 0, ARM_DRIVER_ERROR);
+
+        return;
+    }
+
     switch(event) {
         case DMA_EVENT_END:
             i2c->ctrl->cnt= i2c->ctrl->num;
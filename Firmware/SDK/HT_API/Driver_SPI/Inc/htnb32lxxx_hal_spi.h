@@ -43,6 +43,7 @@
 #include "qcx212.h"
 #include "bsp.h"
 #include "HT_Peripheral_Config.h"
+#include "htnb32lxxx_hal_dma.h"
 
 /* Defines  ------------------------------------------------------------------*/
 
@@ -52,6 +53,19 @@
 #define SPI_FLAG_CONFIGURED           (1UL << 2)     // SPI configured
 #define SPI_FLAG_DATA_LOST            (1UL << 3)     // SPI data lost occurred
 #define SPI_FLAG_MODE_FAULT           (1UL << 4)     // SPI mode fault occurred
+#define SPI_RX_FIFO_TRIG_LVL          (4)            // RX FIFO DMA request level, shortest DMA transfer
+
+#define SPI_FLAG_ASYNC                (1UL << 5)     // Queued transactions own the bus
+#define SPI_FLAG_IDLE_OFF             (1UL << 6)     // Power the bus down when the queue drains
+
+// Segments per queued transaction
+#ifndef HAL_SPI_MAX_SEGMENTS
+#define HAL_SPI_MAX_SEGMENTS            3
+#endif
+
+#define HAL_SPI_SEG_WRITE               0         // Send data, received bytes are dropped
+#define HAL_SPI_SEG_READ                1         // Receive data, TX line carries don't care bytes
+#define HAL_SPI_SEG_STREAM              2         // Receive HAL_SPI_Stream.total bytes through the ping-pong buffers
 
 /* Typedefs  ------------------------------------------------------------------*/
 
@@ -86,6 +100,63 @@ typedef const struct _SPI_PIN {
   PIN               *pin_miso;                                //  MISO Pin identifier
 } SPI_PINS;
 
+// Device on a shared bus, selected by a chip-select pad driven as GPIO
+typedef struct {
+  uint32_t              frame;            // ARM_SPI_CPOL0_CPHA0 .. ARM_SPI_CPOL1_CPHA1
+  uint32_t              bus_speed;        // SCLK in bps, applied with SPI_SetBusSpeed
+  uint8_t               cs_pad;           // Chip-select pad number
+  uint8_t               cs_instance;      // GPIO instance of the chip-select pad
+  uint8_t               cs_index;         // GPIO index of the chip-select pad
+} HAL_SPI_Device;
+
+struct _HAL_SPI_Stream;
+struct _HAL_SPI_Transaction;
+
+/**
+ * \brief Stream block callback, called from IRQ context while the other buffer is being filled.
+ * \param[in] stream   Stream the block belongs to.
+ * \param[in] data     Filled buffer, owned by the caller until the stream wraps back to it.
+ * \param[in] len      Bytes in the buffer.
+ */
+typedef void (*HAL_SPI_StreamCallback_t)(struct _HAL_SPI_Stream *stream, uint8_t *data, uint32_t len);
+
+/**
+ * \brief Queued transaction completion callback, called from IRQ context.
+ * \param[in] xfer     Finished transaction, chip-select already released.
+ * \param[in] status   ARM_DRIVER_OK or an ARM driver error (see HAL_SPI_Transaction.status).
+ */
+typedef void (*HAL_SPI_TransactionCallback_t)(struct _HAL_SPI_Transaction *xfer, int32_t status);
+
+// Streaming read into two buffers: one is filled by DMA while the other is handed to on_block
+typedef struct _HAL_SPI_Stream {
+  uint8_t                      *buf[2];           // Ping-pong buffers, block bytes each
+  uint16_t                      block;            // SPI_RX_FIFO_TRIG_LVL..HAL_DMA_MAX_DESC_LEN
+  uint32_t                      total;            // Bytes to read
+  HAL_SPI_StreamCallback_t      on_block;         // Filled buffer callback, may be NULL
+  void                         *context;          // User data for the callback
+  uint32_t                      done;             // Bytes delivered, driver private
+  uint8_t                       active;           // Buffer being filled, driver private
+} HAL_SPI_Stream;
+
+// One phase of a transaction, all segments run under a single chip-select assertion
+typedef struct {
+  uint8_t                      *data;             // Data to send or receive buffer, unused for streams
+  uint16_t                      len;              // 1..HAL_DMA_MAX_DESC_LEN, unused for streams
+  uint8_t                       dir;              // HAL_SPI_SEG_WRITE, HAL_SPI_SEG_READ or HAL_SPI_SEG_STREAM
+} HAL_SPI_Segment;
+
+// Queued SPI master transaction, owned by the driver from HAL_SPI_Submit until the callback
+typedef struct _HAL_SPI_Transaction {
+  HAL_SPI_Device               *device;           // Target device
+  uint8_t                       count;            // Segments used
+  HAL_SPI_Segment               segments[HAL_SPI_MAX_SEGMENTS];
+  HAL_SPI_Stream               *stream;           // Buffers of the HAL_SPI_SEG_STREAM segment (last one only)
+  HAL_SPI_TransactionCallback_t callback;         // Completion callback, may be NULL
+  void                         *context;          // User data for the callback
+  volatile int32_t              status;           // ARM_DRIVER_ERROR_BUSY until finished
+  struct _HAL_SPI_Transaction  *next;             // Queue link, driver private
+} HAL_SPI_Transaction;
+
 typedef struct _SPI_STATUS {
   uint8_t busy;                         // Transmitter/Receiver busy flag
   uint8_t data_lost;                    // Data lost: Receive overflow / Transmit underflow (cleared on start of transfer operation)
@@ -113,6 +184,11 @@ typedef struct _SPI_INFO {
     uint32_t              bus_speed;    // SPI bus speed
     uint8_t               data_width;   // SPI data bits select in unit of byte
     SPI_TransferTypeDef   transfer_type;
+    HAL_SPI_Transaction  *xfer_head;    // Transaction on the bus
+    HAL_SPI_Transaction  *xfer_tail;    // Last queued transaction
+    uint8_t               seg;          // Current segment of xfer_head
+    HAL_SPI_Device       *device;       // Device the bus is configured for, NULL after power down
+    uint32_t              power_ups;    // Idle power down/up cycles of the queued mode
 } SPI_INFO;
 
 
@@ -294,16 +370,85 @@ int32_t HAL_SPI_Receive_Polling(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16
 /*!******************************************************************
  * \fn int32_t HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint8_t *pRxData, uint16_t size)
  * \brief SPI transmit/receive in DMA mode.
+ *        pRxData may be NULL to drop the received bytes.
  *
  * \param[in]  SPI_HandleTypeDef *spi     spi handle.
  * \param[in] uint8_t *pTxData            TX buffer
  * \param[in] uint16_t size               TX/RX buffer size
- * \param[out] uint8_t *pRxData           RX buffer
+ * \param[out] uint8_t *pRxData           RX buffer or NULL
  *
  * \retval Error code.
  *******************************************************************/
 int32_t HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint8_t *pRxData, uint16_t size);
 
+/*!******************************************************************
+ * \fn int32_t HAL_SPI_BusInit(SPI_HandleTypeDef *spi, bool idleOff)
+ * \brief Initializes an SPI instance as a master bus for queued transactions.
+ *        Devices are configured per transaction (frame format, speed, chip-select),
+ *        so several devices can share the instance. With idleOff the instance clock
+ *        is turned off whenever the queue drains and back on by the next submit.
+ *
+ * \param[in]  SPI_HandleTypeDef *spi     spi handle.
+ * \param[in]  bool idleOff               Power the instance down when idle.
+ * \param[out] none
+ *
+ * \retval Error code.
+ *******************************************************************/
+int32_t HAL_SPI_BusInit(SPI_HandleTypeDef *spi, bool idleOff);
+
+/*!******************************************************************
+ * \fn void HAL_SPI_DeviceInit(HAL_SPI_Device *dev)
+ * \brief Configures the chip-select pad of a device as GPIO output, deasserted (high).
+ *
+ * \param[in]  HAL_SPI_Device *dev        Device.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HAL_SPI_DeviceInit(HAL_SPI_Device *dev);
+
+/*!******************************************************************
+ * \fn int32_t HAL_SPI_Submit(SPI_HandleTypeDef *spi, HAL_SPI_Transaction *xfer)
+ * \brief Queues an SPI master transaction and returns immediately.
+ *        The chip-select of xfer->device is held low across all segments. Segments of
+ *        SPI_RX_FIFO_TRIG_LVL bytes or more are moved by DMA when the instance is in
+ *        DMA_MODE; shorter ones, and all of them in POLLING_MODE, are polled in the
+ *        context that reaches them, so the callback may run before this returns.
+ *        One-shot transfers must not be started while the queue is not empty.
+ *
+ * \param[in]  SPI_HandleTypeDef *spi     spi handle.
+ * \param[in]  HAL_SPI_Transaction *xfer  Transaction, must stay valid until completion.
+ * \param[out] none
+ *
+ * \retval Error code.
+ *******************************************************************/
+int32_t HAL_SPI_Submit(SPI_HandleTypeDef *spi, HAL_SPI_Transaction *xfer);
+
+/*!******************************************************************
+ * \fn void HAL_SPI_PrepareCommand(HAL_SPI_Transaction *xfer, HAL_SPI_Device *dev, uint8_t *cmd, uint16_t cmdSize,
+ *                                 uint8_t *data, uint16_t dataSize, uint8_t dir,
+ *                                 HAL_SPI_TransactionCallback_t callback, void *context)
+ * \brief Fills a command + data transaction (e.g. opcode and address, then payload).
+ *        A zero dataSize gives a command only transaction. For dir HAL_SPI_SEG_STREAM
+ *        data and dataSize are ignored and xfer->stream must be set by the caller.
+ *
+ * \param[in]  HAL_SPI_Transaction *xfer  Transaction to fill.
+ * \param[in]  HAL_SPI_Device *dev        Target device.
+ * \param[in]  uint8_t *cmd               Command bytes.
+ * \param[in]  uint16_t cmdSize           Command size.
+ * \param[in]  uint8_t *data              Data phase buffer.
+ * \param[in]  uint16_t dataSize          Data phase size.
+ * \param[in]  uint8_t dir                Data phase direction.
+ * \param[in]  HAL_SPI_TransactionCallback_t callback  Completion callback.
+ * \param[in]  void *context              User data for the callback.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HAL_SPI_PrepareCommand(HAL_SPI_Transaction *xfer, HAL_SPI_Device *dev, uint8_t *cmd, uint16_t cmdSize,
+                            uint8_t *data, uint16_t dataSize, uint8_t dir,
+                            HAL_SPI_TransactionCallback_t callback, void *context);
+
 /*!******************************************************************
  * \fn int32_t HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint16_t size)
  * \brief SPI transmit in DMA mode.
@@ -21,10 +21,13 @@
 #define DISTANCE(a,b)  ((a>b)?(a-b):(b-a))
 #endif
 
-#define SPI_RX_FIFO_TRIG_LVL      (4)
-
 #define ARM_SPI_DRV_VERSION    ARM_DRIVER_VERSION_MAJOR_MINOR(2, 0) // driver version
 
+#define SPI_SEGMENT_PENDING       (1)     // Queued segment handed to DMA, completion comes from the IRQ
+
+// Bytes of the next stream block
+#define SPI_STREAM_BLOCK_LEN(s)   ((((s)->total - (s)->done) > (s)->block) ? (s)->block : ((s)->total - (s)->done))
+
 #if ((!RTE_SPI0) && (!RTE_SPI1))
 #error "spi not enabled in RTE_Device.h!"
 #endif
@@ -292,11 +295,23 @@ SPI_HandleTypeDef hspi1 = {
 static dma_transfer_config g_dmaTxConfig = { NULL, NULL,
                                              DMA_FlowControlTarget, DMA_AddressIncrementSource,
                                              DMA_DataWidthOneByte,
-                                             DMA_Burst8Bytes, 0
+                                             HAL_DMA_SPI_BURST, 0
                                            };
 
 /* Function prototypes  ------------------------------------------------------------------*/
 
+/*!******************************************************************
+ * \fn static void HAL_SPI_DmaEvent(uint32_t event, void *context)
+ * \brief Forwards a DMA HAL event to the SPI tx/rx DMA callback.
+ *
+ * \param[in]  uint32_t event        DMA event.
+ * \param[in]  void *context         Pointer to the callback member of the SPI DMA structure.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_SPI_DmaEvent(uint32_t event, void *context);
+
 /*!******************************************************************
  * \fn int32_t HAL_SPI_Initialize(ARM_SPI_SignalEvent_t cb_event, SPI_HandleTypeDef *spi)
  * \brief Get SSP driver version.
@@ -414,6 +429,82 @@ static void SPI_Write1ByteFifo(SPI_HandleTypeDef *spi);
  *******************************************************************/
 static void SPI_ClearPendingIrq(SPI_HandleTypeDef *spi);
 
+/*!******************************************************************
+ * \fn static void SPI_DrainRxFifo(SPI_HandleTypeDef *spi)
+ * \brief Reads the RX FIFO into the current transfer, frames beyond xfer.num are left.
+ *        Bytes are dropped when the transfer has no RX buffer.
+ *
+ * \param[inout] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+static void SPI_DrainRxFifo(SPI_HandleTypeDef *spi);
+
+/*!******************************************************************
+ * \fn static int32_t HAL_SPI_BusSelect(SPI_HandleTypeDef *spi, HAL_SPI_Device *dev)
+ * \brief Powers the instance up if needed and configures it for a device.
+ *        Nothing is written when the bus is already set up for dev; a device with the
+ *        same frame format only changes the clock through SPI_SetBusSpeed.
+ *
+ * \param[in] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[in] HAL_SPI_Device *dev           Device.
+ * \param[out] none
+ *
+ * \retval Execution status.
+ *******************************************************************/
+static int32_t HAL_SPI_BusSelect(SPI_HandleTypeDef *spi, HAL_SPI_Device *dev);
+
+/*!******************************************************************
+ * \fn static int32_t HAL_SPI_AsyncStartSegment(SPI_HandleTypeDef *spi)
+ * \brief Starts the current segment (or stream block) of the transaction on the bus.
+ *
+ * \param[in] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[out] none
+ *
+ * \retval SPI_SEGMENT_PENDING if DMA runs it, ARM_DRIVER_OK if it was polled, or an error.
+ *******************************************************************/
+static int32_t HAL_SPI_AsyncStartSegment(SPI_HandleTypeDef *spi);
+
+/*!******************************************************************
+ * \fn static int32_t HAL_SPI_AsyncBegin(SPI_HandleTypeDef *spi)
+ * \brief Selects the device of the head transaction, asserts its chip-select and
+ *        starts the first segment.
+ *
+ * \param[in] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[out] none
+ *
+ * \retval Same as HAL_SPI_AsyncStartSegment.
+ *******************************************************************/
+static int32_t HAL_SPI_AsyncBegin(SPI_HandleTypeDef *spi);
+
+/*!******************************************************************
+ * \fn static int32_t HAL_SPI_AsyncRun(SPI_HandleTypeDef *spi, int32_t status)
+ * \brief Moves the head transaction on after a segment or stream block ended.
+ *        A finished stream block is handed out after the next one was started
+ *        in the other buffer.
+ *
+ * \param[in] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[in] int32_t status                Result of the segment that ended.
+ * \param[out] none
+ *
+ * \retval SPI_SEGMENT_PENDING, or the transaction result once it is over.
+ *******************************************************************/
+static int32_t HAL_SPI_AsyncRun(SPI_HandleTypeDef *spi, int32_t status);
+
+/*!******************************************************************
+ * \fn static void HAL_SPI_AsyncProgress(SPI_HandleTypeDef *spi, int32_t status)
+ * \brief Advances the transaction queue: finishes transactions, releases chip-select,
+ *        calls the callbacks and starts the next transaction or idles the bus.
+ *
+ * \param[in] SPI_HandleTypeDef *spi        SPI handle.
+ * \param[in] int32_t status                Result of the segment that ended.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+static void HAL_SPI_AsyncProgress(SPI_HandleTypeDef *spi, int32_t status);
+
 /* ---------------------------------------------------------------------------------------*/
 
 static uint32_t HAL_SPI_GetInstanceNumber(SPI_HandleTypeDef *spi) {
@@ -574,26 +665,19 @@ int32_t HAL_SPI_Initialize(ARM_SPI_SignalEvent_t cb_event, SPI_HandleTypeDef *sp
     // Configure DMA if necessary
     if (spi->dma)
     {
-        DMA_Init();
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)spi->dma->tx_req, HAL_SPI_DmaEvent, &spi->dma->tx_callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             spi->dma->tx_ch = returnCode;
 
-        DMA_ChannelSetRequestSource(spi->dma->tx_ch, (dma_request_source_t)spi->dma->tx_req);
-        DMA_ChannelRigisterCallback(spi->dma->tx_ch, spi->dma->tx_callback);
-
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)spi->dma->rx_req, HAL_SPI_DmaEvent, &spi->dma->rx_callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             spi->dma->rx_ch = returnCode;
-
-        DMA_ChannelSetRequestSource(spi->dma->rx_ch, (dma_request_source_t)spi->dma->rx_req);
-        DMA_ChannelRigisterCallback(spi->dma->rx_ch, spi->dma->rx_callback);
     }
 
     spi->info->flags = SPI_FLAG_INITIALIZED;  // SPI is initialized
@@ -651,8 +735,8 @@ int32_t HAL_SPI_PowerControl(ARM_POWER_STATE state, SPI_HandleTypeDef *spi) {
 
             // DMA disable
             if(spi->dma) {
-                DMA_StopChannel(spi->dma->tx_ch, true);
-                DMA_StopChannel(spi->dma->rx_ch, true);
+                HAL_DMA_Stop(spi->dma->tx_ch, true);
+                HAL_DMA_Stop(spi->dma->rx_ch, true);
             }
 
             // Reset register values
@@ -722,13 +806,17 @@ int32_t HAL_SPI_PowerControl(ARM_POWER_STATE state, SPI_HandleTypeDef *spi) {
     return ARM_DRIVER_OK;
 }
 
+PLAT_CODE_IN_RAM static void HAL_SPI_DmaEvent(uint32_t event, void *context) {
+    (*(dma_callback_t *)context)(event);
+}
+
 static void SPI_DMARxConfig(void* data_in, dma_address_increment_t option, SPI_HandleTypeDef *spi) {
 
     dma_transfer_config dmaConfig;
     dma_extra_config extraConfig;
 
     dmaConfig.addressIncrement              = option;
-    dmaConfig.burstSize                     = DMA_Burst8Bytes;
+    dmaConfig.burstSize                     = HAL_DMA_SPI_BURST;
     dmaConfig.dataWidth                     = (dma_data_width_t)spi->info->data_width;
     dmaConfig.flowControl                   = DMA_FlowControlSource;
     dmaConfig.sourceAddress                 = (void*)&(spi->reg->DR);
@@ -771,6 +859,23 @@ static void SPI_Write1ByteFifo(SPI_HandleTypeDef *spi) {
     spi->info->xfer.tx_cnt++;
 }
 
+static void SPI_DrainRxFifo(SPI_HandleTypeDef *spi) {
+    uint32_t data;
+
+    while ((spi->reg->SR & SPI_SR_RNE_Msk) && (spi->info->xfer.rx_cnt < spi->info->xfer.num)) {
+        data = spi->reg->DR;
+
+        if(spi->info->xfer.rx_buf) {
+            if(spi->info->data_width == 2)
+                *((uint16_t *)(spi->info->xfer.rx_buf + 2 * spi->info->xfer.rx_cnt)) = (uint16_t)data;
+            else
+                spi->info->xfer.rx_buf[spi->info->xfer.rx_cnt] = (uint8_t)data;
+        }
+
+        spi->info->xfer.rx_cnt++;
+    }
+}
+
 void HAL_SPI_DisableIRQ(SPI_HandleTypeDef *spi) {
     spi->reg->IMSC &= (~SPI_IMSC_TXIM_Msk);
     //spi->reg->IMSC &= (~SPI_IMSC_RXIM_Msk);
@@ -809,7 +914,7 @@ int32_t HAL_SPI_Receive_DMA(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16_t s
 #endif
     uint8_t data_width;
 
-    if ((pRxData == NULL) || (size == 0))
+    if ((pRxData == NULL) || (size == 0) || ((size * spi->info->data_width) > HAL_DMA_MAX_DESC_LEN))
         return ARM_DRIVER_ERROR_PARAMETER;
 
     if (!(spi->info->flags & SPI_FLAG_CONFIGURED))
@@ -826,6 +931,7 @@ int32_t HAL_SPI_Receive_DMA(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16_t s
     spi->info->status.busy       = 1U;
     spi->info->status.data_lost  = 0;
     spi->info->status.mode_fault = 0;
+    spi->info->transfer_type     = SPI_TRANSMIT_RECEIVE;
 
     spi->info->xfer.rx_buf   = pRxData;
     spi->info->xfer.tx_buf   = pRxData;
@@ -858,13 +964,11 @@ int32_t HAL_SPI_Receive_DMA(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16_t s
     g_dmaTxConfig.targetAddress = (void *)&(spi->reg->DR);
     g_dmaTxConfig.totalLength   = (size * data_width);
 
-    DMA_TransferSetup(spi->dma->tx_ch, &g_dmaTxConfig);
-    DMA_EnableChannelInterrupts(spi->dma->tx_ch, DMA_EndInterruptEnable);
-    DMA_StartChannel(spi->dma->tx_ch);
+    HAL_DMA_Start(spi->dma->tx_ch, &g_dmaTxConfig);
 
     SPI_DMARxConfig(pRxData, DMA_AddressIncrementTarget, spi);
-    DMA_ChannelLoadFirstDescriptor(spi->dma->rx_ch, (void *)spi->dma->descriptor);
-    DMA_StartChannel(spi->dma->rx_ch);
+    // Rx descriptor is re-armed chunk by chunk from the SPI IRQ until HAL_DMA_Stop
+    HAL_DMA_StartChain(spi->dma->rx_ch, spi->dma->descriptor, true);
 
     // Enable DMA
     spi->reg->DMACR |= (SPI_DMACR_TXDMAE_Msk | SPI_DMACR_RXDMAE_Msk);
@@ -878,7 +982,7 @@ int32_t HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint16_t
 #endif
     uint8_t data_width;
 
-    if ((pTxData == NULL) || (size == 0))
+    if ((pTxData == NULL) || (size == 0) || ((size * spi->info->data_width) > HAL_DMA_MAX_DESC_LEN))
         return ARM_DRIVER_ERROR_PARAMETER;
 
     if (!(spi->info->flags & SPI_FLAG_CONFIGURED))
@@ -924,9 +1028,7 @@ int32_t HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint16_t
     g_dmaTxConfig.targetAddress = (void *)&(spi->reg->DR);
     g_dmaTxConfig.totalLength   = (size * data_width);
 
-    DMA_TransferSetup(spi->dma->tx_ch, &g_dmaTxConfig);
-    DMA_EnableChannelInterrupts(spi->dma->tx_ch, DMA_EndInterruptEnable);
-    DMA_StartChannel(spi->dma->tx_ch);
+    HAL_DMA_Start(spi->dma->tx_ch, &g_dmaTxConfig);
 
     // Enable DMA
     spi->reg->DMACR |= (SPI_DMACR_TXDMAE_Msk | SPI_DMACR_RXDMAE_Msk);
@@ -940,7 +1042,7 @@ int32_t HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, ui
 #endif
     uint8_t data_width;
 
-    if ((pTxData == NULL) || (pRxData == NULL) || (size == 0))
+    if ((pTxData == NULL) || (size == 0) || ((size * spi->info->data_width) > HAL_DMA_MAX_DESC_LEN))
         return ARM_DRIVER_ERROR_PARAMETER;
 
     if (!(spi->info->flags & SPI_FLAG_CONFIGURED))
@@ -957,6 +1059,7 @@ int32_t HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, ui
     spi->info->status.busy       = 1U;
     spi->info->status.data_lost  = 0;
     spi->info->status.mode_fault = 0;
+    spi->info->transfer_type     = SPI_TRANSMIT_RECEIVE;
 
     spi->info->xfer.rx_buf   = pRxData;
     spi->info->xfer.tx_buf   = pTxData;
@@ -989,13 +1092,15 @@ int32_t HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *spi, uint8_t *pTxData, ui
     g_dmaTxConfig.targetAddress = (void *)&(spi->reg->DR);
     g_dmaTxConfig.totalLength   = (size * data_width);
 
-    DMA_TransferSetup(spi->dma->tx_ch, &g_dmaTxConfig);
-    DMA_EnableChannelInterrupts(spi->dma->tx_ch, DMA_EndInterruptEnable);
-    DMA_StartChannel(spi->dma->tx_ch);
+    HAL_DMA_Start(spi->dma->tx_ch, &g_dmaTxConfig);
 
-    SPI_DMARxConfig(pRxData, DMA_AddressIncrementTarget, spi);
-    DMA_ChannelLoadFirstDescriptor(spi->dma->rx_ch, (void *)spi->dma->descriptor);
-    DMA_StartChannel(spi->dma->rx_ch);
+    // Without a receive buffer the frames are dropped into dump_val
+    if(pRxData)
+        SPI_DMARxConfig(pRxData, DMA_AddressIncrementTarget, spi);
+    else
+        SPI_DMARxConfig(&spi->info->xfer.dump_val, DMA_AddressIncrementNone, spi);
+    // Rx descriptor is re-armed chunk by chunk from the SPI IRQ until HAL_DMA_Stop
+    HAL_DMA_StartChain(spi->dma->rx_ch, spi->dma->descriptor, true);
 
     // Enable DMA
     spi->reg->DMACR |= (SPI_DMACR_TXDMAE_Msk | SPI_DMACR_RXDMAE_Msk);
@@ -1029,7 +1134,7 @@ int32_t HAL_SPI_Receive_IT(SPI_HandleTypeDef *spi, uint8_t *pData, uint16_t size
     spi_buffer_size = size;
 
     /* Clear RX FIFO */
-    HAL_SPI_CleanRxFifo(&hspi1);
+    HAL_SPI_CleanRxFifo(spi);
 
     if((spi->info->xfer.rx_cnt < spi->info->xfer.num)) {
         
@@ -1106,7 +1211,7 @@ int32_t HAL_SPI_Transmit_IT(SPI_HandleTypeDef *spi, uint8_t *pData, uint16_t siz
             while(spi->reg->SR & SPI_SR_BSY_Msk);
             
             // Clear dummy data in RF FIFO
-            HAL_SPI_CleanRxFifo(&hspi1);
+            HAL_SPI_CleanRxFifo(spi);
         }
 
         spi->info->status.busy = 0;
@@ -1202,9 +1307,12 @@ int32_t HAL_SPI_Receive_Polling(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16
     spi->info->status.mode_fault = 0;
 
     spi->info->xfer.rx_buf = pRxData;
+    spi->info->xfer.num    = size;
+    spi->info->xfer.tx_cnt = 0;
+    spi->info->xfer.rx_cnt = 0;
 
     /* Clear RX FIFO */
-    HAL_SPI_CleanRxFifo(&hspi1);
+    HAL_SPI_CleanRxFifo(spi);
 
     while((spi->info->xfer.rx_cnt < spi->info->xfer.num)) {
         
@@ -1216,8 +1324,10 @@ int32_t HAL_SPI_Receive_Polling(SPI_HandleTypeDef *spi, uint8_t *pRxData, uint16
             spi->reg->DR = 0xFF;
 
         // Check overrun error in RIS register
-        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk)
+        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk) {
+            spi->info->status.busy = 0;
             return ARM_DRIVER_ERROR;
+        }
 
         /* Wait for the end of unfinished processes (read/write SPI processes)*/
         while(spi->reg->SR & SPI_SR_BSY_Msk);
@@ -1253,9 +1363,12 @@ int32_t HAL_SPI_Transmit_Polling(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint1
     spi->info->status.mode_fault = 0;
 
     spi->info->xfer.tx_buf = pTxData;
+    spi->info->xfer.num    = size;
+    spi->info->xfer.tx_cnt = 0;
+    spi->info->xfer.rx_cnt = 0;
 
     /* Clear RX FIFO */
-    HAL_SPI_CleanRxFifo(&hspi1);
+    HAL_SPI_CleanRxFifo(spi);
 
     SPI_ClearPendingIrq(spi);
 
@@ -1273,11 +1386,13 @@ int32_t HAL_SPI_Transmit_Polling(SPI_HandleTypeDef *spi, uint8_t *pTxData, uint1
         }
 
         // Check overrun error in RIS register
-        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk)
+        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk) {
+            spi->info->status.busy = 0;
             return ARM_DRIVER_ERROR;
+        }
 
         // Clear dummy data in RF FIFO
-        HAL_SPI_CleanRxFifo(&hspi1);
+        HAL_SPI_CleanRxFifo(spi);
     }
     
     spi->info->status.busy = 0;
@@ -1306,9 +1421,12 @@ int32_t HAL_SPI_TransmitReceive_Polling(SPI_HandleTypeDef *spi, uint8_t *pTxData
 
     spi->info->xfer.tx_buf = pTxData;
     spi->info->xfer.rx_buf = pRxData;
+    spi->info->xfer.num    = size;
+    spi->info->xfer.tx_cnt = 0;
+    spi->info->xfer.rx_cnt = 0;
 
     /* Clear RX FIFO */
-    HAL_SPI_CleanRxFifo(&hspi1);
+    HAL_SPI_CleanRxFifo(spi);
 
     SPI_ClearPendingIrq(spi);
 
@@ -1325,8 +1443,10 @@ int32_t HAL_SPI_TransmitReceive_Polling(SPI_HandleTypeDef *spi, uint8_t *pTxData
         }
 
         // Check overrun error in RIS register
-        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk)
+        if(spi->reg->RIS & SPI_RIS_RORRIS_Msk) {
+            spi->info->status.busy = 0;
             return ARM_DRIVER_ERROR;
+        }
 
         /* Wait for the end of unfinished processes (read/write SPI processes)*/
         while(spi->reg->SR & SPI_SR_BSY_Msk);
@@ -1360,8 +1480,8 @@ int32_t HAL_SPI_Control(uint32_t control, uint32_t arg, SPI_HandleTypeDef *spi)
         if(spi->info->status.busy) {
             // If DMA mode, disable DMA channel
             if(spi->dma) {
-                DMA_StopChannel(spi->dma->tx_ch, true);
-                DMA_StopChannel(spi->dma->rx_ch, true);
+                HAL_DMA_Stop(spi->dma->tx_ch, true);
+                HAL_DMA_Stop(spi->dma->rx_ch, true);
             }
         }
 
@@ -1581,7 +1701,274 @@ int32_t HAL_SPI_Control(uint32_t control, uint32_t arg, SPI_HandleTypeDef *spi)
     return ARM_DRIVER_OK;
 }
 
+static int32_t HAL_SPI_BusSelect(SPI_HandleTypeDef *spi, HAL_SPI_Device *dev) {
+    int32_t ret;
+
+    if(!(spi->info->flags & SPI_FLAG_POWERED)) {
+        ret = HAL_SPI_PowerControl(ARM_POWER_FULL, spi);
+
+        if(ret != ARM_DRIVER_OK)
+            return ret;
+
+        spi->info->device = NULL;
+        spi->info->power_ups++;
+    }
+
+    if(spi->info->device == dev)
+        return ARM_DRIVER_OK;
+
+    if(spi->info->device && (spi->info->device->frame == dev->frame)) {
+        spi->reg->CR1 &= ~SPI_CR1_SSE_Msk;
+        ret = SPI_SetBusSpeed(dev->bus_speed, spi);
+        spi->reg->CR1 |= SPI_CR1_SSE_Msk;
+    } else {
+        ret = HAL_SPI_Control(ARM_SPI_MODE_MASTER | dev->frame | ARM_SPI_DATA_BITS(8) | ARM_SPI_SS_MASTER_UNUSED,
+                              dev->bus_speed, spi);
+    }
+
+    spi->info->device = (ret == ARM_DRIVER_OK) ? dev : NULL;
+
+    return ret;
+}
+
+static int32_t HAL_SPI_AsyncStartSegment(SPI_HandleTypeDef *spi) {
+    HAL_SPI_Transaction *xfer = spi->info->xfer_head;
+    HAL_SPI_Segment *seg = &xfer->segments[spi->info->seg];
+    uint8_t *data = seg->data;
+    uint32_t len = seg->len;
+    int32_t ret;
+
+    if(seg->dir == HAL_SPI_SEG_STREAM) {
+        data = xfer->stream->buf[xfer->stream->active];
+        len = SPI_STREAM_BLOCK_LEN(xfer->stream);
+    }
+
+    if(spi->dma && (len >= SPI_RX_FIFO_TRIG_LVL)) {
+        if(seg->dir == HAL_SPI_SEG_WRITE)
+            ret = HAL_SPI_TransmitReceive_DMA(spi, data, NULL, len);
+        else
+            ret = HAL_SPI_Receive_DMA(spi, data, len);
+
+        return (ret == ARM_DRIVER_OK) ? SPI_SEGMENT_PENDING : ret;
+    }
+
+    if(seg->dir == HAL_SPI_SEG_WRITE)
+        return HAL_SPI_Transmit_Polling(spi, data, len);
+
+    return HAL_SPI_Receive_Polling(spi, data, len);
+}
+
+static int32_t HAL_SPI_AsyncBegin(SPI_HandleTypeDef *spi) {
+    HAL_SPI_Transaction *xfer = spi->info->xfer_head;
+    int32_t ret;
+
+    ret = HAL_SPI_BusSelect(spi, xfer->device);
+
+    if(ret != ARM_DRIVER_OK)
+        return ret;
+
+    if(xfer->stream) {
+        xfer->stream->done = 0;
+        xfer->stream->active = 0;
+    }
+
+    spi->info->seg = 0;
+    GPIO_PinWrite(xfer->device->cs_instance, 1 << xfer->device->cs_index, 0);
+
+    return HAL_SPI_AsyncStartSegment(spi);
+}
+
+static int32_t HAL_SPI_AsyncRun(SPI_HandleTypeDef *spi, int32_t status) {
+    HAL_SPI_Transaction *xfer = spi->info->xfer_head;
+    HAL_SPI_Stream *stream;
+    uint8_t *filled;
+    uint32_t len;
+    bool more;
+
+    while(status == ARM_DRIVER_OK) {
+        if(xfer->segments[spi->info->seg].dir == HAL_SPI_SEG_STREAM) {
+            stream = xfer->stream;
+            filled = stream->buf[stream->active];
+            len = SPI_STREAM_BLOCK_LEN(stream);
+
+            stream->done += len;
+            stream->active ^= 1;
+            more = (stream->done < stream->total);
+
+            // Keep the bus busy with the other buffer while this one is consumed
+            if(more)
+                status = HAL_SPI_AsyncStartSegment(spi);
+
+            if(stream->on_block)
+                stream->on_block(stream, filled, len);
+
+            if(more)
+                continue;
+        }
+
+        if(++spi->info->seg >= xfer->count)
+            break;
+
+        status = HAL_SPI_AsyncStartSegment(spi);
+    }
+
+    return status;
+}
+
+static void HAL_SPI_AsyncProgress(SPI_HandleTypeDef *spi, int32_t status) {
+    HAL_SPI_Transaction *xfer;
+    uint32_t mask;
+    bool last;
+
+    while((status = HAL_SPI_AsyncRun(spi, status)) != SPI_SEGMENT_PENDING) {
+        xfer = spi->info->xfer_head;
+
+        GPIO_PinWrite(xfer->device->cs_instance, 1 << xfer->device->cs_index, 1 << xfer->device->cs_index);
+
+        mask = SaveAndSetIRQMask();
+
+        spi->info->xfer_head = xfer->next;
+        last = (xfer->next == NULL);
+
+        if(last) {
+            spi->info->xfer_tail = NULL;
+            spi->info->flags &= ~SPI_FLAG_ASYNC;
+
+            if(spi->info->flags & SPI_FLAG_IDLE_OFF) {
+                HAL_SPI_PowerControl(ARM_POWER_OFF, spi);
+                spi->info->device = NULL;
+            }
+        }
+
+        RestoreIRQMask(mask);
+
+        xfer->next = NULL;
+        xfer->status = status;
+
+        if(xfer->callback)
+            xfer->callback(xfer, status);
+
+        if(last)
+            return;
+
+        status = HAL_SPI_AsyncBegin(spi);
+    }
+}
+
+int32_t HAL_SPI_BusInit(SPI_HandleTypeDef *spi, bool idleOff) {
+    int32_t ret;
+
+    ret = HAL_SPI_Initialize(NULL, spi);
+
+    if(ret != ARM_DRIVER_OK)
+        return ret;
+
+    spi->info->xfer_head = NULL;
+    spi->info->xfer_tail = NULL;
+    spi->info->device = NULL;
+    spi->info->power_ups = 0;
+
+    if(idleOff) {
+        spi->info->flags |= SPI_FLAG_IDLE_OFF;
+        return ARM_DRIVER_OK;
+    }
+
+    spi->info->flags &= ~SPI_FLAG_IDLE_OFF;
+
+    return HAL_SPI_PowerControl(ARM_POWER_FULL, spi);
+}
+
+void HAL_SPI_DeviceInit(HAL_SPI_Device *dev) {
+    pad_config_t padConfig;
+    gpio_pin_config_t gpioConfig;
+
+    PAD_GetDefaultConfig(&padConfig);
+    padConfig.mux = PAD_MuxAlt0;
+    PAD_SetPinConfig(dev->cs_pad, &padConfig);
+
+    gpioConfig.pinDirection = GPIO_DirectionOutput;
+    gpioConfig.misc.initOutput = 1;
+    GPIO_PinConfig(dev->cs_instance, dev->cs_index, &gpioConfig);
+}
+
+int32_t HAL_SPI_Submit(SPI_HandleTypeDef *spi, HAL_SPI_Transaction *xfer) {
+    HAL_SPI_Stream *stream;
+    uint32_t mask;
+    uint32_t i;
+
+    if(!xfer || !xfer->device || !xfer->count || (xfer->count > HAL_SPI_MAX_SEGMENTS))
+        return ARM_DRIVER_ERROR_PARAMETER;
+
+    for(i = 0; i < xfer->count; i++) {
+        if(xfer->segments[i].dir == HAL_SPI_SEG_STREAM) {
+            stream = xfer->stream;
+
+            if((i != xfer->count - 1U) || !stream || !stream->buf[0] || !stream->buf[1] || !stream->total ||
+               !stream->block || (stream->block > HAL_DMA_MAX_DESC_LEN))
+                return ARM_DRIVER_ERROR_PARAMETER;
+        } else if(!xfer->segments[i].data || !xfer->segments[i].len || (xfer->segments[i].len > HAL_DMA_MAX_DESC_LEN)) {
+            return ARM_DRIVER_ERROR_PARAMETER;
+        }
+    }
+
+    if(!(spi->info->flags & SPI_FLAG_INITIALIZED))
+        return ARM_DRIVER_ERROR;
+
+    xfer->status = ARM_DRIVER_ERROR_BUSY;
+    xfer->next = NULL;
+
+    mask = SaveAndSetIRQMask();
+
+    if(spi->info->flags & SPI_FLAG_ASYNC) {
+        spi->info->xfer_tail->next = xfer;
+        spi->info->xfer_tail = xfer;
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_OK;
+    }
+
+    if(spi->info->status.busy) {
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    spi->info->xfer_head = xfer;
+    spi->info->xfer_tail = xfer;
+    spi->info->flags |= SPI_FLAG_ASYNC;
+
+    RestoreIRQMask(mask);
+
+    // The bus is ours now, later submits only append to the queue
+    HAL_SPI_AsyncProgress(spi, HAL_SPI_AsyncBegin(spi));
+
+    return ARM_DRIVER_OK;
+}
+
+void HAL_SPI_PrepareCommand(HAL_SPI_Transaction *xfer, HAL_SPI_Device *dev, uint8_t *cmd, uint16_t cmdSize,
+                            uint8_t *data, uint16_t dataSize, uint8_t dir,
+                            HAL_SPI_TransactionCallback_t callback, void *context) {
+    xfer->device = dev;
+    xfer->count = 0;
+    xfer->callback = callback;
+    xfer->context = context;
+
+    xfer->segments[xfer->count].data = cmd;
+    xfer->segments[xfer->count].len = cmdSize;
+    xfer->segments[xfer->count].dir = HAL_SPI_SEG_WRITE;
+    xfer->count++;
+
+    if(dataSize || (dir == HAL_SPI_SEG_STREAM)) {
+        xfer->segments[xfer->count].data = data;
+        xfer->segments[xfer->count].len = dataSize;
+        xfer->segments[xfer->count].dir = dir;
+        xfer->count++;
+    }
+}
+
 void SPI_IRQHandler(SPI_HandleTypeDef *spi) {
+#ifdef PM_FEATURE_ENABLE
+    uint32_t instance = HAL_SPI_GetInstanceNumber(spi);
+#endif
+
     HAL_SPI_DisableIRQ(spi);
 
     if(!spi->dma) {
@@ -1607,15 +1994,24 @@ void SPI_IRQHandler(SPI_HandleTypeDef *spi) {
         }    
     
     } else {
-        if(spi->info->xfer.rx_cnt == spi->info->xfer.num) {
+        // Tail shorter than a DMA chunk, left to the cpu by HAL_SPI_DmaRxEvent
+        SPI_DrainRxFifo(spi);
+        spi->reg->ICR = SPI_ICR_RTIC_Msk;
+
+        if(spi->info->status.busy && (spi->info->xfer.rx_cnt == spi->info->xfer.num)) {
             // disable interrupts no matter what kind of trasaction is
             spi->reg->IMSC &= ~(SPI_IMSC_TXIM_Msk | SPI_IMSC_RXIM_Msk | SPI_IMSC_RTIM_Msk | SPI_IMSC_RORIM_Msk);
             spi->info->status.busy = 0;
-            spi->info->cb_event(ARM_SPI_EVENT_TX_RX_COMPLETE);
-            
+
+            // Release the vote first, the completion may start the next transfer
 #ifdef PM_FEATURE_ENABLE
             CHECK_TO_UNLOCK_SLEEP(instance);
 #endif
+
+            if(spi->info->flags & SPI_FLAG_ASYNC)
+                HAL_SPI_AsyncProgress(spi, ARM_DRIVER_OK);
+            else if(spi->info->cb_event)
+                spi->info->cb_event(ARM_SPI_EVENT_TX_RX_COMPLETE);
         }
     }
     
@@ -1663,25 +2059,27 @@ void HAL_SPI_DmaRxEvent(uint32_t event, SPI_HandleTypeDef *spi) {
                 spi->dma->descriptor->TAR =  (spi->info->xfer.rx_buf == NULL)? ((uint32_t)&spi->info->xfer.dump_val) : (uint32_t)(spi->info->xfer.rx_buf + spi->info->xfer.rx_cnt);
 
                 // load descriptor and start DMA transfer
-                extern void DMA_ChannelLoadDescriptorAndRun(uint32_t channel, void* descriptorAddress);
-                DMA_ChannelLoadDescriptorAndRun(dma_rx_channel, spi->dma->descriptor);
+                HAL_DMA_ReloadChain(dma_rx_channel, spi->dma->descriptor);
             
             } else if(remained_cnt == 0) {
-                DMA_StopChannel(dma_rx_channel, true);
+                HAL_DMA_Stop(dma_rx_channel, true);
                 spi->reg->DMACR &= ~SPI_DMACR_RXDMAE_Msk;
                 spi->info->status.busy = 0;
                 spi_buffer_size = 0;
 
-                if(spi->info->cb_event)
-                    spi->info->cb_event(ARM_SPI_EVENT_TX_RX_COMPLETE);
-                
+                // Release the vote first, the completion may start the next transfer
 #ifdef PM_FEATURE_ENABLE
-                 CHECK_TO_UNLOCK_SLEEP(instance);
+                CHECK_TO_UNLOCK_SLEEP(instance);
 #endif
+
+                if(spi->info->flags & SPI_FLAG_ASYNC)
+                    HAL_SPI_AsyncProgress(spi, ARM_DRIVER_OK);
+                else if(spi->info->cb_event)
+                    spi->info->cb_event(ARM_SPI_EVENT_TX_RX_COMPLETE);
             }
             // let cpu transfer last tailing data
             else {
-                DMA_StopChannel(dma_rx_channel, true);
+                HAL_DMA_Stop(dma_rx_channel, true);
                 spi->reg->DMACR &= ~SPI_DMACR_RXDMAE_Msk;
                 spi->reg->IMSC = SPI_IMSC_RXIM_Msk | SPI_IMSC_RTIM_Msk | SPI_IMSC_RORIM_Msk;
 
@@ -1690,6 +2088,17 @@ void HAL_SPI_DmaRxEvent(uint32_t event, SPI_HandleTypeDef *spi) {
 
             break;
         case DMA_EVENT_ERROR:
+            if(spi->info->flags & SPI_FLAG_ASYNC) {
+                HAL_DMA_Stop(spi->dma->tx_ch, false);
+                HAL_DMA_Stop(spi->dma->rx_ch, false);
+                spi->reg->DMACR &= ~(SPI_DMACR_TXDMAE_Msk | SPI_DMACR_RXDMAE_Msk);
+                spi->info->status.busy = 0;
+#ifdef PM_FEATURE_ENABLE
+                CHECK_TO_UNLOCK_SLEEP(instance);
+#endif
+                HAL_SPI_AsyncProgress(spi, ARM_DRIVER_ERROR);
+            }
+            break;
         default:
             break;
     }
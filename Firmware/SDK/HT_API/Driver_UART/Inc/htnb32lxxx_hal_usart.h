@@ -49,6 +49,7 @@
 #include "HT_bsp.h"
 #include "HT_plat_config.h"
 #include "hal_uart.h"
+#include "htnb32lxxx_hal_dma.h"
 
 /* Defines  ------------------------------------------------------------------*/
 
@@ -113,6 +114,18 @@
 
 #endif
 
+// Print (stdout) buffering, active when the print USART TX is in IRQ_MODE
+#define USART_PRINT_POLICY_DROP     0     // Discard what does not fit in the ring
+#define USART_PRINT_POLICY_BLOCK    1     // Spin draining the FIFO until it fits
+
+#ifndef USART_PRINT_BUFFER_SIZE
+#define USART_PRINT_BUFFER_SIZE     1024
+#endif
+
+#ifndef USART_PRINT_POLICY
+#define USART_PRINT_POLICY          USART_PRINT_POLICY_DROP
+#endif
+
 #define USART0_TX_TRIG_LVL   TX_FIFO_TRIG_LVL_0BYTE
 #define USART1_TX_TRIG_LVL   TX_FIFO_TRIG_LVL_0BYTE
 #define USART2_TX_TRIG_LVL   TX_FIFO_TRIG_LVL_0BYTE
@@ -170,6 +183,12 @@ typedef struct _USART_STATUS {
   uint8_t rx_parity_error;              // Parity error detected on receive (cleared on start of next receive operation)
 } USART_STATUS;
 
+/**
+  \brief Called with true right after the print USART functional clock is gated
+         and with false right after it is running again. Runs with interrupts masked.
+ */
+typedef void (*HAL_USART_PrintGateCallback_t)(bool gated);
+
 typedef struct _USART_INFO {
   ARM_USART_SignalEvent_t cb_event;            // Event Callback
   USART_STATUS            rx_status;           // Recieve Status flags
@@ -391,6 +410,12 @@ void HAL_USART_Receive_IT(uint8_t *pRxBuff, uint32_t size);
 /*!******************************************************************
  * \fn int32_t HAL_USART_Receive_DMA(USART_HandleTypeDef *huart, uint8_t *pRxBuff, uint32_t size)
  * \brief Receive a buffer through USART peripheral in DMA mode.
+ *        Each time the line goes idle (RX timeout) the bytes so far are in
+ *        pRxBuff, HAL_USART_GetRxCount tells how many, and the callback gets
+ *        ARM_USART_EVENT_RX_TIMEOUT; reception continues after them. A full
+ *        buffer ends the receive with ARM_USART_EVENT_RECEIVE_COMPLETE or
+ *        ARM_USART_EVENT_DMA_RX_COMPLETE. Line errors are reported as
+ *        ARM_USART_EVENT_RX_OVERFLOW/BREAK/FRAMING_ERROR/PARITY_ERROR.
  *
  * \param[in] USART_HandleTypeDef *huart        USART handle.
  * \param[in] uint8_t *pRxBuff                  RX buffer.
@@ -502,6 +527,78 @@ int32_t HAL_USART_GetTxCount(USART_HandleTypeDef *usart);
  *******************************************************************/
 ARM_USART_STATUS HAL_USART_GetStatus(USART_HandleTypeDef *usart);
 
+/*!******************************************************************
+ * \fn void HAL_USART_FlushPrint(void)
+ * \brief Drains the print ring buffer and waits for the TX shifter to be empty.
+ *        Safe to call with interrupts masked, e.g. from sleep callbacks.
+ *
+ * \param[in] none
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_USART_FlushPrint(void);
+
+/*!******************************************************************
+ * \fn uint32_t HAL_USART_GetPrintDropped(void)
+ * \brief Gets the number of print bytes discarded because the ring was full.
+ *
+ * \param[in] none
+ * \param[out] none
+ *
+ * \retval Dropped byte count since boot.
+ *******************************************************************/
+uint32_t HAL_USART_GetPrintDropped(void);
+
+/*!******************************************************************
+ * \fn int32_t HAL_USART_PrintGate(void)
+ * \brief Stops the functional clock of the print USART. Refused while the
+ *        print ring holds data, the TX shifter is busy or a character is
+ *        being received. The next _write() or HAL_USART_PrintUngate() starts
+ *        the clock again. Reception is blind while gated.
+ *
+ * \param[in] none
+ * \param[out] none
+ *
+ * \retval ARM_DRIVER_OK, ARM_DRIVER_ERROR_BUSY if there is traffic, or
+ *         ARM_DRIVER_ERROR(_UNSUPPORTED) if the print output is not buffered.
+ *******************************************************************/
+int32_t HAL_USART_PrintGate(void);
+
+/*!******************************************************************
+ * \fn void HAL_USART_PrintUngate(void)
+ * \brief Restarts the functional clock of the print USART if gated.
+ *        Callable from interrupt context.
+ *
+ * \param[in] none
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_USART_PrintUngate(void);
+
+/*!******************************************************************
+ * \fn bool HAL_USART_PrintIsGated(void)
+ * \brief Tells whether the print USART functional clock is gated.
+ *
+ * \param[in] none
+ * \param[out] none
+ *
+ * \retval true if gated.
+ *******************************************************************/
+bool HAL_USART_PrintIsGated(void);
+
+/*!******************************************************************
+ * \fn void HAL_USART_SetPrintGateCallback(HAL_USART_PrintGateCallback_t cb)
+ * \brief Registers the function told about every gate and ungate.
+ *
+ * \param[in] HAL_USART_PrintGateCallback_t cb    Callback, NULL to remove.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+void HAL_USART_SetPrintGateCallback(HAL_USART_PrintGateCallback_t cb);
+
 /*!******************************************************************
  * \fn void HT_USART_Callback(uint32_t event)
  * \brief USART interruption callback.
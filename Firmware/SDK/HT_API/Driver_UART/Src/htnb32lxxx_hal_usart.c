@@ -17,14 +17,36 @@
 #include "slpman_qcx212.h"
 #include "HT_Peripheral_Config.h"
 #include "HT_usart_unilog.h"
+#include "ring_buffer.h"
+
+/* Print buffering ------------------------------------------------------------------*/
+
+#if (RTE_UART0 && (USART_PRINT_SELECT == HAL_USART0_SELECT) && (RTE_UART0_TX_IO_MODE == IRQ_MODE))
+#define USART_PRINT_BUFFERED    1
+#define USART_PRINT_HANDLE      ((USART_HandleTypeDef *)&huart0)
+#elif (RTE_UART1 && (USART_PRINT_SELECT == HAL_USART1_SELECT) && (RTE_UART1_TX_IO_MODE == IRQ_MODE))
+#define USART_PRINT_BUFFERED    1
+#define USART_PRINT_HANDLE      ((USART_HandleTypeDef *)&huart1)
+#elif (RTE_UART2 && (USART_PRINT_SELECT == HAL_USART2_SELECT) && (RTE_UART2_TX_IO_MODE == IRQ_MODE))
+#define USART_PRINT_BUFFERED    1
+#define USART_PRINT_HANDLE      ((USART_HandleTypeDef *)&huart2)
+#else
+#define USART_PRINT_BUFFERED    0
+#endif
 
 /* Function prototypes  ------------------------------------------------------------------*/
 
-// declearation for DMA API
-extern void DMA_StopChannelNoWait(uint32_t channel);
-extern uint32_t DMA_SetDescriptorTransferLen(uint32_t dcmd, uint32_t len);
-extern void DMA_ChannelLoadDescriptorAndRun(uint32_t channel, void* descriptorAddress);
-extern uint32_t DMA_ChannelGetCurrentTargetAddress(uint32_t channel, bool sync);
+/*!******************************************************************
+ * \fn static void HAL_USART_DmaEvent(uint32_t event, void *context)
+ * \brief Forwards a DMA HAL event to the USART tx/rx DMA callback.
+ *
+ * \param[in] uint32_t event           DMA event.
+ * \param[in] void *context            Pointer to the callback member of the USART DMA structure.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_USART_DmaEvent(uint32_t event, void *context);
 
 /*!******************************************************************
  * \fn PLAT_CODE_IN_RAM static uint32_t HAL_USART_GetInstanceNumber(USART_HandleTypeDef *usart)
@@ -78,6 +100,31 @@ static void HAL_USART_DmaRxConfig(USART_HandleTypeDef *usart);
  *******************************************************************/
 PLAT_CODE_IN_RAM static void HAL_USART_DmaUpdateRxConfig(USART_HandleTypeDef *usart, uint32_t targetAddress, uint32_t num);
 
+/*!******************************************************************
+ * \fn PLAT_CODE_IN_RAM static void HAL_USART_DmaRxIdle(USART_HandleTypeDef *usart)
+ * \brief Ends a DMA receive frame on RX timeout: syncs with the running burst,
+ *        drains the FIFO tail, re-arms the DMA after the received bytes and
+ *        reports ARM_USART_EVENT_RX_TIMEOUT (or DMA_RX_COMPLETE when full).
+ *
+ * \param[in] USART_HandleTypeDef *usart           USART handle.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_USART_DmaRxIdle(USART_HandleTypeDef *usart);
+
+/*!******************************************************************
+ * \fn PLAT_CODE_IN_RAM static void HAL_USART_RxLineStatus(USART_HandleTypeDef *usart)
+ * \brief Reads (and so clears) the RX line status and reports overrun, break,
+ *        framing and parity errors as the matching ARM_USART_EVENT_*.
+ *
+ * \param[in] USART_HandleTypeDef *usart           USART handle.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_USART_RxLineStatus(USART_HandleTypeDef *usart);
+
 /*!******************************************************************
  * \fn static void __attribute__((unused)) HAL_USART_SetupFifo(USART_HandleTypeDef *huart, uint32_t fcr)
  * \brief Set up the USART FIFO.
@@ -135,6 +182,21 @@ static uint8_t HAL_USART_ReadByte(USART_HandleTypeDef *huart);
  *******************************************************************/
 static void HAL_USART_Transmit_IRQn(USART_HandleTypeDef *huart);
 
+#if USART_PRINT_BUFFERED
+/*!******************************************************************
+ * \fn PLAT_CODE_IN_RAM static void HAL_USART_PrintRefill(USART_HandleTypeDef *huart)
+ * \brief Moves bytes from the print ring into the TX FIFO. Keeps the TX FIFO
+ *        empty interrupt armed while the ring still holds data. Must be called
+ *        with interrupts masked or from the USART IRQ.
+ *
+ * \param[in] USART_HandleTypeDef *huart           Print USART handle.
+ * \param[out] none
+ *
+ * \retval none.
+ *******************************************************************/
+PLAT_CODE_IN_RAM static void HAL_USART_PrintRefill(USART_HandleTypeDef *huart);
+#endif
+
 /*!******************************************************************
  * \fn static void HAL_USART_Receive_IRQn(USART_HandleTypeDef *huart)
  * \brief Handles the USART receive process in interruption mode.
@@ -266,10 +328,32 @@ static uint32_t g_usartInitCounter = 0;
  */
 static uint32_t g_usartWorkingStatus = 0;
 
+#if USART_PRINT_BUFFERED
+/**
+  \brief Print ring, filled by _write() and drained by the TX FIFO empty interrupt.
+ */
+static ring_buffer_t g_usartPrintRing;
+static uint8_t g_usartPrintBuffer[USART_PRINT_BUFFER_SIZE];
+static bool g_usartPrintReady = false;
+
+/**
+  \brief Print USART functional clock gated by HAL_USART_PrintGate(), and who to tell about it.
+ */
+static volatile bool g_usartPrintGated = false;
+static uint32_t g_usartPrintGatedInstance = 0;
+static HAL_USART_PrintGateCallback_t g_usartPrintGateCb = NULL;
+#endif
+
+/**
+  \brief Bytes discarded by _write() under USART_PRINT_POLICY_DROP.
+ */
+static volatile uint32_t g_usartPrintDropped = 0;
+
 
 /**
   \fn        static void USART_EnterLowPowerStatePrepare(void* pdata, slpManLpState state)
   \brief     Perform necessary preparations before sleep.
+             Pending print output is flushed first so it is not lost when the USART loses power.
              After recovering from SLPMAN_SLEEP1_STATE, USART hareware is repowered, we backup
              some registers here first so that we can restore user's configurations after exit.
   \param[in] pdata pointer to user data, not used now
@@ -278,6 +362,8 @@ static uint32_t g_usartWorkingStatus = 0;
 static void USART_EnterLowPowerStatePrepare(void* pdata, slpManLpState state) {
     uint32_t i;
 
+    HAL_USART_FlushPrint();
+
     switch (state) {
         case SLPMAN_SLEEP1_STATE:
 
@@ -324,6 +410,12 @@ static void USART_ExitLowPowerStateRestore(void* pdata, slpManLpState state) {
                     GPR_ClockEnable(g_uartClocks[2*i]);
                     GPR_ClockEnable(g_uartClocks[2*i+1]);
 
+#if USART_PRINT_BUFFERED
+                    // Registers are restored through the APB clock, the gate stays as it was
+                    if(g_usartPrintGated && (i == g_usartPrintGatedInstance))
+                        GPR_ClockDisable(g_uartClocks[2*i+1]);
+#endif
+
                     if(g_usartDataBase[i].backup_registers.ADCR == 0x3) {
                         // baudrate is set to 500, 26000000/16/(DLH:DLL) = 500 => DLH:DLL = 3250 = 0xCB2
                         g_usartBases[i]->LCR |= USART_LCR_ACCESS_DIVISOR_LATCH_Msk;
@@ -699,7 +791,7 @@ const USART_HandleTypeDef huart2 = {
 
 static dma_transfer_config dmaTxConfig = {NULL, NULL,
                                        DMA_FlowControlTarget, DMA_AddressIncrementSource,
-                                       DMA_DataWidthOneByte, DMA_Burst16Bytes, 0
+                                       DMA_DataWidthOneByte, HAL_DMA_USART_TX_BURST, 0
                                       };
 
 /* Variable Declarations  ----------------------------------------------------------------*/
@@ -806,7 +898,7 @@ static void HAL_USART_DmaRxConfig(USART_HandleTypeDef *usart) {
     dma_extra_config extraConfig;
 
     dmaConfig.addressIncrement              = DMA_AddressIncrementTarget;
-    dmaConfig.burstSize                     = DMA_Burst8Bytes;
+    dmaConfig.burstSize                     = HAL_DMA_USART_RX_BURST;
     dmaConfig.dataWidth                     = DMA_DataWidthOneByte;
     dmaConfig.flowControl                   = DMA_FlowControlSource;
     dmaConfig.sourceAddress                 = (void*)&(usart->reg->RBR);
@@ -837,7 +929,11 @@ ARM_USART_MODEM_STATUS HAL_USART_GetModemStatus(USART_HandleTypeDef *usart) {
 PLAT_CODE_IN_RAM static void HAL_USART_DmaUpdateRxConfig(USART_HandleTypeDef *usart, uint32_t targetAddress, uint32_t num) {
     usart->dma_rx->descriptor[0].TAR = targetAddress;
     usart->dma_rx->descriptor[1].TAR = usart->dma_rx->descriptor[0].TAR + UART_DMA_BURST_SIZE;
-    usart->dma_rx->descriptor[1].CMDR = DMA_SetDescriptorTransferLen(usart->dma_rx->descriptor[1].CMDR, num - UART_DMA_BURST_SIZE);
+    HAL_DMA_SetDescriptorLength(&usart->dma_rx->descriptor[1], num - UART_DMA_BURST_SIZE);
+}
+
+PLAT_CODE_IN_RAM static void HAL_USART_DmaEvent(uint32_t event, void *context) {
+    (*(dma_callback_t *)context)(event);
 }
 
 int32_t HAL_USART_Initialize(ARM_USART_SignalEvent_t cb_event, USART_HandleTypeDef *usart) {
@@ -886,32 +982,23 @@ int32_t HAL_USART_Initialize(ARM_USART_SignalEvent_t cb_event, USART_HandleTypeD
     usart->info->xfer.tx_def_val            = 0U;
 
     if (usart->dma_tx) {
-        DMA_Init();
-
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)usart->dma_tx->request, HAL_USART_DmaEvent, &usart->dma_tx->callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             usart->dma_tx->channel = returnCode;
-
-        DMA_ChannelSetRequestSource(usart->dma_tx->channel, (dma_request_source_t)usart->dma_tx->request);
-        DMA_ChannelRigisterCallback(usart->dma_tx->channel, usart->dma_tx->callback);
     }
     
     if (usart->dma_rx) {
-        DMA_Init();
-
-        returnCode = DMA_OpenChannel();
+        returnCode = HAL_DMA_OpenChannel((dma_request_source_t)usart->dma_rx->request, HAL_USART_DmaEvent, &usart->dma_rx->callback);
 
         if (returnCode == ARM_DMA_ERROR_CHANNEL_ALLOC)
             return ARM_DRIVER_ERROR;
         else
             usart->dma_rx->channel = returnCode;
 
-        DMA_ChannelSetRequestSource(usart->dma_rx->channel, (dma_request_source_t)usart->dma_rx->request);
         HAL_USART_DmaRxConfig(usart);
-        DMA_ChannelRigisterCallback(usart->dma_rx->channel, usart->dma_rx->callback);
     }
 
     usart->info->flags = USART_FLAG_INITIALIZED;  // USART is initialized
@@ -938,10 +1025,10 @@ int32_t HAL_USART_Uninitialize(USART_HandleTypeDef *usart) {
     usart->info->cb_event = NULL;
 
     if(usart->dma_tx)
-        DMA_CloseChannel(usart->dma_tx->channel);
+        HAL_DMA_CloseChannel(usart->dma_tx->channel);
 
     if(usart->dma_rx)
-        DMA_CloseChannel(usart->dma_rx->channel);
+        HAL_DMA_CloseChannel(usart->dma_rx->channel);
 
 #ifdef PM_FEATURE_ENABLE
 
@@ -974,9 +1061,9 @@ int32_t HAL_USART_PowerControl(ARM_POWER_STATE state, USART_HandleTypeDef *usart
 
             // DMA disable
             if(usart->dma_tx)
-                DMA_StopChannel(usart->dma_tx->channel, false);
+                HAL_DMA_Stop(usart->dma_tx->channel, false);
             if(usart->dma_rx)
-                DMA_StopChannel(usart->dma_rx->channel, false);
+                HAL_DMA_Stop(usart->dma_rx->channel, false);
 
 
             // Disable power to usart clock
@@ -1089,7 +1176,7 @@ int32_t HAL_USART_GetTxCount(USART_HandleTypeDef *usart) {
     if (!(usart->info->flags & USART_FLAG_CONFIGURED))
         return 0U;
     if(usart->dma_tx)
-        cnt = DMA_ChannelGetCount(usart->dma_tx->channel);
+        cnt = HAL_DMA_GetCount(usart->dma_tx->channel);
     else
         cnt = usart->info->xfer.tx_cnt;
     return cnt;
@@ -1372,7 +1459,7 @@ int32_t HAL_USART_Transmit_DMA(USART_HandleTypeDef *huart, uint8_t *pTxBuff, uin
     uint32_t instance = HAL_USART_GetInstanceNumber(huart);
 #endif
 
-    if ((pTxBuff == NULL) || (size == 0U))
+    if ((pTxBuff == NULL) || (size == 0U) || ((size - 1) > HAL_DMA_MAX_DESC_LEN))
         return ARM_DRIVER_ERROR_PARAMETER;
     if ((huart->info->flags & USART_FLAG_CONFIGURED) == 0U)
         return ARM_DRIVER_ERROR;
@@ -1426,9 +1513,7 @@ int32_t HAL_USART_Transmit_DMA(USART_HandleTypeDef *huart, uint8_t *pTxBuff, uin
         dmaTxConfig.totalLength = size-1;
         
         // Configure tx DMA and start it
-        DMA_TransferSetup(huart->dma_tx->channel, &dmaTxConfig);
-        DMA_EnableChannelInterrupts(huart->dma_tx->channel, DMA_EndInterruptEnable);
-        DMA_StartChannel(huart->dma_tx->channel);
+        HAL_DMA_Start(huart->dma_tx->channel, &dmaTxConfig);
     }
 
     return ARM_DRIVER_OK;
@@ -1472,15 +1557,17 @@ int32_t HAL_USART_Receive_DMA(USART_HandleTypeDef *huart, uint8_t *pRxBuff, uint
     huart->info->xfer.rx_num = size;
     huart->info->xfer.rx_buf = pRxBuff;
     huart->info->xfer.rx_cnt = 0U;
-    
+
+    memset(&(huart->info->rx_status), 0, sizeof(USART_STATUS));
+    if(dma_event == USART_DMA_RX_EVENT)
+        dma_event = USART_DMA_NONE_EVENT;
+
     huart->reg->IER |= USART_IER_RX_TIMEOUT_Msk   | USART_IER_RX_LINE_STATUS_Msk;
     
-    huart->info->rx_status.rx_dma_triggered = 0;
-    
     // Enable DMA tansfer only if there is enough space for supplied buffer
     if(size >= UART_DMA_BURST_SIZE) {
         HAL_USART_DmaUpdateRxConfig(huart, (uint32_t)pRxBuff, size);
-        DMA_ChannelLoadDescriptorAndRun(huart->dma_rx->channel, &huart->dma_rx->descriptor[0]);
+        HAL_DMA_ReloadChain(huart->dma_rx->channel, &huart->dma_rx->descriptor[0]);
     }
     
     return ARM_DRIVER_OK;
@@ -1534,6 +1621,15 @@ void HAL_USART_InitPrint(USART_HandleTypeDef *huart, clock_select_t uartClkSel,
     HAL_USART_Initialize(HT_USART_Callback, huart);
     HAL_USART_PowerControl(ARM_POWER_FULL, huart);
     HAL_USART_Control(control, baudrate, huart);
+
+#if USART_PRINT_BUFFERED
+    if(huart == USART_PRINT_HANDLE && !g_usartPrintReady) {
+        initRingBuffer(&g_usartPrintRing, g_usartPrintBuffer, USART_PRINT_BUFFER_SIZE);
+        g_usartPrintReady = true;
+    }
+    if(huart == USART_PRINT_HANDLE)
+        g_usartPrintGated = false;  // The functional clock was just enabled above
+#endif
 }
 
 void HAL_USART_SetUARTLogClk(clock_select_t uartClkSel) {
@@ -1627,25 +1723,288 @@ void __aeabi_assert (const char *expr, const char *file, int line) {
   while(1);
 }
 
+#if USART_PRINT_BUFFERED
+PLAT_CODE_IN_RAM static void HAL_USART_PrintRefill(USART_HandleTypeDef *huart) {
+    uint8_t *data;
+    uint32_t contiguous = 0;
+
+    while(HAL_USART_ReadLineStatus(huart) & USART_LSR_TX_DATA_REQ_Msk) {
+        getRingBufferData(&g_usartPrintRing, &data, &contiguous);
+        if(contiguous == 0)
+            break;
+
+        HAL_USART_SendByte(huart, *data);
+        g_usartPrintRing.head = (g_usartPrintRing.head + 1) % g_usartPrintRing.size;
+    }
+
+#ifdef PM_FEATURE_ENABLE
+    uint32_t instance = HAL_USART_GetInstanceNumber(huart);
+#endif
+
+    if(getRingBufferUsedSpace(&g_usartPrintRing) == 0) {
+        huart->reg->IER &= ~USART_IER_TX_DATA_REQ_Msk;
+#ifdef PM_FEATURE_ENABLE
+        CHECK_TO_UNLOCK_SLEEP(instance, 1, 0);
+#endif
+    } else {
+        huart->reg->IER |= USART_IER_TX_DATA_REQ_Msk;
+#ifdef PM_FEATURE_ENABLE
+        LOCK_SLEEP(instance, 1, 0);
+#endif
+    }
+}
+#endif
+
+void HAL_USART_FlushPrint(void) {
+#if USART_PRINT_BUFFERED
+    uint32_t mask;
+
+    if(!g_usartPrintReady || g_usartPrintGated)
+        return;
+
+    mask = SaveAndSetIRQMask();
+
+    do {
+        HAL_USART_PrintRefill(USART_PRINT_HANDLE);
+    } while(getRingBufferUsedSpace(&g_usartPrintRing) != 0);
+
+    while((HAL_USART_ReadLineStatus(USART_PRINT_HANDLE) & USART_LSR_TX_EMPTY_Msk) == 0);
+
+    RestoreIRQMask(mask);
+#endif
+}
+
+uint32_t HAL_USART_GetPrintDropped(void) {
+    return g_usartPrintDropped;
+}
+
+int32_t HAL_USART_PrintGate(void) {
+#if USART_PRINT_BUFFERED
+    USART_HandleTypeDef *huart = USART_PRINT_HANDLE;
+    uint32_t instance, mask;
+
+    if(!g_usartPrintReady)
+        return ARM_DRIVER_ERROR;
+
+    mask = SaveAndSetIRQMask();
+
+    if(g_usartPrintGated) {
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_OK;
+    }
+
+    // Output still queued or shifting, or a character being received
+    if((getRingBufferUsedSpace(&g_usartPrintRing) != 0) ||
+       ((HAL_USART_ReadLineStatus(huart) & (USART_LSR_TX_EMPTY_Msk | USART_LSR_RX_DATA_READY_Msk | USART_LSR_RX_BUSY_Msk)) != USART_LSR_TX_EMPTY_Msk)) {
+        RestoreIRQMask(mask);
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    instance = HAL_USART_GetInstanceNumber(huart);
+    GPR_ClockDisable(g_uartClocks[instance*2+1]);
+    g_usartPrintGatedInstance = instance;
+    g_usartPrintGated = true;
+
+    if(g_usartPrintGateCb)
+        g_usartPrintGateCb(true);
+
+    RestoreIRQMask(mask);
+
+    return ARM_DRIVER_OK;
+#else
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+#endif
+}
+
+PLAT_CODE_IN_RAM void HAL_USART_PrintUngate(void) {
+#if USART_PRINT_BUFFERED
+    uint32_t instance, mask;
+
+    mask = SaveAndSetIRQMask();
+
+    if(g_usartPrintGated) {
+        instance = HAL_USART_GetInstanceNumber(USART_PRINT_HANDLE);
+        GPR_ClockEnable(g_uartClocks[instance*2+1]);
+        g_usartPrintGated = false;
+
+        if(g_usartPrintGateCb)
+            g_usartPrintGateCb(false);
+    }
+
+    RestoreIRQMask(mask);
+#endif
+}
+
+bool HAL_USART_PrintIsGated(void) {
+#if USART_PRINT_BUFFERED
+    return g_usartPrintGated;
+#else
+    return false;
+#endif
+}
+
+void HAL_USART_SetPrintGateCallback(HAL_USART_PrintGateCallback_t cb) {
+#if USART_PRINT_BUFFERED
+    g_usartPrintGateCb = cb;
+#endif
+}
+
 int _write(int file, char *ptr, int len) {
 	//extern int io_putchar(int ch);
     int DataIdx;
 
+#if USART_PRINT_BUFFERED
+    uint32_t mask, room, chunk;
+    uint32_t left = (uint32_t)len;
+
+    if(g_usartPrintReady) {
+        if(g_usartPrintGated)
+            HAL_USART_PrintUngate();
+
+        while(left > 0) {
+            mask = SaveAndSetIRQMask();
+
+            room = getFreeRingBuffer(&g_usartPrintRing);
+            chunk = MIN(room, left);
+            if(chunk > 0) {
+                pushRingBuffer(&g_usartPrintRing, (const uint8_t *)ptr, chunk);
+                ptr += chunk;
+                left -= chunk;
+            }
+            HAL_USART_PrintRefill(USART_PRINT_HANDLE);
+
+            RestoreIRQMask(mask);
+
+            if(left == 0)
+                break;
+
+            // Ring full: callers in interrupt context can never wait for the TX IRQ
+            if((USART_PRINT_POLICY == USART_PRINT_POLICY_DROP) || (__get_IPSR() != 0)) {
+                g_usartPrintDropped += left;
+                break;
+            }
+        }
+
+        return len;
+    }
+#endif
+
     for (DataIdx = 0; DataIdx < len; DataIdx++) {
 		io_putchar(*ptr++);
     }
     return len;
 }
 
-PLAT_CODE_IN_RAM void USART_IRQHandler(USART_HandleTypeDef *usart) {
+PLAT_CODE_IN_RAM static void HAL_USART_DmaRxIdle(USART_HandleTypeDef *usart) {
     uint32_t i = 0;
     uint32_t current_cnt = 0, total_cnt = 0, left_to_recv = 0, bytes_in_fifo = 0;
 
+#ifdef PM_FEATURE_ENABLE
+    uint32_t instance = HAL_USART_GetInstanceNumber(usart);
+#endif
+
+    usart->info->rx_status.rx_busy = 1U;
+
+    current_cnt = usart->info->xfer.rx_cnt;
+
+    if(usart->info->rx_status.rx_dma_triggered) {
+        // Sync with undergoing DMA transfer, wait until DMA burst transfer(8 bytes) done and update current_cnt
+        do {
+            current_cnt = HAL_DMA_GetTargetAddress(usart->dma_rx->channel, true) - (uint32_t) usart->info->xfer.rx_buf;
+        } while(((current_cnt - usart->info->xfer.rx_cnt) & (UART_DMA_BURST_SIZE - 1)) != 0);
+
+        usart->info->rx_status.rx_dma_triggered = 0;
+    }
+    /*
+       No matter DMA transfer is started or not(left recv buffer space is not enough),
+       now we can stop DMA saftely for next transfer and handle tailing bytes in FIFO
+    */
+    HAL_DMA_Abort(usart->dma_rx->channel);
+
+    total_cnt = usart->info->xfer.rx_num;
+    bytes_in_fifo = (usart->reg->FCNR & USART_FCNR_RX_FIFO_NUM_Msk) >> USART_FCNR_RX_FIFO_NUM_Pos;
+    left_to_recv = total_cnt - current_cnt;
+
+    i = MIN(bytes_in_fifo, left_to_recv);
+
+    // if still have space to recv
+    if(left_to_recv > 0) {
+        while(i--)
+            usart->info->xfer.rx_buf[current_cnt++] = usart->reg->RBR;
+
+    }
+
+    usart->info->xfer.rx_cnt = current_cnt;
+    dma_event = USART_DMA_NONE_EVENT;
+    usart->info->rx_status.rx_busy = 0U;
+
+    // The line is idle, so RX no longer needs to keep the system awake
+#ifdef PM_FEATURE_ENABLE
+    CHECK_TO_UNLOCK_SLEEP(instance, 0, 1);
+#endif
+
+    // Check if required amount of data is received
+    if (current_cnt == total_cnt) {
+        //Disable RDA interrupt
+        usart->reg->IER &= ~(USART_IER_RX_DATA_REQ_Msk | USART_IER_RX_TIMEOUT_Msk | USART_IER_RX_LINE_STATUS_Msk);
+
+        usart->info->cb_event(ARM_USART_EVENT_DMA_RX_COMPLETE);
+
+    } else {
+        // Prepare for next recv
+        left_to_recv = total_cnt - usart->info->xfer.rx_cnt;
+        // shall not start DMA transfer, next recv event would be timeout or overflow
+        if(left_to_recv >= UART_DMA_BURST_SIZE) {
+            HAL_USART_DmaUpdateRxConfig(usart, (uint32_t)usart->info->xfer.rx_buf + usart->info->xfer.rx_cnt, left_to_recv);
+            // load descriptor and start DMA transfer
+            HAL_DMA_ReloadChain(usart->dma_rx->channel, &usart->dma_rx->descriptor[0]);
+        }
+
+        usart->info->cb_event(ARM_USART_EVENT_RX_TIMEOUT);
+    }
+}
+
+PLAT_CODE_IN_RAM static void HAL_USART_RxLineStatus(USART_HandleTypeDef *usart) {
+    uint32_t lsr = HAL_USART_ReadLineStatus(usart);
+    uint32_t event = 0;
+
+    if(lsr & USART_LSR_RX_OVERRUN_ERROR_Msk) {
+        usart->info->rx_status.rx_overflow = 1U;
+        event |= ARM_USART_EVENT_RX_OVERFLOW;
+    }
+
+    if(lsr & USART_LSR_RX_BREAK_Msk) {
+        usart->info->rx_status.rx_break = 1U;
+        event |= ARM_USART_EVENT_RX_BREAK;
+    } else if(lsr & USART_LSR_RX_FRAME_ERROR_Msk) {
+        usart->info->rx_status.rx_framing_error = 1U;
+        event |= ARM_USART_EVENT_RX_FRAMING_ERROR;
+    }
+
+    if(lsr & USART_LSR_RX_PARITY_ERROR_Msk) {
+        usart->info->rx_status.rx_parity_error = 1U;
+        event |= ARM_USART_EVENT_RX_PARITY_ERROR;
+    }
+
+    if(event && usart->info->cb_event)
+        usart->info->cb_event(event);
+}
+
+PLAT_CODE_IN_RAM void USART_IRQHandler(USART_HandleTypeDef *usart) {
+    uint32_t iir;
+
 #ifdef PM_FEATURE_ENABLE
     uint32_t instance = HAL_USART_GetInstanceNumber(usart);;
 #endif
 
     if(!usart->dma_rx && !usart->dma_tx) {
+#if USART_PRINT_BUFFERED
+        /* The print instance drains its own ring instead of the HAL_USART_Transmit_IT buffer */
+        if(usart == USART_PRINT_HANDLE && g_usartPrintReady) {
+            if(usart->reg->IER & USART_IER_TX_DATA_REQ_Msk)
+                HAL_USART_PrintRefill(usart);
+        } else
+#endif
         /* Handle transmit interrupt if enabled */
         if(usart->reg->IER & USART_IER_TX_DATA_REQ_Msk) {
             HAL_USART_Transmit_IRQn(usart);
@@ -1656,64 +2015,30 @@ PLAT_CODE_IN_RAM void USART_IRQHandler(USART_HandleTypeDef *usart) {
             HAL_USART_Receive_IRQn(usart);
             usart->info->cb_event(ARM_USART_EVENT_RECEIVE_COMPLETE);
         }
-    
-    } else if(usart->dma_rx && dma_event == USART_DMA_RX_EVENT) {
-        usart->info->rx_status.rx_busy = 1U;
 
-        current_cnt = usart->info->xfer.rx_cnt;
-
-        if(usart->info->rx_status.rx_dma_triggered) {
-            // Sync with undergoing DMA transfer, wait until DMA burst transfer(8 bytes) done and update current_cnt
-            do {
-                current_cnt = DMA_ChannelGetCurrentTargetAddress(usart->dma_rx->channel, true) - (uint32_t) usart->info->xfer.rx_buf;
-            } while(((current_cnt - usart->info->xfer.rx_cnt) & (UART_DMA_BURST_SIZE - 1)) != 0);
-            
-            usart->info->rx_status.rx_dma_triggered = 0;
-        }
-        /*
-           No matter DMA transfer is started or not(left recv buffer space is not enough),
-           now we can stop DMA saftely for next transfer and handle tailing bytes in FIFO
-        */
-        DMA_StopChannelNoWait(usart->dma_rx->channel);
+        return;
+    }
 
-        total_cnt = usart->info->xfer.rx_num;
-        bytes_in_fifo = usart->reg->FCNR >> USART_FCNR_RX_FIFO_NUM_Pos;
-        left_to_recv = total_cnt - current_cnt;
+#if USART_PRINT_BUFFERED
+    /* A print instance receiving in DMA mode (console) still transmits from its ring */
+    if(!usart->dma_tx && usart == USART_PRINT_HANDLE && g_usartPrintReady) {
+        if(usart->reg->IER & USART_IER_TX_DATA_REQ_Msk)
+            HAL_USART_PrintRefill(usart);
+    }
+#endif
 
-        i = MIN(bytes_in_fifo, left_to_recv);
+    iir = usart->reg->IIR & USART_INT_TYPE_MSK;
 
-        // if still have space to recv
-        if(left_to_recv > 0) {
-            while(i--)
-                usart->info->xfer.rx_buf[current_cnt++] = usart->reg->RBR;
-            
-        }
+    if(usart->dma_rx && (iir == USART_RLS_INT))
+        HAL_USART_RxLineStatus(usart);
 
-        usart->info->xfer.rx_cnt = current_cnt;
-        // Check if required amount of data is received
-        if (current_cnt == total_cnt) {
-            //Disable RDA interrupt
-            usart->reg->IER &= ~(USART_IER_RX_DATA_REQ_Msk | USART_IER_RX_TIMEOUT_Msk | USART_IER_RX_LINE_STATUS_Msk);
-
-            usart->info->cb_event(ARM_USART_EVENT_DMA_RX_COMPLETE);
-
-        } else {
-            if(usart->dma_rx) {
-                // Prepare for next recv
-                left_to_recv = total_cnt - usart->info->xfer.rx_cnt;
-                // shall not start DMA transfer, next recv event would be timeout or overflow
-                if(left_to_recv >= UART_DMA_BURST_SIZE) {
-                    HAL_USART_DmaUpdateRxConfig(usart, (uint32_t)usart->info->xfer.rx_buf + usart->info->xfer.rx_cnt, left_to_recv);
-                    // load descriptor and start DMA transfer
-                    DMA_ChannelLoadDescriptorAndRun(usart->dma_rx->channel, &usart->dma_rx->descriptor[0]);
-                }
+    /*
+       RX timeout (line idle) ends a frame. Frames shorter than a DMA burst never
+       raise a DMA event, so the timeout alone must be enough to collect them.
+    */
+    if(usart->dma_rx && ((dma_event == USART_DMA_RX_EVENT) || (iir == USART_CTI_INT) || (iir == USART_RLS_INT))) {
+        HAL_USART_DmaRxIdle(usart);
 
-                dma_event = USART_DMA_NONE_EVENT;
-                usart->info->cb_event(ARM_USART_EVENT_RX_TIMEOUT);
-            }
-        }
-        usart->info->rx_status.rx_busy = 0U;
-    
     } else if(usart->dma_tx && dma_event == USART_DMA_TX_EVENT) {
 
         if(((usart->reg->IER & USART_IER_TX_DATA_REQ_Msk) && ((usart->reg->FCNR & USART_FCNR_TX_FIFO_NUM_Msk) == 0))) {
@@ -1729,7 +2054,7 @@ PLAT_CODE_IN_RAM void USART_IRQHandler(USART_HandleTypeDef *usart) {
         }
 
     }
-    
+
 }
 
 void HAL_USART_DmaTxEvent(uint32_t event, USART_HandleTypeDef *usart) {
@@ -1756,7 +2081,7 @@ void HAL_USART_DmaRxEvent(uint32_t event, USART_HandleTypeDef *usart) {
     uint32_t instance = HAL_USART_GetInstanceNumber(usart);
 #endif
 
-    uint32_t dmaCurrentTargetAddress = DMA_ChannelGetCurrentTargetAddress(usart->dma_rx->channel, false);
+    uint32_t dmaCurrentTargetAddress = HAL_DMA_GetTargetAddress(usart->dma_rx->channel, false);
 
     switch (event) {
         case DMA_EVENT_END:
@@ -78,14 +78,15 @@
 #define MBEDTLS_BASE64_C
 #define MBEDTLS_PEM_PARSE_C
 
-//#ifdef CONFIG_MBEDTLS_HW_CRYPTO
-//#define MBEDTLS_AES_ALT
+/* L2C engine, library/ec61x/src/aes_alt.c and sha256_alt.c */
+#ifdef CONFIG_MBEDTLS_HW_CRYPTO
+#define MBEDTLS_AES_ALT
 //#define MBEDTLS_DES_ALT
 //#define MBEDTLS_MD5_ALT
 //#define MBEDTLS_SHA1_ALT
-//#define MBEDTLS_SHA256_ALT
+#define MBEDTLS_SHA256_ALT
 //#define MBEDTLS_SHA512_ALT
-//#endif
+#endif
 #define MBEDTLS_SSL_COOKIE_C
 
 #define MBEDTLS_SSL_MAX_CONTENT_LEN         (4*1024)   /**< Size of the input / output buffer */
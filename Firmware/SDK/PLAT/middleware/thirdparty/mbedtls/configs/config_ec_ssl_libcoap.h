@@ -14,7 +14,11 @@
 /* System support */
 #define MBEDTLS_HAVE_ASM
 #define MBEDTLS_PLATFORM_MEMORY
-#if defined(MBEDTLS_OS_FREERTOS)
+/* Static arena (HT_MQTT_TLSArenaOpen), library/memory_buffer_alloc.c, instead of the FreeRTOS heap */
+#if defined(CONFIG_MBEDTLS_ARENA)
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+#elif defined(MBEDTLS_OS_FREERTOS)
 #define MBEDTLS_PLATFORM_CALLOC_MACRO calloc //mbedtls_calloc //
 #define MBEDTLS_PLATFORM_FREE_MACRO	free //mbedtls_free //
 #endif
@@ -66,6 +70,8 @@
 #define MBEDTLS_SSL_ALPN
 #define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
 #define MBEDTLS_USE_RAND_API_ENTROPY
+/* TRNG entropy source, library/ec61x/src/trng_alt.c, registered by HT_MQTT_TLSConnect */
+#define MBEDTLS_ENTROPY_TRNG
 
 //#define MBEDTLS_NO_PLATFORM_ENTROPY
 //#define MBEDTLS_ENTROPY_HARDWARE_ALT
@@ -74,17 +80,35 @@
 #define MBEDTLS_BASE64_C
 #define MBEDTLS_PEM_PARSE_C
 
-//#ifdef CONFIG_MBEDTLS_HW_CRYPTO
-//#define MBEDTLS_AES_ALT
+/* L2C engine, library/ec61x/src/aes_alt.c and sha256_alt.c */
+#ifdef CONFIG_MBEDTLS_HW_CRYPTO
+#define MBEDTLS_AES_ALT
 //#define MBEDTLS_DES_ALT
 //#define MBEDTLS_MD5_ALT
 //#define MBEDTLS_SHA1_ALT
-//#define MBEDTLS_SHA256_ALT
+#define MBEDTLS_SHA256_ALT
 //#define MBEDTLS_SHA512_ALT
-//#endif
+#endif
 #define MBEDTLS_SSL_COOKIE_C
 
 #define MBEDTLS_SSL_MAX_CONTENT_LEN         (4*1024)   /**< Size of the input / output buffer */
+/* Low-RAM records (HT_TLS_LOW_RAM): the input buffer still takes the certificate chain of a broker
+   that ignores the fragment length, nothing we send is larger than the 1 KB MQTT buffer or our own
+   certificate */
+#if defined(CONFIG_MBEDTLS_LOW_RAM)
+#define MBEDTLS_SSL_IN_CONTENT_LEN          (4*1024)
+#define MBEDTLS_SSL_OUT_CONTENT_LEN         (1*1024)
+#endif
+
+/* DTLS connections kept across hibernate (HT_DTLS): Connection ID, still the draft codepoints in
+   mbedtls 2.23 (extension 254, content type 25), and whole-connection serialization */
+#if defined(CONFIG_MBEDTLS_DTLS_CID)
+#define MBEDTLS_SSL_DTLS_CONNECTION_ID
+#define MBEDTLS_SSL_CONTEXT_SERIALIZATION
+#define MBEDTLS_SSL_DTLS_ANTI_REPLAY
+#define MBEDTLS_SSL_CID_IN_LEN_MAX          8
+#define MBEDTLS_SSL_CID_OUT_LEN_MAX         8
+#endif
 
 //#define MBEDTLS_SSL_MAX_OUT_CONTENT_LEN     (512)   /**< Size of the input / output buffer */
 /**
@@ -0,0 +1,91 @@
+/*
+ *the mbedtls configuration file of the PSK only MQTT over TLS client
+ *
+ * TLS 1.2 with MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8 and nothing else: no X.509,
+ * no public key, no bignum, no ECP. Built instead of config_ec_ssl_libcoap.h
+ * with HT_TLS_PSK_ONLY = y in the application Makefile.
+ */
+
+#ifndef MBEDTLS_CONFIG_PSK_H
+#define MBEDTLS_CONFIG_PSK_H
+
+/* OS */
+#define MBEDTLS_OS_FREERTOS
+
+/*TCPIP STACK*/
+#define MBEDTLS_TCPIP_LWIP
+
+/* System support */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_PLATFORM_MEMORY
+/* Static arena (HT_MQTT_TLSArenaOpen), library/memory_buffer_alloc.c, instead of the FreeRTOS heap */
+#if defined(CONFIG_MBEDTLS_ARENA)
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+#elif defined(MBEDTLS_OS_FREERTOS)
+#define MBEDTLS_PLATFORM_CALLOC_MACRO calloc
+#define MBEDTLS_PLATFORM_FREE_MACRO	free
+#endif
+
+/* mbed TLS feature support */
+#define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+#define MBEDTLS_THREADING_C
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_USE_RAND_API_ENTROPY
+/* TRNG entropy source, library/ec61x/src/trng_alt.c, registered by HT_MQTT_TLSConnect */
+#define MBEDTLS_ENTROPY_TRNG
+
+/* mbed TLS modules */
+#define MBEDTLS_AES_C
+#define MBEDTLS_CCM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_NET_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_TIMING_C
+#define MBEDTLS_TIMING_ALT
+
+/* L2C engine, library/ec61x/src/aes_alt.c and sha256_alt.c */
+#ifdef CONFIG_MBEDTLS_HW_CRYPTO
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_SHA256_ALT
+#endif
+
+/* Save RAM at the expense of ROM */
+#define MBEDTLS_AES_ROM_TABLES
+
+/* One 128-bit key, one suite: the L2C engine runs AES-128, not AES-256 */
+#define MBEDTLS_PSK_MAX_LEN                 16
+#define MBEDTLS_SSL_CIPHERSUITES            MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8
+
+#define MBEDTLS_SSL_MAX_CONTENT_LEN         (4*1024)   /**< Size of the input / output buffer */
+/* Low-RAM records (HT_TLS_LOW_RAM): no certificates, every handshake message fits a 512-byte
+   fragment; the MQTT client splits larger packets over records */
+#if defined(CONFIG_MBEDTLS_LOW_RAM)
+#define MBEDTLS_SSL_IN_CONTENT_LEN          (512)
+#define MBEDTLS_SSL_OUT_CONTENT_LEN         (512)
+#endif
+
+/* DTLS connections kept across hibernate (HT_DTLS): Connection ID, still the draft codepoints in
+   mbedtls 2.23 (extension 254, content type 25), and whole-connection serialization */
+#if defined(CONFIG_MBEDTLS_DTLS_CID)
+#define MBEDTLS_SSL_PROTO_DTLS
+#define MBEDTLS_SSL_DTLS_HELLO_VERIFY
+#define MBEDTLS_SSL_DTLS_CONNECTION_ID
+#define MBEDTLS_SSL_CONTEXT_SERIALIZATION
+#define MBEDTLS_SSL_DTLS_ANTI_REPLAY
+#define MBEDTLS_SSL_CID_IN_LEN_MAX          8
+#define MBEDTLS_SSL_CID_OUT_LEN_MAX         8
+#endif
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_CONFIG_PSK_H */
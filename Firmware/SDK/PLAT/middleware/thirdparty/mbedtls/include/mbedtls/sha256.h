@@ -48,6 +48,13 @@ extern "C" {
 // Regular implementation
 //
 
+#if defined(MBEDTLS_SHA256_ALT)
+#if !defined(MBEDTLS_SHA256_ALT_STAGE)
+#define MBEDTLS_SHA256_ALT_STAGE    256             /* longest message hashed by the L2C engine, multiple of 4 */
+#endif
+#define MBEDTLS_SHA256_ALT_SW       0xFFFFFFFFUL    /* staged value of a context hashing in software */
+#endif
+
 /**
  * \brief          The SHA-256 context structure.
  *
@@ -62,6 +69,11 @@ typedef struct mbedtls_sha256_context
     unsigned char buffer[64];   /*!< The data block being processed. */
     int is224;                  /*!< Determines which function to use:
                                      0: Use SHA-256, or 1: Use SHA-224. */
+
+    #ifdef MBEDTLS_SHA256_ALT
+    uint32_t stage[MBEDTLS_SHA256_ALT_STAGE / 4];  /* message kept for a one shot L2C hash */
+    uint32_t staged;                               /* bytes in stage, MBEDTLS_SHA256_ALT_SW once in software */
+    #endif
 }
 mbedtls_sha256_context;
 
@@ -256,7 +256,11 @@
 #endif
 
 #if !defined(MBEDTLS_SSL_OUT_CONTENT_LEN)
+#if defined(MBEDTLS_SSL_MAX_OUT_CONTENT_LEN)
 #define MBEDTLS_SSL_OUT_CONTENT_LEN MBEDTLS_SSL_MAX_OUT_CONTENT_LEN
+#else
+#define MBEDTLS_SSL_OUT_CONTENT_LEN MBEDTLS_SSL_MAX_CONTENT_LEN
+#endif
 #endif
 
 /*
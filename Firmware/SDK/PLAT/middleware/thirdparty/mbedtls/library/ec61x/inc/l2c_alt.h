@@ -0,0 +1,113 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * \file l2c_alt.h
+ * \brief L2C crypto engine arbitration for MBEDTLS_AES_ALT and MBEDTLS_SHA256_ALT.
+ *
+ * The engine holds one operation at a time and cannot load an intermediate
+ * state, so no context keeps anything in it between calls: every AES call
+ * reloads its key and IV, and a SHA-256 context hands the engine its whole
+ * message in one session (see MBEDTLS_SHA256_ALT_STAGE in sha256.h). That
+ * is what lets any number of contexts interleave.
+ *
+ * The engine is taken with a try-lock. A caller that finds it taken, or a
+ * key size it does not support (AES-256), runs in software instead of
+ * waiting, so an engine user can never block another one.
+ */
+
+#ifndef MBEDTLS_L2C_ALT_H
+#define MBEDTLS_L2C_ALT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MBEDTLS_L2C_CHUNK   256     /*!< Bytes handed to the engine per call, through the bounce buffer. */
+
+/**
+ * \brief Engine usage since boot, or since mbedtls_l2c_reset_stats.
+ */
+typedef struct mbedtls_l2c_stats
+{
+    uint32_t aes_hw_calls;      /*!< AES calls run by the engine. */
+    uint32_t aes_hw_bytes;      /*!< Bytes encrypted or decrypted by the engine. */
+    uint32_t aes_sw_blocks;     /*!< AES blocks run in software. */
+    uint32_t sha_hw;            /*!< SHA-256/224 digests computed by the engine. */
+    uint32_t sha_sw;            /*!< Digests finished in software (message longer than the stage). */
+    uint32_t sha_sw_blocks;     /*!< SHA-256 blocks compressed in software. */
+    uint32_t busy;              /*!< Operations that found the engine taken and ran in software. */
+    uint32_t errors;            /*!< Engine errors, the operation was redone in software. */
+}
+mbedtls_l2c_stats;
+
+/**
+ * \brief Enables or disables the engine (on by default).
+ *
+ * Disabled, every operation runs in software; used by the benchmarks to
+ * compare both paths in one build.
+ */
+void mbedtls_l2c_set_hw( int enable );
+
+/**
+ * \brief Tells whether the engine is enabled.
+ */
+int mbedtls_l2c_get_hw( void );
+
+/**
+ * \brief Takes the engine for one operation.
+ *
+ * \return 1 if the caller owns the engine, 0 if it must use software.
+ */
+int mbedtls_l2c_acquire( void );
+
+/**
+ * \brief Returns the engine taken by mbedtls_l2c_acquire.
+ */
+void mbedtls_l2c_release( void );
+
+/**
+ * \brief Returns the engine bounce buffer, 2 * MBEDTLS_L2C_CHUNK bytes, word aligned.
+ *
+ * Only the owner of the engine may use it. Data goes through it because
+ * the engine takes 32-bit word aligned addresses and the caller's buffers
+ * may be neither.
+ */
+unsigned char *mbedtls_l2c_bounce( void );
+
+/**
+ * \brief Gates the engine clock until the next operation.
+ *
+ * Call when no TLS session is active, e.g. after closing the connection.
+ */
+void mbedtls_l2c_idle( void );
+
+/**
+ * \brief Returns the usage counters.
+ */
+mbedtls_l2c_stats *mbedtls_l2c_get_stats( void );
+
+/**
+ * \brief Clears the usage counters.
+ */
+void mbedtls_l2c_reset_stats( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* l2c_alt.h */
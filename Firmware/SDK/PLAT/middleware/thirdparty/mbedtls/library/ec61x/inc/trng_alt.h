@@ -0,0 +1,71 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * \file trng_alt.h
+ * \brief QCX212 TRNG as an mbedtls entropy source.
+ *
+ * The TRNG hands out 24 conditioned bytes per RngGenRandom call. Register
+ * mbedtls_trng_poll with mbedtls_entropy_add_source as a strong source; it
+ * replaces the platform poll (MBEDTLS_USE_RAND_API_ENTROPY), which is not
+ * backed by hardware.
+ */
+
+#ifndef MBEDTLS_TRNG_ALT_H
+#define MBEDTLS_TRNG_ALT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MBEDTLS_TRNG_BLOCK      24      /*!< Bytes per TRNG read. */
+#define MBEDTLS_TRNG_THRESHOLD  32      /*!< Bytes to gather before the pool releases entropy. */
+
+/**
+ * \brief TRNG usage since boot.
+ */
+typedef struct mbedtls_trng_stats
+{
+    uint32_t reads;             /*!< RngGenRandom calls that succeeded. */
+    uint32_t bytes;             /*!< Bytes handed to entropy pools. */
+    uint32_t errors;            /*!< RngGenRandom calls that failed (timeout or health test). */
+}
+mbedtls_trng_stats;
+
+/**
+ * \brief Entropy source callback (mbedtls_entropy_f_source_ptr) on the TRNG.
+ *
+ * \param data   Unused.
+ * \param output Where to write the entropy.
+ * \param len    Bytes wanted.
+ * \param olen   Bytes written, len on success.
+ *
+ * \return 0, or MBEDTLS_ERR_ENTROPY_SOURCE_FAILED if the TRNG failed.
+ */
+int mbedtls_trng_poll( void *data, unsigned char *output, size_t len, size_t *olen );
+
+/**
+ * \brief Returns the usage counters.
+ */
+mbedtls_trng_stats *mbedtls_trng_get_stats( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* trng_alt.h */
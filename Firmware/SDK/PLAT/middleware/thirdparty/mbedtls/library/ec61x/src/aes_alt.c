@@ -0,0 +1,602 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * MBEDTLS_AES_ALT on the L2C engine.
+ *
+ * ECB and CBC with 128 and 192-bit keys run in the engine, MBEDTLS_L2C_CHUNK
+ * bytes per call. The raw key is kept in ctx->key and loaded again on every
+ * call, with the IV, so contexts need nothing saved in the engine and
+ * interleave freely. 256-bit keys, which the engine does not take, and calls
+ * that find the engine taken use the byte oriented software cipher below
+ * on the schedule in ctx->buf. CFB, OFB and CTR are built on ECB as in the
+ * stock aes.c.
+ *
+ * GCM and CCM encrypt one block per mbedtls_aes_crypt_ecb call, so their
+ * cost is dominated by the per-call overhead: see the crypto benchmarks.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_AES_ALT)
+
+#if defined(MBEDTLS_CIPHER_MODE_XTS)
+#error "MBEDTLS_AES_ALT on the L2C engine does not provide XTS"
+#endif
+
+#include <string.h>
+#include <stdint.h>
+#include "mbedtls/aes.h"
+#include "l2c_alt.h"
+#include "l2ctls_qcx212.h"      // Required for L2CTlsAesProcess
+
+#define AES_KEY_SIZE_NONE   0xFF    /* L2C KeySize of a key the engine does not take */
+
+static const unsigned char FSb[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static const unsigned char RSb[256] =
+{
+    0x52, 0x09, 0x6A, 0xD5, 0x30, 0x36, 0xA5, 0x38, 0xBF, 0x40, 0xA3, 0x9E, 0x81, 0xF3, 0xD7, 0xFB,
+    0x7C, 0xE3, 0x39, 0x82, 0x9B, 0x2F, 0xFF, 0x87, 0x34, 0x8E, 0x43, 0x44, 0xC4, 0xDE, 0xE9, 0xCB,
+    0x54, 0x7B, 0x94, 0x32, 0xA6, 0xC2, 0x23, 0x3D, 0xEE, 0x4C, 0x95, 0x0B, 0x42, 0xFA, 0xC3, 0x4E,
+    0x08, 0x2E, 0xA1, 0x66, 0x28, 0xD9, 0x24, 0xB2, 0x76, 0x5B, 0xA2, 0x49, 0x6D, 0x8B, 0xD1, 0x25,
+    0x72, 0xF8, 0xF6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xD4, 0xA4, 0x5C, 0xCC, 0x5D, 0x65, 0xB6, 0x92,
+    0x6C, 0x70, 0x48, 0x50, 0xFD, 0xED, 0xB9, 0xDA, 0x5E, 0x15, 0x46, 0x57, 0xA7, 0x8D, 0x9D, 0x84,
+    0x90, 0xD8, 0xAB, 0x00, 0x8C, 0xBC, 0xD3, 0x0A, 0xF7, 0xE4, 0x58, 0x05, 0xB8, 0xB3, 0x45, 0x06,
+    0xD0, 0x2C, 0x1E, 0x8F, 0xCA, 0x3F, 0x0F, 0x02, 0xC1, 0xAF, 0xBD, 0x03, 0x01, 0x13, 0x8A, 0x6B,
+    0x3A, 0x91, 0x11, 0x41, 0x4F, 0x67, 0xDC, 0xEA, 0x97, 0xF2, 0xCF, 0xCE, 0xF0, 0xB4, 0xE6, 0x73,
+    0x96, 0xAC, 0x74, 0x22, 0xE7, 0xAD, 0x35, 0x85, 0xE2, 0xF9, 0x37, 0xE8, 0x1C, 0x75, 0xDF, 0x6E,
+    0x47, 0xF1, 0x1A, 0x71, 0x1D, 0x29, 0xC5, 0x89, 0x6F, 0xB7, 0x62, 0x0E, 0xAA, 0x18, 0xBE, 0x1B,
+    0xFC, 0x56, 0x3E, 0x4B, 0xC6, 0xD2, 0x79, 0x20, 0x9A, 0xDB, 0xC0, 0xFE, 0x78, 0xCD, 0x5A, 0xF4,
+    0x1F, 0xDD, 0xA8, 0x33, 0x88, 0x07, 0xC7, 0x31, 0xB1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xEC, 0x5F,
+    0x60, 0x51, 0x7F, 0xA9, 0x19, 0xB5, 0x4A, 0x0D, 0x2D, 0xE5, 0x7A, 0x9F, 0x93, 0xC9, 0x9C, 0xEF,
+    0xA0, 0xE0, 0x3B, 0x4D, 0xAE, 0x2A, 0xF5, 0xB0, 0xC8, 0xEB, 0xBB, 0x3C, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26, 0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
+};
+
+static void aes_zeroize( void *v, size_t n )
+{
+    volatile unsigned char *p = (volatile unsigned char *)v;
+
+    while( n-- )
+        *p++ = 0;
+}
+
+static unsigned char aes_xtime( unsigned char a )
+{
+    return( (unsigned char)( ( a << 1 ) ^ ( ( a & 0x80 ) ? 0x1B : 0x00 ) ) );
+}
+
+/* Engine KeySize of a context */
+static unsigned char aes_l2c_key_size( const mbedtls_aes_context *ctx )
+{
+    switch( ctx->nr )
+    {
+        case 10: return( 0 );
+        case 12: return( 1 );
+        default: return( AES_KEY_SIZE_NONE );
+    }
+}
+
+/* Software cipher --------------------------------------------------------- */
+
+/* Key expansion of FIPS-197 5.2, round keys as bytes in ctx->buf */
+static void aes_sw_expand( mbedtls_aes_context *ctx, const unsigned char *key, unsigned int nk )
+{
+    unsigned char *w = (unsigned char *)ctx->buf;
+    unsigned char t[4], u, rcon = 0x01;
+    unsigned int i, j;
+
+    memcpy( w, key, 4 * nk );
+
+    for( i = nk; i < 4 * ( (unsigned int)ctx->nr + 1 ); i++ )
+    {
+        memcpy( t, w + 4 * ( i - 1 ), 4 );
+
+        if( i % nk == 0 )
+        {
+            u = t[0];
+            t[0] = (unsigned char)( FSb[t[1]] ^ rcon );
+            t[1] = FSb[t[2]];
+            t[2] = FSb[t[3]];
+            t[3] = FSb[u];
+            rcon = aes_xtime( rcon );
+        }
+        else if( nk > 6 && i % nk == 4 )
+        {
+            for( j = 0; j < 4; j++ )
+                t[j] = FSb[t[j]];
+        }
+
+        for( j = 0; j < 4; j++ )
+            w[4 * i + j] = w[4 * ( i - nk ) + j] ^ t[j];
+    }
+}
+
+static void aes_sw_add_key( unsigned char s[16], const unsigned char *rk )
+{
+    unsigned int i;
+
+    for( i = 0; i < 16; i++ )
+        s[i] ^= rk[i];
+}
+
+/* State is column major: byte 4 * column + row */
+static void aes_sw_sub_shift( unsigned char s[16] )
+{
+    unsigned char t[16];
+    unsigned int c, r;
+
+    for( c = 0; c < 4; c++ )
+        for( r = 0; r < 4; r++ )
+            t[4 * c + r] = FSb[s[4 * ( ( c + r ) & 3 ) + r]];
+
+    memcpy( s, t, 16 );
+}
+
+static void aes_sw_inv_shift_sub( unsigned char s[16] )
+{
+    unsigned char t[16];
+    unsigned int c, r;
+
+    for( c = 0; c < 4; c++ )
+        for( r = 0; r < 4; r++ )
+            t[4 * ( ( c + r ) & 3 ) + r] = RSb[s[4 * c + r]];
+
+    memcpy( s, t, 16 );
+}
+
+static void aes_sw_mix( unsigned char s[16] )
+{
+    unsigned char a0, a1, a2, a3, t;
+    unsigned int c;
+
+    for( c = 0; c < 16; c += 4 )
+    {
+        a0 = s[c]; a1 = s[c + 1]; a2 = s[c + 2]; a3 = s[c + 3];
+        t = a0 ^ a1 ^ a2 ^ a3;
+        s[c]     = a0 ^ t ^ aes_xtime( a0 ^ a1 );
+        s[c + 1] = a1 ^ t ^ aes_xtime( a1 ^ a2 );
+        s[c + 2] = a2 ^ t ^ aes_xtime( a2 ^ a3 );
+        s[c + 3] = a3 ^ t ^ aes_xtime( a3 ^ a0 );
+    }
+}
+
+static void aes_sw_inv_mix( unsigned char s[16] )
+{
+    unsigned char u, v;
+    unsigned int c;
+
+    // InvMixColumns = MixColumns after this preprocessing step
+    for( c = 0; c < 16; c += 4 )
+    {
+        u = aes_xtime( aes_xtime( s[c] ^ s[c + 2] ) );
+        v = aes_xtime( aes_xtime( s[c + 1] ^ s[c + 3] ) );
+        s[c] ^= u; s[c + 1] ^= v; s[c + 2] ^= u; s[c + 3] ^= v;
+    }
+
+    aes_sw_mix( s );
+}
+
+static void aes_sw_block( const mbedtls_aes_context *ctx, int mode,
+                          const unsigned char input[16], unsigned char output[16] )
+{
+    const unsigned char *rk = (const unsigned char *)ctx->buf;
+    unsigned char s[16];
+    int r;
+
+    memcpy( s, input, 16 );
+
+    if( mode == MBEDTLS_AES_ENCRYPT )
+    {
+        aes_sw_add_key( s, rk );
+        for( r = 1; r < ctx->nr; r++ )
+        {
+            aes_sw_sub_shift( s );
+            aes_sw_mix( s );
+            aes_sw_add_key( s, rk + 16 * r );
+        }
+        aes_sw_sub_shift( s );
+        aes_sw_add_key( s, rk + 16 * ctx->nr );
+    }
+    else
+    {
+        aes_sw_add_key( s, rk + 16 * ctx->nr );
+        for( r = ctx->nr - 1; r > 0; r-- )
+        {
+            aes_sw_inv_shift_sub( s );
+            aes_sw_add_key( s, rk + 16 * r );
+            aes_sw_inv_mix( s );
+        }
+        aes_sw_inv_shift_sub( s );
+        aes_sw_add_key( s, rk );
+    }
+
+    memcpy( output, s, 16 );
+    aes_zeroize( s, sizeof( s ) );
+}
+
+/* Engine ------------------------------------------------------------------ */
+
+/*
+ * Runs ECB (iv == NULL) or CBC over whole blocks in the engine. Returns the
+ * bytes done, which may be short of length if the engine is taken or fails
+ * part way; iv is then the one to continue with in software.
+ */
+static size_t aes_l2c_crypt( mbedtls_aes_context *ctx, int mode, unsigned char iv[16],
+                             const unsigned char *input, unsigned char *output, size_t length )
+{
+    static uint32_t l2cKey[8];
+    static uint32_t l2cIv[4];
+    unsigned char *in, *out;
+    unsigned char next[16];
+    L2CTlsAesStruct info;
+    mbedtls_l2c_stats *stats = mbedtls_l2c_get_stats();
+    unsigned char keySize = aes_l2c_key_size( ctx );
+    size_t done = 0, n;
+    size_t used = ( length > MBEDTLS_L2C_CHUNK ) ? MBEDTLS_L2C_CHUNK : length;
+
+    if( keySize == AES_KEY_SIZE_NONE || !mbedtls_l2c_acquire() )
+        return( 0 );
+
+    in = mbedtls_l2c_bounce();
+    out = in + MBEDTLS_L2C_CHUNK;
+    memcpy( l2cKey, ctx->key, NR_TO_KEY_BYTE_LEN( ctx->nr ) );
+
+    memset( &info, 0, sizeof( info ) );
+    info.KeyAddress = (uint32_t)(uintptr_t)l2cKey;
+    info.InputData = (uint32_t)(uintptr_t)in;
+    info.OutputData = (uint32_t)(uintptr_t)out;
+    info.Ctrl.Encrypt = ( mode == MBEDTLS_AES_ENCRYPT ) ? 0 : 1;
+    info.Ctrl.ChainMode = ( iv != NULL ) ? 1 : 0;
+    info.Ctrl.KeySize = keySize;
+    info.Ctrl.KeyType = 1;
+
+    while( done < length )
+    {
+        n = ( length - done > MBEDTLS_L2C_CHUNK ) ? MBEDTLS_L2C_CHUNK : length - done;
+        memcpy( in, input + done, n );
+        info.DataLen = (uint32_t)n;
+
+        if( iv != NULL )
+        {
+            memcpy( l2cIv, iv, 16 );
+            info.IVAddress = (uint32_t)(uintptr_t)l2cIv;
+            // The next IV is the last ciphertext block, read it before output may overwrite input
+            if( mode == MBEDTLS_AES_DECRYPT )
+                memcpy( next, in + n - 16, 16 );
+        }
+
+        if( L2CTlsAesProcess( &info ) != L2CTLSDRV_OK )
+        {
+            stats->errors++;
+            break;
+        }
+
+        memcpy( output + done, out, n );
+        if( iv != NULL )
+            memcpy( iv, ( mode == MBEDTLS_AES_DECRYPT ) ? next : out + n - 16, 16 );
+
+        stats->aes_hw_calls++;
+        stats->aes_hw_bytes += (uint32_t)n;
+        done += n;
+    }
+
+    aes_zeroize( l2cKey, sizeof( l2cKey ) );
+    aes_zeroize( in, used );
+    aes_zeroize( out, used );
+    mbedtls_l2c_release();
+
+    return( done );
+}
+
+/* Context ----------------------------------------------------------------- */
+
+void mbedtls_aes_init( mbedtls_aes_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_aes_context ) );
+}
+
+void mbedtls_aes_free( mbedtls_aes_context *ctx )
+{
+    if( ctx == NULL )
+        return;
+
+    aes_zeroize( ctx, sizeof( mbedtls_aes_context ) );
+}
+
+int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
+                            unsigned int keybits )
+{
+    switch( keybits )
+    {
+        case 128: ctx->nr = 10; break;
+        case 192: ctx->nr = 12; break;
+        case 256: ctx->nr = 14; break;
+        default : return( MBEDTLS_ERR_AES_INVALID_KEY_LENGTH );
+    }
+
+    // The engine runs the key schedule itself, software needs it expanded
+    ctx->rk = ctx->buf;
+    memcpy( ctx->key, key, keybits / 8 );
+    aes_sw_expand( ctx, key, keybits / 32 );
+
+    return( 0 );
+}
+
+/* The inverse cipher walks the encryption schedule backwards */
+int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
+                            unsigned int keybits )
+{
+    return( mbedtls_aes_setkey_enc( ctx, key, keybits ) );
+}
+
+/* Modes ------------------------------------------------------------------- */
+
+int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    return( mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, input, output ) );
+}
+
+int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    return( mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_DECRYPT, input, output ) );
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_internal_aes_encrypt( ctx, input, output );
+}
+
+void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] )
+{
+    mbedtls_internal_aes_decrypt( ctx, input, output );
+}
+#endif /* !MBEDTLS_DEPRECATED_REMOVED */
+
+int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
+                           int mode,
+                           const unsigned char input[16],
+                           unsigned char output[16] )
+{
+    if( mode != MBEDTLS_AES_ENCRYPT && mode != MBEDTLS_AES_DECRYPT )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    if( aes_l2c_crypt( ctx, mode, NULL, input, output, 16 ) == 16 )
+        return( 0 );
+
+    mbedtls_l2c_get_stats()->aes_sw_blocks++;
+    aes_sw_block( ctx, mode, input, output );
+
+    return( 0 );
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
+                           int mode,
+                           size_t length,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    unsigned char temp[16];
+    size_t done;
+    int i;
+
+    if( mode != MBEDTLS_AES_ENCRYPT && mode != MBEDTLS_AES_DECRYPT )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    if( length % 16 )
+        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
+    done = aes_l2c_crypt( ctx, mode, iv, input, output, length );
+    input += done;
+    output += done;
+    length -= done;
+
+    mbedtls_l2c_get_stats()->aes_sw_blocks += (uint32_t)( length / 16 );
+
+    while( length > 0 )
+    {
+        if( mode == MBEDTLS_AES_DECRYPT )
+        {
+            memcpy( temp, input, 16 );
+            aes_sw_block( ctx, mode, input, output );
+            for( i = 0; i < 16; i++ )
+                output[i] ^= iv[i];
+            memcpy( iv, temp, 16 );
+        }
+        else
+        {
+            for( i = 0; i < 16; i++ )
+                output[i] = input[i] ^ iv[i];
+            aes_sw_block( ctx, mode, output, output );
+            memcpy( iv, output, 16 );
+        }
+
+        input += 16;
+        output += 16;
+        length -= 16;
+    }
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+
+#if defined(MBEDTLS_CIPHER_MODE_CFB)
+int mbedtls_aes_crypt_cfb128( mbedtls_aes_context *ctx,
+                              int mode,
+                              size_t length,
+                              size_t *iv_off,
+                              unsigned char iv[16],
+                              const unsigned char *input,
+                              unsigned char *output )
+{
+    size_t n = *iv_off;
+    int c;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    while( length-- )
+    {
+        if( n == 0 )
+            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+        {
+            c = *input++;
+            *output++ = (unsigned char)( c ^ iv[n] );
+            iv[n] = (unsigned char)c;
+        }
+        else
+        {
+            iv[n] = *output++ = (unsigned char)( iv[n] ^ *input++ );
+        }
+
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+
+int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
+                            int mode,
+                            size_t length,
+                            unsigned char iv[16],
+                            const unsigned char *input,
+                            unsigned char *output )
+{
+    unsigned char c;
+    unsigned char ov[17];
+
+    while( length-- )
+    {
+        memcpy( ov, iv, 16 );
+        mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        if( mode == MBEDTLS_AES_DECRYPT )
+            ov[16] = *input;
+
+        c = *output++ = (unsigned char)( iv[0] ^ *input++ );
+
+        if( mode == MBEDTLS_AES_ENCRYPT )
+            ov[16] = c;
+
+        memcpy( iv, ov + 1, 16 );
+    }
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_OFB)
+int mbedtls_aes_crypt_ofb( mbedtls_aes_context *ctx,
+                           size_t length,
+                           size_t *iv_off,
+                           unsigned char iv[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    size_t n = *iv_off;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    while( length-- )
+    {
+        if( n == 0 )
+            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+        *output++ = *input++ ^ iv[n];
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *iv_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_OFB */
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
+                           size_t length,
+                           size_t *nc_off,
+                           unsigned char nonce_counter[16],
+                           unsigned char stream_block[16],
+                           const unsigned char *input,
+                           unsigned char *output )
+{
+    size_t n = *nc_off;
+    int i;
+
+    if( n > 15 )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    while( length-- )
+    {
+        if( n == 0 )
+        {
+            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block );
+
+            for( i = 16; i > 0; i-- )
+                if( ++nonce_counter[i - 1] != 0 )
+                    break;
+        }
+
+        *output++ = *input++ ^ stream_block[n];
+        n = ( n + 1 ) & 0x0F;
+    }
+
+    *nc_off = n;
+
+    return( 0 );
+}
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+
+#endif /* MBEDTLS_AES_C && MBEDTLS_AES_ALT */
@@ -0,0 +1,117 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_AES_ALT) || defined(MBEDTLS_SHA256_ALT)
+
+#include <string.h>
+#include <stdint.h>
+#include "l2c_alt.h"
+#include "cmsis_os2.h"          // Required for osKernelLock
+#include "l2ctls_qcx212.h"      // Required for L2CTlsInit, L2CTlsDeInit
+
+static volatile uint8_t l2cOwned;
+static uint8_t l2cClocked;
+static uint8_t l2cDisabled;
+static mbedtls_l2c_stats l2cStats;
+static uint32_t l2cBounce[2 * MBEDTLS_L2C_CHUNK / 4];
+
+/* Try-lock: crypto never runs in interrupts, holding off the scheduler is enough */
+static int l2c_take( void )
+{
+    int32_t lock;
+    int taken = 0;
+
+    lock = osKernelLock();
+    if( !l2cOwned )
+    {
+        l2cOwned = 1;
+        taken = 1;
+    }
+    osKernelRestoreLock( lock );
+
+    return( taken );
+}
+
+void mbedtls_l2c_set_hw( int enable )
+{
+    l2cDisabled = !enable;
+}
+
+int mbedtls_l2c_get_hw( void )
+{
+    return( !l2cDisabled );
+}
+
+int mbedtls_l2c_acquire( void )
+{
+    if( l2cDisabled )
+        return( 0 );
+
+    if( !l2c_take() )
+    {
+        l2cStats.busy++;
+        return( 0 );
+    }
+
+    if( !l2cClocked )
+    {
+        L2CTlsInit();
+        l2cClocked = 1;
+    }
+
+    return( 1 );
+}
+
+void mbedtls_l2c_release( void )
+{
+    l2cOwned = 0;
+}
+
+unsigned char *mbedtls_l2c_bounce( void )
+{
+    return( (unsigned char *)l2cBounce );
+}
+
+void mbedtls_l2c_idle( void )
+{
+    if( !l2c_take() )
+        return;
+
+    if( l2cClocked )
+    {
+        L2CTlsDeInit();
+        l2cClocked = 0;
+    }
+
+    mbedtls_l2c_release();
+}
+
+mbedtls_l2c_stats *mbedtls_l2c_get_stats( void )
+{
+    return( &l2cStats );
+}
+
+void mbedtls_l2c_reset_stats( void )
+{
+    memset( &l2cStats, 0, sizeof( l2cStats ) );
+}
+
+#endif /* MBEDTLS_AES_ALT || MBEDTLS_SHA256_ALT */
@@ -0,0 +1,359 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * MBEDTLS_SHA256_ALT on the L2C engine.
+ *
+ * The engine hashes a message from the initial state in one session and
+ * cannot load an intermediate one, so a context first keeps its message in
+ * ctx->stage. A message that is complete within MBEDTLS_SHA256_ALT_STAGE
+ * bytes when finished is hashed by the engine in one go: the HMAC and PRF
+ * hashes of a TLS session are that short. A longer one, the handshake
+ * transcript or a certificate, replays the stage into the software state
+ * and goes on in software, as does a finish that finds the engine taken.
+ *
+ * Cloning copies the stage or the software state, so the handshake
+ * checksum can be forked for the Finished message in either mode.
+ *
+ * mbedtls_sha256_ret and the self test stay in the stock sha256.c.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_SHA256_C) && defined(MBEDTLS_SHA256_ALT)
+
+#include <string.h>
+#include <stdint.h>
+#include "mbedtls/sha256.h"
+#include "l2c_alt.h"
+#include "l2ctls_qcx212.h"      // Required for L2CShaComInit, L2CShaUpdate
+
+#if MBEDTLS_SHA256_ALT_STAGE % 4
+#error "MBEDTLS_SHA256_ALT_STAGE must be a multiple of 4"
+#endif
+
+#define GET_UINT32_BE(n, b, i)                          \
+    (n) = ( (uint32_t) (b)[(i)    ] << 24 )             \
+        | ( (uint32_t) (b)[(i) + 1] << 16 )             \
+        | ( (uint32_t) (b)[(i) + 2] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 3]       )
+
+#define PUT_UINT32_BE(n, b, i)                          \
+    do {                                                \
+        (b)[(i)    ] = (unsigned char) ( (n) >> 24 );   \
+        (b)[(i) + 1] = (unsigned char) ( (n) >> 16 );   \
+        (b)[(i) + 2] = (unsigned char) ( (n) >>  8 );   \
+        (b)[(i) + 3] = (unsigned char) ( (n)       );   \
+    } while( 0 )
+
+static const uint32_t K[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+#define ROTR(x, n)  ( ( (x) >> (n) ) | ( (x) << ( 32 - (n) ) ) )
+#define S0(x)       ( ROTR( x,  7 ) ^ ROTR( x, 18 ) ^ ( (x) >>  3 ) )
+#define S1(x)       ( ROTR( x, 17 ) ^ ROTR( x, 19 ) ^ ( (x) >> 10 ) )
+#define S2(x)       ( ROTR( x,  2 ) ^ ROTR( x, 13 ) ^ ROTR( x, 22 ) )
+#define S3(x)       ( ROTR( x,  6 ) ^ ROTR( x, 11 ) ^ ROTR( x, 25 ) )
+#define F0(x, y, z) ( ( (x) & (y) ) | ( (z) & ( (x) | (y) ) ) )
+#define F1(x, y, z) ( (z) ^ ( (x) & ( (y) ^ (z) ) ) )
+
+static void sha256_zeroize( void *v, size_t n )
+{
+    volatile unsigned char *p = (volatile unsigned char *)v;
+
+    while( n-- )
+        *p++ = 0;
+}
+
+/* Software ---------------------------------------------------------------- */
+
+static void sha256_sw_process( mbedtls_sha256_context *ctx, const unsigned char data[64] )
+{
+    uint32_t W[64], a, b, c, d, e, f, g, h, t1, t2;
+    unsigned int i;
+
+    for( i = 0; i < 16; i++ )
+        GET_UINT32_BE( W[i], data, 4 * i );
+
+    for( ; i < 64; i++ )
+        W[i] = S1( W[i - 2] ) + W[i - 7] + S0( W[i - 15] ) + W[i - 16];
+
+    a = ctx->state[0]; b = ctx->state[1]; c = ctx->state[2]; d = ctx->state[3];
+    e = ctx->state[4]; f = ctx->state[5]; g = ctx->state[6]; h = ctx->state[7];
+
+    for( i = 0; i < 64; i++ )
+    {
+        t1 = h + S3( e ) + F1( e, f, g ) + K[i] + W[i];
+        t2 = S2( a ) + F0( a, b, c );
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+
+    sha256_zeroize( W, sizeof( W ) );
+    mbedtls_l2c_get_stats()->sha_sw_blocks++;
+}
+
+static void sha256_sw_update( mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen )
+{
+    size_t fill;
+    uint32_t left;
+
+    left = ctx->total[0] & 0x3F;
+    fill = 64 - left;
+
+    ctx->total[0] += (uint32_t)ilen;
+    if( ctx->total[0] < (uint32_t)ilen )
+        ctx->total[1]++;
+
+    if( left && ilen >= fill )
+    {
+        memcpy( ctx->buffer + left, input, fill );
+        sha256_sw_process( ctx, ctx->buffer );
+        input += fill;
+        ilen -= fill;
+        left = 0;
+    }
+
+    while( ilen >= 64 )
+    {
+        sha256_sw_process( ctx, input );
+        input += 64;
+        ilen -= 64;
+    }
+
+    if( ilen > 0 )
+        memcpy( ctx->buffer + left, input, ilen );
+}
+
+/* Continues the staged message in software */
+static void sha256_demote( mbedtls_sha256_context *ctx )
+{
+    uint32_t staged = ctx->staged;
+
+    if( staged == MBEDTLS_SHA256_ALT_SW )
+        return;
+
+    ctx->staged = MBEDTLS_SHA256_ALT_SW;
+    sha256_sw_update( ctx, (const unsigned char *)ctx->stage, staged );
+    sha256_zeroize( ctx->stage, staged );
+}
+
+/* Engine ------------------------------------------------------------------ */
+
+/* Hashes the staged message in one engine session, returns 0 if it could not */
+static int sha256_l2c( mbedtls_sha256_context *ctx, unsigned char output[32] )
+{
+    const unsigned char *stage = (const unsigned char *)ctx->stage;
+    unsigned char *in, *out;
+    uint32_t done = 0, n;
+    int last, ok = 1;
+
+    // The engine is not given empty messages
+    if( ctx->staged == 0 || !mbedtls_l2c_acquire() )
+        return( 0 );
+
+    in = mbedtls_l2c_bounce();
+    out = in + MBEDTLS_L2C_CHUNK;
+
+    L2CShaComInit( ctx->is224 ? L2C_SHA_TYPE_224 : L2C_SHA_TYPE_256 );
+
+    do
+    {
+        n = ( ctx->staged - done > MBEDTLS_L2C_CHUNK ) ? MBEDTLS_L2C_CHUNK : ctx->staged - done;
+        last = ( done + n == ctx->staged );
+        memcpy( in, stage + done, n );
+
+        if( L2CShaUpdate( (uint32_t)(uintptr_t)in, (uint32_t)(uintptr_t)out, n, last ) != L2CTLSDRV_OK )
+        {
+            mbedtls_l2c_get_stats()->errors++;
+            ok = 0;
+            break;
+        }
+        done += n;
+    }
+    while( !last );
+
+    if( ok )
+        memcpy( output, out, ctx->is224 ? 28 : 32 );
+
+    sha256_zeroize( in, MBEDTLS_L2C_CHUNK + 32 );
+    mbedtls_l2c_release();
+
+    return( ok );
+}
+
+/* Context ----------------------------------------------------------------- */
+
+void mbedtls_sha256_init( mbedtls_sha256_context *ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_sha256_context ) );
+}
+
+void mbedtls_sha256_free( mbedtls_sha256_context *ctx )
+{
+    if( ctx == NULL )
+        return;
+
+    sha256_zeroize( ctx, sizeof( mbedtls_sha256_context ) );
+}
+
+void mbedtls_sha256_clone( mbedtls_sha256_context *dst,
+                           const mbedtls_sha256_context *src )
+{
+    *dst = *src;
+}
+
+int mbedtls_sha256_starts_ret( mbedtls_sha256_context *ctx, int is224 )
+{
+    static const uint32_t iv256[8] =
+    {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+    };
+    static const uint32_t iv224[8] =
+    {
+        0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939,
+        0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4,
+    };
+
+    if( is224 != 0 && is224 != 1 )
+        return( MBEDTLS_ERR_SHA256_BAD_INPUT_DATA );
+
+    ctx->total[0] = 0;
+    ctx->total[1] = 0;
+    memcpy( ctx->state, is224 ? iv224 : iv256, sizeof( ctx->state ) );
+    ctx->is224 = is224;
+    ctx->staged = 0;
+
+    return( 0 );
+}
+
+int mbedtls_internal_sha256_process( mbedtls_sha256_context *ctx,
+                                     const unsigned char data[64] )
+{
+    sha256_demote( ctx );
+    sha256_sw_process( ctx, data );
+
+    return( 0 );
+}
+
+int mbedtls_sha256_update_ret( mbedtls_sha256_context *ctx,
+                               const unsigned char *input,
+                               size_t ilen )
+{
+    if( ilen == 0 )
+        return( 0 );
+
+    if( ctx->staged != MBEDTLS_SHA256_ALT_SW && ilen <= MBEDTLS_SHA256_ALT_STAGE - ctx->staged )
+    {
+        memcpy( (unsigned char *)ctx->stage + ctx->staged, input, ilen );
+        ctx->staged += (uint32_t)ilen;
+        return( 0 );
+    }
+
+    sha256_demote( ctx );
+    sha256_sw_update( ctx, input, ilen );
+
+    return( 0 );
+}
+
+int mbedtls_sha256_finish_ret( mbedtls_sha256_context *ctx,
+                               unsigned char output[32] )
+{
+    uint32_t used, high, low;
+
+    if( ctx->staged != MBEDTLS_SHA256_ALT_SW && sha256_l2c( ctx, output ) )
+    {
+        mbedtls_l2c_get_stats()->sha_hw++;
+        return( 0 );
+    }
+
+    sha256_demote( ctx );
+    mbedtls_l2c_get_stats()->sha_sw++;
+
+    used = ctx->total[0] & 0x3F;
+    ctx->buffer[used++] = 0x80;
+
+    if( used > 56 )
+    {
+        memset( ctx->buffer + used, 0, 64 - used );
+        sha256_sw_process( ctx, ctx->buffer );
+        used = 0;
+    }
+    memset( ctx->buffer + used, 0, 56 - used );
+
+    high = ( ctx->total[0] >> 29 ) | ( ctx->total[1] << 3 );
+    low = ( ctx->total[0] << 3 );
+    PUT_UINT32_BE( high, ctx->buffer, 56 );
+    PUT_UINT32_BE( low, ctx->buffer, 60 );
+    sha256_sw_process( ctx, ctx->buffer );
+
+    for( used = 0; used < ( ctx->is224 ? 7u : 8u ); used++ )
+        PUT_UINT32_BE( ctx->state[used], output, 4 * used );
+
+    return( 0 );
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_sha256_starts( mbedtls_sha256_context *ctx, int is224 )
+{
+    mbedtls_sha256_starts_ret( ctx, is224 );
+}
+
+void mbedtls_sha256_update( mbedtls_sha256_context *ctx,
+                            const unsigned char *input,
+                            size_t ilen )
+{
+    mbedtls_sha256_update_ret( ctx, input, ilen );
+}
+
+void mbedtls_sha256_finish( mbedtls_sha256_context *ctx,
+                            unsigned char output[32] )
+{
+    mbedtls_sha256_finish_ret( ctx, output );
+}
+
+void mbedtls_sha256_process( mbedtls_sha256_context *ctx,
+                             const unsigned char data[64] )
+{
+    mbedtls_internal_sha256_process( ctx, data );
+}
+#endif /* !MBEDTLS_DEPRECATED_REMOVED */
+
+#endif /* MBEDTLS_SHA256_C && MBEDTLS_SHA256_ALT */
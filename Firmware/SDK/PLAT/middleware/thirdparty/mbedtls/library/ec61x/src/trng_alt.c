@@ -0,0 +1,67 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ENTROPY_C) && defined(MBEDTLS_ENTROPY_TRNG)
+
+#include <string.h>
+#include "mbedtls/entropy.h"
+#include "mbedtls/platform_util.h"
+#include "trng_alt.h"
+#include "qcx212.h"             // Required by rng_qcx212.h
+#include "rng_qcx212.h"         // Required for RngGenRandom
+
+static mbedtls_trng_stats trngStats;
+
+int mbedtls_trng_poll( void *data, unsigned char *output, size_t len, size_t *olen )
+{
+    uint8_t block[MBEDTLS_TRNG_BLOCK];
+    size_t n;
+
+    (void) data;
+    *olen = 0;
+
+    while( *olen < len )
+    {
+        if( RngGenRandom( block ) != RNGDRV_OK )
+        {
+            trngStats.errors++;
+            mbedtls_platform_zeroize( block, sizeof( block ) );
+            return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+        }
+        trngStats.reads++;
+
+        n = len - *olen < sizeof( block ) ? len - *olen : sizeof( block );
+        memcpy( output + *olen, block, n );
+        *olen += n;
+    }
+
+    trngStats.bytes += *olen;
+    mbedtls_platform_zeroize( block, sizeof( block ) );
+
+    return( 0 );
+}
+
+mbedtls_trng_stats *mbedtls_trng_get_stats( void )
+{
+    return( &trngStats );
+}
+
+#endif /* MBEDTLS_ENTROPY_C && MBEDTLS_ENTROPY_TRNG */
@@ -51,16 +51,50 @@
 #define HT_MQTT_TX_BUF_LEN 1024
 #define HT_MQTT_RX_BUF_LEN 1024
 
+#if !defined(HT_MQTT_TLS_ARENA_SIZE)
+#define HT_MQTT_TLS_ARENA_SIZE (24*1024)   // mbedTLS heap with MBEDTLS_MEMORY_BUFFER_ALLOC_C, set by the application Makefile
+#endif
+
+// DRBG requests between two reseeds from the TRNG. The DRBG outlives the connections of a boot,
+// a handshake takes a few dozen requests
+#if !defined(HT_MQTT_TLS_DRBG_RESEED_INTERVAL)
+#define HT_MQTT_TLS_DRBG_RESEED_INTERVAL 256
+#endif
+
+// Maximum fragment length (RFC 6066) asked of the broker, MBEDTLS_SSL_MAX_FRAG_LEN_NONE for none.
+// mbedTLS 2 cannot rebuild a handshake message split over records: a broker that honours it has to
+// send its certificate chain in one fragment, one that ignores it in one MBEDTLS_SSL_IN_CONTENT_LEN record
+#if !defined(HT_MQTT_TLS_MFL)
+#define HT_MQTT_TLS_MFL MBEDTLS_SSL_MAX_FRAG_LEN_1024
+#endif
+// Same with a pre-shared key, nothing in that handshake comes near 512 bytes
+#if !defined(HT_MQTT_TLS_MFL_PSK)
+#if defined(CONFIG_MBEDTLS_LOW_RAM)
+#define HT_MQTT_TLS_MFL_PSK MBEDTLS_SSL_MAX_FRAG_LEN_512
+#else
+#define HT_MQTT_TLS_MFL_PSK HT_MQTT_TLS_MFL
+#endif
+#endif
+// 1: a full PSK handshake fails unless the broker acknowledges the fragment length. The record buffers
+// shrink to it after the handshake, a broker that ignored it would overrun them mid-session
+#if !defined(HT_MQTT_TLS_MFL_REQUIRED)
+#if defined(CONFIG_MBEDTLS_LOW_RAM)
+#define HT_MQTT_TLS_MFL_REQUIRED 1
+#else
+#define HT_MQTT_TLS_MFL_REQUIRED 0
+#endif
+#endif
+
 typedef struct MqttClientSslTag {
     mbedtls_ssl_context sslContext;
     mbedtls_net_context netContext;
     mbedtls_ssl_config sslConfig;
-    mbedtls_entropy_context entropyContext;
-    mbedtls_ctr_drbg_context ctrDrbgContext;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
     mbedtls_x509_crt_profile crtProfile;
     mbedtls_x509_crt caCert;
     mbedtls_x509_crt clientCert;
     mbedtls_pk_context pkContext;
+#endif
 } MqttClientSsl;
 
 typedef struct MqttClientContextTag {
@@ -87,10 +121,48 @@ typedef struct MqttClientContextTag {
     int32_t clientPkLen;
     char *host;
     uint32_t timeout_ms;
+    uint32_t handshake_ms;      // Duration of the last TLS handshake, set by HT_MQTT_TLSConnect
+    uint8_t *session;           // Serialized mbedtls_ssl_session to resume, NULL disables resumption
+    size_t sessionSize;         // Capacity of session
+    size_t sessionLen;          // In: bytes of session to offer, 0 for none. Out: the new session, 0 if it did not fit
+    uint32_t sessionLifetime_s; // Out: ticket lifetime hint of the new session, 0 if none
+    uint8_t sessionOffered;     // Out: the last handshake offered the session
+    uint8_t sessionResumed;     // Out: the last handshake was abbreviated (session accepted)
+    const uint8_t *psk;         // Pre-shared key, selects PSK-AES-128-CCM-8 instead of certificates. NULL for certificates
+    size_t pskLen;              // Bytes in psk, at most MBEDTLS_PSK_MAX_LEN
+    const uint8_t *pskIdentity; // PSK identity sent to the broker
+    size_t pskIdentityLen;      // Bytes in pskIdentity
+    uint8_t mflAccepted;        // Out: the broker acknowledged the maximum fragment length in the last handshake
+    uint16_t recordInLen;       // Out: input record buffer kept after the last handshake, bytes
+    uint16_t recordOutLen;      // Out: output record buffer kept after the last handshake, bytes
+    uint8_t rngSeeded;          // Out: the last connect seeded the DRBG (first connect of the boot)
+    uint32_t rng_ms;            // Out: time the last connect spent seeding the DRBG
 } MqttClientContext;
 
+// mbedTLS arena usage, all zero when mbedTLS allocates from the system heap
+typedef struct MqttTlsArenaStatsTag {
+    uint32_t size;              // Arena bytes (HT_MQTT_TLS_ARENA_SIZE)
+    uint32_t used;              // Bytes allocated now
+    uint32_t peak;              // Most bytes allocated at once since boot
+    uint32_t handshakePeak;     // Most bytes allocated during the last handshake
+    uint32_t freeBytes;         // Bytes not allocated after the last handshake, block headers included
+    uint32_t largestFree;       // Largest block that could be allocated after the last handshake
+    uint16_t leaks;             // Releases that found blocks still allocated: the arena was kept
+} MqttTlsArenaStats;
+
 int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network);
 
+// mbedTLS allocates only between these two. HT_MQTT_TLSConnect opens the arena and the disconnect
+// (or a failed connect) closes it; other mbedTLS users, e.g. a crypto self-test, bracket their calls.
+// Brackets nest: the arena is emptied when the last one closes
+void HT_MQTT_TLSArenaOpen(void);
+void HT_MQTT_TLSArenaClose(void);
+void HT_MQTT_TLSArenaGetStats(MqttTlsArenaStats *stats);
+
+// The DRBG of every TLS and DTLS connection of the boot, seeded from the TRNG by the first call.
+// Returns 1 if this call seeded it (seed_ms: time taken), 0 if an earlier one did, < 0 on error
+int HT_MQTT_TLSDrbg(mbedtls_ctr_drbg_context **drbg, uint32_t *seed_ms);
+
 #endif /*__HT_MQTT_H__*/
 
 /************************ HT Micron Semicondutores S.A *****END OF FILE****/
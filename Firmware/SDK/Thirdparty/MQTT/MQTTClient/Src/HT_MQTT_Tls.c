@@ -1,24 +1,302 @@
 
 #include "HT_MQTT_Tls.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl_internal.h"
+#if defined(MBEDTLS_AES_ALT) || defined(MBEDTLS_SHA256_ALT)
+#include "l2c_alt.h"
+#endif
+#if defined(MBEDTLS_ENTROPY_TRNG)
+#include "trng_alt.h"
+#endif
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#include "mbedtls/memory_buffer_alloc.h"
+#include "mbedtls/platform_util.h"
+#endif
 
 MqttClientSsl *ssl;
+static MqttClientContext *client;
+static MqttTlsArenaStats arenaStats;
+
+// One DRBG for every connection of the boot, DTLS included, outside the arena: seeded by the first
+// connect, then reseeded from the TRNG every HT_MQTT_TLS_DRBG_RESEED_INTERVAL requests
+static mbedtls_entropy_context HT_MQTT_TlsEntropy;
+static mbedtls_ctr_drbg_context HT_MQTT_TlsDrbg;
+static uint8_t drbgSeeded;
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+// Every mbedTLS allocation, MqttClientSsl included, comes from here instead of the FreeRTOS heap
+static unsigned char HT_MQTT_TlsArena[HT_MQTT_TLS_ARENA_SIZE] __attribute__((aligned(8)));
+static uint8_t arenaOpen;
+static uint8_t arenaUsers;      // Open brackets not closed yet: the MQTT connection, a DTLS connection, a self-test
+#endif
+
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) && defined(MBEDTLS_CCM_C)
+#define HT_MQTT_TLS_PSK
+// PSK mode: no certificates, no ECDHE, AES-128 on the L2C engine with an 8-byte tag
+static const int HT_MQTT_TlsPskCiphersuites[] = {
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+	0
+};
+#endif
+
+#if defined(MBEDTLS_AES_ALT) && defined(MBEDTLS_X509_CRT_PARSE_C)
+// The L2C engine takes 128 and 192-bit keys, AES-256 suites run in software: offered last
+static const int HT_MQTT_TlsCiphersuites[] = {
+	MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+	MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM,
+	MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+	MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+	MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256,
+	MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,
+	MBEDTLS_TLS_RSA_WITH_AES_128_CBC_SHA256,
+	MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+	MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+	MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+	MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA384,
+	MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+	MBEDTLS_TLS_RSA_WITH_AES_256_GCM_SHA384,
+	MBEDTLS_TLS_RSA_WITH_AES_256_CBC_SHA256,
+	0
+};
+#endif
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+// Folds the allocator peak since the last call into the statistics and starts a new window
+static size_t HT_MQTT_TLSArenaPeak(void) {
+	size_t peak = 0, blocks = 0;
+
+	mbedtls_memory_buffer_alloc_max_get(&peak, &blocks);
+	mbedtls_memory_buffer_alloc_max_reset();
+	if (peak > arenaStats.peak)
+		arenaStats.peak = peak;
+
+	return peak;
+}
+
+// Largest block the arena can still hand out, by bisection: the allocator keeps no such figure
+static size_t HT_MQTT_TLSArenaLargest(void) {
+	size_t lo = 0, hi = sizeof(HT_MQTT_TlsArena), mid;
+	void *probe;
+
+	while (hi - lo > 16) {
+		mid = lo + (hi - lo) / 2;
+		probe = mbedtls_calloc(1, mid);
+		if (probe != NULL) {
+			mbedtls_free(probe);
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+#endif
+
+void HT_MQTT_TLSArenaOpen(void) {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+	if (!arenaOpen) {
+		mbedtls_memory_buffer_alloc_init(HT_MQTT_TlsArena, sizeof(HT_MQTT_TlsArena));
+		arenaOpen = 1;
+	}
+	arenaUsers++;
+	arenaStats.size = sizeof(HT_MQTT_TlsArena);
+	HT_MQTT_TLSArenaPeak();
+#endif
+}
+
+void HT_MQTT_TLSArenaClose(void) {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+	size_t used = 0, blocks = 0;
+
+	if (arenaUsers == 0 || --arenaUsers != 0)
+		return;
+
+	HT_MQTT_TLSArenaPeak();
+	mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+	arenaStats.used = used;
+	if (used != 0) {
+		// Something still points into it, resetting would hand that memory out twice
+		arenaStats.leaks++;
+		return;
+	}
+
+	// Empty: start the next connection from one free block, without the last session keys
+	mbedtls_memory_buffer_alloc_free();
+	mbedtls_platform_zeroize(HT_MQTT_TlsArena, sizeof(HT_MQTT_TlsArena));
+	arenaOpen = 0;
+#endif
+}
+
+void HT_MQTT_TLSArenaGetStats(MqttTlsArenaStats *stats) {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+	size_t used = 0, blocks = 0;
+
+	if (arenaOpen) {
+		mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+		arenaStats.used = used;
+	}
+#endif
+	*stats = arenaStats;
+}
+
+// Records the handshake peak and how fragmented the handshake left the arena
+static void HT_MQTT_TLSArenaSample(void) {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+	size_t used = 0, blocks = 0;
+
+	arenaStats.handshakePeak = HT_MQTT_TLSArenaPeak();
+	mbedtls_memory_buffer_alloc_cur_get(&used, &blocks);
+	arenaStats.used = used;
+	arenaStats.freeBytes = sizeof(HT_MQTT_TlsArena) - used;
+	arenaStats.largestFree = HT_MQTT_TLSArenaLargest();
+	mbedtls_memory_buffer_alloc_max_reset();   // The probes are not part of the session peak
+#endif
+}
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+// Tells whether the ServerHello in the input buffer acknowledges max_fragment_length (RFC 6066).
+// mbedTLS takes a missing acknowledgement as a yes, and keeps using the length it asked for
+static uint8_t HT_MQTT_TLSServerHelloMfl(const mbedtls_ssl_context *sslContext) {
+	const unsigned char *msg = sslContext->in_msg;
+	size_t len = sslContext->in_hslen;
+	size_t pos, end;
+
+	// Header (4), version (2), random (32), session ID (1 + n), ciphersuite (2), compression (1)
+	if (len < 4 + 2 + 32 + 1 || msg[0] != MBEDTLS_SSL_HS_SERVER_HELLO)
+		return 0;
+	pos = 4 + 2 + 32;
+	pos += 1 + msg[pos] + 2 + 1;
+	if (pos + 2 > len)
+		return 0;
+
+	end = pos + 2 + ((msg[pos] << 8) | msg[pos + 1]);
+	if (end > len)
+		return 0;
+	for (pos += 2; pos + 4 <= end; pos += 4 + ((msg[pos + 2] << 8) | msg[pos + 3])) {
+		if (((msg[pos] << 8) | msg[pos + 1]) == MBEDTLS_TLS_EXT_MAX_FRAGMENT_LENGTH)
+			return 1;
+	}
+
+	return 0;
+}
+#endif
+
+// Seeds the DRBG unless an earlier connect of this boot did
+int HT_MQTT_TLSDrbg(mbedtls_ctr_drbg_context **drbg, uint32_t *seed_ms) {
+	const char *custom = "SSLs";
+	TickType_t start;
+	int ret;
+
+	*drbg = &HT_MQTT_TlsDrbg;
+	*seed_ms = 0;
+	if (drbgSeeded)
+		return 0;
+
+	start = xTaskGetTickCount();
+	mbedtls_entropy_init(&HT_MQTT_TlsEntropy);
+#if defined(MBEDTLS_ENTROPY_TRNG)
+	// The TRNG alone: the platform poll (MBEDTLS_USE_RAND_API_ENTROPY) is not backed by hardware
+	HT_MQTT_TlsEntropy.source_count = 0;
+	ret = mbedtls_entropy_add_source(&HT_MQTT_TlsEntropy, mbedtls_trng_poll, NULL,
+									 MBEDTLS_TRNG_THRESHOLD, MBEDTLS_ENTROPY_SOURCE_STRONG);
+	if (ret != 0) {
+		mbedtls_entropy_free(&HT_MQTT_TlsEntropy);
+		return ret;
+	}
+#endif
+	mbedtls_ctr_drbg_init(&HT_MQTT_TlsDrbg);
+	ret = mbedtls_ctr_drbg_seed(&HT_MQTT_TlsDrbg, mbedtls_entropy_func, &HT_MQTT_TlsEntropy,
+								(const unsigned char *) custom, strlen(custom));
+	if (ret != 0) {
+		mbedtls_ctr_drbg_free(&HT_MQTT_TlsDrbg);
+		mbedtls_entropy_free(&HT_MQTT_TlsEntropy);
+		return ret;
+	}
+	mbedtls_ctr_drbg_set_reseed_interval(&HT_MQTT_TlsDrbg, HT_MQTT_TLS_DRBG_RESEED_INTERVAL);
 
-static int HT_MQTT_MyCertVerify(void * data, mbedtls_x509_crt * crt, int depth, uint32_t * flags) {
-	char buf[4096];
+	drbgSeeded = 1;
+	*seed_ms = (uint32_t)(xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
 
-	((void) data);
-	mbedtls_x509_crt_info(buf, sizeof(buf) - 1, "", crt);
-	return (0);
+	return 1;
+}
+
+// Frees everything HT_MQTT_TLSConnect set up, closing the socket, and empties the arena
+static void HT_MQTT_TLSRelease(void) {
+	mbedtls_net_free(&ssl->netContext);
+	mbedtls_ssl_free(&ssl->sslContext);
+	mbedtls_ssl_config_free(&ssl->sslConfig);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	mbedtls_x509_crt_free(&ssl->caCert);
+	mbedtls_x509_crt_free(&ssl->clientCert);
+	mbedtls_pk_free(&ssl->pkContext);
+#endif
+	mbedtls_free(ssl);
+	ssl = NULL;
+	if (client != NULL)
+		client->ssl = NULL;
+	HT_MQTT_TLSArenaClose();
+}
+
+// Hands the stored session to the handshake; a server that does not know it any more runs a full one
+static void HT_MQTT_TLSOfferSession(MqttClientContext *context) {
+	mbedtls_ssl_session session;
+
+	context->sessionOffered = 0;
+	if (context->session == NULL || context->sessionLen == 0)
+		return;
+
+	mbedtls_ssl_session_init(&session);
+	if (mbedtls_ssl_session_load(&session, context->session, context->sessionLen) == 0 &&
+		mbedtls_ssl_set_session(&(ssl->sslContext), &session) == 0)
+		context->sessionOffered = 1;
+	mbedtls_ssl_session_free(&session);
+}
+
+// Serializes the negotiated session into context->session for the next connection
+static void HT_MQTT_TLSSaveSession(MqttClientContext *context) {
+	mbedtls_ssl_session session;
+	size_t len = 0;
+	int ret;
+
+	context->sessionLen = 0;
+	context->sessionLifetime_s = 0;
+	if (context->session == NULL)
+		return;
+
+	mbedtls_ssl_session_init(&session);
+	if (mbedtls_ssl_get_session(&(ssl->sslContext), &session) == 0) {
+		ret = mbedtls_ssl_session_save(&session, context->session, context->sessionSize, &len);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		// A ticket too large to keep: keep the session ID, the server cache may still have it
+		if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL && session.ticket_len != 0 && session.id_len != 0) {
+			session.ticket_len = 0;
+			ret = mbedtls_ssl_session_save(&session, context->session, context->sessionSize, &len);
+		}
+		if (session.ticket_len != 0)
+			context->sessionLifetime_s = session.ticket_lifetime;
+#endif
+		if (ret == 0)
+			context->sessionLen = len;
+	}
+	mbedtls_ssl_session_free(&session);
 }
 
 static int HT_MQTT_TLSDisconnect(Network * network) {
 	int ret = 0;
 
+	if (ssl == NULL)
+		return 0;
+
 	do {
 		ret = mbedtls_ssl_close_notify(&(ssl->sslContext));
 	} while(ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
-	mbedtls_net_free(&(ssl->netContext));
+	HT_MQTT_TLSRelease();
+#if defined(MBEDTLS_AES_ALT) || defined(MBEDTLS_SHA256_ALT)
+	mbedtls_l2c_idle();
+#endif
 
 	return 0;
 }
@@ -28,6 +306,9 @@ static int HT_MQTT_TLSWrite(Network * network, unsigned char *buffer, int len, i
 	int written;
 	int frags;
 
+	if (ssl == NULL)
+		return -1;
+
 	for (written = 0, frags = 0; written < len; written += ret, frags++) {
 		while ((ret = mbedtls_ssl_write(&(ssl->sslContext), buffer + written, len - written)) <= 0) {
 			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
@@ -42,46 +323,71 @@ static int HT_MQTT_TLSWrite(Network * network, unsigned char *buffer, int len, i
 static int HT_MQTT_TLSRead(Network * network, unsigned char *buffer, int len, int timeout_ms) {
 	int rxLen = 0;
 	int ret_val = -1;
-	bool isErrorFlag = false;
-	bool isCompleteFlag = false;
+
+	if (ssl == NULL)
+		return -1;
 
 	if (timeout_ms != 0)
 		mbedtls_ssl_conf_read_timeout(&(ssl->sslConfig), timeout_ms);
 
-	do {
-		ret_val = mbedtls_ssl_read(&(ssl->sslContext), buffer, len);
+	// A packet may span records when the fragment length is shorter than it
+	while (rxLen < len) {
+		ret_val = mbedtls_ssl_read(&(ssl->sslContext), buffer + rxLen, len - rxLen);
 
 		if (ret_val > 0) {
 			rxLen += ret_val;
 		}
-		else if (ret_val == MBEDTLS_ERR_SSL_TIMEOUT) {
-			ret_val = 0;
-			return ret_val;
-		}
-		else if (ret_val == MBEDTLS_ERR_SSL_WANT_READ) {
-			isErrorFlag = true;
+		else if (ret_val == MBEDTLS_ERR_SSL_TIMEOUT || ret_val == MBEDTLS_ERR_SSL_WANT_READ) {
+			// Bytes taken from earlier records belong to the caller, or the MQTT stream loses sync
+			if (rxLen > 0)
+				return rxLen;
+			return ret_val == MBEDTLS_ERR_SSL_TIMEOUT ? 0 : ret_val;
 		}
 		else if (ret_val == 0) {
-			ret_val = 100; //To Handle Mbedtls EOF case
-			return ret_val;
+			return 100; //To Handle Mbedtls EOF case
 		}
-
-		if (rxLen >= len) {
-			isCompleteFlag = true;
+		else {
+			// Close notify, receive failure, EOF: the connection is gone
+			return ret_val;
 		}
-	
-	} while( (!isErrorFlag) && (!isCompleteFlag) );
+	}
 
-	return ret_val;
+	return rxLen;
 }
 
 int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	int32_t ret = 0;
-	const char *custom = "SSLs";
     int32_t authmode = MBEDTLS_SSL_VERIFY_NONE;
+	TickType_t handshakeStart;
+	uint8_t full = 0;
+	int state;
+	mbedtls_ctr_drbg_context *drbg;
+
+#if !defined(MBEDTLS_X509_CRT_PARSE_C)
+	// PSK only build (config_ec_ssl_psk.h)
+	if (context->psk == NULL)
+		return -1;
+#endif
+#if !defined(HT_MQTT_TLS_PSK)
+	if (context->psk != NULL)
+		return -1;
+#endif
+
+	// A connection dropped without HT_MQTT_TLSDisconnect still holds its context
+	if (ssl != NULL)
+		HT_MQTT_TLSRelease();
 
-	context->ssl = malloc(sizeof(MqttClientSsl));
-    ssl = context->ssl;
+	HT_MQTT_TLSArenaOpen();
+	ssl = mbedtls_calloc(1, sizeof(MqttClientSsl));
+	if (ssl == NULL) {
+		HT_MQTT_TLSArenaClose();
+		return -1;
+	}
+	context->ssl = ssl;
+	client = context;
+	context->sessionOffered = 0;
+	context->sessionResumed = 0;
+	context->mflAccepted = 0;
 
 	/*
 	 * 0. Initialize the RNG and the session data
@@ -90,42 +396,47 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	mbedtls_net_init(&ssl->netContext);
     mbedtls_ssl_init(&ssl->sslContext);
     mbedtls_ssl_config_init(&ssl->sslConfig);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
     mbedtls_x509_crt_init(&ssl->caCert);
     mbedtls_x509_crt_init(&ssl->clientCert);
     mbedtls_pk_init(&ssl->pkContext);
-    mbedtls_ctr_drbg_init(&ssl->ctrDrbgContext);
-    mbedtls_entropy_init(&ssl->entropyContext);
+#endif
 
-	if ((ret =
-		 mbedtls_ctr_drbg_seed(& (ssl->ctrDrbgContext), mbedtls_entropy_func, &(ssl->entropyContext), (const unsigned char *) custom, strlen(custom))) !=0) {			
+	if ((ret = HT_MQTT_TLSDrbg(&drbg, &context->rng_ms)) < 0) {
+		HT_MQTT_TLSRelease();
 		return ret;
 	}
+	context->rngSeeded = (uint8_t)ret;
 
 	/*
-	 * Initialize server ca root 
+	 * Initialize server ca root, not used with a pre-shared key
 	 */
-
-	if (context->clientCert != NULL && context->clientPk != NULL) {
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (context->psk == NULL && context->clientCert != NULL && context->clientPk != NULL) {
 		authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
 		ret = mbedtls_x509_crt_parse(& (ssl->caCert), (const unsigned char *)context->caCert, context->caCertLen);
 
 		if (ret < 0) {
+			HT_MQTT_TLSRelease();
 			return -1;
 		}
 	} 
 
 	//2. START OF CLIENT CERT INIT AND PARSING - device_ec_cert.pem
-    if (context->clientCert != NULL && context->clientPk != NULL) {
+    if (context->psk == NULL && context->clientCert != NULL && context->clientPk != NULL) {
         ret = mbedtls_x509_crt_parse(&(ssl->clientCert), (const unsigned char *) context->clientCert, context->clientCertLen);
         if (ret != 0) {
+            HT_MQTT_TLSRelease();
             return -1;
         }
 
         ret = mbedtls_pk_parse_key(&ssl->pkContext, (const unsigned char *) context->clientPk, context->clientPkLen, NULL, 0);
         if (ret != 0) {
+            HT_MQTT_TLSRelease();
             return -1;
         }
     }
+#endif
 
 	// 5. Setup the network parameters
 	network->mqttread = HT_MQTT_TLSRead;
@@ -135,12 +446,14 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	// 4. Start the TLS connection
 	ret = NetworkSetConnTimeout(network, 5000, 5000); 	// Add send_timeout , recieve_timeout in TLSConnectParams 
     if(ret != 0) {
+        HT_MQTT_TLSRelease();
         return -1;
     }
 
 	// Step 4.2: Do NetworkConnect // hostname and port
 	ret = TLSNetworkConnect(network, context->host, context->port, context->timeout_ms);
     if(ret != 0) {
+        HT_MQTT_TLSRelease();
         return -1;
     }
     ssl->netContext.fd = network->my_socket;
@@ -150,17 +463,36 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 		MBEDTLS_SSL_IS_CLIENT, 
 		MBEDTLS_SSL_TRANSPORT_STREAM, 
 		MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+		HT_MQTT_TLSRelease();
 		return ret;
 	}
 
 	mbedtls_ssl_conf_max_version(&ssl->sslConfig, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
     mbedtls_ssl_conf_min_version(&ssl->sslConfig, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 
-	mbedtls_ssl_conf_verify(&ssl->sslConfig, HT_MQTT_MyCertVerify, NULL);
+#if defined(HT_MQTT_TLS_PSK)
+	if (context->psk != NULL) {
+		// The config keeps its own copy of the key, zeroized by mbedtls_ssl_config_free
+		mbedtls_ssl_conf_ciphersuites(&ssl->sslConfig, HT_MQTT_TlsPskCiphersuites);
+		if (mbedtls_ssl_conf_psk(&ssl->sslConfig, context->psk, context->pskLen,
+								 context->pskIdentity, context->pskIdentityLen) != 0) {
+			HT_MQTT_TLSRelease();
+			return -1;
+		}
+	}
+#endif
+#if defined(MBEDTLS_AES_ALT) && defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (context->psk == NULL)
+		mbedtls_ssl_conf_ciphersuites(&ssl->sslConfig, HT_MQTT_TlsCiphersuites);
+#endif
+
 	mbedtls_ssl_conf_authmode(&(ssl->sslConfig), authmode);
 
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
-    if ((ret = mbedtls_ssl_conf_max_frag_len(&(ssl->sslConfig), MBEDTLS_SSL_MAX_FRAG_LEN_1024)) != 0) {
+	// Capped by the smaller of MBEDTLS_SSL_IN_CONTENT_LEN and MBEDTLS_SSL_OUT_CONTENT_LEN
+    if ((ret = mbedtls_ssl_conf_max_frag_len(&(ssl->sslConfig),
+                                             context->psk != NULL ? HT_MQTT_TLS_MFL_PSK : HT_MQTT_TLS_MFL)) != 0) {
+        HT_MQTT_TLSRelease();
         return -1;
     }
 #endif
@@ -168,11 +500,13 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	// Step 4.5 SSL conf check for CA chain.
 #if defined(MBEDTLS_X509_CRT_PARSE_C) 
     
+    ssl->crtProfile = mbedtls_x509_crt_profile_default;
     mbedtls_ssl_conf_cert_profile(&ssl->sslConfig, &ssl->crtProfile);
 	mbedtls_ssl_conf_ca_chain(&(ssl->sslConfig), &(ssl->caCert), NULL);
 
 	if(context->clientCert) {
         if ((ret = mbedtls_ssl_conf_own_cert(&(ssl->sslConfig), &(ssl->clientCert), &(ssl->pkContext))) != 0) {
+            HT_MQTT_TLSRelease();
             return -1;
         }
     }
@@ -180,7 +514,7 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 #endif
 	
 	// Step 4.7 Random number generator	
-	mbedtls_ssl_conf_rng(&(ssl->sslConfig), mbedtls_ctr_drbg_random, &(ssl->ctrDrbgContext));	
+	mbedtls_ssl_conf_rng(&(ssl->sslConfig), mbedtls_ctr_drbg_random, drbg);	
 
 	//mbedtls_ssl_conf_dbg(&(ssl->conf), sslDebug, NULL);
 	if (context->timeout_r > 0) {
@@ -191,27 +525,65 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	}
 
 	if ((ret = mbedtls_ssl_setup(&(ssl->sslContext), &(ssl->sslConfig))) != 0) {
+        HT_MQTT_TLSRelease();
         return -1;
     }
 
 	//	  params->pDestinationURL = hostname;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
 	mbedtls_ssl_set_hostname(&(ssl->sslContext), context->host);
+#endif
     mbedtls_ssl_set_bio(&(ssl->sslContext), &(ssl->netContext), mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
 	
-	// Step 4.12 TLS HANDSHAKE process on
-    while ((ret = mbedtls_ssl_handshake(&(ssl->sslContext))) != 0) {
-        if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
-            return -1;
-        }
-    }
+	HT_MQTT_TLSOfferSession(context);
+
+	// Step 4.12 TLS HANDSHAKE process on, stepwise: only a full handshake goes through ClientKeyExchange
+	handshakeStart = xTaskGetTickCount();
+	while (ssl->sslContext.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+		state = ssl->sslContext.state;
+		if (state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE)
+			full = 1;
+
+		ret = mbedtls_ssl_handshake_step(&(ssl->sslContext));
+		if ((ret != 0) && (ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+			HT_MQTT_TLSRelease();
+			return -1;
+		}
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+		// A resumed session kept the fragment length of the full handshake that made it
+		if (ret == 0 && state == MBEDTLS_SSL_SERVER_HELLO) {
+			context->mflAccepted = HT_MQTT_TLSServerHelloMfl(&(ssl->sslContext));
+			if (HT_MQTT_TLS_MFL_REQUIRED && context->psk != NULL && !context->mflAccepted &&
+				!ssl->sslContext.handshake->resume && ssl->sslConfig.mfl_code != MBEDTLS_SSL_MAX_FRAG_LEN_NONE) {
+				HT_MQTT_TLSRelease();
+				return -1;
+			}
+		}
+#endif
+	}
+	context->handshake_ms = (uint32_t)(xTaskGetTickCount() - handshakeStart) * portTICK_PERIOD_MS;
+	context->sessionResumed = !full;
+
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+	// Shrunk to the fragment length when the handshake was wrapped up
+	context->recordInLen = ssl->sslContext.in_buf_len;
+	context->recordOutLen = ssl->sslContext.out_buf_len;
+#else
+	context->recordInLen = MBEDTLS_SSL_IN_BUFFER_LEN;
+	context->recordOutLen = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
 
     /*
-     * 4. Verify the server certificate
+     * 4. Verify the server certificate (kept in the session when resumed), always passes with a pre-shared key
      */
     ret = mbedtls_ssl_get_verify_result(&(ssl->sslContext));
     if (ret != 0) {
+		HT_MQTT_TLSRelease();
         return -1;
     }
 
+	HT_MQTT_TLSSaveSession(context);
+	HT_MQTT_TLSArenaSample();
+
 	return ret;
 }